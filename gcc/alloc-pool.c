@@ -63,17 +63,23 @@ typedef struct allocation_object_def
 static ALLOC_POOL_ID_TYPE last_id;
 #endif
 
-#ifdef GATHER_STATISTICS
-
-/* Store information about each particular alloc_pool.  */
+/* APPLE LOCAL begin alloc arena */
+/* Store information about all the alloc_pools with a given name, for
+   -fmem-report.  Each pool points to its descriptor, so keeping these
+   up to date costs no more than a few additions.  */
 struct alloc_pool_descriptor
 {
   const char *name;
-  int allocated;
+  /* The number of pools created.  */
   int created;
-  int peak;
-  int current;
+  /* The number of bytes handed out by pool_alloc.  */
+  size_t allocated;
+  /* The largest and the current number of bytes in the blocks of the
+     live pools.  */
+  size_t peak;
+  size_t current;
 };
+/* APPLE LOCAL end alloc arena */
 
 /* Hashtable mapping alloc_pool names to descriptors.  */
 static htab_t alloc_pool_hash;
@@ -111,19 +117,18 @@ alloc_pool_descriptor (const char *name)
   (*slot)->name = name;
   return *slot;
 }
-#endif
 
+/* APPLE LOCAL begin alloc arena */
 /* Create a pool of things of size SIZE, with NUM in each block we
-   allocate.  */
+   allocate, and account for it in DESC.  */
 
-alloc_pool
-create_alloc_pool (const char *name, size_t size, size_t num)
+static alloc_pool
+create_alloc_pool_1 (const char *name, size_t size, size_t num,
+		     struct alloc_pool_descriptor *desc)
+/* APPLE LOCAL end alloc arena */
 {
   alloc_pool pool;
   size_t pool_size, header_size;
-#ifdef GATHER_STATISTICS
-  struct alloc_pool_descriptor *desc;
-#endif
 
   gcc_assert (name);
 
@@ -150,10 +155,10 @@ create_alloc_pool (const char *name, size_t size, size_t num)
 
   /* Now init the various pieces of our pool structure.  */
   pool->name = /*xstrdup (name)*/name;
-#ifdef GATHER_STATISTICS
-  desc = alloc_pool_descriptor (name);
-  desc->created++;
-#endif
+  /* APPLE LOCAL begin alloc arena */
+  pool->desc = desc;
+  pool->desc->created++;
+  /* APPLE LOCAL end alloc arena */
   pool->elt_size = size;
   pool->elts_per_block = num;
 
@@ -167,6 +172,21 @@ create_alloc_pool (const char *name, size_t size, size_t num)
   pool->blocks_allocated = 0;
   pool->block_list = NULL;
 
+  return (pool);
+}
+
+/* APPLE LOCAL begin alloc arena */
+/* Create a pool of things of size SIZE, with NUM in each block we
+   allocate.  */
+
+alloc_pool
+create_alloc_pool (const char *name, size_t size, size_t num)
+{
+  alloc_pool pool;
+
+  gcc_assert (name);
+  pool = create_alloc_pool_1 (name, size, num, alloc_pool_descriptor (name));
+
 #ifdef ENABLE_CHECKING
   /* Increase the last used ID and use it for this pool.
      ID == 0 is used for free elements of pool so skip it.  */
@@ -179,15 +199,15 @@ create_alloc_pool (const char *name, size_t size, size_t num)
 
   return (pool);
 }
+/* APPLE LOCAL end alloc arena */
 
-/* Free all memory allocated for the given memory pool.  */
+/* APPLE LOCAL begin alloc arena */
+/* Free all the blocks of POOL, leaving it empty but ready for reuse.
+   This releases every object allocated from POOL at once.  */
 void
-free_alloc_pool (alloc_pool pool)
+empty_alloc_pool (alloc_pool pool)
 {
   alloc_pool_list block, next_block;
-#ifdef GATHER_STATISTICS
-  struct alloc_pool_descriptor *desc = alloc_pool_descriptor (pool->name);
-#endif
 
   gcc_assert (pool);
 
@@ -196,16 +216,28 @@ free_alloc_pool (alloc_pool pool)
     {
       next_block = block->next;
       free (block);
-#ifdef GATHER_STATISTICS
-      desc->current -= pool->block_size;
-#endif
     }
+  pool->desc->current -= pool->blocks_allocated * pool->block_size;
+
+  pool->free_list = NULL;
+  pool->elts_allocated = 0;
+  pool->elts_free = 0;
+  pool->blocks_allocated = 0;
+  pool->block_list = NULL;
+}
+
+/* Free all memory allocated for the given memory pool.  */
+void
+free_alloc_pool (alloc_pool pool)
+{
+  empty_alloc_pool (pool);
 #ifdef ENABLE_CHECKING
   memset (pool, 0xaf, sizeof (*pool));
 #endif
   /* Lastly, free the pool.  */
   free (pool);
 }
+/* APPLE LOCAL end alloc arena */
 
 /* Frees the alloc_pool, if it is empty and zero *POOL in this case.  */
 void
@@ -224,11 +256,11 @@ pool_alloc (alloc_pool pool)
 {
   alloc_pool_list header;
   char *block;
-#ifdef GATHER_STATISTICS
-  struct alloc_pool_descriptor *desc = alloc_pool_descriptor (pool->name);
+  /* APPLE LOCAL begin alloc arena */
+  struct alloc_pool_descriptor *desc = pool->desc;
 
-  desc->allocated+=pool->elt_size;
-#endif
+  desc->allocated += pool->elt_size;
+  /* APPLE LOCAL end alloc arena */
 
   gcc_assert (pool);
 
@@ -242,11 +274,11 @@ pool_alloc (alloc_pool pool)
       block = XNEWVEC (char, pool->block_size);
       block_header = (alloc_pool_list) block;
       block += align_eight (sizeof (struct alloc_pool_list_def));
-#ifdef GATHER_STATISTICS
+      /* APPLE LOCAL begin alloc arena */
       desc->current += pool->block_size;
       if (desc->peak < desc->current)
 	desc->peak = desc->current;
-#endif
+      /* APPLE LOCAL end alloc arena */
 
       /* Throw it on the block list.  */
       block_header->next = pool->block_list;
@@ -309,14 +341,139 @@ pool_free (alloc_pool pool, void *ptr)
   pool->free_list = header;
   pool->elts_free++;
 }
+/* APPLE LOCAL begin alloc arena */
+/* Create an arena named NAME, whose size class pools allocate NUM
+   objects at a time.  */
+alloc_arena
+create_alloc_arena (const char *name, size_t num)
+{
+  alloc_arena arena;
+
+  gcc_assert (name);
+  gcc_assert (num);
+
+  arena = XCNEW (struct alloc_arena_def);
+  arena->name = name;
+  arena->elts_per_block = num;
+  arena->desc = XCNEW (struct alloc_pool_descriptor);
+  arena->desc->name = name;
+  return arena;
+}
+
+/* The space before an object allocated with malloc, which keeps the
+   object itself aligned like a pool element.  */
+#define ARENA_LARGE_HEADER_SIZE \
+  align_eight (sizeof (struct alloc_arena_large_def))
+
+/* Return the size class for objects of SIZE bytes.  Sizes of
+   ALLOC_ARENA_CLASSES or more are allocated with malloc.  */
+#define ARENA_SIZE_CLASS(SIZE) \
+  ((SIZE) ? ((SIZE) - 1) / ALLOC_ARENA_GRANULE : 0)
+
+/* Allocate SIZE bytes from ARENA.  */
+void *
+arena_alloc (alloc_arena arena, size_t size)
+{
+  size_t sc = ARENA_SIZE_CLASS (size);
+  alloc_arena_large large;
+
+  if (sc < ALLOC_ARENA_CLASSES)
+    {
+      if (!arena->pools[sc])
+	{
+	  arena->pools[sc]
+	    = create_alloc_pool_1 (arena->name,
+				   (sc + 1) * ALLOC_ARENA_GRANULE,
+				   arena->elts_per_block, arena->desc);
+#ifdef ENABLE_CHECKING
+	  /* Stay away from LAST_ID, which the other pools share.  No
+	     other live pool has the address of this one.  */
+	  arena->pools[sc]->id = (ALLOC_POOL_ID_TYPE) (size_t) arena->pools[sc];
+#endif
+	}
+      return pool_alloc (arena->pools[sc]);
+    }
+
+  large = xmalloc (ARENA_LARGE_HEADER_SIZE + size);
+  large->prev = NULL;
+  large->next = arena->large_list;
+  if (large->next)
+    large->next->prev = large;
+  arena->large_list = large;
+  return (char *) large + ARENA_LARGE_HEADER_SIZE;
+}
+
+/* Return PTR, an object of SIZE bytes allocated from ARENA, to it.  */
+void
+arena_free (alloc_arena arena, void *ptr, size_t size)
+{
+  size_t sc = ARENA_SIZE_CLASS (size);
+  alloc_arena_large large;
+
+  if (sc < ALLOC_ARENA_CLASSES)
+    {
+      pool_free (arena->pools[sc], ptr);
+      return;
+    }
+
+  large = (alloc_arena_large) ((char *) ptr - ARENA_LARGE_HEADER_SIZE);
+  if (large->prev)
+    large->prev->next = large->next;
+  else
+    arena->large_list = large->next;
+  if (large->next)
+    large->next->prev = large->prev;
+  free (large);
+}
+
+/* Free every object allocated from ARENA, leaving it ready for reuse.  */
+void
+empty_alloc_arena (alloc_arena arena)
+{
+  alloc_arena_large large, next;
+  size_t i;
+
+  for (i = 0; i < ALLOC_ARENA_CLASSES; i++)
+    if (arena->pools[i])
+      empty_alloc_pool (arena->pools[i]);
+
+  for (large = arena->large_list; large; large = next)
+    {
+      next = large->next;
+      free (large);
+    }
+  arena->large_list = NULL;
+}
+
+/* Free ARENA and every object allocated from it, and add its
+   statistics to those of the pools with the same name.  */
+void
+free_alloc_arena (alloc_arena arena)
+{
+  struct alloc_pool_descriptor *desc;
+  size_t i;
+
+  empty_alloc_arena (arena);
+  for (i = 0; i < ALLOC_ARENA_CLASSES; i++)
+    if (arena->pools[i])
+      free_alloc_pool (arena->pools[i]);
+
+  desc = alloc_pool_descriptor (arena->name);
+  desc->created += arena->desc->created;
+  desc->allocated += arena->desc->allocated;
+  if (desc->peak < arena->desc->peak)
+    desc->peak = arena->desc->peak;
+  free (arena->desc);
+  free (arena);
+}
+
 /* Output per-alloc_pool statistics.  */
-#ifdef GATHER_STATISTICS
 
 /* Used to accumulate statistics about alloc_pool sizes.  */
 struct output_info
 {
   int count;
-  int size;
+  size_t size;
 };
 
 /* Called via htab_traverse.  Output alloc_pool descriptor pointed out by SLOT
@@ -329,20 +486,19 @@ print_statistics (void **slot, void *b)
 
   if (d->allocated)
     {
-      fprintf (stderr, "%-21s %6d %10d %10d %10d\n", d->name,
-	       d->created, d->allocated, d->peak, d->current);
+      fprintf (stderr, "%-21s %6d %10lu %10lu %10lu\n", d->name,
+	       d->created, (unsigned long) d->allocated,
+	       (unsigned long) d->peak, (unsigned long) d->current);
       i->size += d->allocated;
       i->count += d->created;
     }
   return 1;
 }
-#endif
 
 /* Output per-alloc_pool memory usage statistics.  */
 void
 dump_alloc_pool_statistics (void)
 {
-#ifdef GATHER_STATISTICS
   struct output_info info;
 
   if (!alloc_pool_hash)
@@ -354,8 +510,8 @@ dump_alloc_pool_statistics (void)
   info.size = 0;
   htab_traverse (alloc_pool_hash, print_statistics, &info);
   fprintf (stderr, "-------------------------------------------------------------\n");
-  fprintf (stderr, "%-20s %7d %10d\n",
-	   "Total", info.count, info.size);
+  fprintf (stderr, "%-20s %7d %10lu\n",
+	   "Total", info.count, (unsigned long) info.size);
   fprintf (stderr, "-------------------------------------------------------------\n");
-#endif
 }
+/* APPLE LOCAL end alloc arena */
@@ -44,13 +44,65 @@ typedef struct alloc_pool_def
   alloc_pool_list block_list;
   size_t block_size;
   size_t elt_size;
+  /* APPLE LOCAL begin alloc arena */
+  /* The -fmem-report statistics for all pools named NAME.  */
+  struct alloc_pool_descriptor *desc;
+  /* APPLE LOCAL end alloc arena */
 }
  *alloc_pool;
 
+/* APPLE LOCAL begin alloc arena */
+/* An alloc_arena hands out objects of any size.  Small objects come
+   from one alloc_pool per size class, each class ALLOC_ARENA_GRANULE
+   bytes wider than the last; larger ones come from malloc.  Like a
+   pool, an arena is usually emptied all at once, for example when the
+   pass using it finishes with a function.
+
+   An arena keeps its -fmem-report statistics to itself until it is
+   freed, and its pools are not entered in the table of pool names, so
+   arena_alloc, arena_free and empty_alloc_arena touch no global state.
+   create_alloc_arena and free_alloc_arena do; code that gives each
+   thread its own arena has to serialize those calls.  */
+
+#define ALLOC_ARENA_GRANULE 8
+#define ALLOC_ARENA_CLASSES 32
+
+/* An object too large for any of an arena's size classes.  */
+typedef struct alloc_arena_large_def
+{
+  struct alloc_arena_large_def *next;
+  struct alloc_arena_large_def *prev;
+}
+ *alloc_arena_large;
+
+typedef struct alloc_arena_def
+{
+  const char *name;
+  /* The number of objects in each block of the size class pools.  */
+  size_t elts_per_block;
+  /* The size class pools, created on first use.  */
+  alloc_pool pools[ALLOC_ARENA_CLASSES];
+  /* The objects allocated with malloc.  */
+  alloc_arena_large large_list;
+  /* The statistics of the size class pools.  */
+  struct alloc_pool_descriptor *desc;
+}
+ *alloc_arena;
+/* APPLE LOCAL end alloc arena */
+
 extern alloc_pool create_alloc_pool (const char *, size_t, size_t);
 extern void free_alloc_pool (alloc_pool);
 extern void free_alloc_pool_if_empty (alloc_pool *);
+/* APPLE LOCAL alloc arena */
+extern void empty_alloc_pool (alloc_pool);
 extern void *pool_alloc (alloc_pool);
 extern void pool_free (alloc_pool, void *);
+/* APPLE LOCAL begin alloc arena */
+extern alloc_arena create_alloc_arena (const char *, size_t);
+extern void free_alloc_arena (alloc_arena);
+extern void empty_alloc_arena (alloc_arena);
+extern void *arena_alloc (alloc_arena, size_t);
+extern void arena_free (alloc_arena, void *, size_t);
+/* APPLE LOCAL end alloc arena */
 extern void dump_alloc_pool_statistics (void);
 #endif
@@ -35,6 +35,19 @@ bitmap_obstack bitmap_default_obstack;    /* The default bitmap obstack.  */
 static GTY((deletable)) bitmap_element *bitmap_ggc_free; /* Freelist of
 							    GC'd elements.  */
 
+/* APPLE LOCAL begin dense bitmaps */
+/* The operations bitmap_dense_op knows how to compute.  */
+enum bitmap_dense_code
+{
+  BITMAP_DENSE_COPY,		/* DST = A */
+  BITMAP_DENSE_AND,		/* DST = A & B */
+  BITMAP_DENSE_AND_COMPL,	/* DST = A & ~B */
+  BITMAP_DENSE_COMPL_AND,	/* DST = ~A & B */
+  BITMAP_DENSE_IOR,		/* DST = A | B */
+  BITMAP_DENSE_XOR		/* DST = A ^ B */
+};
+/* APPLE LOCAL end dense bitmaps */
+
 static void bitmap_elem_to_freelist (bitmap, bitmap_element *);
 static void bitmap_element_free (bitmap, bitmap_element *);
 static bitmap_element *bitmap_element_allocate (bitmap);
@@ -43,6 +56,18 @@ static void bitmap_element_link (bitmap, bitmap_element *);
 static bitmap_element *bitmap_elt_insert_after (bitmap, bitmap_element *, unsigned int);
 static void bitmap_elt_clear_from (bitmap, bitmap_element *);
 static bitmap_element *bitmap_find_bit (bitmap, unsigned int);
+/* APPLE LOCAL begin dense bitmaps */
+static void bitmap_element_unlink (bitmap, bitmap_element *);
+static bitmap_element *bitmap_dense_alloc (bitmap_obstack *, unsigned int);
+static void bitmap_dense_free (bitmap_obstack *, bitmap_element *,
+			       unsigned int);
+static void bitmap_dense_install (bitmap, bitmap_element *, unsigned int,
+				  unsigned int);
+static void bitmap_dense_release (bitmap);
+static void bitmap_to_sparse (bitmap);
+static void bitmap_maybe_densify (bitmap);
+static bool bitmap_dense_op (bitmap, bitmap, bitmap, enum bitmap_dense_code);
+/* APPLE LOCAL end dense bitmaps */
 
 
 /* Add ELEM to the appropriate freelist.  */
@@ -64,11 +89,12 @@ bitmap_elem_to_freelist (bitmap head, bitmap_element *elt)
     }
 }
 
-/* Free a bitmap element.  Since these are allocated off the
-   bitmap_obstack, "free" actually means "put onto the freelist".  */
+/* APPLE LOCAL begin dense bitmaps */
+/* Remove ELT from the linked list of bitmap HEAD, without freeing it.  */
 
 static inline void
-bitmap_element_free (bitmap head, bitmap_element *elt)
+bitmap_element_unlink (bitmap head, bitmap_element *elt)
+/* APPLE LOCAL end dense bitmaps */
 {
   bitmap_element *next = elt->next;
   bitmap_element *prev = elt->prev;
@@ -92,6 +118,17 @@ bitmap_element_free (bitmap head, bitmap_element *elt)
       else
 	head->indx = 0;
     }
+/* APPLE LOCAL begin dense bitmaps */
+}
+
+/* Free a bitmap element.  Since these are allocated off the
+   bitmap_obstack, "free" actually means "put onto the freelist".  */
+
+static inline void
+bitmap_element_free (bitmap head, bitmap_element *elt)
+{
+  bitmap_element_unlink (head, elt);
+/* APPLE LOCAL end dense bitmaps */
   bitmap_elem_to_freelist (head, elt);
 }
 
@@ -189,7 +226,11 @@ bitmap_elt_clear_from (bitmap head, bitmap_element *elt)
 inline void
 bitmap_clear (bitmap head)
 {
-  if (head->first)
+  /* APPLE LOCAL begin dense bitmaps */
+  if (head->dense)
+    bitmap_dense_release (head);
+  else if (head->first)
+  /* APPLE LOCAL end dense bitmaps */
     bitmap_elt_clear_from (head, head->first);
 }
 
@@ -208,6 +249,8 @@ bitmap_obstack_initialize (bitmap_obstack *bit_obstack)
 
   bit_obstack->elements = NULL;
   bit_obstack->heads = NULL;
+  /* APPLE LOCAL dense bitmaps */
+  memset (bit_obstack->dense_free, 0, sizeof (bit_obstack->dense_free));
   obstack_specify_allocation (&bit_obstack->obstack, OBSTACK_CHUNK_SIZE,
 			      __alignof__ (bitmap_element),
 			      obstack_chunk_alloc,
@@ -225,6 +268,8 @@ bitmap_obstack_release (bitmap_obstack *bit_obstack)
 
   bit_obstack->elements = NULL;
   bit_obstack->heads = NULL;
+  /* APPLE LOCAL dense bitmaps */
+  memset (bit_obstack->dense_free, 0, sizeof (bit_obstack->dense_free));
   obstack_free (&bit_obstack->obstack, NULL);
 }
 
@@ -383,12 +428,404 @@ bitmap_elt_insert_after (bitmap head, bitmap_element *elt, unsigned int indx)
   return node;
 }
 
+/* APPLE LOCAL begin dense bitmaps */
+/* Return the size class of a dense array of NELTS elements.  */
+
+static inline unsigned int
+bitmap_dense_log2 (unsigned int nelts)
+{
+  unsigned int log2 = 0;
+
+  while ((1u << log2) < nelts)
+    log2++;
+  return log2;
+}
+
+/* Allocate an array for NELTS dense elements from BIT_OBSTACK.  The
+   array is not initialized.  */
+
+static bitmap_element *
+bitmap_dense_alloc (bitmap_obstack *bit_obstack, unsigned int nelts)
+{
+  unsigned int log2 = bitmap_dense_log2 (nelts);
+  bitmap_element *array = bit_obstack->dense_free[log2];
+
+  if (array)
+    bit_obstack->dense_free[log2] = array->next;
+  else
+    array = (bitmap_element *) obstack_alloc (&bit_obstack->obstack,
+					      sizeof (bitmap_element)
+					      << log2);
+  return array;
+}
+
+/* Put ARRAY, a dense array allocated for NELTS elements, onto the
+   freelist of BIT_OBSTACK.  */
+
+static void
+bitmap_dense_free (bitmap_obstack *bit_obstack, bitmap_element *array,
+		   unsigned int nelts)
+{
+  unsigned int log2 = bitmap_dense_log2 (nelts);
+
+  array->next = bit_obstack->dense_free[log2];
+  bit_obstack->dense_free[log2] = array;
+}
+
+/* Release the element array of the dense bitmap HEAD, leaving HEAD
+   empty.  */
+
+static void
+bitmap_dense_release (bitmap head)
+{
+  bitmap_dense_free (head->obstack, head->dense, head->dense_nelts);
+  head->dense = NULL;
+  head->first = head->current = NULL;
+  head->indx = 0;
+}
+
+/* Make ARRAY, which holds NELTS elements starting at index INDX, the
+   storage of the empty bitmap HEAD, and chain its nonzero elements
+   together.  If too few of the elements are nonzero, convert HEAD back
+   to a linked list.  */
+
+static void
+bitmap_dense_install (bitmap head, bitmap_element *array, unsigned int indx,
+		      unsigned int nelts)
+{
+  bitmap_element *prev = NULL;
+  unsigned int i, count = 0;
+
+  gcc_assert (!head->first && !head->dense);
+
+  for (i = 0; i < nelts; i++)
+    {
+      bitmap_element *elt = &array[i];
+
+      elt->indx = indx + i;
+      if (bitmap_element_zerop (elt))
+	continue;
+      elt->prev = prev;
+      if (prev)
+	prev->next = elt;
+      else
+	head->first = elt;
+      prev = elt;
+      count++;
+    }
+  if (prev)
+    prev->next = NULL;
+
+  head->dense = array;
+  head->dense_indx = indx;
+  head->dense_nelts = nelts;
+  head->current = head->first;
+  head->indx = head->first ? head->first->indx : 0;
+
+  if (!count)
+    bitmap_dense_release (head);
+  else if (count < BITMAP_DENSE_MIN_ELTS
+	   || count * 200 < nelts * BITMAP_DENSE_FILL)
+    bitmap_to_sparse (head);
+}
+
+/* Convert the dense bitmap HEAD into a plain linked list.  The elements
+   on the list stay where they are in the array, so that an iterator over
+   HEAD remains valid; the unused ones go onto the element freelist.  */
+
+static void
+bitmap_to_sparse (bitmap head)
+{
+  bitmap_element *array = head->dense;
+  unsigned int size = 1u << bitmap_dense_log2 (head->dense_nelts);
+  unsigned int i;
+
+  head->dense = NULL;
+  for (i = 0; i < size; i++)
+    if (i >= head->dense_nelts || bitmap_element_zerop (&array[i]))
+      bitmap_elem_to_freelist (head, &array[i]);
+}
+
+/* Convert the linked list bitmap HEAD, whose elements span the indices
+   LO up to HI - 1, into dense form.  */
+
+static void
+bitmap_densify (bitmap head, unsigned int lo, unsigned int hi)
+{
+  bitmap_element *array = bitmap_dense_alloc (head->obstack, hi - lo);
+  bitmap_element *elt;
+
+  memset (array, 0, (hi - lo) * sizeof (bitmap_element));
+  for (elt = head->first; elt; elt = elt->next)
+    memcpy (array[elt->indx - lo].bits, elt->bits, sizeof (elt->bits));
+
+  bitmap_elt_clear_from (head, head->first);
+  bitmap_dense_install (head, array, lo, hi - lo);
+}
+
+/* Convert the linked list bitmap HEAD into dense form if it has become
+   dense enough.  */
+
+static void
+bitmap_maybe_densify (bitmap head)
+{
+  bitmap_element *elt = head->first;
+  unsigned int count = 1;
+
+  if (!elt || !head->obstack || head->dense)
+    return;
+
+  for (; elt->next; elt = elt->next)
+    count++;
+
+  if (count >= BITMAP_DENSE_MIN_ELTS
+      && count * 100 >= (elt->indx + 1 - head->first->indx) * BITMAP_DENSE_FILL)
+    bitmap_densify (head, head->first->indx, elt->indx + 1);
+}
+
+/* Make room in the dense bitmap HEAD for element INDX, which is outside
+   its array.  Bits may be set while HEAD is being iterated over, so the
+   array is never moved: unless INDX fits in the array's unused tail,
+   convert HEAD to a linked list and return false.  */
+
+static bool
+bitmap_dense_grow (bitmap head, unsigned int indx)
+{
+  unsigned int lo = head->dense_indx;
+  unsigned int i;
+
+  if (indx < lo
+      || indx - lo >= 1u << bitmap_dense_log2 (head->dense_nelts))
+    {
+      bitmap_to_sparse (head);
+      return false;
+    }
+
+  for (i = head->dense_nelts; i <= indx - lo; i++)
+    {
+      memset (head->dense[i].bits, 0, sizeof (head->dense[i].bits));
+      head->dense[i].indx = lo + i;
+    }
+  head->dense_nelts = indx - lo + 1;
+  return true;
+}
+
+/* Set BIT in the dense bitmap HEAD.  Return false if HEAD had to be
+   converted to a linked list instead.  */
+
+static bool
+bitmap_dense_set_bit (bitmap head, unsigned int bit)
+{
+  unsigned int indx = bit / BITMAP_ELEMENT_ALL_BITS;
+  unsigned word_num = bit / BITMAP_WORD_BITS % BITMAP_ELEMENT_WORDS;
+  BITMAP_WORD bit_val = ((BITMAP_WORD) 1) << (bit % BITMAP_WORD_BITS);
+  bitmap_element *elt;
+
+  if (indx - head->dense_indx >= head->dense_nelts
+      && !bitmap_dense_grow (head, indx))
+    return false;
+
+  elt = &head->dense[indx - head->dense_indx];
+  if (bitmap_element_zerop (elt))
+    {
+      elt->bits[word_num] = bit_val;
+      bitmap_element_link (head, elt);
+    }
+  else
+    elt->bits[word_num] |= bit_val;
+  return true;
+}
+
+/* Store in *LO and *HI the index of the first nonzero element of MAP
+   and one more than that of the last.  Return false if MAP is empty.  */
+
+static inline bool
+bitmap_dense_range (bitmap map, unsigned int *lo, unsigned int *hi)
+{
+  bitmap_element *elt = map->first;
+
+  if (!elt)
+    return false;
+  *lo = elt->indx;
+
+  if (map->dense)
+    {
+      elt = &map->dense[map->dense_nelts - 1];
+      while (bitmap_element_zerop (elt))
+	elt--;
+    }
+  else
+    {
+      if (map->current)
+	elt = map->current;
+      while (elt->next)
+	elt = elt->next;
+    }
+  *hi = elt->indx + 1;
+  return true;
+}
+
+/* Return the bits of element INDX of MAP.  *CURSOR is the position of a
+   walk of MAP's list in increasing index order.  */
+
+static inline const BITMAP_WORD *
+bitmap_dense_fetch (bitmap_element **cursor, bitmap map, unsigned int indx)
+{
+  bitmap_element *elt;
+
+  if (map->dense)
+    {
+      if (indx - map->dense_indx < map->dense_nelts)
+	return map->dense[indx - map->dense_indx].bits;
+      return bitmap_zero_bits.bits;
+    }
+
+  for (elt = *cursor; elt && elt->indx < indx; elt = elt->next)
+    ;
+  *cursor = elt;
+  if (elt && elt->indx == indx)
+    return elt->bits;
+  return bitmap_zero_bits.bits;
+}
+
+/* Return true if the result of an operation storing into DST from A
+   and B should be computed by bitmap_dense_op.  */
+
+static inline bool
+bitmap_use_dense_p (bitmap dst, bitmap a, bitmap b)
+{
+  return (dst->dense
+	  || (dst->obstack && (a->dense || (b && b->dense))));
+}
+
+/* Compute DST = A CODE B into a dense array, then install that as the
+   new contents of DST.  DST may be the same bitmap as A, and B is
+   unused for BITMAP_DENSE_COPY.  Return true if DST changes.  */
+
+static bool
+bitmap_dense_op (bitmap dst, bitmap a, bitmap b, enum bitmap_dense_code code)
+{
+  bitmap_element *a_elt = a->first;
+  bitmap_element *b_elt = b ? b->first : NULL;
+  bitmap_element *d_elt = dst->first;
+  unsigned int a_lo = 0, a_hi = 0, b_lo = 0, b_hi = 0, d_lo = 0, d_hi = 0;
+  unsigned int lo = 0, hi = 0, k;
+  bool a_p, b_p, d_p;
+  bitmap_element *array;
+  BITMAP_WORD changed = 0;
+
+  a_p = bitmap_dense_range (a, &a_lo, &a_hi);
+  b_p = b && bitmap_dense_range (b, &b_lo, &b_hi);
+  d_p = bitmap_dense_range (dst, &d_lo, &d_hi);
+
+  /* Work out which elements of the result can be nonzero.  */
+  switch (code)
+    {
+    case BITMAP_DENSE_COPY:
+    case BITMAP_DENSE_AND_COMPL:
+      b_p = false;
+      break;
+    case BITMAP_DENSE_COMPL_AND:
+      a_p = false;
+      break;
+    case BITMAP_DENSE_AND:
+      if (a_p && b_p)
+	{
+	  a_lo = b_lo = MAX (a_lo, b_lo);
+	  a_hi = b_hi = MIN (a_hi, b_hi);
+	  if (a_lo >= a_hi)
+	    a_p = b_p = false;
+	}
+      else
+	a_p = b_p = false;
+      break;
+    default:
+      break;
+    }
+  if (a_p && b_p)
+    {
+      lo = MIN (a_lo, b_lo);
+      hi = MAX (a_hi, b_hi);
+    }
+  else if (a_p)
+    lo = a_lo, hi = a_hi;
+  else if (b_p)
+    lo = b_lo, hi = b_hi;
+  else
+    {
+      bitmap_clear (dst);
+      return d_p;
+    }
+
+  array = bitmap_dense_alloc (dst->obstack, hi - lo);
+  for (k = lo; k != hi; k++)
+    {
+      const BITMAP_WORD *a_bits = bitmap_dense_fetch (&a_elt, a, k);
+      const BITMAP_WORD *b_bits
+	= b ? bitmap_dense_fetch (&b_elt, b, k) : bitmap_zero_bits.bits;
+      const BITMAP_WORD *d_bits
+	= dst == a ? a_bits : bitmap_dense_fetch (&d_elt, dst, k);
+      BITMAP_WORD *r = array[k - lo].bits;
+      unsigned ix;
+
+      switch (code)
+	{
+	case BITMAP_DENSE_COPY:
+	  for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	    r[ix] = a_bits[ix];
+	  break;
+	case BITMAP_DENSE_AND:
+	  for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	    r[ix] = a_bits[ix] & b_bits[ix];
+	  break;
+	case BITMAP_DENSE_AND_COMPL:
+	  for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	    r[ix] = a_bits[ix] & ~b_bits[ix];
+	  break;
+	case BITMAP_DENSE_COMPL_AND:
+	  for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	    r[ix] = ~a_bits[ix] & b_bits[ix];
+	  break;
+	case BITMAP_DENSE_IOR:
+	  for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	    r[ix] = a_bits[ix] | b_bits[ix];
+	  break;
+	case BITMAP_DENSE_XOR:
+	  for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	    r[ix] = a_bits[ix] ^ b_bits[ix];
+	  break;
+	default:
+	  gcc_unreachable ();
+	}
+      for (ix = 0; ix != BITMAP_ELEMENT_WORDS; ix++)
+	changed |= r[ix] ^ d_bits[ix];
+    }
+
+  /* Elements of the old DST outside the new range are dropped.  */
+  if (d_p && (d_lo < lo || d_hi > hi))
+    changed = 1;
+
+  bitmap_clear (dst);
+  bitmap_dense_install (dst, array, lo, hi - lo);
+  return changed != 0;
+}
+/* APPLE LOCAL end dense bitmaps */
+
 /* Copy a bitmap to another bitmap.  */
 
 void
 bitmap_copy (bitmap to, bitmap from)
 {
   bitmap_element *from_ptr, *to_ptr = 0;
+  /* APPLE LOCAL begin dense bitmaps */
+  unsigned int count = 0;
+
+  if (bitmap_use_dense_p (to, from, NULL))
+    {
+      bitmap_dense_op (to, from, NULL, BITMAP_DENSE_COPY);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
 
   bitmap_clear (to);
 
@@ -416,7 +853,17 @@ bitmap_copy (bitmap to, bitmap from)
 	}
 
       to_ptr = to_elt;
+      /* APPLE LOCAL dense bitmaps */
+      count++;
     }
+
+  /* APPLE LOCAL begin dense bitmaps */
+  if (to->obstack
+      && count >= BITMAP_DENSE_MIN_ELTS
+      && (count * 100
+	  >= (to_ptr->indx + 1 - to->first->indx) * BITMAP_DENSE_FILL))
+    bitmap_densify (to, to->first->indx, to_ptr->indx + 1);
+  /* APPLE LOCAL end dense bitmaps */
 }
 
 /* Find a bitmap element that would hold a bitmap's bit.
@@ -473,7 +920,34 @@ bitmap_find_bit (bitmap head, unsigned int bit)
 void
 bitmap_clear_bit (bitmap head, int bit)
 {
-  bitmap_element *ptr = bitmap_find_bit (head, bit);
+  bitmap_element *ptr;
+
+  /* APPLE LOCAL begin dense bitmaps */
+  if (head->dense)
+    {
+      unsigned int indx = bit / BITMAP_ELEMENT_ALL_BITS - head->dense_indx;
+
+      if (indx < head->dense_nelts)
+	{
+	  unsigned bit_num  = bit % BITMAP_WORD_BITS;
+	  unsigned word_num = bit / BITMAP_WORD_BITS % BITMAP_ELEMENT_WORDS;
+
+	  ptr = &head->dense[indx];
+	  if (bitmap_element_zerop (ptr))
+	    return;
+	  ptr->bits[word_num] &= ~ (((BITMAP_WORD) 1) << bit_num);
+	  if (bitmap_element_zerop (ptr))
+	    {
+	      bitmap_element_unlink (head, ptr);
+	      if (!head->first)
+		bitmap_dense_release (head);
+	    }
+	}
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
+  ptr = bitmap_find_bit (head, bit);
 
   if (ptr != 0)
     {
@@ -492,11 +966,17 @@ bitmap_clear_bit (bitmap head, int bit)
 void
 bitmap_set_bit (bitmap head, int bit)
 {
-  bitmap_element *ptr = bitmap_find_bit (head, bit);
+  bitmap_element *ptr;
   unsigned word_num = bit / BITMAP_WORD_BITS % BITMAP_ELEMENT_WORDS;
   unsigned bit_num  = bit % BITMAP_WORD_BITS;
   BITMAP_WORD bit_val = ((BITMAP_WORD) 1) << bit_num;
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (head->dense && bitmap_dense_set_bit (head, bit))
+    return;
+  /* APPLE LOCAL end dense bitmaps */
+
+  ptr = bitmap_find_bit (head, bit);
   if (ptr == 0)
     {
       ptr = bitmap_element_allocate (head);
@@ -517,7 +997,18 @@ bitmap_bit_p (bitmap head, int bit)
   unsigned bit_num;
   unsigned word_num;
 
-  ptr = bitmap_find_bit (head, bit);
+  /* APPLE LOCAL begin dense bitmaps */
+  if (head->dense)
+    {
+      unsigned int indx = bit / BITMAP_ELEMENT_ALL_BITS - head->dense_indx;
+
+      if (indx >= head->dense_nelts)
+	return 0;
+      ptr = &head->dense[indx];
+    }
+  else
+    ptr = bitmap_find_bit (head, bit);
+  /* APPLE LOCAL end dense bitmaps */
   if (ptr == 0)
     return 0;
 
@@ -528,30 +1019,23 @@ bitmap_bit_p (bitmap head, int bit)
 }
 
 #if GCC_VERSION < 3400
-/* Table of number of set bits in a character, indexed by value of char.  */
-static unsigned char popcount_table[] =
-{
-    0,1,1,2,1,2,2,3,1,2,2,3,2,3,3,4,1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,
-    1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
-    1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
-    2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
-    1,2,2,3,2,3,3,4,2,3,3,4,3,4,4,5,2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,
-    2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
-    2,3,3,4,3,4,4,5,3,4,4,5,4,5,5,6,3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,
-    3,4,4,5,4,5,5,6,4,5,5,6,5,6,6,7,4,5,5,6,5,6,6,7,5,6,6,7,6,7,7,8,
-};
+/* APPLE LOCAL begin bitmap popcount */
+/* Return the number of bits set in A.  Hosts without
+   __builtin_popcountl sum the bits in parallel within the word: each
+   step adds adjacent fields of twice the previous width, and the
+   final multiply gathers the byte counts into the top byte.  */
 
 static unsigned long
 bitmap_popcount (BITMAP_WORD a)
 {
-  unsigned long ret = 0;
-  unsigned i;
+  const BITMAP_WORD ones = (BITMAP_WORD) -1;
 
-  /* Just do this the table way for now  */
-  for (i = 0; i < BITMAP_WORD_BITS; i+= 8)
-    ret += popcount_table[(a >> i) & 0xff];
-  return ret;
+  a -= (a >> 1) & (ones / 3);
+  a = (a & (ones / 15 * 3)) + ((a >> 2) & (ones / 15 * 3));
+  a = (a + (a >> 4)) & (ones / 255 * 15);
+  return (unsigned long) ((a * (ones / 255)) >> (BITMAP_WORD_BITS - 8));
 }
+/* APPLE LOCAL end bitmap popcount */
 #endif
 /* Count the number of bits set in the bitmap, and return it.  */
 
@@ -650,6 +1134,14 @@ bitmap_and (bitmap dst, bitmap a, bitmap b)
       return;
     }
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (dst, a, b))
+    {
+      bitmap_dense_op (dst, a, b, BITMAP_DENSE_AND);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt && b_elt)
     {
       if (a_elt->indx < b_elt->indx)
@@ -700,6 +1192,14 @@ bitmap_and_into (bitmap a, bitmap b)
   if (a == b)
     return;
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (a->dense)
+    {
+      bitmap_dense_op (a, a, b, BITMAP_DENSE_AND);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt && b_elt)
     {
       if (a_elt->indx < b_elt->indx)
@@ -753,6 +1253,14 @@ bitmap_and_compl (bitmap dst, bitmap a, bitmap b)
       return;
     }
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (dst, a, b))
+    {
+      bitmap_dense_op (dst, a, b, BITMAP_DENSE_AND_COMPL);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt)
     {
       if (!b_elt || a_elt->indx < b_elt->indx)
@@ -822,6 +1330,11 @@ bitmap_and_compl_into (bitmap a, bitmap b)
 	}
     }
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (a->dense)
+    return bitmap_dense_op (a, a, b, BITMAP_DENSE_AND_COMPL);
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt && b_elt)
     {
       if (a_elt->indx < b_elt->indx)
@@ -863,7 +1376,14 @@ bitmap_clear_range (bitmap head, unsigned int start, unsigned int count)
   unsigned int end_bit_plus1 = start + count;
   unsigned int end_bit = end_bit_plus1 - 1;
   unsigned int last_index = (end_bit) / BITMAP_ELEMENT_ALL_BITS;
-  bitmap_element *elt = bitmap_find_bit (head, start);
+  bitmap_element *elt;
+
+  /* APPLE LOCAL begin dense bitmaps */
+  if (head->dense)
+    bitmap_to_sparse (head);
+  /* APPLE LOCAL end dense bitmaps */
+
+  elt = bitmap_find_bit (head, start);
 
   /* If bitmap_find_bit returns zero, the current is the closest block
      to the result.  If the current is less than first index, find the
@@ -998,6 +1518,14 @@ bitmap_compl_and_into (bitmap a, bitmap b)
       return;
     }
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (a, b, NULL))
+    {
+      bitmap_dense_op (a, a, b, BITMAP_DENSE_COMPL_AND);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt || b_elt)
     {
       if (!b_elt || (a_elt && a_elt->indx < b_elt->indx))
@@ -1057,6 +1585,11 @@ bitmap_ior (bitmap dst, bitmap a, bitmap b)
 
   gcc_assert (dst != a && dst != b);
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (dst, a, b))
+    return bitmap_dense_op (dst, a, b, BITMAP_DENSE_IOR);
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt || b_elt)
     {
       if (a_elt && b_elt && a_elt->indx == b_elt->indx)
@@ -1146,6 +1679,10 @@ bitmap_ior (bitmap dst, bitmap a, bitmap b)
   gcc_assert (!dst->current == !dst->first);
   if (dst->current)
     dst->indx = dst->current->indx;
+  /* APPLE LOCAL begin dense bitmaps */
+  if (changed)
+    bitmap_maybe_densify (dst);
+  /* APPLE LOCAL end dense bitmaps */
   return changed;
 }
 
@@ -1162,6 +1699,11 @@ bitmap_ior_into (bitmap a, bitmap b)
   if (a == b)
     return false;
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (a, b, NULL))
+    return bitmap_dense_op (a, a, b, BITMAP_DENSE_IOR);
+  /* APPLE LOCAL end dense bitmaps */
+
   while (b_elt)
     {
       if (!a_elt || b_elt->indx < a_elt->indx)
@@ -1209,6 +1751,10 @@ bitmap_ior_into (bitmap a, bitmap b)
   gcc_assert (!a->current == !a->first);
   if (a->current)
     a->indx = a->current->indx;
+  /* APPLE LOCAL begin dense bitmaps */
+  if (changed)
+    bitmap_maybe_densify (a);
+  /* APPLE LOCAL end dense bitmaps */
   return changed;
 }
 
@@ -1229,6 +1775,14 @@ bitmap_xor (bitmap dst, bitmap a, bitmap b)
       return;
     }
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (dst, a, b))
+    {
+      bitmap_dense_op (dst, a, b, BITMAP_DENSE_XOR);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
   while (a_elt || b_elt)
     {
       if (a_elt && b_elt && a_elt->indx == b_elt->indx)
@@ -1302,6 +1856,14 @@ bitmap_xor_into (bitmap a, bitmap b)
       return;
     }
 
+  /* APPLE LOCAL begin dense bitmaps */
+  if (bitmap_use_dense_p (a, b, NULL))
+    {
+      bitmap_dense_op (a, a, b, BITMAP_DENSE_XOR);
+      return;
+    }
+  /* APPLE LOCAL end dense bitmaps */
+
   while (b_elt)
     {
       if (!a_elt || b_elt->indx < a_elt->indx)
@@ -1465,6 +2027,11 @@ debug_bitmap_file (FILE *file, bitmap head)
 
   fprintf (file, "\nfirst = %p current = %p indx = %u\n",
 	   (void *) head->first, (void *) head->current, head->indx);
+  /* APPLE LOCAL begin dense bitmaps */
+  if (head->dense)
+    fprintf (file, "dense = %p dense_indx = %u dense_nelts = %u\n",
+	     (void *) head->dense, head->dense_indx, head->dense_nelts);
+  /* APPLE LOCAL end dense bitmaps */
 
   for (ptr = head->first; ptr; ptr = ptr->next)
     {
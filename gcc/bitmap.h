@@ -40,11 +40,35 @@ typedef unsigned long BITMAP_WORD;
 
 #define BITMAP_ELEMENT_ALL_BITS (BITMAP_ELEMENT_WORDS * BITMAP_WORD_BITS)
 
+/* APPLE LOCAL begin dense bitmaps */
+/* An obstack bitmap switches to the dense representation once it has at
+   least BITMAP_DENSE_MIN_ELTS elements and they fill at least
+   BITMAP_DENSE_FILL percent of the index range they span.  It goes back
+   to the linked list when the fill drops below half of that.  */
+
+#ifndef BITMAP_DENSE_MIN_ELTS
+#define BITMAP_DENSE_MIN_ELTS 8
+#endif
+
+#ifndef BITMAP_DENSE_FILL
+#define BITMAP_DENSE_FILL 50
+#endif
+
+/* Number of size classes of dense element arrays kept on the freelists
+   of a bitmap obstack.  Class N holds arrays of 1 << N elements.  */
+
+#define BITMAP_DENSE_BUCKETS 32
+/* APPLE LOCAL end dense bitmaps */
+
 /* Obstack for allocating bitmaps and elements from.  */
 typedef struct bitmap_obstack GTY (())
 {
   struct bitmap_element_def *elements;
   struct bitmap_head_def *heads;
+  /* APPLE LOCAL begin dense bitmaps */
+  /* Freelists of dense element arrays, by size class.  */
+  struct bitmap_element_def * GTY ((skip)) dense_free[BITMAP_DENSE_BUCKETS];
+  /* APPLE LOCAL end dense bitmaps */
   struct obstack GTY ((skip)) obstack;
 } bitmap_obstack;
 
@@ -68,11 +92,26 @@ typedef struct bitmap_element_def GTY(())
   BITMAP_WORD bits[BITMAP_ELEMENT_WORDS]; /* Bits that are set.  */
 } bitmap_element;
 
-/* Head of bitmap linked list.  */
+/* Head of bitmap linked list.
+
+   A bitmap allocated on a bitmap obstack may also be in dense form.  Its
+   elements then live in the array DENSE, which holds one element for
+   every index from DENSE_INDX up to DENSE_INDX + DENSE_NELTS - 1.  The
+   elements of the array with any bit set are still chained together
+   from FIRST in index order, so everything that walks the list (the
+   iterators in particular) works unchanged, while the set operations
+   can work on the array by index instead of chasing pointers.  Array
+   elements that are not on the list have all their bits clear.  */
 typedef struct bitmap_head_def GTY(()) {
   bitmap_element *first;	/* First element in linked list.  */
   bitmap_element *current;	/* Last element looked at.  */
   unsigned int indx;		/* Index of last element looked at.  */
+  /* APPLE LOCAL begin dense bitmaps */
+  unsigned int dense_indx;	/* Index of the first element of DENSE.  */
+  unsigned int dense_nelts;	/* Number of elements in DENSE.  */
+  bitmap_element * GTY((skip)) dense; /* Element array, or NULL if the
+				   bitmap is a plain linked list.  */
+  /* APPLE LOCAL end dense bitmaps */
   bitmap_obstack *obstack;	/* Obstack to allocate elements from.
 				   If NULL, then use ggc_alloc.  */
 } bitmap_head;
@@ -101,6 +140,11 @@ extern bool bitmap_intersect_compl_p (bitmap, bitmap);
 /* True if MAP is an empty bitmap.  */
 #define bitmap_empty_p(MAP) (!(MAP)->first)
 
+/* APPLE LOCAL begin dense bitmaps */
+/* True if MAP is in dense form.  */
+#define bitmap_dense_p(MAP) ((MAP)->dense != NULL)
+/* APPLE LOCAL end dense bitmaps */
+
 /* Count the number of bits set in the bitmap.  */
 extern unsigned long bitmap_count_bits (bitmap);
 
@@ -152,6 +196,8 @@ static inline void
 bitmap_initialize (bitmap head, bitmap_obstack *obstack)
 {
   head->first = head->current = NULL;
+  /* APPLE LOCAL dense bitmaps */
+  head->dense = NULL;
   head->obstack = obstack;
 }
 
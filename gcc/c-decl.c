@@ -709,6 +709,13 @@ pop_scope (void)
 
   bool functionbody = scope->function_body;
   bool keep = functionbody || scope->keep || scope->bindings;
+  /* APPLE LOCAL begin PCH sharing */
+  /* The file and external scopes only go at the end of a translation
+     unit, when there is little use for the freelist.  Their bindings
+     often came from a PCH, and clearing them would give this compiler
+     its own copy of every page holding one.  */
+  bool reuse_bindings = scope != file_scope && scope != external_scope;
+  /* APPLE LOCAL end PCH sharing */
 
   c_end_vm_scope (scope->depth);
 
@@ -754,7 +761,9 @@ pop_scope (void)
     context = block;
 
   /* Clear all bindings in this scope.  */
-  for (b = scope->bindings; b; b = free_binding_and_advance (b))
+  /* APPLE LOCAL PCH sharing */
+  for (b = scope->bindings; b;
+       b = reuse_bindings ? free_binding_and_advance (b) : b->prev)
     {
       p = b->decl;
       switch (TREE_CODE (p))
@@ -41,6 +41,8 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 #include "mkdeps.h"
 /* APPLE LOCAL iframework for 4.3 4094959 */
 #include "tm_p.h"
+/* APPLE LOCAL compile server prefix PCH */
+#include "compile-server.h"
 
 #ifndef DOLLARS_IN_IDENTIFIERS
 # define DOLLARS_IN_IDENTIFIERS true
@@ -1093,6 +1095,18 @@ c_common_post_options (const char **pfilename)
   if (cpp_opts->deps.style == DEPS_NONE)
     check_deps_environment_vars ();
 
+  /* APPLE LOCAL begin compile server prefix PCH */
+  /* The compile server has precompiled the first -include file.  The
+     dependencies saved with it stand in for the ones reading the
+     header would have added.  */
+  if (compile_server_prefix_pch)
+    {
+      cpp_opts->next_pch = compile_server_prefix_pch;
+      if (cpp_opts->deps.style != DEPS_NONE)
+	cpp_opts->restore_pch_deps = true;
+    }
+  /* APPLE LOCAL end compile server prefix PCH */
+
   handle_deferred_opts ();
 
   sanitize_cpp_opts ();
@@ -211,7 +211,8 @@ c_common_write_pch (void)
   if (fseek (asm_out_file, 0, SEEK_END) != 0)
     fatal_error ("can%'t seek in %s: %m", asm_file_name);
 
-  gt_pch_save (pch_outfile);
+  /* APPLE LOCAL chained PCH */
+  gt_pch_save (pch_outfile, flag_pch_chain);
   cpp_write_pch_state (parse_in, pch_outfile);
 
   if (fseek (pch_outfile, 0, SEEK_SET) != 0
@@ -350,8 +351,36 @@ c_common_valid_pch (cpp_reader *pfile, const char *name, int fd)
   result = cpp_valid_state (pfile, name, fd);
   if (result == -1)
     return 2;
-  else
-    return result == 0;
+
+  /* APPLE LOCAL begin chained PCH */
+  /* Check that the PCH files this one was built on are still there
+     and unchanged.  */
+  if (result == 0)
+    {
+      struct c_pch_header h;
+      off_t here = lseek (fd, 0, SEEK_CUR);
+      char *base;
+
+      if (here == -1
+	  || read (fd, &h, sizeof (h)) != sizeof (h)
+	  || lseek (fd, h.asm_size, SEEK_CUR) == -1)
+	fatal_error ("can%'t read %s: %m", name);
+      base = gt_pch_chain_invalid (fd);
+      if (lseek (fd, here, SEEK_SET) == -1)
+	fatal_error ("can%'t read %s: %m", name);
+      if (base != NULL)
+	{
+	  if (cpp_get_options (pfile)->warn_invalid_pch)
+	    cpp_error (pfile, CPP_DL_WARNING,
+		       "%s: built on %s, which is missing or has changed",
+		       name, base);
+	  free (base);
+	  return 2;
+	}
+    }
+  /* APPLE LOCAL end chained PCH */
+
+  return result == 0;
 }
 
 /* If non-NULL, this function is called after a precompile header file
@@ -416,7 +445,8 @@ c_common_read_pch (cpp_reader *pfile, const char *name,
 
   cpp_prepare_state (pfile, &smd);
 
-  gt_pch_restore (f);
+  /* APPLE LOCAL chained PCH */
+  gt_pch_restore (f, name);
 
   if (cpp_read_state (pfile, name, f, smd) != 0)
     return;
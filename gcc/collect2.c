@@ -46,6 +46,16 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 #include "obstack.h"
 #include "intl.h"
 #include "version.h"
+/* APPLE LOCAL resource log */
+#include "resource-log.h"
+/* APPLE LOCAL begin collect2 ELF scan */
+#ifdef HAVE_MMAP_FILE
+#include <sys/mman.h>
+#ifndef MAP_FAILED
+#define MAP_FAILED ((void *)-1)
+#endif
+#endif
+/* APPLE LOCAL end collect2 ELF scan */
 
 /* On certain systems, we have code that works by scanning the object file
    directly.  But this code uses system-specific header files and library
@@ -1495,6 +1505,18 @@ collect_wait (const char *prog, struct pex_obj *pex)
 
   if (!pex_get_status (pex, 1, &status))
     fatal_perror ("can't get program status");
+  /* APPLE LOCAL begin resource log */
+  if (resource_log_p ())
+    {
+      struct pex_time usage;
+      const char *argv[2];
+
+      argv[0] = prog;
+      argv[1] = NULL;
+      if (pex_get_times (pex, 1, &usage))
+	resource_log (argv, NULL, status, &usage);
+    }
+  /* APPLE LOCAL end resource log */
   pex_free (pex);
 
   if (status)
@@ -1561,7 +1583,8 @@ collect_execute (const char *prog, char **argv, const char *outname,
   if (argv[0] == 0)
     fatal ("cannot find '%s'", prog);
 
-  pex = pex_init (0, "collect2", NULL);
+  /* APPLE LOCAL resource log */
+  pex = pex_init (resource_log_p () ? PEX_RECORD_TIMES : 0, "collect2", NULL);
   if (pex == NULL)
     fatal_perror ("pex_init failed");
 
@@ -1998,6 +2021,277 @@ write_aix_file (FILE *stream, struct id *list)
 
 #ifdef OBJECT_FORMAT_NONE
 
+/* APPLE LOCAL begin collect2 ELF scan */
+/* Add NAME, found in the symbol table of PROG_NAME on pass WHICH_PASS,
+   to the appropriate list if it is a constructor or destructor.
+   Return false if it is neither.  */
+
+static bool
+note_ctor_dtor (const char *name, const char *prog_name,
+		enum pass which_pass)
+{
+  switch (is_ctor_dtor (name))
+    {
+    case 1:
+      if (which_pass != PASS_LIB)
+	add_to_list (&constructors, name);
+      break;
+
+    case 2:
+      if (which_pass != PASS_LIB)
+	add_to_list (&destructors, name);
+      break;
+
+    case 3:
+      if (which_pass != PASS_LIB)
+	fatal ("init function found in object %s", prog_name);
+#ifndef LD_INIT_SWITCH
+      add_to_list (&constructors, name);
+#endif
+      break;
+
+    case 4:
+      if (which_pass != PASS_LIB)
+	fatal ("fini function found in object %s", prog_name);
+#ifndef LD_FINI_SWITCH
+      add_to_list (&destructors, name);
+#endif
+      break;
+
+    case 5:
+      if (which_pass != PASS_LIB)
+	add_to_list (&frame_tables, name);
+      break;
+
+    default:		/* not a constructor or destructor */
+      return false;
+    }
+  return true;
+}
+
+#ifdef HAVE_MMAP_FILE
+
+/* Scanning the symbol table of an ELF file ourselves is much cheaper
+   than running nm on it and parsing the output, which matters when
+   linking a large program.  Only the parts of the format needed for
+   that are described here, for both classes and byte orders, so this
+   works for cross linkers too.  */
+
+#define ELF_CLASS32 1
+#define ELF_CLASS64 2
+#define ELF_DATA2LSB 1
+#define ELF_DATA2MSB 2
+#define ELF_SHT_SYMTAB 2
+#define ELF_SHN_UNDEF 0
+#define ELF_STT_SECTION 3
+#define ELF_STT_FILE 4
+#define ELF_STB_WEAK 2
+
+/* A mapped ELF file.  */
+
+struct elf_file
+{
+  const unsigned char *data;
+  size_t size;
+  bool is64;
+  bool big_endian;
+};
+
+/* A symbol to be looked at, in the order nm -n would print it.  */
+
+struct elf_symbol
+{
+  unsigned HOST_WIDEST_INT value;
+  const char *name;
+  bool undefined;
+};
+
+/* Read the SIZE-byte number at offset OFF in ELF.  The caller has
+   checked that it is inside the file.  */
+
+static unsigned HOST_WIDEST_INT
+elf_read (const struct elf_file *elf, size_t off, int size)
+{
+  const unsigned char *p = elf->data + off;
+  unsigned HOST_WIDEST_INT v = 0;
+  int i;
+
+  for (i = 0; i < size; i++)
+    v |= ((unsigned HOST_WIDEST_INT) p[elf->big_endian ? size - 1 - i : i]
+	  << (8 * i));
+  return v;
+}
+
+/* Return true if the range of LEN bytes at OFF is inside ELF.  */
+
+static bool
+elf_in_file (const struct elf_file *elf, unsigned HOST_WIDEST_INT off,
+	     unsigned HOST_WIDEST_INT len)
+{
+  return off <= elf->size && len <= elf->size - off;
+}
+
+/* qsort comparison putting undefined symbols first and the rest in
+   order of address and then name, as nm -n does.  */
+
+static int
+elf_symbol_cmp (const void *xp, const void *yp)
+{
+  const struct elf_symbol *x = (const struct elf_symbol *) xp;
+  const struct elf_symbol *y = (const struct elf_symbol *) yp;
+
+  if (x->undefined != y->undefined)
+    return x->undefined ? -1 : 1;
+  if (!x->undefined && x->value != y->value)
+    return x->value < y->value ? -1 : 1;
+  return strcmp (x->name, y->name);
+}
+
+/* Scan the symbol table of ELF, which is PROG_NAME, for constructors
+   and destructors as scan_prog_file would with nm.  Return false if
+   it has no symbol table we can read.  */
+
+static bool
+scan_elf_symtab (const struct elf_file *elf, const char *prog_name,
+		 enum pass which_pass)
+{
+  unsigned HOST_WIDEST_INT shoff, shnum, shentsize;
+  unsigned HOST_WIDEST_INT symoff = 0, symsize = 0, syment = 0;
+  unsigned HOST_WIDEST_INT stroff = 0, strsize = 0;
+  unsigned HOST_WIDEST_INT i, n, sh;
+  struct elf_symbol *syms;
+  size_t nsyms = 0;
+  bool found = false;
+
+  shoff = elf_read (elf, elf->is64 ? 40 : 32, elf->is64 ? 8 : 4);
+  shentsize = elf_read (elf, elf->is64 ? 58 : 46, 2);
+  shnum = elf_read (elf, elf->is64 ? 60 : 48, 2);
+  if (shoff == 0 || shentsize < (elf->is64 ? 64U : 40U)
+      || !elf_in_file (elf, shoff, shentsize))
+    return false;
+  /* An extended section count lives in the first section header.  */
+  if (shnum == 0)
+    shnum = elf_read (elf, shoff + (elf->is64 ? 32 : 20), elf->is64 ? 8 : 4);
+  if (shnum > elf->size / shentsize
+      || !elf_in_file (elf, shoff, shnum * shentsize))
+    return false;
+
+  for (i = 0; i < shnum && !found; i++)
+    {
+      sh = shoff + i * shentsize;
+      if (elf_read (elf, sh + 4, 4) == ELF_SHT_SYMTAB)
+	{
+	  unsigned HOST_WIDEST_INT link, str;
+
+	  symoff = elf_read (elf, sh + (elf->is64 ? 24 : 16), elf->is64 ? 8 : 4);
+	  symsize = elf_read (elf, sh + (elf->is64 ? 32 : 20), elf->is64 ? 8 : 4);
+	  syment = elf_read (elf, sh + (elf->is64 ? 56 : 36), elf->is64 ? 8 : 4);
+	  link = elf_read (elf, sh + (elf->is64 ? 40 : 24), 4);
+	  if (link >= shnum)
+	    return false;
+	  str = shoff + link * shentsize;
+	  stroff = elf_read (elf, str + (elf->is64 ? 24 : 16), elf->is64 ? 8 : 4);
+	  strsize = elf_read (elf, str + (elf->is64 ? 32 : 20), elf->is64 ? 8 : 4);
+	  found = true;
+	}
+    }
+  if (!found
+      || syment < (elf->is64 ? 24U : 16U)
+      || !elf_in_file (elf, symoff, symsize)
+      || !elf_in_file (elf, stroff, strsize)
+      || strsize == 0
+      || elf->data[stroff + strsize - 1] != '\0')
+    return false;
+
+  n = symsize / syment;
+  syms = XNEWVEC (struct elf_symbol, n);
+  /* The first symbol is always the null one.  */
+  for (i = 1; i < n; i++)
+    {
+      size_t sym = symoff + i * syment;
+      unsigned HOST_WIDEST_INT name, value;
+      int info, shndx;
+
+      name = elf_read (elf, sym, 4);
+      info = elf->data[sym + (elf->is64 ? 4 : 12)];
+      shndx = elf_read (elf, sym + (elf->is64 ? 6 : 14), 2);
+      value = elf_read (elf, sym + (elf->is64 ? 8 : 4), elf->is64 ? 8 : 4);
+
+      /* nm leaves out section and file symbols, and the scan below
+	 would skip names it prints as "U".  */
+      if ((info & 0xf) == ELF_STT_SECTION || (info & 0xf) == ELF_STT_FILE
+	  || name >= strsize
+	  || (shndx == ELF_SHN_UNDEF && (info >> 4) != ELF_STB_WEAK))
+	continue;
+
+      syms[nsyms].name = (const char *) elf->data + stroff + name;
+      syms[nsyms].value = value;
+      syms[nsyms].undefined = shndx == ELF_SHN_UNDEF;
+      nsyms++;
+    }
+
+  /* The order matters for constructors of the same priority.  */
+  qsort (syms, nsyms, sizeof (struct elf_symbol), elf_symbol_cmp);
+
+  if (debug)
+    fprintf (stderr, "\nsymbol table with constructors/destructors.\n");
+
+  for (i = 0; i < nsyms; i++)
+    if (syms[i].name[0] == '_'
+	&& note_ctor_dtor (syms[i].name, prog_name, which_pass)
+	&& debug)
+      fprintf (stderr, "\t%s\n", syms[i].name);
+
+  if (debug)
+    fprintf (stderr, "\n");
+
+  free (syms);
+  return true;
+}
+
+/* Scan PROG_NAME for constructors and destructors without running nm,
+   if it is an ELF file with a symbol table.  Return false if the
+   caller should use nm after all.  */
+
+static bool
+scan_elf_file (const char *prog_name, enum pass which_pass)
+{
+  struct elf_file elf;
+  struct stat st;
+  void *map;
+  bool ok = false;
+  int fd;
+
+  fd = open (prog_name, O_RDONLY);
+  if (fd < 0)
+    return false;
+  if (fstat (fd, &st) != 0 || st.st_size < 64
+      || (off_t) (size_t) st.st_size != st.st_size)
+    {
+      close (fd);
+      return false;
+    }
+  map = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close (fd);
+  if (map == (void *) MAP_FAILED)
+    return false;
+
+  elf.data = (const unsigned char *) map;
+  elf.size = st.st_size;
+  elf.is64 = elf.data[4] == ELF_CLASS64;
+  elf.big_endian = elf.data[5] == ELF_DATA2MSB;
+  if (memcmp (elf.data, "\177ELF", 4) == 0
+      && (elf.data[4] == ELF_CLASS32 || elf.data[4] == ELF_CLASS64)
+      && (elf.data[5] == ELF_DATA2LSB || elf.data[5] == ELF_DATA2MSB))
+    ok = scan_elf_symtab (&elf, prog_name, which_pass);
+
+  munmap (map, st.st_size);
+  return ok;
+}
+
+#endif /* HAVE_MMAP_FILE */
+/* APPLE LOCAL end collect2 ELF scan */
+
 /* Generic version to scan the name list of the loaded program for
    the symbols g++ uses for static constructors and destructors.
 
@@ -2026,6 +2320,13 @@ scan_prog_file (const char *prog_name, enum pass which_pass)
   if (which_pass == PASS_SECOND)
     return;
 
+  /* APPLE LOCAL begin collect2 ELF scan */
+#ifdef HAVE_MMAP_FILE
+  if (scan_elf_file (prog_name, which_pass))
+    return;
+#endif
+  /* APPLE LOCAL end collect2 ELF scan */
+
   /* If we do not have an `nm', complain.  */
   if (nm_file_name == 0)
     fatal ("cannot find 'nm'");
@@ -2107,42 +2408,9 @@ scan_prog_file (const char *prog_name, enum pass which_pass)
 
 
       *end = '\0';
-      switch (is_ctor_dtor (name))
-	{
-	case 1:
-	  if (which_pass != PASS_LIB)
-	    add_to_list (&constructors, name);
-	  break;
-
-	case 2:
-	  if (which_pass != PASS_LIB)
-	    add_to_list (&destructors, name);
-	  break;
-
-	case 3:
-	  if (which_pass != PASS_LIB)
-	    fatal ("init function found in object %s", prog_name);
-#ifndef LD_INIT_SWITCH
-	  add_to_list (&constructors, name);
-#endif
-	  break;
-
-	case 4:
-	  if (which_pass != PASS_LIB)
-	    fatal ("fini function found in object %s", prog_name);
-#ifndef LD_FINI_SWITCH
-	  add_to_list (&destructors, name);
-#endif
-	  break;
-
-	case 5:
-	  if (which_pass != PASS_LIB)
-	    add_to_list (&frame_tables, name);
-	  break;
-
-	default:		/* not a constructor or destructor */
-	  continue;
-	}
+      /* APPLE LOCAL collect2 ELF scan */
+      if (!note_ctor_dtor (name, prog_name, which_pass))
+	continue;
 
       if (debug)
 	fprintf (stderr, "\t%s\n", buf);
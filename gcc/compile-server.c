@@ -0,0 +1,1104 @@
+/* APPLE LOCAL file compile server */
+/* Persistent compiler proper, forking a child per compilation.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 2, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING.  If not, write to the Free
+Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+02110-1301, USA.  */
+
+/* The server pays for exec, dynamic linking and general_init once;
+   every compilation is a fork of it that starts at option decoding.
+   Parsing the prefix header most compilations in a project start with
+   is paid once too: the server precompiles it in a child of its own,
+   and the compilations after that load the result.
+   The protocol is described in compile-server.h.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+#include "toplev.h"
+#include "opts.h"
+#include "md5.h"
+#include "compile-server.h"
+#include "intl.h"
+
+const char *compile_server_prefix_pch;
+
+#if defined (HAVE_SYS_SOCKET_H) && defined (HAVE_SYS_UN_H) \
+    && defined (HAVE_WORKING_FORK)
+
+#include <signal.h>
+#include <poll.h>
+#include <dirent.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
+extern char **environ;
+
+/* A request, taken apart.  The strings point into its buffer.  */
+struct server_request
+{
+  const char *cwd;
+  mode_t mask;
+  unsigned int argc;
+  const char **argv;
+  char **env;
+};
+
+/* A compilation in progress: the child doing it and the connection
+   its status goes back on.  */
+struct server_job
+{
+  pid_t pid;
+  int fd;
+};
+
+static struct server_job *jobs;
+static int n_jobs, jobs_alloc;
+
+/* Written to by the SIGCHLD handler so that poll wakes up.  */
+static int child_pipe[2];
+
+/* The executable this server was started from, to notice it being
+   rebuilt.  */
+static struct stat self_stat;
+
+/* The directory precompiled prefix headers are kept in, or NULL if
+   there is none.  */
+static char *pch_dir;
+
+/* A prefix header being precompiled by the process PID into the files
+   in PCH_DIR whose names start with KEY.  */
+struct pch_build
+{
+  pid_t pid;
+  char *key;
+};
+
+static struct pch_build *builds;
+static int n_builds, builds_alloc;
+
+static void
+sigchld_handler (int sig ATTRIBUTE_UNUSED)
+{
+  int saved_errno = errno;
+  char c = 0;
+
+  if (write (child_pipe[1], &c, 1) < 0)
+    {
+      /* The pipe is full, so poll will wake up anyway.  */
+    }
+  errno = saved_errno;
+}
+
+/* Send STATUS back on FD and close it.  */
+
+static void
+send_status (int fd, int status)
+{
+  if (write (fd, &status, sizeof (status)) < 0)
+    {
+      /* The driver has gone, and there is nobody to tell.  */
+    }
+  close (fd);
+}
+
+/* Return true if the executable at PROG is no longer the one this
+   server is running.  */
+
+static bool
+self_changed_p (const char *prog)
+{
+  struct stat st;
+
+  return (stat (prog, &st) != 0
+	  || st.st_ino != self_stat.st_ino
+	  || st.st_dev != self_stat.st_dev
+	  || st.st_size != self_stat.st_size
+	  || st.st_mtime != self_stat.st_mtime);
+}
+
+/* Return the next string in the request [*P, END), advancing *P past
+   it, or NULL if there is no complete one.  */
+
+static const char *
+next_string (const char **p, const char *end)
+{
+  const char *s = *p, *nul;
+
+  if (s >= end || (nul = memchr (s, '\0', end - s)) == NULL)
+    return NULL;
+  *p = nul + 1;
+  return s;
+}
+
+/* Return true if [BUF, BUF + LEN) holds a whole request.  */
+
+static bool
+request_complete_p (const char *buf, size_t len)
+{
+  const char *p = buf, *end = buf + len;
+  const char *s;
+  long n, i;
+
+  for (i = 0; i < 4; i++)
+    if (next_string (&p, end) == NULL)
+      return false;
+  if ((s = next_string (&p, end)) == NULL)
+    return false;
+  for (n = atol (s), i = 0; i < n; i++)
+    if (next_string (&p, end) == NULL)
+      return false;
+  if ((s = next_string (&p, end)) == NULL)
+    return false;
+  for (n = atol (s), i = 0; i < n; i++)
+    if (next_string (&p, end) == NULL)
+      return false;
+  return true;
+}
+
+/* Read a request from connection FD into *BUF, *LEN bytes long, and
+   store the three descriptors sent along with it in FDS.  The driver
+   keeps the connection open for the status, so the request ends where
+   its strings do.  Return false if there is no whole request.  */
+
+static bool
+read_request (int fd, char **buf, size_t *len, int fds[3])
+{
+  size_t alloc = 4096, used;
+  char *p = XNEWVEC (char, alloc);
+  union
+  {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE (3 * sizeof (int))];
+  } control;
+  struct msghdr msg;
+  struct iovec iov;
+  struct cmsghdr *cmsg;
+  ssize_t n;
+
+  memset (&msg, 0, sizeof (msg));
+  iov.iov_base = p;
+  iov.iov_len = alloc;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+
+  do
+    n = recvmsg (fd, &msg, 0);
+  while (n < 0 && errno == EINTR);
+  cmsg = n > 0 ? CMSG_FIRSTHDR (&msg) : NULL;
+  if (cmsg == NULL
+      || cmsg->cmsg_level != SOL_SOCKET
+      || cmsg->cmsg_type != SCM_RIGHTS
+      || cmsg->cmsg_len != CMSG_LEN (3 * sizeof (int)))
+    {
+      free (p);
+      return false;
+    }
+  memcpy (fds, CMSG_DATA (cmsg), 3 * sizeof (int));
+  used = n;
+
+  while (!request_complete_p (p, used))
+    {
+      if (used == alloc)
+	{
+	  alloc *= 2;
+	  p = XRESIZEVEC (char, p, alloc);
+	}
+      n = read (fd, p + used, alloc - used);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	{
+	  close (fds[0]);
+	  close (fds[1]);
+	  close (fds[2]);
+	  free (p);
+	  return false;
+	}
+      used += n;
+    }
+
+  *buf = p;
+  *len = used;
+  return true;
+}
+
+/* Take apart the request in BUF, which is LEN bytes long, into REQ.  */
+
+static void
+parse_request (const char *buf, size_t len, struct server_request *req)
+{
+  const char *p = buf, *end = buf + len;
+  const char *s;
+  unsigned int envc, i;
+
+  next_string (&p, end);
+  next_string (&p, end);
+  req->cwd = next_string (&p, end);
+  req->mask = strtol (next_string (&p, end), NULL, 8);
+  req->argc = atoi (next_string (&p, end));
+  req->argv = XNEWVEC (const char *, req->argc + 1);
+  for (i = 0; i < req->argc; i++)
+    req->argv[i] = next_string (&p, end);
+  req->argv[req->argc] = NULL;
+  s = next_string (&p, end);
+  envc = s ? atoi (s) : 0;
+  req->env = XNEWVEC (char *, envc + 1);
+  for (i = 0; i < envc; i++)
+    req->env[i] = (char *) next_string (&p, end);
+  req->env[envc] = NULL;
+}
+
+/* Read the whole of the file NAME into a NUL-terminated buffer, and
+   store its length in *LEN.  Return NULL if it cannot be read.  */
+
+static char *
+read_whole_file (const char *name, size_t *len)
+{
+  int fd = open (name, O_RDONLY);
+  struct stat st;
+  char *buf;
+  ssize_t n = -1;
+
+  if (fd < 0)
+    return NULL;
+  if (fstat (fd, &st) == 0)
+    {
+      buf = XNEWVEC (char, st.st_size + 1);
+      n = read (fd, buf, st.st_size);
+      if (n != st.st_size)
+	{
+	  free (buf);
+	  n = -1;
+	}
+    }
+  close (fd);
+  if (n < 0)
+    return NULL;
+  buf[n] = '\0';
+  *len = n;
+  return buf;
+}
+
+/* Switches that make a compilation something other than turning one
+   source file into assembly, or that make it write files named after
+   its input.  A compilation with any of them is left alone.  */
+static const char *const unsuitable_switches[] = {
+  "-E", "-M", "-MM", "-fsyntax-only", "-fpreprocessed", "--output-pch=",
+  "-imacros", "-d", "-aux-info", "-ftest-coverage", "-fbranch-probabilities"
+};
+
+/* Switches that name the compilation's own outputs.  They make no
+   difference to what its prefix header compiles to, except that
+   whether -MD or -MMD is given decides which dependencies it keeps.  */
+static const char *const output_switches[] = {
+  "-o", "-dumpbase", "-auxbase", "-auxbase-strip",
+  "-MD", "-MMD", "-MF", "-MT", "-MQ"
+};
+
+/* Environment variables that can change what a header compiles to.  */
+static const char *const prefix_env[] = {
+  "CPATH", "C_INCLUDE_PATH", "CPLUS_INCLUDE_PATH", "OBJC_INCLUDE_PATH",
+  "OBJCPLUS_INCLUDE_PATH", "GCC_EXEC_PREFIX", "PWD", "LANG", "LC_ALL",
+  "LC_CTYPE", "RC_DEBUG_OPTIONS", "RC_FORCE_SSE3",
+  "MACOSX_DEPLOYMENT_TARGET", "IPHONEOS_DEPLOYMENT_TARGET"
+};
+
+/* Return true if NAME is one of the N strings in TABLE.  */
+
+static bool
+name_in_p (const char *name, const char *const *table, size_t n)
+{
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    if (strcmp (name, table[i]) == 0)
+      return true;
+  return false;
+}
+
+/* Return the number of arguments, 1 or 2, that the switch ARG takes up
+   on the command line, and store in *NAME the switch as the option
+   table spells it, without any joined argument.  */
+
+static unsigned int
+switch_args (const char *arg, const char **name)
+{
+  size_t i = find_opt (arg + 1, CL_COMMON | CL_TARGET);
+  const struct cl_option *option;
+
+  *name = arg;
+  if (i == cl_options_count)
+    return 1;
+  option = &cl_options[i];
+  *name = option->opt_text;
+  if ((option->flags & CL_JOINED)
+      && (arg[option->opt_len + 1] != '\0'
+	  || (option->flags & CL_MISSING_OK)))
+    return 1;
+  return (option->flags & CL_SEPARATE) ? 2 : 1;
+}
+
+/* If the compilation REQ has a prefix header that can be precompiled
+   on its own, return the index of its name in REQ->argv and store in
+   KEY a name for it and everything else that decides what it compiles
+   to.  Otherwise return 0.  The prefix header is the first -include
+   file, when the compiler finds it in its current directory or by an
+   absolute name, and it has no precompiled header of its own.  */
+
+static unsigned int
+prefix_header (const struct server_request *req, char key[33])
+{
+  struct md5_ctx ctx;
+  unsigned char digest[16];
+  unsigned int i, j, n, header = 0, input = 0;
+  const char *name;
+  char *path, *gch;
+  struct stat st;
+  bool ok;
+
+  md5_init_ctx (&ctx);
+  md5_process_bytes (COMPILE_SERVER_MAGIC, sizeof (COMPILE_SERVER_MAGIC),
+		     &ctx);
+  md5_process_bytes (&self_stat.st_dev, sizeof (self_stat.st_dev), &ctx);
+  md5_process_bytes (&self_stat.st_ino, sizeof (self_stat.st_ino), &ctx);
+  md5_process_bytes (&self_stat.st_size, sizeof (self_stat.st_size), &ctx);
+  md5_process_bytes (&self_stat.st_mtime, sizeof (self_stat.st_mtime),
+		     &ctx);
+  md5_process_bytes (req->cwd, strlen (req->cwd) + 1, &ctx);
+
+  for (i = 1; i < req->argc; i += n)
+    {
+      const char *arg = req->argv[i];
+
+      n = 1;
+      if (arg[0] != '-' || arg[1] == '\0')
+	{
+	  /* Only one named input file.  */
+	  if (input || arg[0] == '-')
+	    return 0;
+	  input = i;
+	  continue;
+	}
+
+      n = switch_args (arg, &name);
+      if (i + n > req->argc
+	  || name_in_p (name, unsuitable_switches,
+			ARRAY_SIZE (unsuitable_switches))
+	  || strncmp (name, "-fdump-", 7) == 0
+	  || strncmp (name, "-fprofile-", 10) == 0)
+	return 0;
+
+      if (strcmp (name, "-include") == 0 && !header)
+	{
+	  if (n != 2)
+	    return 0;
+	  header = i + 1;
+	}
+
+      if (name_in_p (name, output_switches, ARRAY_SIZE (output_switches)))
+	{
+	  if (strcmp (name, "-MD") == 0 || strcmp (name, "-MMD") == 0)
+	    md5_process_bytes (name, strlen (name) + 1, &ctx);
+	  continue;
+	}
+      for (j = i; j < i + n; j++)
+	md5_process_bytes (req->argv[j], strlen (req->argv[j]) + 1, &ctx);
+    }
+  if (!header || !input)
+    return 0;
+
+  for (i = 0; req->env[i]; i++)
+    {
+      const char *eq = strchr (req->env[i], '=');
+      size_t len = eq ? (size_t) (eq - req->env[i]) : 0;
+
+      /* These turn on dependency output that -MD cannot stand in for
+	 when the header is precompiled.  */
+      if ((len == 19 && strncmp (req->env[i], "DEPENDENCIES_OUTPUT", 19) == 0)
+	  || (len == 19
+	      && strncmp (req->env[i], "SUNPRO_DEPENDENCIES", 19) == 0))
+	return 0;
+      for (j = 0; j < ARRAY_SIZE (prefix_env); j++)
+	if (strlen (prefix_env[j]) == len
+	    && strncmp (req->env[i], prefix_env[j], len) == 0)
+	  md5_process_bytes (req->env[i], strlen (req->env[i]) + 1, &ctx);
+    }
+
+  name = req->argv[header];
+  if (IS_ABSOLUTE_PATH (name))
+    path = xstrdup (name);
+  else
+    path = concat (req->cwd, "/", name, NULL);
+  gch = concat (path, ".gch", NULL);
+  ok = (stat (path, &st) == 0 && S_ISREG (st.st_mode)
+	&& stat (gch, &st) != 0);
+  free (path);
+  free (gch);
+  if (!ok)
+    return 0;
+
+  md5_finish_ctx (&ctx, digest);
+  for (i = 0; i < 16; i++)
+    sprintf (key + 2 * i, "%02x", digest[i]);
+  return header;
+}
+
+/* Write to F a line "MTIME SIZE NAME" for each file listed in the
+   dependency file DEPS, with names relative to CWD made absolute.
+   Return false if DEPS cannot be read or a file it lists is gone.  */
+
+static bool
+write_manifest (FILE *f, const char *deps, const char *cwd)
+{
+  size_t len;
+  char *buf = read_whole_file (deps, &len);
+  char *p, *name, *path, *q;
+  struct stat st;
+  bool ok = true;
+
+  if (buf == NULL)
+    return false;
+
+  /* Skip the target; the dependencies run to the end of the first
+     line not continued with a backslash.  */
+  for (p = buf; *p && *p != ':'; p++)
+    if (*p == '\\' && p[1])
+      p++;
+  if (*p == ':')
+    p++;
+  while (ok)
+    {
+      while (*p == ' ' || *p == '\t' || (*p == '\\' && p[1] == '\n'))
+	p += *p == '\\' ? 2 : 1;
+      if (*p == '\0' || *p == '\n' || *p == '\r')
+	break;
+
+      /* Undo the quoting mkdeps does, in place.  */
+      for (name = q = p; *p && !ISSPACE (*p); p++)
+	{
+	  if (*p == '\\' && (p[1] == ' ' || p[1] == '\t' || p[1] == '#'))
+	    p++;
+	  else if (*p == '$' && p[1] == '$')
+	    p++;
+	  *q++ = *p;
+	}
+      if (*p)
+	p++;
+      *q = '\0';
+
+      path = IS_ABSOLUTE_PATH (name) ? name : concat (cwd, "/", name, NULL);
+      if (stat (path, &st) == 0)
+	fprintf (f, "%ld %ld %s\n", (long) st.st_mtime, (long) st.st_size,
+		 path);
+      else
+	ok = false;
+      if (path != name)
+	free (path);
+    }
+
+  free (buf);
+  return ok;
+}
+
+/* In the child precompiling the prefix header of REQ, at index HEADER
+   in its argv, into the files in PCH_DIR whose names start with BASE:
+   compile it with the options of REQ, less its -include files and
+   outputs, and exit.  */
+
+static void
+precompile_prefix (const struct server_request *req, unsigned int header,
+		   const char *base)
+{
+  const char **argv = XNEWVEC (const char *, req->argc + 8);
+  const char *deps = "-MD";
+  const char *name;
+  unsigned int i, j, n, argc = 0;
+  int fd;
+
+  argv[argc++] = req->argv[0];
+  for (i = 1; i < req->argc; i += n)
+    {
+      const char *arg = req->argv[i];
+
+      n = 1;
+      if (arg[0] != '-' || arg[1] == '\0')
+	continue;
+      n = switch_args (arg, &name);
+      if (strcmp (name, "-MMD") == 0)
+	deps = name;
+      if (strcmp (name, "-include") == 0
+	  || name_in_p (name, output_switches, ARRAY_SIZE (output_switches)))
+	continue;
+      for (j = i; j < i + n; j++)
+	argv[argc++] = req->argv[j];
+    }
+
+  /* Spell the header the way the preprocessor would have found it, so
+     that __FILE__ and the dependencies come out the same.  */
+  name = req->argv[header];
+  argv[argc++] = IS_ABSOLUTE_PATH (name) ? name : concat ("./", name, NULL);
+  argv[argc++] = "-o";
+  argv[argc++] = concat (base, ".s", NULL);
+  argv[argc++] = concat ("--output-pch=", base, ".tmp", NULL);
+  argv[argc++] = deps;
+  argv[argc++] = concat (base, ".d", NULL);
+  argv[argc] = NULL;
+
+  umask (req->mask);
+  environ = req->env;
+  fd = open ("/dev/null", O_RDWR);
+  dup2 (fd, 0);
+  dup2 (fd, 1);
+  close (fd);
+  /* Anything the header has to say is left to the compilations that
+     parse it; a header with diagnostics is not used precompiled.  */
+  name = concat (base, ".err", NULL);
+  fd = open (name, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0 || chdir (req->cwd) != 0)
+    exit (FATAL_EXIT_CODE);
+  dup2 (fd, 2);
+  close (fd);
+
+  exit (toplev_compile (argc, argv));
+}
+
+/* In the child the server forks to precompile the prefix header of
+   REQ, at index HEADER in its argv, into the files in PCH_DIR whose
+   names start with BASE: have a child of its own compile it, and make
+   BASE.dep list the files it was made from.  If it compiled cleanly,
+   BASE.gch is the header; if not, BASE.dep alone records that there
+   is no point in trying again until one of those files changes.  */
+
+static void
+build_prefix_pch (const struct server_request *req, unsigned int header,
+		  const char *base)
+{
+  char *gch = concat (base, ".gch", NULL);
+  char *tmp = concat (base, ".tmp", NULL);
+  char *dep = concat (base, ".dep", NULL);
+  char *new_dep = concat (base, ".new", NULL);
+  char *deps = concat (base, ".d", NULL);
+  char *err = concat (base, ".err", NULL);
+  char *asm_name = concat (base, ".s", NULL);
+  const char *name = req->argv[header];
+  struct stat st;
+  int status;
+  bool ok;
+  pid_t pid;
+  FILE *f;
+
+  pid = fork ();
+  if (pid == 0)
+    precompile_prefix (req, header, base);
+  ok = (pid > 0
+	&& waitpid (pid, &status, 0) == pid
+	&& WIFEXITED (status) && WEXITSTATUS (status) == SUCCESS_EXIT_CODE
+	&& stat (err, &st) == 0 && st.st_size == 0
+	&& stat (tmp, &st) == 0);
+
+  f = fopen (new_dep, "w");
+  if (f != NULL)
+    {
+      if (!write_manifest (f, deps, req->cwd))
+	{
+	  /* At least notice the header itself changing.  */
+	  if (!IS_ABSOLUTE_PATH (name))
+	    name = concat (req->cwd, "/", name, NULL);
+	  if (stat (name, &st) == 0)
+	    fprintf (f, "%ld %ld %s\n", (long) st.st_mtime,
+		     (long) st.st_size, name);
+	  ok = false;
+	}
+      if (fclose (f) == 0 && (!ok || rename (tmp, gch) == 0))
+	rename (new_dep, dep);
+    }
+
+  unlink (tmp);
+  unlink (new_dep);
+  unlink (deps);
+  unlink (err);
+  unlink (asm_name);
+  exit (SUCCESS_EXIT_CODE);
+}
+
+/* In a compilation child, return true if the files in PCH_DIR whose
+   names start with BASE hold a precompiled prefix header that can be
+   used: none of the files BASE.dep lists have changed, and BASE.gch
+   exists.  If some have changed, remove both so that the server makes
+   them again.  */
+
+static bool
+prefix_pch_usable_p (const char *base)
+{
+  char *dep = concat (base, ".dep", NULL);
+  char *gch = concat (base, ".gch", NULL);
+  size_t len;
+  char *buf = read_whole_file (dep, &len);
+  char *p, *eol, *q;
+  struct stat st;
+  bool current = buf != NULL;
+  bool usable;
+
+  for (p = buf; current && p < buf + len; p = eol + 1)
+    {
+      long mtime, size;
+
+      eol = strchr (p, '\n');
+      if (eol == NULL)
+	current = false;
+      else
+	{
+	  *eol = '\0';
+	  mtime = strtol (p, &q, 10);
+	  size = strtol (q, &q, 10);
+	  current = (*q == ' '
+		     && stat (q + 1, &st) == 0
+		     && (long) st.st_mtime == mtime
+		     && (long) st.st_size == size);
+	}
+    }
+
+  if (buf != NULL && !current)
+    {
+      unlink (dep);
+      unlink (gch);
+    }
+  usable = current && access (gch, R_OK) == 0;
+  free (buf);
+  free (dep);
+  if (!usable)
+    free (gch);
+  else
+    compile_server_prefix_pch = gch;
+  return usable;
+}
+
+/* In the child forked for the request REQ, take on its standard
+   descriptors FDS, directory, umask and environment, and compile,
+   using the precompiled prefix header in the files starting with
+   PCH_BASE if that is not NULL and they are up to date.  Does not
+   return.  */
+
+static void
+serve_request (const struct server_request *req, int fds[3],
+	       const char *pch_base)
+{
+  int fd;
+
+  umask (req->mask);
+  environ = req->env;
+  /* The server set up the locale, and with it the quotes used in
+     diagnostics, from its own environment.  */
+  gcc_init_libintl ();
+
+  for (fd = 0; fd < 3; fd++)
+    if (fds[fd] != fd)
+      {
+	dup2 (fds[fd], fd);
+	close (fds[fd]);
+      }
+
+  if (chdir (req->cwd) != 0)
+    fatal_error ("cannot change to directory %s: %m", req->cwd);
+
+  if (pch_base)
+    prefix_pch_usable_p (pch_base);
+
+  exit (toplev_compile (req->argc, req->argv));
+}
+
+/* Return true if the request in BUF is for the program PROG.  */
+
+static bool
+request_for_p (const char *buf, const char *prog)
+{
+  return (strcmp (buf, COMPILE_SERVER_MAGIC) == 0
+	  && strcmp (buf + strlen (buf) + 1, prog) == 0);
+}
+
+/* In a child just forked, close the descriptors only the server
+   needs, LISTEN_FD among them, and put back the signals it handles.  */
+
+static void
+leave_server (int listen_fd)
+{
+  int i;
+
+  close (listen_fd);
+  close (child_pipe[0]);
+  close (child_pipe[1]);
+  for (i = 0; i < n_jobs; i++)
+    close (jobs[i].fd);
+  signal (SIGCHLD, SIG_DFL);
+  signal (SIGPIPE, SIG_DFL);
+}
+
+/* Return the names, less their suffixes, of the files in PCH_DIR for
+   the prefix header of the compilation REQ if they are there, for the
+   compilation to check and use.  If they are not, start making them
+   unless that is already under way, and return NULL.  LISTEN_FD and
+   the descriptors in FDS are closed in the child doing that.  */
+
+static char *
+prefix_pch (const struct server_request *req, int listen_fd, int fds[4])
+{
+  char key[33];
+  unsigned int header;
+  char *base, *dep;
+  bool made;
+  pid_t pid;
+  int i;
+
+  if (pch_dir == NULL || (header = prefix_header (req, key)) == 0)
+    return NULL;
+
+  base = concat (pch_dir, "/", key, NULL);
+  dep = concat (base, ".dep", NULL);
+  made = access (dep, F_OK) == 0;
+  free (dep);
+  if (made)
+    return base;
+
+  for (i = 0; i < n_builds; i++)
+    if (strcmp (builds[i].key, key) == 0)
+      {
+	free (base);
+	return NULL;
+      }
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      leave_server (listen_fd);
+      for (i = 0; i < 4; i++)
+	close (fds[i]);
+      build_prefix_pch (req, header, base);
+    }
+  free (base);
+  if (pid < 0)
+    return NULL;
+
+  if (n_builds == builds_alloc)
+    {
+      builds_alloc = builds_alloc ? builds_alloc * 2 : 4;
+      builds = XRESIZEVEC (struct pch_build, builds, builds_alloc);
+    }
+  builds[n_builds].pid = pid;
+  builds[n_builds].key = xstrdup (key);
+  n_builds++;
+  return NULL;
+}
+
+/* Accept a connection on LISTEN_FD and start the compilation it asks
+   for.  Return false if PROG has changed since the server started,
+   so that it should stop taking requests.  */
+
+static bool
+accept_request (int listen_fd, const char *prog)
+{
+  int fd = accept (listen_fd, NULL, NULL);
+  int fds[4];
+  struct server_request req;
+  char *buf, *pch_base;
+  size_t len;
+  pid_t pid;
+
+  if (fd < 0)
+    return true;
+  if (!read_request (fd, &buf, &len, fds))
+    {
+      close (fd);
+      return true;
+    }
+
+  if (!request_for_p (buf, prog) || self_changed_p (prog))
+    {
+      close (fds[0]);
+      close (fds[1]);
+      close (fds[2]);
+      free (buf);
+      send_status (fd, COMPILE_SERVER_REFUSED);
+      return !self_changed_p (prog);
+    }
+
+  parse_request (buf, len, &req);
+  fds[3] = fd;
+  pch_base = prefix_pch (&req, listen_fd, fds);
+
+  pid = fork ();
+  if (pid == 0)
+    {
+      leave_server (listen_fd);
+      close (fd);
+      serve_request (&req, fds, pch_base);
+    }
+
+  close (fds[0]);
+  close (fds[1]);
+  close (fds[2]);
+  free (req.argv);
+  free (req.env);
+  free (pch_base);
+  free (buf);
+  if (pid < 0)
+    {
+      send_status (fd, COMPILE_SERVER_REFUSED);
+      return true;
+    }
+
+  if (n_jobs == jobs_alloc)
+    {
+      jobs_alloc = jobs_alloc ? jobs_alloc * 2 : 16;
+      jobs = XRESIZEVEC (struct server_job, jobs, jobs_alloc);
+    }
+  jobs[n_jobs].pid = pid;
+  jobs[n_jobs].fd = fd;
+  n_jobs++;
+  return true;
+}
+
+/* Send the status of every compilation that has finished, and forget
+   the prefix headers that are done.  */
+
+static void
+reap_jobs (void)
+{
+  int status, i;
+  pid_t pid;
+
+  while ((pid = waitpid (-1, &status, WNOHANG)) > 0)
+    {
+      for (i = 0; i < n_jobs; i++)
+	if (jobs[i].pid == pid)
+	  {
+	    send_status (jobs[i].fd, status);
+	    jobs[i] = jobs[--n_jobs];
+	    break;
+	  }
+      for (i = 0; i < n_builds; i++)
+	if (builds[i].pid == pid)
+	  {
+	    free (builds[i].key);
+	    builds[i] = builds[--n_builds];
+	    break;
+	  }
+    }
+}
+
+/* Remove the files in PCH_DIR.  */
+
+static void
+clear_pch_dir (void)
+{
+  DIR *dir = opendir (pch_dir);
+  struct dirent *d;
+  char *name;
+
+  if (dir == NULL)
+    return;
+  while ((d = readdir (dir)) != NULL)
+    if (strcmp (d->d_name, ".") != 0 && strcmp (d->d_name, "..") != 0)
+      {
+	name = concat (pch_dir, "/", d->d_name, NULL);
+	unlink (name);
+	free (name);
+      }
+  closedir (dir);
+}
+
+/* Set up PCH_DIR as the directory NAME.pch, empty, or leave it NULL if
+   that cannot be done.  */
+
+static void
+open_pch_dir (const char *name)
+{
+  struct stat st;
+
+  pch_dir = concat (name, ".pch", NULL);
+  if (mkdir (pch_dir, 0700) == 0)
+    return;
+  if (errno == EEXIST
+      && lstat (pch_dir, &st) == 0
+      && S_ISDIR (st.st_mode)
+      && st.st_uid == getuid ())
+    {
+      clear_pch_dir ();
+      return;
+    }
+  free (pch_dir);
+  pch_dir = NULL;
+}
+
+/* Bind and listen on the Unix socket NAME.  Return the descriptor, or
+   -1 if there is already a server there or the socket cannot be
+   made.  */
+
+static int
+listen_on (const char *name)
+{
+  struct sockaddr_un addr;
+  int fd;
+  mode_t mask;
+
+  if (strlen (name) >= sizeof (addr.sun_path))
+    return -1;
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, name);
+
+  fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return -1;
+
+  mask = umask (077);
+  if (bind (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+    {
+      /* A socket left behind by a server that has gone can be
+	 replaced; one with a server behind it cannot.  */
+      int in_use = errno == EADDRINUSE;
+      int probe = socket (AF_UNIX, SOCK_STREAM, 0);
+
+      if (!in_use
+	  || probe < 0
+	  || connect (probe, (struct sockaddr *) &addr, sizeof (addr)) == 0
+	  || unlink (name) != 0
+	  || bind (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+	{
+	  if (probe >= 0)
+	    close (probe);
+	  close (fd);
+	  umask (mask);
+	  return -1;
+	}
+      close (probe);
+    }
+  umask (mask);
+
+  if (listen (fd, SOMAXCONN) != 0)
+    {
+      close (fd);
+      return -1;
+    }
+  return fd;
+}
+
+/* Run as a compile server for the compiler at PROG on the socket NAME.
+   Return once it has been idle for COMPILE_SERVER_IDLE_TIMEOUT seconds
+   with no compilation or precompiled header in progress, or when PROG
+   is replaced and those in progress have finished.  */
+
+int
+compile_server_main (const char *prog, const char *name)
+{
+  int listen_fd;
+  bool accepting = true;
+  struct pollfd *fds = NULL;
+  int fds_alloc = 0;
+
+  if (stat (prog, &self_stat) != 0)
+    return FATAL_EXIT_CODE;
+  listen_fd = listen_on (name);
+  if (listen_fd < 0)
+    return FATAL_EXIT_CODE;
+  if (pipe (child_pipe) != 0)
+    return FATAL_EXIT_CODE;
+  fcntl (child_pipe[0], F_SETFL, O_NONBLOCK);
+  fcntl (child_pipe[1], F_SETFL, O_NONBLOCK);
+  signal (SIGCHLD, sigchld_handler);
+  signal (SIGPIPE, SIG_IGN);
+
+  toplev_init (prog);
+  open_pch_dir (name);
+
+  while (accepting || n_jobs > 0 || n_builds > 0)
+    {
+      int i, n;
+      char c;
+
+      reap_jobs ();
+      if (!accepting && n_jobs == 0 && n_builds == 0)
+	break;
+
+      if (fds_alloc < n_jobs + 2)
+	{
+	  fds_alloc = n_jobs + 16;
+	  fds = XRESIZEVEC (struct pollfd, fds, fds_alloc);
+	}
+      fds[0].fd = child_pipe[0];
+      fds[0].events = POLLIN;
+      fds[1].fd = accepting ? listen_fd : -1;
+      fds[1].events = POLLIN;
+      /* The driver sends nothing after its request, so input or a
+	 hangup on a connection means it has gone away.  */
+      for (i = 0; i < n_jobs; i++)
+	{
+	  fds[i + 2].fd = jobs[i].fd;
+	  fds[i + 2].events = POLLIN;
+	}
+
+      n = poll (fds, n_jobs + 2,
+		n_jobs || n_builds ? -1 : COMPILE_SERVER_IDLE_TIMEOUT * 1000);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	break;
+
+      while (read (child_pipe[0], &c, 1) > 0)
+	;
+      for (i = 0; i < n_jobs; i++)
+	if (fds[i + 2].revents)
+	  kill (jobs[i].pid, SIGKILL);
+      if (accepting && fds[1].revents & POLLIN)
+	accepting = accept_request (listen_fd, prog);
+      if (!accepting && listen_fd >= 0)
+	{
+	  unlink (name);
+	  close (listen_fd);
+	  listen_fd = -1;
+	}
+    }
+
+  /* A server that has stopped taking requests leaves the directory to
+     the one that may have taken its place.  */
+  if (listen_fd >= 0)
+    {
+      unlink (name);
+      if (pch_dir)
+	{
+	  clear_pch_dir ();
+	  rmdir (pch_dir);
+	}
+    }
+  return SUCCESS_EXIT_CODE;
+}
+
+#else /* no Unix sockets or fork */
+
+int
+compile_server_main (const char *prog ATTRIBUTE_UNUSED,
+		     const char *name ATTRIBUTE_UNUSED)
+{
+  return FATAL_EXIT_CODE;
+}
+
+#endif
@@ -0,0 +1,66 @@
+/* APPLE LOCAL file compile server */
+/* Interface between the driver and a persistent compiler proper.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 2, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING.  If not, write to the Free
+Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+02110-1301, USA.  */
+
+#ifndef GCC_COMPILE_SERVER_H
+#define GCC_COMPILE_SERVER_H
+
+/* A compiler proper started as "cc1 -fcompile-server=SOCKET" does its
+   option-independent initialization once and then listens on the Unix
+   socket SOCKET.  Each connection is one compilation: the driver sends
+   its standard input, output and error descriptors with the first byte
+   of a request made of NUL-terminated strings
+
+     COMPILE_SERVER_MAGIC, program, cwd, umask (octal),
+     argc (decimal), argv[0] ... argv[argc - 1],
+     envc (decimal), env[0] ... env[envc - 1]
+
+   and then waits on the connection.  The server forks, and the child
+   compiles with that command line, directory and environment.  When it
+   exits, the server sends back its wait status as an int, or
+   COMPILE_SERVER_REFUSED if the request was not for this compiler, in
+   which case the driver runs the program itself.
+
+   The driver uses a server when the environment variable
+   COMPILE_SERVER_ENV names a directory, and starts one there when
+   there is none for the program it is about to run.
+
+   A server on SOCKET also keeps precompiled headers in the directory
+   SOCKET.pch.  The first time it sees a compilation whose first
+   -include file has no precompiled header of its own, it precompiles
+   that header in the background with the same options.  Later
+   compilations with the same options load it instead of parsing the
+   header, for as long as none of the files it was made from change.  */
+
+#define COMPILE_SERVER_OPTION "-fcompile-server="
+#define COMPILE_SERVER_ENV "GCC_COMPILE_SERVER"
+#define COMPILE_SERVER_MAGIC "gcc-compile-server-1"
+#define COMPILE_SERVER_REFUSED (-1)
+
+/* Seconds a server with nothing to do waits before exiting.  */
+#define COMPILE_SERVER_IDLE_TIMEOUT 600
+
+extern int compile_server_main (const char *, const char *);
+
+/* In a compilation the server has a precompiled header for, the file
+   the front end should load in place of the first -include file.  */
+extern const char *compile_server_prefix_pch;
+
+#endif /* ! GCC_COMPILE_SERVER_H */
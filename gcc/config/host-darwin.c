@@ -77,6 +77,11 @@ darwin_gt_pch_use_address (void *addr, size_t sz, int fd, size_t off)
       /* Sanity check for broken MAP_FIXED.  */
       gcc_assert (!ret || mmap_result == addr);
     }
+  /* APPLE LOCAL begin relocatable PCH */
+  /* Let the caller map the file elsewhere and relocate it.  */
+  else
+    ret = -1;
+  /* APPLE LOCAL end relocatable PCH */
 
   return ret;
 }
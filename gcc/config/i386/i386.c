@@ -1209,6 +1209,8 @@ static void ix86_setup_incoming_varargs (CUMULATIVE_ARGS *, enum machine_mode,
 static tree ix86_gimplify_va_arg (tree, tree, tree *, tree *);
 static bool ix86_scalar_mode_supported_p (enum machine_mode);
 static bool ix86_vector_mode_supported_p (enum machine_mode);
+/* APPLE LOCAL vect cost model */
+static int ix86_builtin_vectorization_cost (enum vect_cost_for_stmt);
 
 static int ix86_address_cost (rtx);
 static bool ix86_cannot_force_const_mem (rtx);
@@ -1442,6 +1444,12 @@ static section *x86_64_elf_select_section (tree decl, int reloc,
 #undef TARGET_VECTOR_MODE_SUPPORTED_P
 #define TARGET_VECTOR_MODE_SUPPORTED_P ix86_vector_mode_supported_p
 
+/* APPLE LOCAL begin vect cost model */
+#undef TARGET_VECTORIZE_BUILTIN_VECTORIZATION_COST
+#define TARGET_VECTORIZE_BUILTIN_VECTORIZATION_COST \
+  ix86_builtin_vectorization_cost
+/* APPLE LOCAL end vect cost model */
+
 #ifdef HAVE_AS_TLS
 #undef TARGET_ASM_OUTPUT_DWARF_DTPREL
 #define TARGET_ASM_OUTPUT_DWARF_DTPREL i386_output_dwarf_dtprel
@@ -12984,6 +12992,98 @@ ix86_expand_sse4_unpack (rtx operands[2], bool unsigned_p, bool high_p)
 }
 /* APPLE LOCAL end 5612787 mainline sse4 */
 
+/* APPLE LOCAL begin vect multiple types */
+/* Pack OP[1] and OP[2] into OP[0], a vector of the next narrower integer
+   type, keeping the low part of each element.  The elements of OP[1] go
+   into the low half of OP[0].  */
+
+void
+ix86_expand_sse_pack (rtx operands[])
+{
+  enum machine_mode imode = GET_MODE (operands[1]);
+  rtx op1 = operands[1], op2 = operands[2];
+  rtx mask, t1, t2, t3;
+  rtvec v;
+  int i;
+
+  switch (imode)
+    {
+    case V8HImode:
+      /* Clear the high byte of each element, so that the saturating
+	 pack is exact.  */
+      mask = gen_rtx_CONST_VECTOR (V8HImode,
+				   gen_rtvec (8, GEN_INT (0xff), GEN_INT (0xff),
+					      GEN_INT (0xff), GEN_INT (0xff),
+					      GEN_INT (0xff), GEN_INT (0xff),
+					      GEN_INT (0xff), GEN_INT (0xff)));
+      mask = force_reg (V8HImode, mask);
+      t1 = gen_reg_rtx (V8HImode);
+      t2 = gen_reg_rtx (V8HImode);
+      emit_insn (gen_andv8hi3 (t1, op1, mask));
+      emit_insn (gen_andv8hi3 (t2, op2, mask));
+      emit_insn (gen_sse2_packuswb (operands[0], t1, t2));
+      break;
+
+    case V4SImode:
+      t1 = gen_reg_rtx (V4SImode);
+      t2 = gen_reg_rtx (V4SImode);
+      if (TARGET_SSE4_1)
+	{
+	  /* Clear the high half of each element and use the unsigned
+	     saturating pack.  */
+	  mask = GEN_INT (0xffff);
+	  mask = gen_rtx_CONST_VECTOR (V4SImode,
+				       gen_rtvec (4, mask, mask, mask, mask));
+	  mask = force_reg (V4SImode, mask);
+	  emit_insn (gen_andv4si3 (t1, op1, mask));
+	  emit_insn (gen_andv4si3 (t2, op2, mask));
+	  emit_insn (gen_sse4_1_packusdw (operands[0], t1, t2));
+	}
+      else if (TARGET_SSSE3)
+	{
+	  /* Gather the low halfwords of each operand into its low
+	     quadword and concatenate the two quadwords.  */
+	  v = rtvec_alloc (16);
+	  for (i = 0; i < 16; i++)
+	    RTVEC_ELT (v, i) = GEN_INT (i < 8 ? (i / 2) * 4 + (i & 1) : -128);
+	  mask = force_reg (V16QImode, gen_rtx_CONST_VECTOR (V16QImode, v));
+	  emit_insn (gen_ssse3_pshufbv16qi3 (gen_lowpart (V16QImode, t1),
+					     gen_lowpart (V16QImode, op1),
+					     mask));
+	  emit_insn (gen_ssse3_pshufbv16qi3 (gen_lowpart (V16QImode, t2),
+					     gen_lowpart (V16QImode, op2),
+					     mask));
+	  t3 = gen_reg_rtx (V2DImode);
+	  emit_insn (gen_sse2_punpcklqdq (t3, gen_lowpart (V2DImode, t1),
+					  gen_lowpart (V2DImode, t2)));
+	  emit_move_insn (operands[0], gen_lowpart (V8HImode, t3));
+	}
+      else
+	{
+	  /* Sign extend the low half of each element into the whole
+	     element, so that the signed saturating pack is exact.  */
+	  t3 = GEN_INT (16);
+	  emit_insn (gen_ashlv4si3 (t1, op1, t3));
+	  emit_insn (gen_ashrv4si3 (t1, t1, t3));
+	  emit_insn (gen_ashlv4si3 (t2, op2, t3));
+	  emit_insn (gen_ashrv4si3 (t2, t2, t3));
+	  emit_insn (gen_sse2_packssdw (operands[0], t1, t2));
+	}
+      break;
+
+    case V2DImode:
+      /* The low doubleword of each element is the even one.  */
+      emit_insn (gen_vec_extract_evenv4si (operands[0],
+					   gen_lowpart (V4SImode, op1),
+					   gen_lowpart (V4SImode, op2)));
+      break;
+
+    default:
+      gcc_unreachable ();
+    }
+}
+/* APPLE LOCAL end vect multiple types */
+
 /* Expand conditional increment or decrement using adb/sbb instructions.
    The default case using setcc followed by the conditional move can be
    done by generic code.  */
@@ -21778,6 +21878,32 @@ ix86_vector_mode_supported_p (enum machine_mode mode)
   return false;
 }
 
+/* APPLE LOCAL begin vect cost model */
+/* Implements target hook builtin_vectorization_cost.  Misaligned SSE
+   accesses are split into two halves on the Netburst cores, and crossing
+   between the integer and SSE register files is slow everywhere.  */
+static int
+ix86_builtin_vectorization_cost (enum vect_cost_for_stmt kind)
+{
+  switch (kind)
+    {
+    case unaligned_load:
+    case unaligned_store:
+      return (TARGET_PENTIUM4 || TARGET_NOCONA) ? 3 : 2;
+
+    case vec_to_scalar:
+    case scalar_to_vec:
+      return 2;
+
+    case cond_branch_taken:
+      return 3;
+
+    default:
+      return 1;
+    }
+}
+/* APPLE LOCAL end vect cost model */
+
 /* Worker function for TARGET_MD_ASM_CLOBBERS.
 
    We do this in the new i386 backend to maintain source compatibility
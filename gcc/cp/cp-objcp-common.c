@@ -244,8 +244,9 @@ decl_shadowed_for_var_lookup (tree from)
   struct tree_map *h, in;
   in.from = from;
 
+  /* APPLE LOCAL relocatable PCH */
   h = (struct tree_map *) htab_find_with_hash (shadowed_var_for_decl, &in,
-					       htab_hash_pointer (from));
+					       DECL_UID (from));
   if (h)
     return h->to;
   return NULL_TREE;
@@ -260,7 +261,8 @@ decl_shadowed_for_var_insert (tree from, tree to)
   void **loc;
 
   h = GGC_NEW (struct tree_map);
-  h->hash = htab_hash_pointer (from);
+  /* APPLE LOCAL relocatable PCH */
+  h->hash = DECL_UID (from);
   h->from = from;
   h->to = to;
   loc = htab_find_slot_with_hash (shadowed_var_for_decl, h, h->hash, INSERT);
@@ -2724,6 +2724,24 @@ finish_case_label (tree low_value, tree high_value)
   return r;
 }
 
+/* APPLE LOCAL begin relocatable PCH */
+/* Hash the SCOPE and NAME of a TYPENAME_TYPE.  This must not depend on
+   addresses, since the table is saved in PCH files, which may be
+   loaded at a different address.  */
+
+static hashval_t
+typename_hash_1 (tree scope, tree name)
+{
+  hashval_t hash = IDENTIFIER_HASH_VALUE (name);
+  unsigned int uid;
+
+  if (scope == NULL_TREE)
+    return hash;
+  uid = TYPE_P (scope) ? TYPE_UID (scope) : DECL_UID (scope);
+  return iterative_hash_object (uid, hash);
+}
+/* APPLE LOCAL end relocatable PCH */
+
 /* Hash a TYPENAME_TYPE.  K is really of type `tree'.  */
 
 static hashval_t
@@ -2732,8 +2750,8 @@ typename_hash (const void* k)
   hashval_t hash;
   tree t = (tree) k;
 
-  hash = (htab_hash_pointer (TYPE_CONTEXT (t))
-	  ^ htab_hash_pointer (DECL_NAME (TYPE_NAME (t))));
+  /* APPLE LOCAL relocatable PCH */
+  hash = typename_hash_1 (TYPE_CONTEXT (t), DECL_NAME (TYPE_NAME (t)));
 
   return hash;
 }
@@ -2792,8 +2810,8 @@ build_typename_type (tree context, tree name, tree fullname,
   ti.class_p = (tag_type == class_type
 		|| tag_type == record_type
 		|| tag_type == union_type);
-  hash =  (htab_hash_pointer (ti.scope)
-	   ^ htab_hash_pointer (ti.name));
+  /* APPLE LOCAL relocatable PCH */
+  hash = typename_hash_1 (ti.scope, ti.name);
 
   /* See if we already have this type.  */
   e = htab_find_slot_with_hash (typename_htab, &ti, hash, INSERT);
@@ -318,7 +318,8 @@ reg_attrs_htab_hash (const void *x)
 {
   reg_attrs *p = (reg_attrs *) x;
 
-  return ((p->offset * 1000) ^ (long) p->decl);
+  /* APPLE LOCAL relocatable PCH */
+  return ((p->offset * 1000) ^ (size_t) iterative_hash_expr (p->decl, 0));
 }
 
 /* Returns nonzero if the value represented by X (which is really a
@@ -4071,6 +4071,29 @@ expand_assignment (tree to, tree from)
   if (operand_equal_p (to, from, 0))
     return;
 
+  /* APPLE LOCAL begin vect slp */
+  /* A vector store to an address of unknown alignment.  The vectorizer
+     has already checked that the target can do it.  */
+  if (TREE_CODE (to) == MISALIGNED_INDIRECT_REF)
+    {
+      enum machine_mode mode = TYPE_MODE (TREE_TYPE (to));
+      int icode = movmisalign_optab->handlers[mode].insn_code;
+      rtx addr, mem, reg;
+
+      gcc_assert (icode != CODE_FOR_nothing);
+
+      addr = expand_expr (TREE_OPERAND (to, 0), NULL_RTX, VOIDmode,
+			  EXPAND_SUM);
+      addr = memory_address (mode, addr);
+      mem = gen_rtx_MEM (mode, addr);
+      set_mem_attributes (mem, to, 0);
+
+      reg = force_reg (mode, expand_normal (from));
+      emit_insn (GEN_FCN (icode) (mem, reg));
+      return;
+    }
+  /* APPLE LOCAL end vect slp */
+
   /* Assignment of a structure component needs special treatment
      if the structure component's rtx is not simply a MEM.
      Assignment of an array element at a constant index, and assignment of
@@ -8894,6 +8917,31 @@ expand_expr_real_1 (tree exp, rtx target, enum machine_mode tmode,
 	return target;
       }
 
+      /* APPLE LOCAL begin vect interleave */
+    case VEC_EXTRACT_EVEN_EXPR:
+    case VEC_EXTRACT_ODD_EXPR:
+    case VEC_INTERLEAVE_HIGH_EXPR:
+    case VEC_INTERLEAVE_LOW_EXPR:
+      goto binop;
+      /* APPLE LOCAL end vect interleave */
+
+      /* APPLE LOCAL begin vect multiple types */
+    case VEC_UNPACK_HI_EXPR:
+    case VEC_UNPACK_LO_EXPR:
+      {
+	op0 = expand_normal (TREE_OPERAND (exp, 0));
+	temp = expand_widen_pattern_expr (exp, op0, NULL_RTX, NULL_RTX,
+					  target, unsignedp);
+	gcc_assert (temp);
+	return temp;
+      }
+
+    case VEC_PACK_MOD_EXPR:
+      /* The operands are twice as wide as the elements of the result.  */
+      mode = TYPE_MODE (TREE_TYPE (TREE_OPERAND (exp, 0)));
+      goto binop;
+      /* APPLE LOCAL end vect multiple types */
+
     default:
       return lang_hooks.expand_expr (exp, original_target, tmode,
 				     modifier, alt_rtl);
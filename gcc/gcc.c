@@ -87,6 +87,27 @@ compilation is specified by a string called a "spec".  */
 #include "gcc.h"
 #include "flags.h"
 #include "opts.h"
+/* APPLE LOCAL begin compile server */
+#include "hashtab.h"
+#include "compile-server.h"
+#if defined (HAVE_SYS_SOCKET_H) && defined (HAVE_SYS_UN_H) \
+    && defined (HAVE_WORKING_FORK)
+#define USE_COMPILE_SERVER
+#include <sys/socket.h>
+#include <sys/un.h>
+#if !defined (SO_PEERCRED) && defined (LOCAL_PEERCRED)
+#include <sys/ucred.h>
+#endif
+extern char **environ;
+#endif
+/* APPLE LOCAL end compile server */
+/* APPLE LOCAL resource log */
+#include "resource-log.h"
+/* APPLE LOCAL begin result cache */
+#include "md5.h"
+#include <dirent.h>
+#include <utime.h>
+/* APPLE LOCAL end result cache */
 
 /* By default there is no special suffix for target executables.  */
 /* FIXME: when autoconf is fixed, remove the host check - dj */
@@ -223,6 +244,12 @@ static int combine_flag = 0;
 
 static int use_pipes;
 
+/* APPLE LOCAL begin parallel driver */
+/* The most input files to compile at once (-j).  */
+
+static int max_jobs = 1;
+/* APPLE LOCAL end parallel driver */
+
 /* The compiler version.  */
 
 static const char *compiler_version;
@@ -311,6 +338,16 @@ static void delete_if_ordinary (const char *);
 static void delete_temp_files (void);
 static void delete_failure_queue (void);
 static void clear_failure_queue (void);
+/* APPLE LOCAL begin parallel driver */
+static void start_compile_job (int);
+static void reap_compile_job (void);
+static void flush_compile_jobs (void);
+static void finish_compile_jobs (void);
+/* APPLE LOCAL end parallel driver */
+/* APPLE LOCAL compile server */
+static bool run_in_compile_server (const char **, int *);
+/* APPLE LOCAL resource log */
+static const char *resource_log_input (void);
 static int check_live_switch (int, int);
 static const char *handle_braces (const char *);
 static inline bool input_suffix_matches (const char *, const char *);
@@ -2829,6 +2866,793 @@ add_sysrooted_prefix (struct path_prefix *pprefix, const char *prefix,
 	      require_machine_suffix, os_multilib);
 }
 
+/* APPLE LOCAL begin compile server */
+#ifdef USE_COMPILE_SERVER
+
+/* Return true if PROG, the full name of a program about to be run, is
+   a compiler proper that can run as a compile server.  */
+
+static bool
+compile_server_program_p (const char *prog)
+{
+  const char *base = lbasename (prog);
+
+  return (IS_ABSOLUTE_PATH (prog)
+	  && (strcmp (base, "cc1") == 0
+	      || strcmp (base, "cc1plus") == 0
+	      || strcmp (base, "cc1obj") == 0
+	      || strcmp (base, "cc1objplus") == 0));
+}
+
+/* Start a compile server for PROG on the socket NAME, detached from
+   this process so that nothing waits for it to exit.  */
+
+static void
+start_compile_server (const char *prog, const char *name)
+{
+  pid_t pid;
+
+  fflush (stdout);
+  fflush (stderr);
+  pid = fork ();
+  if (pid == 0)
+    {
+      setsid ();
+      if (fork () == 0)
+	{
+	  long max_fd = sysconf (_SC_OPEN_MAX);
+	  int fd = open ("/dev/null", O_RDWR);
+
+	  if (fd >= 0)
+	    {
+	      dup2 (fd, 0);
+	      dup2 (fd, 1);
+	      dup2 (fd, 2);
+	    }
+	  if (max_fd < 0 || max_fd > 1024)
+	    max_fd = 1024;
+	  for (fd = 3; fd < max_fd; fd++)
+	    close (fd);
+	  execl (prog, prog, concat (COMPILE_SERVER_OPTION, name, NULL),
+		 (char *) 0);
+	}
+      _exit (0);
+    }
+  if (pid > 0)
+    waitpid (pid, NULL, 0);
+}
+
+/* Return true if the directory DIR, where the compile server sockets
+   go, belongs to the user and nobody else can write to it, so that no
+   other user can have put a server of theirs there.  */
+
+static bool
+compile_server_dir_ok_p (const char *dir)
+{
+  struct stat st;
+
+  return (stat (dir, &st) == 0
+	  && S_ISDIR (st.st_mode)
+	  && st.st_uid == getuid ()
+	  && (st.st_mode & (S_IWGRP | S_IWOTH)) == 0);
+}
+
+/* Return true if the compile server at the other end of the socket FD
+   runs as the user, where the host can tell.  */
+
+static bool
+compile_server_peer_ok_p (int fd ATTRIBUTE_UNUSED)
+{
+#if defined (SO_PEERCRED)
+  struct ucred cred;
+  socklen_t len = sizeof (cred);
+
+  return (getsockopt (fd, SOL_SOCKET, SO_PEERCRED, &cred, &len) == 0
+	  && cred.uid == getuid ());
+#elif defined (LOCAL_PEERCRED)
+  struct xucred cred;
+  socklen_t len = sizeof (cred);
+
+  return (getsockopt (fd, SOL_LOCAL, LOCAL_PEERCRED, &cred, &len) == 0
+	  && cred.cr_version == XUCRED_VERSION
+	  && cred.cr_uid == getuid ());
+#else
+  return true;
+#endif
+}
+
+/* Add the string S, with its terminating NUL, to OB.  */
+
+static void
+add_server_string (struct obstack *ob, const char *s)
+{
+  obstack_grow (ob, s, strlen (s) + 1);
+}
+
+/* Run the compiler proper command ARGV in a compile server, if the
+   environment asks for one, and store its wait status in *STATUS.
+   Return false if the command was not run, in which case the caller
+   should run it itself; the first time round for a given compiler,
+   this starts a server for the next.  */
+
+static bool
+run_in_compile_server (const char **argv, int *status)
+{
+  const char *dir = getenv (COMPILE_SERVER_ENV);
+  const char *prog = argv[0];
+  struct sockaddr_un addr;
+  struct stat st;
+  struct obstack ob;
+  struct msghdr msg;
+  struct iovec iov;
+  union
+  {
+    struct cmsghdr align;
+    char buf[CMSG_SPACE (3 * sizeof (int))];
+  } control;
+  struct cmsghdr *cmsg;
+  char hash[16], mask_str[16];
+  const char *cwd;
+  char *name, *request;
+  size_t len, done;
+  mode_t mask;
+  int fd, n, fds[3];
+  bool ok = false;
+  void (*old_sigpipe) (int);
+
+  if (dir == NULL || *dir == '\0' || !compile_server_program_p (prog)
+      || !compile_server_dir_ok_p (dir))
+    return false;
+  cwd = getpwd ();
+  if (cwd == NULL)
+    return false;
+
+  sprintf (hash, "-%08lx", (unsigned long) htab_hash_string (prog));
+  name = concat (dir, dir_separator_str, lbasename (prog), hash, NULL);
+  if (strlen (name) >= sizeof (addr.sun_path))
+    {
+      free (name);
+      return false;
+    }
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, name);
+
+  /* The request carries the standard descriptors and the whole
+     environment, so it must only ever go to a server of the user's.  */
+  if (lstat (name, &st) == 0
+      && (!S_ISSOCK (st.st_mode) || st.st_uid != getuid ()))
+    {
+      free (name);
+      return false;
+    }
+
+  fd = socket (AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    {
+      free (name);
+      return false;
+    }
+  if (connect (fd, (struct sockaddr *) &addr, sizeof (addr)) != 0)
+    {
+      if (errno == ENOENT || errno == ECONNREFUSED)
+	start_compile_server (prog, name);
+      close (fd);
+      free (name);
+      return false;
+    }
+  free (name);
+  if (!compile_server_peer_ok_p (fd))
+    {
+      close (fd);
+      return false;
+    }
+
+  mask = umask (0);
+  umask (mask);
+  sprintf (mask_str, "%o", (unsigned int) mask);
+
+  obstack_init (&ob);
+  add_server_string (&ob, COMPILE_SERVER_MAGIC);
+  add_server_string (&ob, prog);
+  add_server_string (&ob, cwd);
+  add_server_string (&ob, mask_str);
+  for (n = 0; argv[n]; n++)
+    ;
+  sprintf (hash, "%d", n);
+  add_server_string (&ob, hash);
+  for (n = 0; argv[n]; n++)
+    add_server_string (&ob, argv[n]);
+  for (n = 0; environ[n]; n++)
+    ;
+  sprintf (hash, "%d", n);
+  add_server_string (&ob, hash);
+  for (n = 0; environ[n]; n++)
+    add_server_string (&ob, environ[n]);
+  len = obstack_object_size (&ob);
+  request = obstack_finish (&ob);
+
+  /* The standard descriptors go with the first byte of the request.  */
+  fds[0] = 0;
+  fds[1] = 1;
+  fds[2] = 2;
+  memset (&msg, 0, sizeof (msg));
+  iov.iov_base = request;
+  iov.iov_len = 1;
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof (control.buf);
+  cmsg = CMSG_FIRSTHDR (&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN (3 * sizeof (int));
+  memcpy (CMSG_DATA (cmsg), fds, 3 * sizeof (int));
+
+  fflush (stdout);
+  fflush (stderr);
+  old_sigpipe = signal (SIGPIPE, SIG_IGN);
+  if (sendmsg (fd, &msg, 0) == 1)
+    {
+      for (done = 1; done < len; done += n)
+	{
+	  n = write (fd, request + done, len - done);
+	  if (n < 0 && errno == EINTR)
+	    n = 0;
+	  else if (n <= 0)
+	    break;
+	}
+      if (done == len)
+	{
+	  for (done = 0; done < sizeof (int); done += n)
+	    {
+	      n = read (fd, (char *) status + done, sizeof (int) - done);
+	      if (n < 0 && errno == EINTR)
+		n = 0;
+	      else if (n <= 0)
+		break;
+	    }
+	  ok = done == sizeof (int) && *status != COMPILE_SERVER_REFUSED;
+	}
+    }
+  signal (SIGPIPE, old_sigpipe);
+
+  obstack_free (&ob, NULL);
+  close (fd);
+  return ok;
+}
+
+#else
+
+static bool
+run_in_compile_server (const char **argv ATTRIBUTE_UNUSED,
+		       int *status ATTRIBUTE_UNUSED)
+{
+  return false;
+}
+
+#endif
+/* APPLE LOCAL end compile server */
+
+/* APPLE LOCAL begin result cache */
+/* The driver keeps a cache of object files when the environment
+   variable RESULT_CACHE_DIR_ENV names a directory.  It then preprocesses
+   each source file on its own and pipes the compiler proper into the
+   assembler, so that execute sees both commands at once.  An entry is
+   named after the MD5 sum of the preprocessed source, both commands
+   (less their temporary files and the object file name), the programs
+   run and the parts of the environment they look at.  On a hit the
+   driver copies the object file and replays the diagnostics that came
+   with it, and runs neither command.
+
+   Entries are kept in 16 subdirectories, by the first digit of their
+   name, and each subdirectory holds at most a 16th of the limit given
+   by RESULT_CACHE_SIZE_ENV.  When storing an entry takes one over it,
+   the least recently used entries there are removed until it is back
+   to four fifths of that.  */
+
+#define RESULT_CACHE_DIR_ENV "GCC_CACHE_DIR"
+#define RESULT_CACHE_SIZE_ENV "GCC_CACHE_SIZE"
+#define RESULT_CACHE_MAGIC "gcc-result-cache-1"
+
+/* Default limit on the size of the cache, in kilobytes.  */
+#define RESULT_CACHE_DEFAULT_SIZE (1024 * 1024)
+
+/* The cache directory, or null if there is no cache, and the most it
+   may hold in kilobytes, or zero for no limit.  */
+static const char *result_cache_dir;
+static unsigned long result_cache_limit;
+
+/* A compilation looked up in the cache.  */
+struct result_cache_job
+{
+  /* The name of its entry without a suffix, or null if the compilation
+     cannot be cached.  */
+  char *name;
+  /* The object file the assembler writes.  */
+  const char *object;
+  /* Where the compiler and the assembler write their diagnostics.  */
+  char *errors[2];
+};
+
+/* Options of the compiler proper, or prefixes of them, that read or
+   write files other than its input and output, or that make its
+   diagnostics worth seeing as they come.  */
+static const char *const result_cache_unsuitable[] = {
+  "-fprofile-", "-fbranch-probabilities", "-ftest-coverage", "-fdump-",
+  "-frepo", "-aux-info", "-version", NULL
+};
+
+/* Environment variables the compiler proper or the assembler look at.  */
+static const char *const result_cache_env[] = {
+  "GCC_DASH_W", "GCC_ERROR_COLON", "RC_FORCE_SSE3",
+  "LANG", "LC_ALL", "LC_CTYPE", "LC_MESSAGES", NULL
+};
+
+/* Parse the cache size S, a number of bytes optionally followed by
+   k, M or G, and return it in kilobytes.  */
+
+static unsigned long
+result_cache_size (const char *s)
+{
+  char *end;
+  unsigned long n = strtoul (s, &end, 10);
+
+  switch (*end)
+    {
+    case 'k': case 'K':
+      end++;
+      break;
+    case 'm': case 'M':
+      n *= 1024;
+      end++;
+      break;
+    case 'g': case 'G':
+      n *= 1024 * 1024;
+      end++;
+      break;
+    default:
+      n /= 1024;
+      break;
+    }
+  if (end == s || *end != '\0')
+    {
+      error ("warning: ignoring invalid %s '%s'", RESULT_CACHE_SIZE_ENV, s);
+      return RESULT_CACHE_DEFAULT_SIZE;
+    }
+  return n;
+}
+
+/* Return true if NAME is a temporary file of this compilation.  */
+
+static bool
+temp_file_p (const char *name)
+{
+  struct temp_file *temp;
+
+  for (temp = always_delete_queue; temp; temp = temp->next)
+    if (strcmp (name, temp->name) == 0)
+      return true;
+  return false;
+}
+
+/* Add S, with its terminating NUL, to the sum CTX.  */
+
+static void
+result_cache_hash (struct md5_ctx *ctx, const char *s)
+{
+  md5_process_bytes (s, strlen (s) + 1, ctx);
+}
+
+/* Add the program PROG to the sum CTX, and return false if it cannot
+   be found.  */
+
+static bool
+result_cache_hash_program (struct md5_ctx *ctx, const char *prog)
+{
+  struct stat st;
+  char buf[64];
+
+  if (stat (prog, &st) != 0)
+    return false;
+  result_cache_hash (ctx, prog);
+  sprintf (buf, "%lu %lu", (unsigned long) st.st_size,
+	   (unsigned long) st.st_mtime);
+  result_cache_hash (ctx, buf);
+  return true;
+}
+
+/* Copy the contents of descriptor FROM to descriptor TO, and return
+   false if that fails.  */
+
+static bool
+copy_descriptor (int from, int to)
+{
+  char buf[8192];
+  ssize_t n, done, m;
+
+  while ((n = read (from, buf, sizeof (buf))) != 0)
+    {
+      if (n < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  return false;
+	}
+      for (done = 0; done < n; done += m)
+	{
+	  m = write (to, buf + done, n - done);
+	  if (m < 0 && errno == EINTR)
+	    m = 0;
+	  else if (m <= 0)
+	    return false;
+	}
+    }
+  return true;
+}
+
+/* Copy the file FROM to the file TO, and return false, leaving no TO
+   behind, if that fails.  */
+
+static bool
+copy_file (const char *from, const char *to)
+{
+  int in, out;
+  bool ok;
+
+  in = open (from, O_RDONLY);
+  if (in < 0)
+    return false;
+  out = open (to, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (out < 0)
+    {
+      close (in);
+      return false;
+    }
+  ok = copy_descriptor (in, out);
+  close (in);
+  if (close (out) != 0)
+    ok = false;
+  if (!ok)
+    unlink (to);
+  return ok;
+}
+
+/* Copy the file NAME, if it exists, to the standard error.  */
+
+static void
+replay_errors (const char *name)
+{
+  int fd = open (name, O_RDONLY);
+
+  if (fd >= 0)
+    {
+      copy_descriptor (fd, 2);
+      close (fd);
+    }
+}
+
+/* Work out the entry in JOB for the compiler proper command CC1, whose
+   output the assembler command AS reads, leaving JOB->name null if the
+   compilation cannot be cached.  */
+
+static void
+result_cache_key (const char **cc1, const char **as,
+		  struct result_cache_job *job)
+{
+  struct md5_ctx ctx;
+  unsigned char digest[16];
+  char hex[33], sub[2];
+  const char *input = NULL, *object = NULL, *cwd;
+  bool debug = false;
+  FILE *f;
+  int i, j;
+
+  if (strncmp (lbasename (cc1[0]), "cc1", 3) != 0
+      || strcmp (lbasename (as[0]), "as") != 0)
+    return;
+
+  md5_init_ctx (&ctx);
+  result_cache_hash (&ctx, RESULT_CACHE_MAGIC);
+  result_cache_hash (&ctx, version_string);
+  result_cache_hash (&ctx, spec_machine);
+  if (!result_cache_hash_program (&ctx, cc1[0])
+      || !result_cache_hash_program (&ctx, as[0]))
+    return;
+
+  for (i = 1; cc1[i]; i++)
+    {
+      for (j = 0; result_cache_unsuitable[j]; j++)
+	if (strncmp (cc1[i], result_cache_unsuitable[j],
+		     strlen (result_cache_unsuitable[j])) == 0)
+	  return;
+      if (cc1[i][0] == '-' && cc1[i][1] == 'd'
+	  && strcmp (cc1[i], "-dumpbase") != 0)
+	return;
+      /* The base name for auxiliary files only matters to the options
+	 above.  */
+      if ((strcmp (cc1[i], "-auxbase") == 0
+	   || strcmp (cc1[i], "-auxbase-strip") == 0)
+	  && cc1[i + 1])
+	{
+	  i++;
+	  continue;
+	}
+      /* The compiler must write to the pipe.  */
+      if (strcmp (cc1[i], "-o") == 0
+	  && (cc1[i + 1] == NULL || strcmp (cc1[i + 1], "-") != 0))
+	return;
+      if (strncmp (cc1[i], "-g", 2) == 0 && strcmp (cc1[i], "-g0") != 0)
+	debug = true;
+      if (strcmp (cc1[i], "-fpreprocessed") == 0 && cc1[i + 1])
+	input = cc1[i + 1];
+      if (!temp_file_p (cc1[i]))
+	result_cache_hash (&ctx, cc1[i]);
+    }
+  result_cache_hash (&ctx, "|");
+  for (i = 1; as[i]; i++)
+    if (strcmp (as[i], "-o") == 0 && as[i + 1])
+      object = as[++i];
+    else if (!temp_file_p (as[i]))
+      result_cache_hash (&ctx, as[i]);
+  if (input == NULL || object == NULL || strcmp (object, "-") == 0)
+    return;
+
+  /* Without -fworking-directory the preprocessed source does not say
+     where it was compiled, but the debugging information does.  */
+  if (debug)
+    {
+      cwd = getpwd ();
+      if (cwd == NULL)
+	return;
+      result_cache_hash (&ctx, cwd);
+    }
+
+  for (i = 0; result_cache_env[i]; i++)
+    {
+      const char *value = getenv (result_cache_env[i]);
+
+      result_cache_hash (&ctx, result_cache_env[i]);
+      result_cache_hash (&ctx, value ? value : "");
+      md5_process_bytes (value ? "=" : "", 1, &ctx);
+    }
+
+  f = fopen (input, "rb");
+  if (f == NULL)
+    return;
+  i = md5_stream (f, digest);
+  fclose (f);
+  if (i != 0)
+    return;
+  md5_process_bytes (digest, sizeof (digest), &ctx);
+
+  md5_finish_ctx (&ctx, digest);
+  for (i = 0; i < 16; i++)
+    sprintf (hex + 2 * i, "%02x", digest[i]);
+  sub[0] = hex[0];
+  sub[1] = '\0';
+  job->name = concat (result_cache_dir, dir_separator_str, sub,
+		      dir_separator_str, hex, NULL);
+  job->object = object;
+}
+
+/* Look up the compilation made of the compiler proper command CC1 and
+   the assembler command AS in the cache, and describe it in JOB.
+   Return true if the cache had it, in which case its object file and
+   diagnostics have been reproduced.  */
+
+static bool
+result_cache_lookup (const char **cc1, const char **as,
+		     struct result_cache_job *job)
+{
+  char *entry;
+  bool hit;
+
+  memset (job, 0, sizeof (*job));
+  result_cache_key (cc1, as, job);
+  if (job->name == NULL)
+    return false;
+
+  entry = concat (job->name, ".o", NULL);
+  hit = copy_file (entry, job->object);
+  if (hit)
+    {
+      /* Keep the entry's time up to date for result_cache_trim.  */
+      utime (entry, NULL);
+      free (entry);
+      entry = concat (job->name, ".err", NULL);
+      fflush (stderr);
+      replay_errors (entry);
+      free (job->name);
+      job->name = NULL;
+    }
+  else
+    {
+      job->errors[0] = make_temp_file (".err");
+      job->errors[1] = make_temp_file (".err");
+      record_temp_file (job->errors[0], 1, 1);
+      record_temp_file (job->errors[1], 1, 1);
+    }
+  free (entry);
+  return hit;
+}
+
+/* An entry in a cache subdirectory.  */
+
+struct result_cache_entry
+{
+  char *name;
+  time_t time;
+  unsigned long size;
+};
+
+static int
+compare_result_cache_entries (const void *a, const void *b)
+{
+  const struct result_cache_entry *const e1 = a;
+  const struct result_cache_entry *const e2 = b;
+
+  return e1->time < e2->time ? -1 : e1->time > e2->time;
+}
+
+/* Return the size of the file NAME in kilobytes, and its time in
+   *TIME if TIME is not null.  */
+
+static unsigned long
+result_cache_file_size (const char *name, time_t *time)
+{
+  struct stat st;
+
+  if (stat (name, &st) != 0)
+    return 0;
+  if (time)
+    *time = st.st_mtime;
+  return ((unsigned long) st.st_size + 1023) / 1024;
+}
+
+/* Remove the least recently used entries of the cache subdirectory SUB
+   if it holds more than its share of the cache.  */
+
+static void
+result_cache_trim (const char *sub)
+{
+  unsigned long limit = (result_cache_limit + 15) / 16, total = 0;
+  struct result_cache_entry *entries = NULL;
+  size_t n = 0, alloc = 0, i;
+  struct dirent *d;
+  DIR *dir;
+
+  if (limit == 0)
+    return;
+  dir = opendir (sub);
+  if (dir == NULL)
+    return;
+  while ((d = readdir (dir)) != NULL)
+    {
+      char *name;
+      size_t len = strlen (d->d_name);
+
+      if (d->d_name[0] == '.')
+	continue;
+      name = concat (sub, dir_separator_str, d->d_name, NULL);
+      if (len == 34 && strcmp (d->d_name + 32, ".o") == 0)
+	{
+	  char *errors;
+
+	  if (n == alloc)
+	    {
+	      alloc = alloc ? 2 * alloc : 64;
+	      entries = XRESIZEVEC (struct result_cache_entry, entries, alloc);
+	    }
+	  entries[n].size = result_cache_file_size (name, &entries[n].time);
+	  name[strlen (name) - 2] = '\0';
+	  errors = concat (name, ".err", NULL);
+	  entries[n].size += result_cache_file_size (errors, NULL);
+	  free (errors);
+	  entries[n].name = name;
+	  total += entries[n++].size;
+	}
+      else
+	{
+	  if (len < 4 || strcmp (d->d_name + len - 4, ".err") != 0)
+	    total += result_cache_file_size (name, NULL);
+	  free (name);
+	}
+    }
+  closedir (dir);
+
+  if (total > limit)
+    {
+      qsort (entries, n, sizeof (*entries), compare_result_cache_entries);
+      for (i = 0; i < n && total > limit / 5 * 4; i++)
+	{
+	  char *name = concat (entries[i].name, ".o", NULL);
+
+	  unlink (name);
+	  free (name);
+	  name = concat (entries[i].name, ".err", NULL);
+	  unlink (name);
+	  free (name);
+	  total -= entries[i].size;
+	}
+    }
+  for (i = 0; i < n; i++)
+    free (entries[i].name);
+  free (entries);
+}
+
+/* The commands of JOB, a cache miss, have finished with the wait
+   statuses STATUSES.  Show their diagnostics, and if they succeeded
+   store the result in the cache.  */
+
+static void
+result_cache_store (struct result_cache_job *job, const int *statuses)
+{
+  char *sub, *tmp, *entry;
+  char suffix[32];
+  bool ok = true;
+  int i, fd;
+
+  fflush (stderr);
+  for (i = 0; i < 2; i++)
+    {
+      replay_errors (job->errors[i]);
+      if (!WIFEXITED (statuses[i]) || WEXITSTATUS (statuses[i]) != 0)
+	ok = false;
+    }
+
+  sub = xstrdup (job->name);
+  ((char *) lbasename (sub))[-1] = '\0';
+  if (ok)
+    {
+      mkdir (result_cache_dir, 0777);
+      mkdir (sub, 0777);
+
+      sprintf (suffix, ".%ld.tmp", (long) getpid ());
+      tmp = concat (job->name, suffix, NULL);
+
+      /* The diagnostics go in first, so that an entry is never found
+	 without them.  */
+      entry = concat (job->name, ".err", NULL);
+      fd = open (tmp, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+      if (fd < 0)
+	ok = false;
+      else
+	{
+	  for (i = 0; i < 2; i++)
+	    {
+	      int in = open (job->errors[i], O_RDONLY);
+
+	      if (in < 0 || !copy_descriptor (in, fd))
+		ok = false;
+	      if (in >= 0)
+		close (in);
+	    }
+	  if (close (fd) != 0)
+	    ok = false;
+	  if (ok && result_cache_file_size (tmp, NULL) == 0)
+	    unlink (entry);
+	  else if (ok)
+	    ok = rename (tmp, entry) == 0;
+	  unlink (tmp);
+	}
+      free (entry);
+
+      entry = concat (job->name, ".o", NULL);
+      if (ok && copy_file (job->object, tmp) && rename (tmp, entry) != 0)
+	unlink (tmp);
+      free (entry);
+      free (tmp);
+
+      if (ok)
+	result_cache_trim (sub);
+    }
+  free (sub);
+  free (job->name);
+  job->name = NULL;
+}
+/* APPLE LOCAL end result cache */
+
 /* Execute the command specified by the arguments on the current line of spec.
    When using pipes, this includes several piped-together commands
    with `|' between them.
@@ -2849,6 +3673,10 @@ execute (void)
   };
 
   struct command *commands;	/* each command buffer with above info.  */
+  /* APPLE LOCAL result cache */
+  struct result_cache_job cache_job;
+  /* APPLE LOCAL resource log */
+  bool log_resources = resource_log_p ();
 
   gcc_assert (!processing_spec_function);
 
@@ -2997,9 +3825,54 @@ execute (void)
     }
 #endif
 
+  /* APPLE LOCAL begin result cache */
+  cache_job.name = NULL;
+  if (n_commands == 2 && result_cache_dir && !report_times
+      && result_cache_lookup (commands[0].argv, commands[1].argv,
+			      &cache_job))
+    {
+      for (i = 0; i < n_commands; i++)
+	if (commands[i].argv[0] != commands[i].prog)
+	  free ((void *) commands[i].argv[0]);
+      execution_count++;
+      return 0;
+    }
+  /* APPLE LOCAL end result cache */
+
+  /* APPLE LOCAL begin compile server */
+  /* APPLE LOCAL resource log */
+  if (n_commands == 1 && !report_times && !log_resources)
+    {
+      int status;
+
+      if (run_in_compile_server (commands[0].argv, &status))
+	{
+	  if (commands[0].argv[0] != commands[0].prog)
+	    free ((void *) commands[0].argv[0]);
+	  execution_count++;
+	  if (WIFSIGNALED (status))
+	    fatal_ice ("\
+Internal error: %s (program %s)\n\
+Please submit a full bug report.\n\
+See %s for instructions.",
+		       strsignal (WTERMSIG (status)), commands[0].prog,
+		       bug_report_url);
+	  if (WIFEXITED (status) && WEXITSTATUS (status) >= MIN_FATAL_STATUS)
+	    {
+	      if (WEXITSTATUS (status) > greatest_status)
+		greatest_status = WEXITSTATUS (status);
+	      return -1;
+	    }
+	  return 0;
+	}
+    }
+  /* APPLE LOCAL end compile server */
+
   /* Run each piped subprocess.  */
 
-  pex = pex_init (PEX_USE_PIPES | (report_times ? PEX_RECORD_TIMES : 0),
+  /* APPLE LOCAL resource log */
+  pex = pex_init (PEX_USE_PIPES
+		  | (report_times || log_resources ? PEX_RECORD_TIMES : 0),
 		  programname, temp_filename);
   if (pex == NULL)
     pfatal_with_name (_("pex_init failed"));
@@ -3026,7 +3899,8 @@ execute (void)
 			((i + 1 == n_commands ? PEX_LAST : 0)
 			 | (string == commands[i].prog ? PEX_SEARCH : 0)),
 			string, (char * const *) commands[i].argv,
-			NULL, NULL, &err);
+			/* APPLE LOCAL result cache */
+			NULL, cache_job.name ? cache_job.errors[i] : NULL, &err);
       /* APPLE LOCAL end verbose help 2920964 */
       if (errmsg != NULL)
 	{
@@ -3040,7 +3914,8 @@ execute (void)
 	    }
 	}
 
-      if (string != commands[i].prog)
+      /* APPLE LOCAL resource log */
+      if (string != commands[i].prog && !log_resources)
 	free ((void *) string);
     }
 
@@ -3057,7 +3932,8 @@ execute (void)
     if (!pex_get_status (pex, n_commands, statuses))
       pfatal_with_name (_("failed to get exit status"));
 
-    if (report_times)
+    /* APPLE LOCAL resource log */
+    if (report_times || log_resources)
       {
 	times = alloca (n_commands * sizeof (struct pex_time));
 	if (!pex_get_times (pex, n_commands, times))
@@ -3066,10 +3942,25 @@ execute (void)
 
     pex_free (pex);
 
+    /* APPLE LOCAL begin result cache */
+    if (cache_job.name)
+      result_cache_store (&cache_job, statuses);
+    /* APPLE LOCAL end result cache */
+
     for (i = 0; i < n_commands; ++i)
       {
 	int status = statuses[i];
 
+	/* APPLE LOCAL begin resource log */
+	if (log_resources)
+	  {
+	    resource_log (commands[i].argv, resource_log_input (), status,
+			  &times[i]);
+	    if (commands[i].argv[0] != commands[i].prog)
+	      free ((void *) commands[i].argv[0]);
+	  }
+	/* APPLE LOCAL end resource log */
+
 	if (WIFSIGNALED (status))
 	  {
 #ifdef SIGPIPE
@@ -3292,6 +4183,8 @@ display_help (void)
   fputs (_("  -combine                 Pass multiple source files to compiler at once\n"), stdout);
   fputs (_("  -save-temps              Do not delete intermediate files\n"), stdout);
   fputs (_("  -pipe                    Use pipes rather than intermediate files\n"), stdout);
+  /* APPLE LOCAL parallel driver */
+  fputs (_("  -j <number>              Compile up to <number> input files at once\n"), stdout);
   fputs (_("  -time                    Time the execution of each subprocess\n"), stdout);
   fputs (_("  -specs=<file>            Override built-in specs with the contents of <file>\n"), stdout);
   fputs (_("  -std=<standard>          Assume that the input sources are for <standard>\n"), stdout);
@@ -3367,6 +4260,47 @@ add_linker_option (const char *option, int len)
   linker_options [n_linker_options - 1] = save_string (option, len);
 }
 
+/* APPLE LOCAL begin result cache */
+/* Set up the cache if the environment asks for one and the command
+   line compiles anything to an object file.  */
+
+static void
+init_result_cache (void)
+{
+  const char *dir = getenv (RESULT_CACHE_DIR_ENV);
+  const char *size = getenv (RESULT_CACHE_SIZE_ENV);
+  int i;
+
+  if (dir == NULL || *dir == '\0'
+      || save_temps_flag || combine_flag || verbose_only_flag
+      || print_help_list || target_help_flag)
+    return;
+  for (i = 0; i < n_switches; i++)
+    if (strcmp (switches[i].part1, "E") == 0
+	|| strcmp (switches[i].part1, "M") == 0
+	|| strcmp (switches[i].part1, "MM") == 0
+	|| strcmp (switches[i].part1, "S") == 0
+	|| strcmp (switches[i].part1, "fsyntax-only") == 0)
+      return;
+
+  result_cache_dir = dir;
+  result_cache_limit = RESULT_CACHE_DEFAULT_SIZE;
+  if (size != NULL && *size != '\0')
+    result_cache_limit = result_cache_size (size);
+
+  /* Have the specs preprocess separately, and pipe the compiler into
+     the assembler.  */
+  switches = XRESIZEVEC (struct switchstr, switches, n_switches + 2);
+  switches[n_switches].part1 = "no-integrated-cpp";
+  switches[n_switches].args = 0;
+  switches[n_switches].live_cond = SWITCH_OK;
+  switches[n_switches].validated = 1;
+  switches[n_switches].ordering = 0;
+  n_switches++;
+  use_pipes = 1;
+}
+/* APPLE LOCAL end result cache */
+
 /* Create the vector `switches' and its contents.
    Store its length in `n_switches'.  */
 
@@ -3877,6 +4811,22 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
 	}
       else if (strcmp (argv[i], "-time") == 0)
 	report_times = 1;
+      /* APPLE LOCAL begin parallel driver */
+      else if (strncmp (argv[i], "-j", 2) == 0)
+	{
+	  const char *n = argv[i] + 2;
+
+	  if (*n == '\0')
+	    {
+	      if (++i >= argc)
+		fatal ("argument to '-j' is missing");
+	      n = argv[i];
+	    }
+	  max_jobs = atoi (n);
+	  if (max_jobs < 1 || strspn (n, "0123456789") != strlen (n))
+	    fatal ("argument to '-j' should be a positive number");
+	}
+      /* APPLE LOCAL end parallel driver */
       else if (strcmp (argv[i], "-pipe") == 0)
 	{
 	  /* -pipe has to go into the switches array as well as
@@ -4334,6 +5284,12 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
       /* APPLE LOCAL end -ObjC 2001-08-03 --sts */
       else if (strcmp (argv[i], "-time") == 0)
 	;
+      /* APPLE LOCAL begin parallel driver */
+      else if (strcmp (argv[i], "-j") == 0)
+	i++;
+      else if (strncmp (argv[i], "-j", 2) == 0)
+	;
+      /* APPLE LOCAL end parallel driver */
       else if (strcmp (argv[i], "-###") == 0)
 	;
       /* APPLE LOCAL begin frameworks */
@@ -4475,6 +5431,9 @@ warranty; not even for MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.\n\n"
 	}
     }
 
+  /* APPLE LOCAL result cache */
+  init_result_cache ();
+
   switches[n_switches].part1 = 0;
   infiles[n_infiles].name = 0;
 }
@@ -6368,6 +7327,16 @@ is_directory (const char *path1, bool linker)
   return (stat (path, &st) >= 0 && S_ISDIR (st.st_mode));
 }
 
+/* APPLE LOCAL begin resource log */
+/* Return the input file being compiled, or null when linking.  */
+
+static const char *
+resource_log_input (void)
+{
+  return input_file_number < n_infiles ? input_filename : NULL;
+}
+/* APPLE LOCAL end resource log */
+
 /* Set up the various global variables to indicate that we're processing
    the input file named FILENAME.  */
 
@@ -6412,6 +7381,248 @@ set_input (const char *filename)
 
 /* On fatal signals, delete all the temporary files.  */
 
+/* APPLE LOCAL begin parallel driver */
+/* With -j, each input file is compiled by a copy of the driver made
+   with fork.  Its output goes to temporary files, which are copied out
+   in input file order once it is done, so each file's diagnostics stay
+   together and in the usual order.  What the rest of the driver needs
+   to know about the compilation is passed back in a third file.  */
+
+struct compile_job
+{
+  /* The copy doing the compilation, or 0 once it has finished.  */
+  pid_t pid;
+  /* Whether a copy was started for this input file, and its status.  */
+  bool started;
+  int status;
+  /* Where its standard output and error, and its results, go.  */
+  char *out_name;
+  char *err_name;
+  char *result_name;
+};
+
+/* One job per input file, how many are running, the input files up to
+   which jobs have been started, and those up to which they have been
+   finished off.  */
+
+static struct compile_job *compile_jobs;
+static int running_jobs;
+static int reached_jobs;
+static int flushed_jobs;
+
+/* Write out, to the file where the parent expects them, the results of
+   the compilation of input file I, which failed if THIS_FILE_ERROR.  */
+
+static void
+write_compile_job_result (int i, int this_file_error)
+{
+  FILE *f = fopen (compile_jobs[i].result_name, "wb");
+  struct temp_file *temp;
+
+  if (f == NULL)
+    pfatal_with_name (compile_jobs[i].result_name);
+  fprintf (f, "%d %d %d", this_file_error, greatest_status, signal_count);
+  putc ('\0', f);
+  if (outfiles[i])
+    fprintf (f, "o%s%c", outfiles[i], '\0');
+  for (temp = always_delete_queue; temp; temp = temp->next)
+    fprintf (f, "d%s%c", temp->name, '\0');
+  if (fclose (f) != 0)
+    pfatal_with_name (compile_jobs[i].result_name);
+}
+
+/* Compile input file I, which set_input has been called for, with
+   INPUT_FILE_COMPILER in a copy of this driver.  Wait first if there
+   are already as many compilations going as -j allows.  */
+
+static void
+start_compile_job (int i)
+{
+  struct compile_job *job;
+
+  if (compile_jobs == NULL)
+    compile_jobs = XCNEWVEC (struct compile_job, n_infiles);
+  job = &compile_jobs[i];
+
+  while (running_jobs >= max_jobs)
+    reap_compile_job ();
+
+  job->out_name = make_temp_file (".out");
+  job->err_name = make_temp_file (".err");
+  job->result_name = make_temp_file (".res");
+  record_temp_file (job->out_name, 1, 0);
+  record_temp_file (job->err_name, 1, 0);
+  record_temp_file (job->result_name, 1, 0);
+
+  fflush (stdout);
+  fflush (stderr);
+#ifdef HAVE_WORKING_FORK
+  job->pid = fork ();
+#else
+  job->pid = -1;
+  errno = ENOSYS;
+#endif
+  if (job->pid < 0)
+    pfatal_with_name ("fork");
+
+  if (job->pid == 0)
+    {
+      int out = open (job->out_name, O_WRONLY | O_TRUNC);
+      int err = open (job->err_name, O_WRONLY | O_TRUNC);
+      int this_file_error;
+
+      if (out < 0 || err < 0 || dup2 (out, 1) < 0 || dup2 (err, 2) < 0)
+	pfatal_with_name (job->err_name);
+      close (out);
+      close (err);
+
+      /* The temporary files so far are the parent's to delete.  */
+      always_delete_queue = 0;
+      failure_delete_queue = 0;
+
+      this_file_error = do_spec (input_file_compiler->spec) < 0;
+      if (this_file_error)
+	delete_failure_queue ();
+      write_compile_job_result (i, this_file_error);
+      fflush (stdout);
+      fflush (stderr);
+      _exit (0);
+    }
+
+  job->started = true;
+  running_jobs++;
+  reached_jobs = i + 1;
+}
+
+/* Wait for one of the running compilations to finish, and finish off
+   those that can be, in order.  */
+
+static void
+reap_compile_job (void)
+{
+  int status, i;
+  pid_t pid = waitpid (-1, &status, 0);
+
+  if (pid < 0)
+    pfatal_with_name ("waitpid");
+  for (i = flushed_jobs; i < reached_jobs; i++)
+    if (compile_jobs[i].started && compile_jobs[i].pid == pid)
+      {
+	compile_jobs[i].pid = 0;
+	compile_jobs[i].status = status;
+	running_jobs--;
+	break;
+      }
+  flush_compile_jobs ();
+}
+
+/* Copy the contents of the file NAME to STREAM.  */
+
+static void
+copy_compile_job_output (const char *name, FILE *stream)
+{
+  FILE *f = fopen (name, "rb");
+  char buf[4096];
+  size_t n;
+
+  if (f == NULL)
+    return;
+  while ((n = fread (buf, 1, sizeof (buf), f)) > 0)
+    fwrite (buf, 1, n, stream);
+  fclose (f);
+  fflush (stream);
+}
+
+/* Read the results of JOB, which compiled input file I, and record
+   them as if the compilation had been done here.  Return false if
+   there are none.  */
+
+static bool
+read_compile_job_result (struct compile_job *job, int i)
+{
+  FILE *f = fopen (job->result_name, "rb");
+  struct stat st;
+  char *buf, *p, *end;
+  int this_file_error, status, signals;
+
+  if (f == NULL || fstat (fileno (f), &st) != 0 || st.st_size == 0)
+    {
+      if (f)
+	fclose (f);
+      return false;
+    }
+  buf = XNEWVEC (char, st.st_size + 1);
+  if (fread (buf, 1, st.st_size, f) != (size_t) st.st_size)
+    pfatal_with_name (job->result_name);
+  fclose (f);
+  buf[st.st_size] = '\0';
+  end = buf + st.st_size;
+
+  if (sscanf (buf, "%d %d %d", &this_file_error, &status, &signals) != 3)
+    return false;
+  if (this_file_error)
+    error_count++;
+  if (status > greatest_status)
+    greatest_status = status;
+  signal_count += signals;
+
+  outfiles[i] = NULL;
+  for (p = buf + strlen (buf) + 1; p < end; p += strlen (p) + 1)
+    if (*p == 'o')
+      outfiles[i] = xstrdup (p + 1);
+    else if (*p == 'd')
+      record_temp_file (p + 1, 1, 0);
+  free (buf);
+  return true;
+}
+
+/* Finish off, in input file order, each compilation that is done and
+   follows only finished ones: copy out what it wrote, and take on its
+   results.  */
+
+static void
+flush_compile_jobs (void)
+{
+  for (; flushed_jobs < reached_jobs; flushed_jobs++)
+    {
+      struct compile_job *job = &compile_jobs[flushed_jobs];
+
+      if (!job->started)
+	continue;
+      if (job->pid != 0)
+	break;
+
+      copy_compile_job_output (job->out_name, stdout);
+      copy_compile_job_output (job->err_name, stderr);
+      if (WIFSIGNALED (job->status))
+	{
+	  signal_count++;
+	  error_count++;
+	}
+      else if (!WIFEXITED (job->status) || WEXITSTATUS (job->status) != 0
+	       || !read_compile_job_result (job, flushed_jobs))
+	error_count++;
+
+      delete_if_ordinary (job->out_name);
+      delete_if_ordinary (job->err_name);
+      delete_if_ordinary (job->result_name);
+    }
+}
+
+/* Wait for all the compilations started by start_compile_job.  */
+
+static void
+finish_compile_jobs (void)
+{
+  if (compile_jobs == NULL)
+    return;
+  reached_jobs = n_infiles;
+  while (running_jobs > 0)
+    reap_compile_job ();
+  flush_compile_jobs ();
+}
+/* APPLE LOCAL end parallel driver */
+
 static void
 fatal_error (int signum)
 {
@@ -7044,6 +8255,16 @@ main (int argc, char **argv)
 	  else if (!capital_e_flag || !combine_inputs)
 	  /* APPLE LOCAL end IMA */
 	    {
+	      /* APPLE LOCAL begin parallel driver */
+	      /* Leave the compilation to a copy of this driver, which
+		 sees to its own delete-on-failure queue.  */
+	      if (max_jobs > 1 && !combine_inputs)
+		{
+		  start_compile_job (i);
+		  infiles[i].compiled = true;
+		  continue;
+		}
+	      /* APPLE LOCAL end parallel driver */
 	      value = do_spec (input_file_compiler->spec);
 	      infiles[i].compiled = true;
 	      if (value < 0)
@@ -7069,6 +8290,9 @@ main (int argc, char **argv)
       clear_failure_queue ();
     }
 
+  /* APPLE LOCAL parallel driver */
+  finish_compile_jobs ();
+
   /* Reset the input file name to the first compile/object file name, for use
      with %b in LINK_SPEC. We use the first input file that we can find
      a compiler to compile it instead of using infiles.language since for
@@ -76,8 +76,10 @@ static int call_count (void **, void *);
 static int call_alloc (void **, void *);
 static int compare_ptr_data (const void *, const void *);
 static void relocate_ptrs (void *, void *);
-static void write_pch_globals (const struct ggc_root_tab * const *tab,
-			       struct traversal_state *state);
+/* APPLE LOCAL begin PCH sharing */
+static char *write_pch_globals (const struct ggc_root_tab * const *tab,
+				char *);
+/* APPLE LOCAL end PCH sharing */
 static double ggc_rlimit_bound (double);
 
 /* Maintain global roots that are preserved during GC.  */
@@ -236,6 +238,75 @@ ggc_print_common_statistics (FILE *stream ATTRIBUTE_UNUSED,
 
 static htab_t saving_htab;
 
+/* Hold the information we need to mmap the file back in.  */
+
+struct mmap_info
+{
+  size_t offset;
+  size_t size;
+  void *preferred_base;
+};
+
+/* APPLE LOCAL begin chained PCH */
+/* A PCH image mapped into this compiler.  A PCH written on top of
+   these refers to their objects instead of copying them; only new
+   objects, and the objects of these images that have changed, go into
+   the new file.  */
+
+struct pch_image
+{
+  /* The absolute name of the file, with its size and modification
+     time when it was loaded.  */
+  char *name;
+  size_t file_size;
+  long mtime;
+  /* Where the image is in the file and where it was laid out to go.  */
+  struct mmap_info mmi;
+  /* Where it went.  */
+  char *addr;
+};
+
+/* How a pch_image is recorded in a PCH built on top of it.  The name
+   follows.  */
+
+struct pch_image_ondisk
+{
+  size_t name_len;
+  size_t file_size;
+  long mtime;
+  struct mmap_info mmi;
+};
+
+/* A changed object of a loaded image.  SIZE bytes of data follow, then
+   a relocation bitmap for them.  */
+
+struct pch_patch
+{
+  size_t image;
+  size_t offset;
+  size_t size;
+};
+
+/* The PCH images in this compiler, in the order they were mapped.  */
+
+static struct pch_image *pch_images;
+static size_t n_pch_images;
+
+/* Return the loaded image containing OBJ, or NULL.  */
+
+static struct pch_image *
+gt_pch_image_of (const void *obj)
+{
+  size_t i;
+
+  for (i = 0; i < n_pch_images; i++)
+    if ((const char *) obj >= pch_images[i].addr
+	&& (const char *) obj < pch_images[i].addr + pch_images[i].mmi.size)
+      return &pch_images[i];
+  return NULL;
+}
+/* APPLE LOCAL end chained PCH */
+
 struct ptr_data
 {
   void *obj;
@@ -245,6 +316,8 @@ struct ptr_data
   size_t size;
   void *new_addr;
   enum gt_types_enum type;
+  /* APPLE LOCAL chained PCH */
+  struct pch_image *image;
 };
 
 #define POINTER_HASH(x) (hashval_t)((long)x >> 3)
@@ -323,6 +396,37 @@ struct traversal_state
   size_t count;
   struct ptr_data **ptrs;
   size_t ptrs_i;
+  /* APPLE LOCAL begin relocatable PCH */
+  /* The address the image is laid out for, and a bitmap with one bit
+     per pointer-sized word of the image, set for each word holding a
+     pointer that must be adjusted if the image is mapped elsewhere.
+     RELOCATABLE is cleared if some pointer could not be recorded, in
+     which case the image can only be used at its preferred address.  */
+  char *base;
+  unsigned char *reloc;
+  size_t reloc_bytes;
+  bool relocatable;
+  /* Set when the current object had a pointer converted through a
+     temporary, so its slot is not known; and the displacement added to
+     every pointer while finding such slots.  */
+  bool indirect;
+  size_t shift;
+  /* APPLE LOCAL end relocatable PCH */
+  /* APPLE LOCAL begin chained PCH */
+  /* Where gt_pch_note_reloc records pointers: the bitmap, and the
+     address its first bit stands for.  This is RELOC and BASE, except
+     while an object of a loaded image is being compared.  */
+  unsigned char *reloc_map;
+  size_t reloc_origin;
+  /* Set if objects of the loaded PCH images are to be referred to
+     rather than copied.  PRISTINE holds the contents of each image as
+     it is in its file, and PATCHES accumulates the objects that have
+     changed since, PATCH_COUNT of them in PATCHES_SIZE bytes.  */
+  bool chain;
+  char **pristine;
+  char *patches;
+  size_t patches_size, patches_alloc, patch_count;
+  /* APPLE LOCAL end chained PCH */
 };
 
 /* Callbacks for htab_traverse.  */
@@ -333,9 +437,14 @@ call_count (void **slot, void *state_p)
   struct ptr_data *d = (struct ptr_data *)*slot;
   struct traversal_state *state = (struct traversal_state *)state_p;
 
-  ggc_pch_count_object (state->d, d->obj, d->size,
-			d->note_ptr_fn == gt_pch_p_S,
-			d->type);
+  /* APPLE LOCAL begin chained PCH */
+  if (state->chain)
+    d->image = gt_pch_image_of (d->obj);
+  if (!d->image)
+    ggc_pch_count_object (state->d, d->obj, d->size,
+			  d->note_ptr_fn == gt_pch_p_S,
+			  d->type);
+  /* APPLE LOCAL end chained PCH */
   state->count++;
   return 1;
 }
@@ -346,9 +455,16 @@ call_alloc (void **slot, void *state_p)
   struct ptr_data *d = (struct ptr_data *)*slot;
   struct traversal_state *state = (struct traversal_state *)state_p;
 
-  d->new_addr = ggc_pch_alloc_object (state->d, d->obj, d->size,
-				      d->note_ptr_fn == gt_pch_p_S,
-				      d->type);
+  /* APPLE LOCAL begin chained PCH */
+  /* Objects of a loaded image stay where that image was laid out.  */
+  if (d->image)
+    d->new_addr = ((char *) d->image->mmi.preferred_base
+		   + ((char *) d->obj - d->image->addr));
+  else
+    d->new_addr = ggc_pch_alloc_object (state->d, d->obj, d->size,
+					d->note_ptr_fn == gt_pch_p_S,
+					d->type);
+  /* APPLE LOCAL end chained PCH */
   state->ptrs[state->ptrs_i++] = d;
   return 1;
 }
@@ -364,13 +480,64 @@ compare_ptr_data (const void *p1_p, const void *p2_p)
 	  - ((size_t)p1->new_addr < (size_t)p2->new_addr));
 }
 
+/* APPLE LOCAL begin relocatable PCH */
+/* Mark the pointer-sized word at byte SLOT of object D as needing
+   relocation, or give up on relocation if it is misaligned.  */
+
+static void
+gt_pch_note_reloc (struct traversal_state *state, struct ptr_data *d,
+		   size_t slot)
+{
+  /* APPLE LOCAL chained PCH */
+  size_t word = ((size_t) d->new_addr - state->reloc_origin) + slot;
+
+  if (word % sizeof (void *) != 0)
+    {
+      state->relocatable = false;
+      return;
+    }
+  word /= sizeof (void *);
+  /* APPLE LOCAL chained PCH */
+  state->reloc_map[word / CHAR_BIT] |= 1 << (word % CHAR_BIT);
+}
+
+/* Object D, whose original contents are ORIG, has just been rewritten
+   for the image but had some pointers converted through a temporary.
+   Rewrite it a second time with every pointer displaced, and record
+   each word that moved.  Leave D as it was on entry.  */
+
+static void
+gt_pch_find_indirect_ptrs (struct traversal_state *state,
+			   struct ptr_data *d, const char *orig)
+{
+  char *first = XNEWVEC (char, d->size);
+  size_t i;
+
+  memcpy (first, d->obj, d->size);
+  memcpy (d->obj, orig, d->size);
+  state->shift = sizeof (void *);
+  if (d->reorder_fn != NULL)
+    d->reorder_fn (d->obj, d->note_ptr_cookie, relocate_ptrs, state);
+  d->note_ptr_fn (d->obj, d->note_ptr_cookie, relocate_ptrs, state);
+  state->shift = 0;
+
+  for (i = 0; state->relocatable && i + sizeof (void *) <= d->size;
+       i += sizeof (void *))
+    if (memcmp (first + i, (char *) d->obj + i, sizeof (void *)) != 0)
+      gt_pch_note_reloc (state, d, i);
+
+  memcpy (d->obj, first, d->size);
+  free (first);
+}
+/* APPLE LOCAL end relocatable PCH */
+
 /* Callbacks for note_ptr_fn.  */
 
 static void
 relocate_ptrs (void *ptr_p, void *state_p)
 {
   void **ptr = (void **)ptr_p;
-  struct traversal_state *state ATTRIBUTE_UNUSED
+  struct traversal_state *state
     = (struct traversal_state *)state_p;
   struct ptr_data *result;
 
@@ -379,13 +546,52 @@ relocate_ptrs (void *ptr_p, void *state_p)
 
   result = htab_find_with_hash (saving_htab, *ptr, POINTER_HASH (*ptr));
   gcc_assert (result);
-  *ptr = result->new_addr;
+  /* APPLE LOCAL begin relocatable PCH */
+  *ptr = (char *) result->new_addr + state->shift;
+
+  /* Record where in the image this pointer will live.  Pointers
+     converted through a temporary (GTY nested_ptr) are not inside the
+     object; gt_pch_find_indirect_ptrs finds those.  */
+  if (state->relocatable)
+    {
+      struct ptr_data *obj = state->ptrs[state->ptrs_i];
+      size_t slot = (char *) ptr_p - (char *) obj->obj;
+
+      if (slot >= obj->size)
+	state->indirect = true;
+      else
+	gt_pch_note_reloc (state, obj, slot);
+    }
+  /* APPLE LOCAL end relocatable PCH */
 }
 
-/* Write out, after relocation, the pointers in TAB.  */
-static void
-write_pch_globals (const struct ggc_root_tab * const *tab,
-		   struct traversal_state *state)
+/* APPLE LOCAL begin PCH sharing */
+/* Return the size of the root block of a PCH file: the scalar roots,
+   then each global pointer.  */
+
+static size_t
+gt_pch_roots_size (void)
+{
+  const struct ggc_root_tab *const *rt;
+  const struct ggc_root_tab *rti;
+  size_t size = 0;
+
+  for (rt = gt_pch_scalar_rtab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      size += rti->stride;
+  for (rt = gt_ggc_rtab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      size += rti->nelt * sizeof (void *);
+  for (rt = gt_pch_cache_rtab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      size += rti->nelt * sizeof (void *);
+  return size;
+}
+
+/* Store, after relocation, the pointers in TAB at OUT.  Return the end
+   of what was stored.  */
+static char *
+write_pch_globals (const struct ggc_root_tab * const *tab, char *out)
 {
   const struct ggc_root_tab *const *rt;
   const struct ggc_root_tab *rti;
@@ -397,36 +603,123 @@ write_pch_globals (const struct ggc_root_tab * const *tab,
 	{
 	  void *ptr = *(void **)((char *)rti->base + rti->stride * i);
 	  struct ptr_data *new_ptr;
-	  if (ptr == NULL || ptr == (void *)1)
-	    {
-	      if (fwrite (&ptr, sizeof (void *), 1, state->f)
-		  != 1)
-		fatal_error ("can't write PCH file: %m");
-	    }
-	  else
+	  if (ptr != NULL && ptr != (void *)1)
 	    {
 	      new_ptr = htab_find_with_hash (saving_htab, ptr,
 					     POINTER_HASH (ptr));
-	      if (fwrite (&new_ptr->new_addr, sizeof (void *), 1, state->f)
-		  != 1)
-		fatal_error ("can't write PCH file: %m");
+	      ptr = new_ptr->new_addr;
 	    }
+	  memcpy (out, &ptr, sizeof (void *));
+	  out += sizeof (void *);
 	}
+  return out;
 }
 
-/* Hold the information we need to mmap the file back in.  */
+/* Copy the pointers in TAB from IN.  Return the end of what was
+   copied.  */
+static const char *
+read_pch_globals (const struct ggc_root_tab * const *tab, const char *in)
+{
+  const struct ggc_root_tab *const *rt;
+  const struct ggc_root_tab *rti;
+  size_t i;
 
-struct mmap_info
+  for (rt = tab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      for (i = 0; i < rti->nelt; i++)
+	{
+	  memcpy ((char *)rti->base + rti->stride * i, in, sizeof (void *));
+	  in += sizeof (void *);
+	}
+  return in;
+}
+/* APPLE LOCAL end PCH sharing */
+
+/* APPLE LOCAL begin chained PCH */
+/* Write to F the list of loaded images that the PCH being written
+   refers to: all of them if CHAIN, otherwise none.  */
+
+static void
+gt_pch_write_chain (FILE *f, bool chain)
 {
-  size_t offset;
-  size_t size;
-  void *preferred_base;
-};
+  size_t i, n = chain ? n_pch_images : 0;
+
+  if (fwrite (&n, sizeof (n), 1, f) != 1)
+    fatal_error ("can't write PCH file: %m");
+  for (i = 0; i < n; i++)
+    {
+      struct pch_image_ondisk od;
+
+      od.name_len = strlen (pch_images[i].name);
+      od.file_size = pch_images[i].file_size;
+      od.mtime = pch_images[i].mtime;
+      od.mmi = pch_images[i].mmi;
+      if (fwrite (&od, sizeof (od), 1, f) != 1
+	  || fwrite (pch_images[i].name, od.name_len, 1, f) != 1)
+	fatal_error ("can't write PCH file: %m");
+    }
+}
+
+/* Return the contents of IMAGE as they are in its file, before any
+   change made since it was loaded.  */
+
+static char *
+gt_pch_read_pristine (const struct pch_image *image)
+{
+  FILE *f = fopen (image->name, "rb");
+  char *buf;
+
+  if (f == NULL)
+    fatal_error ("can't open %s: %m", image->name);
+  buf = XNEWVEC (char, image->mmi.size);
+  if (fseek (f, image->mmi.offset, SEEK_SET) != 0
+      || fread (buf, image->mmi.size, 1, f) != 1)
+    fatal_error ("can't read %s: %m", image->name);
+  fclose (f);
+  return buf;
+}
+
+/* Object D of a loaded image has just been rewritten as it would be
+   saved, with its pointers recorded in STATE->reloc_map.  If that is
+   not what the image's file already has, queue it as a patch.  */
+
+static void
+gt_pch_note_patch (struct traversal_state *state, struct ptr_data *d)
+{
+  size_t image = d->image - pch_images;
+  size_t offset = (char *) d->obj - d->image->addr;
+  size_t map_bytes = (d->size / sizeof (void *) + CHAR_BIT - 1) / CHAR_BIT;
+  struct pch_patch patch;
+  char *p;
+
+  if (memcmp (d->obj, state->pristine[image] + offset, d->size) == 0)
+    return;
+
+  patch.image = image;
+  patch.offset = offset;
+  patch.size = d->size;
+  if (state->patches_size + sizeof (patch) + d->size + map_bytes
+      > state->patches_alloc)
+    {
+      state->patches_alloc = MAX (2 * state->patches_alloc,
+				  state->patches_size + sizeof (patch)
+				  + d->size + map_bytes);
+      state->patches = xrealloc (state->patches, state->patches_alloc);
+    }
+  p = state->patches + state->patches_size;
+  memcpy (p, &patch, sizeof (patch));
+  memcpy (p + sizeof (patch), d->obj, d->size);
+  memcpy (p + sizeof (patch) + d->size, state->reloc_map, map_bytes);
+  state->patches_size += sizeof (patch) + d->size + map_bytes;
+  state->patch_count++;
+}
+/* APPLE LOCAL end chained PCH */
 
 /* Write out the state of the compiler to F.  */
 
 void
-gt_pch_save (FILE *f)
+/* APPLE LOCAL chained PCH */
+gt_pch_save (FILE *f, bool chain)
 {
   const struct ggc_root_tab *const *rt;
   const struct ggc_root_tab *rti;
@@ -436,6 +729,14 @@ gt_pch_save (FILE *f)
   size_t this_object_size = 0;
   struct mmap_info mmi;
   const size_t mmap_offset_alignment = host_hooks.gt_pch_alloc_granularity();
+  /* APPLE LOCAL begin chained PCH */
+  unsigned char *patch_map = NULL;
+  size_t patch_map_bytes = 0;
+  /* APPLE LOCAL end chained PCH */
+  /* APPLE LOCAL begin PCH sharing */
+  char *roots, *p;
+  size_t roots_size;
+  /* APPLE LOCAL end PCH sharing */
 
   gt_pch_save_stringpool ();
 
@@ -455,17 +756,37 @@ gt_pch_save (FILE *f)
   state.f = f;
   state.d = init_ggc_pch();
   state.count = 0;
+  /* APPLE LOCAL chained PCH */
+  state.chain = chain && n_pch_images != 0;
   htab_traverse (saving_htab, call_count, &state);
 
   mmi.size = ggc_pch_total_size (state.d);
 
-  /* Try to arrange things so that no relocation is necessary, but
-     don't try very hard.  On most platforms, this will always work,
-     and on the rest it's a lot of work to do better.  
-     (The extra work goes in HOST_HOOKS_GT_PCH_GET_ADDRESS and
-     HOST_HOOKS_GT_PCH_USE_ADDRESS.)  */
-  mmi.preferred_base = host_hooks.gt_pch_get_address (mmi.size, fileno (f));
-      
+  /* APPLE LOCAL begin chained PCH */
+  /* A PCH built on others is laid out just above them, so that they
+     can all usually go where they were laid out to go, and otherwise
+     can all be moved by the same amount.  */
+  if (state.chain)
+    {
+      size_t end = 0;
+
+      for (i = 0; i < n_pch_images; i++)
+	end = MAX (end, ((size_t) pch_images[i].mmi.preferred_base
+			 + pch_images[i].mmi.size));
+      end = ((end + mmap_offset_alignment - 1)
+	     / mmap_offset_alignment * mmap_offset_alignment);
+      mmi.preferred_base = (void *) end;
+    }
+  else
+    /* Try to arrange things so that no relocation is necessary, but
+       don't try very hard.  On most platforms, this will always work,
+       and on the rest it's a lot of work to do better.
+       (The extra work goes in HOST_HOOKS_GT_PCH_GET_ADDRESS and
+       HOST_HOOKS_GT_PCH_USE_ADDRESS.)  */
+    mmi.preferred_base = host_hooks.gt_pch_get_address (mmi.size,
+							fileno (f));
+  /* APPLE LOCAL end chained PCH */
+
   ggc_pch_this_base (state.d, mmi.preferred_base);
 
   state.ptrs = XNEWVEC (struct ptr_data *, state.count);
@@ -473,15 +794,46 @@ gt_pch_save (FILE *f)
   htab_traverse (saving_htab, call_alloc, &state);
   qsort (state.ptrs, state.count, sizeof (*state.ptrs), compare_ptr_data);
 
-  /* Write out all the scalar variables.  */
+  /* APPLE LOCAL begin relocatable PCH */
+  state.base = mmi.preferred_base;
+  state.reloc_bytes = (mmi.size / sizeof (void *) + CHAR_BIT - 1) / CHAR_BIT;
+  state.reloc = XCNEWVEC (unsigned char, state.reloc_bytes);
+  state.relocatable = true;
+  state.shift = 0;
+  /* APPLE LOCAL end relocatable PCH */
+
+  /* APPLE LOCAL begin chained PCH */
+  state.pristine = NULL;
+  state.patches = NULL;
+  state.patches_size = state.patches_alloc = state.patch_count = 0;
+  if (state.chain)
+    {
+      state.pristine = XNEWVEC (char *, n_pch_images);
+      for (i = 0; i < n_pch_images; i++)
+	state.pristine[i] = gt_pch_read_pristine (&pch_images[i]);
+    }
+  gt_pch_write_chain (f, state.chain);
+  /* APPLE LOCAL end chained PCH */
+
+  /* APPLE LOCAL begin PCH sharing */
+  /* Write out all the scalar variables, then all the global pointers
+     after translation, as one block.  */
+  roots_size = gt_pch_roots_size ();
+  roots = XNEWVEC (char, roots_size);
+  p = roots;
   for (rt = gt_pch_scalar_rtab; *rt; rt++)
     for (rti = *rt; rti->base != NULL; rti++)
-      if (fwrite (rti->base, rti->stride, 1, f) != 1)
-	fatal_error ("can't write PCH file: %m");
-
-  /* Write out all the global pointers, after translation.  */
-  write_pch_globals (gt_ggc_rtab, &state);
-  write_pch_globals (gt_pch_cache_rtab, &state);
+      {
+	memcpy (p, rti->base, rti->stride);
+	p += rti->stride;
+      }
+  p = write_pch_globals (gt_ggc_rtab, p);
+  p = write_pch_globals (gt_pch_cache_rtab, p);
+  gcc_assert (p == roots + roots_size);
+  if (fwrite (roots, roots_size, 1, f) != 1)
+    fatal_error ("can't write PCH file: %m");
+  free (roots);
+  /* APPLE LOCAL end PCH sharing */
 
   /* Pad the PCH file so that the mmapped area starts on an allocation
      granularity (usually page) boundary.  */
@@ -512,6 +864,31 @@ gt_pch_save (FILE *f)
 	  this_object = xrealloc (this_object, this_object_size);
 	}
       memcpy (this_object, state.ptrs[i]->obj, state.ptrs[i]->size);
+      /* APPLE LOCAL relocatable PCH */
+      state.ptrs_i = i, state.indirect = false;
+      /* APPLE LOCAL begin chained PCH */
+      /* Pointers in an object of a loaded image are recorded for its
+	 patch, should it need one, rather than for the new image.  */
+      if (state.ptrs[i]->image)
+	{
+	  size_t map_bytes = ((state.ptrs[i]->size / sizeof (void *)
+			       + CHAR_BIT - 1) / CHAR_BIT);
+
+	  if (patch_map_bytes < map_bytes)
+	    {
+	      patch_map_bytes = map_bytes;
+	      patch_map = xrealloc (patch_map, patch_map_bytes);
+	    }
+	  memset (patch_map, 0, map_bytes);
+	  state.reloc_map = patch_map;
+	  state.reloc_origin = (size_t) state.ptrs[i]->new_addr;
+	}
+      else
+	{
+	  state.reloc_map = state.reloc;
+	  state.reloc_origin = (size_t) state.base;
+	}
+      /* APPLE LOCAL end chained PCH */
       if (state.ptrs[i]->reorder_fn != NULL)
 	state.ptrs[i]->reorder_fn (state.ptrs[i]->obj,
 				   state.ptrs[i]->note_ptr_cookie,
@@ -519,29 +896,394 @@ gt_pch_save (FILE *f)
       state.ptrs[i]->note_ptr_fn (state.ptrs[i]->obj,
 				  state.ptrs[i]->note_ptr_cookie,
 				  relocate_ptrs, &state);
-      ggc_pch_write_object (state.d, state.f, state.ptrs[i]->obj,
-			    state.ptrs[i]->new_addr, state.ptrs[i]->size,
-			    state.ptrs[i]->note_ptr_fn == gt_pch_p_S);
+      /* APPLE LOCAL begin relocatable PCH */
+      if (state.indirect && state.relocatable)
+	gt_pch_find_indirect_ptrs (&state, state.ptrs[i], this_object);
+      /* APPLE LOCAL end relocatable PCH */
+      /* APPLE LOCAL begin chained PCH */
+      if (state.ptrs[i]->image)
+	gt_pch_note_patch (&state, state.ptrs[i]);
+      else
+	ggc_pch_write_object (state.d, state.f, state.ptrs[i]->obj,
+			      state.ptrs[i]->new_addr, state.ptrs[i]->size,
+			      state.ptrs[i]->note_ptr_fn == gt_pch_p_S);
+      /* APPLE LOCAL end chained PCH */
       if (state.ptrs[i]->note_ptr_fn != gt_pch_p_S)
 	memcpy (state.ptrs[i]->obj, this_object, state.ptrs[i]->size);
     }
   ggc_pch_finish (state.d, state.f);
+
+  /* APPLE LOCAL begin relocatable PCH */
+  /* Write out the relocation bitmap, preceded by its size in bytes;
+     a size of zero means the image cannot be relocated.  */
+  if (!state.relocatable)
+    state.reloc_bytes = 0;
+  if (fwrite (&state.reloc_bytes, sizeof (state.reloc_bytes), 1, state.f) != 1
+      || (state.reloc_bytes != 0
+	  && fwrite (state.reloc, state.reloc_bytes, 1, state.f) != 1))
+    fatal_error ("can't write PCH file: %m");
+  free (state.reloc);
+  /* APPLE LOCAL end relocatable PCH */
+
+  /* APPLE LOCAL begin chained PCH */
+  /* Write out the changed objects of the loaded images.  */
+  if (fwrite (&state.patch_count, sizeof (state.patch_count), 1, state.f) != 1
+      || (state.patches_size != 0
+	  && fwrite (state.patches, state.patches_size, 1, state.f) != 1))
+    fatal_error ("can't write PCH file: %m");
+  free (state.patches);
+  free (patch_map);
+  if (state.chain)
+    {
+      for (i = 0; i < n_pch_images; i++)
+	free (state.pristine[i]);
+      free (state.pristine);
+    }
+  /* APPLE LOCAL end chained PCH */
+
   gt_pch_fixup_stringpool ();
 
   free (state.ptrs);
   htab_delete (saving_htab);
 }
 
+/* APPLE LOCAL begin relocatable PCH */
+/* Add BIAS to each word of WORDS whose bit is set in the BYTES bytes
+   of MAP.  */
+
+static void
+gt_pch_apply_reloc (char **words, const unsigned char *map, size_t bytes,
+		    size_t bias)
+{
+  size_t i;
+
+  /* Most of an image is not pointers, so skip a byte of the bitmap at
+     a time where we can.  */
+  for (i = 0; i < bytes; i++)
+    if (map[i] != 0)
+      {
+	unsigned int bits = map[i];
+	char **w = words + i * CHAR_BIT;
+
+	for (; bits != 0; bits >>= 1, w++)
+	  if (bits & 1)
+	    *w += bias;
+      }
+}
+
+/* Add BIAS to each non-null pointer in the roots TAB.  */
+
+static void
+gt_pch_relocate_roots (const struct ggc_root_tab *const *tab, size_t bias)
+{
+  const struct ggc_root_tab *const *rt;
+  const struct ggc_root_tab *rti;
+  size_t i;
+
+  for (rt = tab; *rt; rt++)
+    for (rti = *rt; rti->base != NULL; rti++)
+      for (i = 0; i < rti->nelt; i++)
+	{
+	  char **ptr = (char **)((char *)rti->base + rti->stride * i);
+	  if (*ptr != NULL && *ptr != (char *)1)
+	    *ptr += bias;
+	}
+}
+
+/* Read the relocation bitmap written by gt_pch_save from F.  If the
+   image it describes, at ADDR, was moved BIAS bytes from where it was
+   laid out to go, adjust every pointer in it accordingly.  */
+
+static void
+gt_pch_relocate (FILE *f, char *addr, size_t bias)
+{
+  size_t reloc_bytes;
+  unsigned char *reloc;
+
+  if (fread (&reloc_bytes, sizeof (reloc_bytes), 1, f) != 1)
+    fatal_error ("can't read PCH file: %m");
+
+  if (bias == 0)
+    {
+      if (reloc_bytes != 0 && fseek (f, reloc_bytes, SEEK_CUR) != 0)
+	fatal_error ("can't read PCH file: %m");
+      return;
+    }
+  if (reloc_bytes == 0)
+    fatal_error ("had to relocate PCH");
+
+  reloc = XNEWVEC (unsigned char, reloc_bytes);
+  if (fread (reloc, reloc_bytes, 1, f) != 1)
+    fatal_error ("can't read PCH file: %m");
+  gt_pch_apply_reloc ((char **) addr, reloc, reloc_bytes, bias);
+  free (reloc);
+}
+/* APPLE LOCAL end relocatable PCH */
+
+/* APPLE LOCAL begin chained PCH */
+/* Read from F the list of images that the PCH being read was built
+   on, and open their files.  Return how many there are; IMAGES and
+   FILES are allocated with room for one more.  */
+
+static size_t
+gt_pch_read_chain (FILE *f, struct pch_image **images, FILE ***files)
+{
+  size_t i, n;
+
+  if (fread (&n, sizeof (n), 1, f) != 1)
+    fatal_error ("can't read PCH file: %m");
+  *images = XNEWVEC (struct pch_image, n + 1);
+  *files = XNEWVEC (FILE *, n + 1);
+  for (i = 0; i < n; i++)
+    {
+      struct pch_image *image = &(*images)[i];
+      struct pch_image_ondisk od;
+      struct stat st;
+
+      if (fread (&od, sizeof (od), 1, f) != 1)
+	fatal_error ("can't read PCH file: %m");
+      image->name = XNEWVEC (char, od.name_len + 1);
+      if (fread (image->name, od.name_len, 1, f) != 1)
+	fatal_error ("can't read PCH file: %m");
+      image->name[od.name_len] = '\0';
+      image->file_size = od.file_size;
+      image->mtime = od.mtime;
+      image->mmi = od.mmi;
+
+      (*files)[i] = fopen (image->name, "rb");
+      if ((*files)[i] == NULL
+	  || fstat (fileno ((*files)[i]), &st) != 0
+	  || (size_t) st.st_size != image->file_size
+	  || (long) st.st_mtime != image->mtime)
+	fatal_error ("PCH file %s has changed", image->name);
+    }
+  return n;
+}
+
+/* FD is open on a PCH file, where gt_pch_save began writing.  Return
+   NULL if each PCH that file was built on is as it was then, else the
+   name of one that is not, which the caller should free.  */
+
+char *
+gt_pch_chain_invalid (int fd)
+{
+  size_t i, n;
+
+  if (read (fd, &n, sizeof (n)) != sizeof (n))
+    fatal_error ("can't read PCH file: %m");
+  for (i = 0; i < n; i++)
+    {
+      struct pch_image_ondisk od;
+      struct stat st;
+      char *name;
+
+      if (read (fd, &od, sizeof (od)) != sizeof (od))
+	fatal_error ("can't read PCH file: %m");
+      name = XNEWVEC (char, od.name_len + 1);
+      if ((size_t) read (fd, name, od.name_len) != od.name_len)
+	fatal_error ("can't read PCH file: %m");
+      name[od.name_len] = '\0';
+      if (stat (name, &st) != 0
+	  || (size_t) st.st_size != od.file_size
+	  || (long) st.st_mtime != od.mtime)
+	return name;
+      free (name);
+    }
+  return NULL;
+}
+
+/* Try to map IMAGE from F at exactly the address it was laid out for.
+   Return true, and set its ADDR, if that worked.  */
+
+static bool
+gt_pch_map_at (FILE *f ATTRIBUTE_UNUSED, struct pch_image *image)
+{
+#if HAVE_MMAP_FILE
+  char *want = image->mmi.preferred_base;
+  char *addr = mmap (want, image->mmi.size, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE, fileno (f), image->mmi.offset);
+
+  if (addr == want)
+    {
+      image->addr = addr;
+      return true;
+    }
+  if (addr != (char *) MAP_FAILED)
+    munmap (addr, image->mmi.size);
+#endif
+  return false;
+}
+/* APPLE LOCAL end chained PCH */
+
+/* APPLE LOCAL begin relocatable PCH */
+/* The N images in IMAGES, from FILES, could not all go where they were
+   laid out to go.  Map them, or read them, into memory anywhere
+   suitably aligned, keeping the distances between them, and set their
+   ADDR.  */
+
+static void
+gt_pch_map_anywhere (struct pch_image *images, FILE **files, size_t n)
+{
+  const size_t align = host_hooks.gt_pch_alloc_granularity ();
+  size_t lo = (size_t) images[0].mmi.preferred_base;
+  size_t span = ((size_t) images[n - 1].mmi.preferred_base
+		 + images[n - 1].mmi.size - lo);
+  char *addr;
+  size_t i;
+
+#if HAVE_MMAP_FILE
+  /* Map the first image with room for the rest after it, then map the
+     rest over that room.  */
+  addr = mmap (NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	       fileno (files[0]), images[0].mmi.offset);
+  if (addr != (char *) MAP_FAILED)
+    {
+      for (i = 1; i < n; i++)
+	{
+	  char *want = addr + ((size_t) images[i].mmi.preferred_base - lo);
+
+	  if (mmap (want, images[i].mmi.size, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_FIXED, fileno (files[i]),
+		    images[i].mmi.offset) != want)
+	    break;
+	}
+      if (i == n)
+	{
+	  for (i = 0; i < n; i++)
+	    images[i].addr = addr + ((size_t) images[i].mmi.preferred_base
+				     - lo);
+	  return;
+	}
+      munmap (addr, span);
+    }
+#endif
+
+  /* The images are never freed, so neither is the slop used to align
+     them.  */
+  addr = XNEWVEC (char, span + align);
+  addr += (align - (size_t) addr % align) % align;
+  for (i = 0; i < n; i++)
+    {
+      images[i].addr = addr + ((size_t) images[i].mmi.preferred_base - lo);
+      if (fseek (files[i], images[i].mmi.offset, SEEK_SET) != 0
+	  || fread (images[i].addr, images[i].mmi.size, 1, files[i]) != 1)
+	fatal_error ("can't read PCH file: %m");
+    }
+}
+/* APPLE LOCAL end relocatable PCH */
+
+/* APPLE LOCAL begin chained PCH */
+/* Map the N images in IMAGES, from FILES, where they were laid out to
+   go or, failing that, all the same distance from there; and set their
+   ADDR.  */
+
+static void
+gt_pch_map_images (struct pch_image *images, FILE **files, size_t n)
+{
+  int result;
+  size_t i;
+
+  /* The host may have set space aside for the first image.  */
+  result = host_hooks.gt_pch_use_address (images[0].mmi.preferred_base,
+					  images[0].mmi.size,
+					  fileno (files[0]),
+					  images[0].mmi.offset);
+  images[0].addr = images[0].mmi.preferred_base;
+  if (result == 0
+      && (fseek (files[0], images[0].mmi.offset, SEEK_SET) != 0
+	  || fread (images[0].addr, images[0].mmi.size, 1, files[0]) != 1))
+    fatal_error ("can't read PCH file: %m");
+
+  /* The others were laid out just above it.  If one of them cannot go
+     there, give back the space of all the images placed so far, the
+     first one included, before looking for room for all of them.  The
+     hosts with mmap set the first image's space aside with mmap; the
+     others allocate it with xmalloc.  */
+  for (i = 1; result >= 0 && i < n; i++)
+    if (!gt_pch_map_at (files[i], &images[i]))
+      {
+#if HAVE_MMAP_FILE
+	while (--i > 0)
+	  munmap (images[i].addr, images[i].mmi.size);
+	munmap (images[0].addr, images[0].mmi.size);
+#else
+	free (images[0].addr);
+#endif
+	result = -1;
+      }
+
+  if (result < 0)
+    gt_pch_map_anywhere (images, files, n);
+}
+
+/* Read the changed objects of loaded images written by gt_pch_save
+   from F, and store them into the N IMAGES, which were moved BIAS
+   bytes from where they were laid out to go.  */
+
+static void
+gt_pch_apply_patches (FILE *f, const struct pch_image *images, size_t n,
+		      size_t bias)
+{
+  size_t count, map_alloc = 0;
+  unsigned char *map = NULL;
+
+  if (fread (&count, sizeof (count), 1, f) != 1)
+    fatal_error ("can't read PCH file: %m");
+  for (; count != 0; count--)
+    {
+      struct pch_patch patch;
+      size_t map_bytes;
+      char *dest;
+
+      if (fread (&patch, sizeof (patch), 1, f) != 1)
+	fatal_error ("can't read PCH file: %m");
+      gcc_assert (patch.image < n
+		  && patch.offset + patch.size <= images[patch.image].mmi.size);
+      dest = images[patch.image].addr + patch.offset;
+      map_bytes = (patch.size / sizeof (void *) + CHAR_BIT - 1) / CHAR_BIT;
+      if (fread (dest, patch.size, 1, f) != 1)
+	fatal_error ("can't read PCH file: %m");
+
+      if (bias == 0)
+	{
+	  if (map_bytes != 0 && fseek (f, map_bytes, SEEK_CUR) != 0)
+	    fatal_error ("can't read PCH file: %m");
+	  continue;
+	}
+      if (map_alloc < map_bytes)
+	{
+	  map_alloc = map_bytes;
+	  map = xrealloc (map, map_alloc);
+	}
+      if (map_bytes != 0 && fread (map, map_bytes, 1, f) != 1)
+	fatal_error ("can't read PCH file: %m");
+      gt_pch_apply_reloc ((char **) dest, map, map_bytes, bias);
+    }
+  free (map);
+}
+/* APPLE LOCAL end chained PCH */
+
 /* Read the state of the compiler back in from F.  */
 
 void
-gt_pch_restore (FILE *f)
+/* APPLE LOCAL chained PCH */
+gt_pch_restore (FILE *f, const char *name)
 {
   const struct ggc_root_tab *const *rt;
   const struct ggc_root_tab *rti;
   size_t i;
   struct mmap_info mmi;
-  int result;
+  /* APPLE LOCAL begin chained PCH */
+  struct pch_image *images;
+  FILE **files;
+  size_t n, bias;
+  struct stat st;
+  /* APPLE LOCAL end chained PCH */
+  /* APPLE LOCAL begin PCH sharing */
+  char *roots;
+  const char *p;
+  size_t roots_size;
+  /* APPLE LOCAL end PCH sharing */
 
   /* Delete any deletable objects.  This makes ggc_pch_read much
      faster, as it can be sure that no GCable objects remain other
@@ -550,44 +1292,69 @@ gt_pch_restore (FILE *f)
     for (rti = *rt; rti->base != NULL; rti++)
       memset (rti->base, 0, rti->stride);
 
-  /* Read in all the scalar variables.  */
-  for (rt = gt_pch_scalar_rtab; *rt; rt++)
-    for (rti = *rt; rti->base != NULL; rti++)
-      if (fread (rti->base, rti->stride, 1, f) != 1)
-	fatal_error ("can't read PCH file: %m");
-
-  /* Read in all the global pointers, in 6 easy loops.  */
-  for (rt = gt_ggc_rtab; *rt; rt++)
-    for (rti = *rt; rti->base != NULL; rti++)
-      for (i = 0; i < rti->nelt; i++)
-	if (fread ((char *)rti->base + rti->stride * i,
-		   sizeof (void *), 1, f) != 1)
-	  fatal_error ("can't read PCH file: %m");
+  /* APPLE LOCAL chained PCH */
+  n = gt_pch_read_chain (f, &images, &files);
 
-  for (rt = gt_pch_cache_rtab; *rt; rt++)
+  /* APPLE LOCAL begin PCH sharing */
+  /* Read in all the scalar variables and the global pointers, in one
+     go.  */
+  roots_size = gt_pch_roots_size ();
+  roots = XNEWVEC (char, roots_size);
+  if (fread (roots, roots_size, 1, f) != 1)
+    fatal_error ("can't read PCH file: %m");
+  p = roots;
+  for (rt = gt_pch_scalar_rtab; *rt; rt++)
     for (rti = *rt; rti->base != NULL; rti++)
-      for (i = 0; i < rti->nelt; i++)
-	if (fread ((char *)rti->base + rti->stride * i,
-		   sizeof (void *), 1, f) != 1)
-	  fatal_error ("can't read PCH file: %m");
+      {
+	memcpy (rti->base, p, rti->stride);
+	p += rti->stride;
+      }
+  p = read_pch_globals (gt_ggc_rtab, p);
+  p = read_pch_globals (gt_pch_cache_rtab, p);
+  free (roots);
+  /* APPLE LOCAL end PCH sharing */
 
   if (fread (&mmi, sizeof (mmi), 1, f) != 1)
     fatal_error ("can't read PCH file: %m");
 
-  result = host_hooks.gt_pch_use_address (mmi.preferred_base, mmi.size,
-					  fileno (f), mmi.offset);
-  if (result < 0)
-    fatal_error ("had to relocate PCH");
-  if (result == 0)
+  /* APPLE LOCAL begin chained PCH */
+  /* This file's own image goes after those it was built on.  */
+  if (fstat (fileno (f), &st) != 0)
+    fatal_error ("can't read PCH file: %m");
+  images[n].name = lrealpath (name);
+  images[n].file_size = st.st_size;
+  images[n].mtime = st.st_mtime;
+  images[n].mmi = mmi;
+  files[n] = f;
+  n++;
+
+  gt_pch_map_images (images, files, n);
+  bias = (size_t) images[0].addr - (size_t) images[0].mmi.preferred_base;
+
+  /* Set up the collector's view of each image, and adjust the pointers
+     in each if it was moved.  Then bring in the objects of the earlier
+     images that changed before this file was written.  */
+  for (i = 0; i < n; i++)
     {
-      if (fseek (f, mmi.offset, SEEK_SET) != 0
-	  || fread (mmi.preferred_base, mmi.size, 1, f) != 1)
+      if (fseek (files[i], images[i].mmi.offset + images[i].mmi.size,
+		 SEEK_SET) != 0)
 	fatal_error ("can't read PCH file: %m");
+      ggc_pch_read (files[i], images[i].addr);
+      gt_pch_relocate (files[i], images[i].addr, bias);
+      if (files[i] != f)
+	fclose (files[i]);
     }
-  else if (fseek (f, mmi.offset + mmi.size, SEEK_SET) != 0)
-    fatal_error ("can't read PCH file: %m");
+  gt_pch_apply_patches (f, images, n, bias);
+  if (bias != 0)
+    {
+      gt_pch_relocate_roots (gt_ggc_rtab, bias);
+      gt_pch_relocate_roots (gt_pch_cache_rtab, bias);
+    }
+  free (files);
 
-  ggc_pch_read (f, mmi.preferred_base);
+  pch_images = images;
+  n_pch_images = n;
+  /* APPLE LOCAL end chained PCH */
 
   gt_pch_restore_stringpool ();
 }
@@ -614,7 +1381,14 @@ default_gt_pch_use_address (void *base, size_t size, int fd ATTRIBUTE_UNUSED,
 			    size_t offset ATTRIBUTE_UNUSED)
 {
   void *addr = xmalloc (size);
-  return (addr == base) - 1;
+  /* APPLE LOCAL begin relocatable PCH */
+  if (addr != base)
+    {
+      free (addr);
+      return -1;
+    }
+  return 0;
+  /* APPLE LOCAL end relocatable PCH */
 }
 
 /* Default version of HOST_HOOKS_GT_PCH_GET_ADDRESS.   Return the
@@ -669,7 +1443,13 @@ mmap_gt_pch_use_address (void *base, size_t size, int fd, size_t offset)
   addr = mmap (base, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
 	       fd, offset);
 
-  return addr == base ? 1 : -1;
+  /* APPLE LOCAL begin relocatable PCH */
+  if (addr == base)
+    return 1;
+  if (addr != (void *) MAP_FAILED)
+    munmap (addr, size);
+  return -1;
+  /* APPLE LOCAL end relocatable PCH */
 }
 #endif /* HAVE_MMAP_FILE */
 
@@ -605,13 +605,15 @@ lookup_page_table_entry (const void *p)
   return base[L1][L2];
 }
 
-/* Set the page table entry for a page.  */
+/* APPLE LOCAL begin PCH sharing */
+/* Return the level 2 page table that covers P, allocating it if need
+   be.  */
 
-static void
-set_page_table_entry (void *p, page_entry *entry)
+static page_entry **
+page_table_l2 (void *p)
 {
   page_entry ***base;
-  size_t L1, L2;
+  size_t L1;
 
 #if HOST_BITS_PER_PTR <= 32
   base = &G.lookup[0];
@@ -631,16 +633,44 @@ found:
   base = &table->table[0];
 #endif
 
-  /* Extract the level 1 and 2 indices.  */
   L1 = LOOKUP_L1 (p);
-  L2 = LOOKUP_L2 (p);
-
   if (base[L1] == NULL)
     base[L1] = XCNEWVEC (page_entry *, PAGE_L2_SIZE);
 
-  base[L1][L2] = entry;
+  return base[L1];
 }
 
+/* Set the page table entry for a page.  */
+
+static void
+set_page_table_entry (void *p, page_entry *entry)
+{
+  page_table_l2 (p)[LOOKUP_L2 (p)] = entry;
+}
+
+/* Set the page table entries for all the pages in the BYTES bytes at
+   P to ENTRY, looking up each level 2 table only once.  */
+
+static void
+set_page_table_range (char *p, size_t bytes, page_entry *entry)
+{
+  const size_t l2_span = (size_t) 1 << (32 - PAGE_L1_BITS);
+  char *end = p + bytes;
+
+  while (p < end)
+    {
+      page_entry **l2 = page_table_l2 (p);
+      char *stop = (char *) (((size_t) p | (l2_span - 1)) + 1);
+      size_t i;
+
+      if (stop > end || stop < p)
+	stop = end;
+      for (i = LOOKUP_L2 (p); p < stop; p += G.pagesize)
+	l2[i++] = entry;
+    }
+}
+/* APPLE LOCAL end PCH sharing */
+
 /* Prints the page-entry for object size ORDER, for debugging.  */
 
 void
@@ -2221,8 +2251,17 @@ move_ptes_to_front (int count_old_page_tables, int count_new_page_tables)
      0, so there is nothing to update in the first slot.  We need a
      second slot, only if we have old ptes, and if we do, they start
      at index count_new_page_tables.  */
-  if (count_old_page_tables)
+  /* APPLE LOCAL begin chained PCH */
+  /* When a PCH has already been read, the old ptes may include its
+     context 0 pages, and any context 1 pages already have a slot,
+     which just moves up.  */
+  if (G.depth_in_use > 1)
+    for (i = 1; i < G.depth_in_use; i++)
+      G.depth[i] += count_new_page_tables;
+  else if (count_old_page_tables
+	   && G.by_depth[G.by_depth_in_use - 1]->context_depth != 0)
     push_depth (count_new_page_tables);
+  /* APPLE LOCAL end chained PCH */
 }
 
 void
@@ -2233,9 +2272,17 @@ ggc_pch_read (FILE *f, void *addr)
   char *offs = addr;
   unsigned long count_old_page_tables;
   unsigned long count_new_page_tables;
+  /* APPLE LOCAL chained PCH */
+  bool chained = G.context_depth != 0;
 
   count_old_page_tables = G.by_depth_in_use;
 
+  /* APPLE LOCAL begin chained PCH */
+  /* A PCH built on others is read just after them, and the objects
+     allocated before the first of them have already been dealt with.  */
+  if (!chained)
+    {
+  /* APPLE LOCAL end chained PCH */
   /* We've just read in a PCH file.  So, every object that used to be
      allocated is now free.  */
   clear_marks ();
@@ -2246,7 +2293,6 @@ ggc_pch_read (FILE *f, void *addr)
   /* No object read from a PCH file should ever be freed.  So, set the
      context depth to 1, and set the depth of all the currently-allocated
      pages to be 1 too.  PCH pages will have depth 0.  */
-  gcc_assert (!G.context_depth);
   G.context_depth = 1;
   for (i = 0; i < NUM_ORDERS; i++)
     {
@@ -2254,6 +2300,11 @@ ggc_pch_read (FILE *f, void *addr)
       for (p = G.pages[i]; p != NULL; p = p->next)
 	p->context_depth = G.context_depth;
     }
+  /* APPLE LOCAL begin chained PCH */
+    }
+  else
+    gcc_assert (G.context_depth == 1);
+  /* APPLE LOCAL end chained PCH */
 
   /* Allocate the appropriate page-table entries for the pages read from
      the PCH file.  */
@@ -2263,7 +2314,6 @@ ggc_pch_read (FILE *f, void *addr)
   for (i = 0; i < NUM_ORDERS; i++)
     {
       struct page_entry *entry;
-      char *pte;
       size_t bytes;
       size_t num_objs;
       size_t j;
@@ -2291,10 +2341,8 @@ ggc_pch_read (FILE *f, void *addr)
 	entry->in_use_p[j / HOST_BITS_PER_LONG]
 	  |= 1L << (j % HOST_BITS_PER_LONG);
 
-      for (pte = entry->page;
-	   pte < entry->page + entry->bytes;
-	   pte += G.pagesize)
-	set_page_table_entry (pte, entry);
+      /* APPLE LOCAL PCH sharing */
+      set_page_table_range (entry->page, entry->bytes, entry);
 
       if (G.page_tails[i] != NULL)
 	G.page_tails[i]->next = entry;
@@ -2316,5 +2364,7 @@ ggc_pch_read (FILE *f, void *addr)
   move_ptes_to_front (count_old_page_tables, count_new_page_tables);
 
   /* Update the statistics.  */
-  G.allocated = G.allocated_last_gc = offs - (char *)addr;
+  /* APPLE LOCAL chained PCH */
+  G.allocated = G.allocated_last_gc
+    = (chained ? G.allocated : 0) + (offs - (char *)addr);
 }
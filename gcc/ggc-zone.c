@@ -2321,6 +2321,12 @@ ggc_pch_read (FILE *f, void *addr)
   struct page_entry *pch_page;
   char *p;
 
+  /* APPLE LOCAL begin chained PCH */
+  /* There is only the one PCH zone.  */
+  if (pch_zone.page != NULL)
+    fatal_error ("chained PCH is not supported by this garbage collector");
+  /* APPLE LOCAL end chained PCH */
+
   if (fread (&d, sizeof (d), 1, f) != 1)
     fatal_error ("can't read PCH file: %m");
 
@@ -264,11 +264,18 @@ extern void ggc_collect	(void);
 /* Return the number of bytes allocated at the indicated address.  */
 extern size_t ggc_get_size (const void *);
 
-/* Write out all GCed objects to F.  */
-extern void gt_pch_save (FILE *f);
-
-/* Read objects previously saved with gt_pch_save from F.  */
-extern void gt_pch_restore (FILE *f);
+/* APPLE LOCAL begin chained PCH */
+/* Write out all GCed objects to F.  If CHAIN, objects that came from
+   PCH files already read are left in those files.  */
+extern void gt_pch_save (FILE *f, bool chain);
+
+/* Read objects previously saved with gt_pch_save from F, which is the
+   file NAME.  */
+extern void gt_pch_restore (FILE *f, const char *name);
+
+/* Check the PCH files that the one open on FD was built on.  */
+extern char *gt_pch_chain_invalid (int fd);
+/* APPLE LOCAL end chained PCH */
 
 /* Statistics.  */
 
@@ -2706,3 +2706,310 @@ lambda_transform_legal_p (lambda_trans_matrix trans,
     }
   return true;
 }
+
+/* APPLE LOCAL begin loop tiling */
+/* Return true if TRANS, applied to the loop nest of depth NB_LOOPS whose
+   dependences are DEPENDENCE_RELATIONS, leaves a nest that can be tiled,
+   i.e. a nest whose loops can be freely permuted: all the distance
+   vectors of the transformed nest must have nonnegative components.  The
+   conservative answer is false.  */
+
+bool
+lambda_tiling_legal_p (lambda_trans_matrix trans,
+		       int nb_loops,
+		       VEC (ddr_p, heap) *dependence_relations)
+{
+  unsigned int i, j;
+  int k;
+  lambda_vector distres;
+  struct data_dependence_relation *ddr;
+
+  if (!lambda_transform_legal_p (trans, nb_loops, dependence_relations))
+    return false;
+
+  distres = lambda_vector_new (nb_loops);
+
+  for (i = 0; VEC_iterate (ddr_p, dependence_relations, i, ddr); i++)
+    {
+      if (DDR_ARE_DEPENDENT (ddr) == chrec_known
+	  || (DR_IS_READ (DDR_A (ddr)) && DR_IS_READ (DDR_B (ddr))))
+	continue;
+
+      if (DDR_ARE_DEPENDENT (ddr) == chrec_dont_know
+	  || DDR_NUM_DIST_VECTS (ddr) == 0)
+	return false;
+
+      for (j = 0; j < DDR_NUM_DIST_VECTS (ddr); j++)
+	{
+	  lambda_matrix_vector_mult (LTM_MATRIX (trans), nb_loops, nb_loops,
+				     DDR_DIST_VECT (ddr, j), distres);
+
+	  for (k = 0; k < nb_loops; k++)
+	    if (distres[k] < 0)
+	      return false;
+	}
+    }
+  return true;
+}
+
+/* Return true if LLE is a single linear expression that does not depend
+   on the induction variables of the DEPTH loops of the nest.  */
+
+static bool
+lambda_rectangular_bound_p (lambda_linear_expression lle, int depth)
+{
+  return (lle != NULL
+	  && LLE_NEXT (lle) == NULL
+	  && LLE_DENOMINATOR (lle) == 1
+	  && lambda_vector_zerop (LLE_COEFFICIENTS (lle), depth));
+}
+
+/* Return a copy of the rectangular bound LLE, with DEPTH induction
+   variable coefficients and INVARIANTS invariant coefficients, and with
+   OFFSET added to its constant.  */
+
+static lambda_linear_expression
+lambda_copy_rectangular_bound (lambda_linear_expression lle, int offset,
+			       int depth, int invariants)
+{
+  lambda_linear_expression ret;
+
+  ret = lambda_linear_expression_new (depth, invariants);
+  lambda_vector_copy (LLE_INVARIANT_COEFFICIENTS (lle),
+		      LLE_INVARIANT_COEFFICIENTS (ret), invariants);
+  LLE_CONSTANT (ret) = LLE_CONSTANT (lle) + offset;
+  return ret;
+}
+
+/* Wrap LOOP, a member of LOOPS, into a new loop whose only content is
+   LOOP.  The new loop has a dummy induction variable of type TYPE
+   counting from zero, which is stored in IV, and an exit condition that
+   lambda_loopnest_to_gcc_loopnest will rewrite.  Return the new loop.
+
+   The preheader edge of LOOP is split twice, giving the header of the
+   new loop and a new preheader for LOOP.  The exit edge of LOOP is split
+   once, giving the block that holds the exit condition of the new loop,
+   and a new latch block is created after it.  */
+
+static struct loop *
+lambda_wrap_loop (struct loops *loops, struct loop *loop, tree type,
+		  tree *iv)
+{
+  basic_block headerbb, preheaderbb, exitbb, latchbb, olddest;
+  basic_block *bbs;
+  tree then_label, else_label, cond_stmt, ivvar;
+  block_stmt_iterator bsi;
+  bool insert_after;
+  struct loop *newloop;
+  unsigned i;
+  edge e;
+
+  olddest = loop->single_exit->dest;
+  headerbb = split_edge (loop_preheader_edge (loop));
+  preheaderbb = split_edge (single_succ_edge (headerbb));
+  exitbb = split_edge (loop->single_exit);
+  loop->single_exit = single_pred_edge (exitbb);
+  latchbb = create_empty_bb (exitbb);
+
+  e = single_succ_edge (exitbb);
+  e->flags &= ~EDGE_FALLTHRU;
+  e->flags |= EDGE_FALSE_VALUE;
+  make_edge (exitbb, latchbb, EDGE_TRUE_VALUE);
+  make_edge (latchbb, headerbb, EDGE_FALLTHRU);
+  then_label = build1 (GOTO_EXPR, void_type_node, tree_block_label (latchbb));
+  else_label = build1 (GOTO_EXPR, void_type_node, tree_block_label (olddest));
+  cond_stmt = build3 (COND_EXPR, void_type_node,
+		      build2 (NE_EXPR, boolean_type_node,
+			      integer_one_node,
+			      integer_zero_node),
+		      then_label, else_label);
+  bsi = bsi_start (exitbb);
+  bsi_insert_after (&bsi, cond_stmt, BSI_NEW_STMT);
+  set_immediate_dominator (CDI_DOMINATORS, latchbb, exitbb);
+
+  /* Update the loop structures: LOOP becomes the only subloop of the new
+     loop.  */
+  newloop = duplicate_loop (loops, loop, loop->outer);
+  newloop->header = headerbb;
+  newloop->latch = latchbb;
+  newloop->single_exit = e;
+  flow_loop_tree_node_remove (loop);
+  flow_loop_tree_node_add (newloop, loop);
+  newloop->num_nodes = loop->num_nodes;
+  add_bb_to_loop (headerbb, newloop);
+  add_bb_to_loop (preheaderbb, newloop);
+  add_bb_to_loop (exitbb, newloop);
+  add_bb_to_loop (latchbb, newloop);
+
+  bbs = get_loop_body (loop);
+  for (i = 0; i < loop->num_nodes; i++)
+    bbs[i]->loop_depth = bbs[i]->loop_father->depth;
+  free (bbs);
+
+  /* Create the dummy induction variable.  */
+  ivvar = create_tmp_var (type, "tileiv");
+  add_referenced_var (ivvar);
+  standard_iv_increment_position (newloop, &bsi, &insert_after);
+  create_iv (build_int_cst (type, 0), build_int_cst (type, 1), ivvar,
+	     newloop, &bsi, insert_after, iv, NULL);
+
+  return newloop;
+}
+
+/* Tile the loop nest NEST, a member of LOOPS, whose lambda loopnest
+   AFTER is the result of applying TRANS to it.  OLDIVS and INVARIANTS
+   are the induction variables and invariants of the nest, as computed by
+   gcc_loopnest_to_lambda_loopnest.  Each loop of the nest is split into
+   a loop over tiles of TILE_SIZE iterations and a loop over the
+   iterations of a tile, and all the loops over tiles are placed outside
+   the loops over iterations:
+
+   for (i = lb; i <= ub; i += s)
+
+   becomes
+
+   for (ii = lb; ii <= ub; ii += TILE_SIZE * s)
+     for (i = ii; i <= min (ii + (TILE_SIZE - 1) * s, ub); i += s)
+
+   Only nests whose bounds do not depend on the induction variables of
+   other loops are handled.  Return false, without changing anything, if
+   the nest cannot be tiled.  */
+
+bool
+lambda_loopnest_tile (struct loops *loops, struct loop *nest,
+		      VEC(tree,heap) *oldivs, VEC(tree,heap) *invariants,
+		      lambda_loopnest after, lambda_trans_matrix trans,
+		      int tile_size)
+{
+  int depth = LN_DEPTH (after);
+  int invs = LN_INVARIANTS (after);
+  lambda_loopnest tiled;
+  VEC(tree,heap) *allivs = NULL;
+  struct loop *outer = nest, *temp;
+  tree *tileivs, phi;
+  basic_block *bbs;
+  unsigned j;
+  int i;
+
+  for (i = 0; i < depth; i++)
+    {
+      lambda_loop loop = LN_LOOPS (after)[i];
+
+      if (LL_STEP (loop) <= 0
+	  || !lambda_rectangular_bound_p (LL_LOWER_BOUND (loop), depth)
+	  || !lambda_rectangular_bound_p (LL_UPPER_BOUND (loop), depth)
+	  || !lambda_rectangular_bound_p (LL_LINEAR_OFFSET (loop), depth))
+	{
+	  if (dump_file)
+	    fprintf (dump_file, "Can't tile loop nest: bounds are not rectangular.\n");
+	  return false;
+	}
+    }
+
+  /* Scalars other than the induction variables that flow around the
+     loops, or out of the nest, would need new PHI nodes in the loops over
+     tiles.  */
+  for (temp = nest; temp; temp = temp->inner)
+    {
+      int nphis = 0;
+
+      for (phi = phi_nodes (temp->header); phi; phi = PHI_CHAIN (phi))
+	if (is_gimple_reg (PHI_RESULT (phi)))
+	  nphis++;
+      if (nphis != 1)
+	{
+	  if (dump_file)
+	    fprintf (dump_file, "Can't tile loop nest: loop carries scalars.\n");
+	  return false;
+	}
+    }
+  for (phi = phi_nodes (nest->single_exit->dest); phi; phi = PHI_CHAIN (phi))
+    if (is_gimple_reg (PHI_RESULT (phi)))
+      {
+	if (dump_file)
+	  fprintf (dump_file, "Can't tile loop nest: scalars live after the nest.\n");
+	return false;
+      }
+
+  /* The memory state now flows around the loops over tiles, so the
+     virtual operands of the nest have to be renamed.  */
+  bbs = get_loop_body (nest);
+  for (j = 0; j < nest->num_nodes; j++)
+    {
+      block_stmt_iterator bsi;
+
+      for (phi = phi_nodes (bbs[j]); phi; phi = PHI_CHAIN (phi))
+	if (!is_gimple_reg (PHI_RESULT (phi)))
+	  mark_sym_for_renaming (SSA_NAME_VAR (PHI_RESULT (phi)));
+
+      for (bsi = bsi_start (bbs[j]); !bsi_end_p (bsi); bsi_next (&bsi))
+	{
+	  ssa_op_iter iter;
+	  tree op;
+
+	  FOR_EACH_SSA_TREE_OPERAND (op, bsi_stmt (bsi), iter,
+				     SSA_OP_ALL_VIRTUALS)
+	    mark_sym_for_renaming (SSA_NAME_VAR (op));
+	}
+    }
+  free (bbs);
+
+  /* Create the loops over tiles, innermost first.  */
+  tileivs = XNEWVEC (tree, depth);
+  for (i = depth - 1; i >= 0; i--)
+    outer = lambda_wrap_loop (loops, outer,
+			      TREE_TYPE (VEC_index (tree, oldivs, i)),
+			      &tileivs[i]);
+
+  tiled = lambda_loopnest_new (2 * depth, invs);
+  for (i = 0; i < depth; i++)
+    {
+      lambda_loop loop = LN_LOOPS (after)[i];
+      lambda_loop tile = lambda_loop_new ();
+      lambda_loop elt = lambda_loop_new ();
+      int offset = LLE_CONSTANT (LL_LINEAR_OFFSET (loop));
+      lambda_linear_expression lle;
+
+      LL_STEP (tile) = tile_size * LL_STEP (loop);
+      LL_LOWER_BOUND (tile)
+	= lambda_copy_rectangular_bound (LL_LOWER_BOUND (loop), offset,
+					 2 * depth, invs);
+      LL_UPPER_BOUND (tile)
+	= lambda_copy_rectangular_bound (LL_UPPER_BOUND (loop), offset,
+					 2 * depth, invs);
+      LL_LINEAR_OFFSET (tile) = lambda_linear_expression_new (2 * depth, invs);
+
+      LL_STEP (elt) = LL_STEP (loop);
+      lle = lambda_linear_expression_new (2 * depth, invs);
+      LLE_COEFFICIENTS (lle)[i] = 1;
+      LL_LOWER_BOUND (elt) = lle;
+      lle = lambda_linear_expression_new (2 * depth, invs);
+      LLE_COEFFICIENTS (lle)[i] = 1;
+      LLE_CONSTANT (lle) = (tile_size - 1) * LL_STEP (loop);
+      LLE_NEXT (lle) = lambda_copy_rectangular_bound (LL_UPPER_BOUND (loop),
+						      offset, 2 * depth, invs);
+      LL_UPPER_BOUND (elt) = lle;
+      LL_LINEAR_OFFSET (elt) = lambda_linear_expression_new (2 * depth, invs);
+
+      LN_LOOPS (tiled)[i] = tile;
+      LN_LOOPS (tiled)[depth + i] = elt;
+    }
+
+  if (dump_file)
+    {
+      fprintf (dump_file, "Tiled:\n");
+      print_lambda_loopnest (dump_file, tiled, 'a');
+    }
+
+  for (i = 0; i < depth; i++)
+    VEC_safe_push (tree, heap, allivs, tileivs[i]);
+  for (i = 0; i < depth; i++)
+    VEC_safe_push (tree, heap, allivs, VEC_index (tree, oldivs, i));
+  free (tileivs);
+
+  lambda_loopnest_to_gcc_loopnest (outer, allivs, invariants, tiled,
+				   lambda_trans_matrix_tiled (trans));
+  VEC_free (tree, heap, allivs);
+  return true;
+}
+/* APPLE LOCAL end loop tiling */
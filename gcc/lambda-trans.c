@@ -70,6 +70,33 @@ lambda_trans_matrix_inverse (lambda_trans_matrix mat)
 }
 
 
+/* APPLE LOCAL begin loop tiling */
+/* Return the transformation matrix of a nest of depth 2 * D obtained by
+   tiling the D loops transformed by TRANS: the D outer loops walk the
+   tiles and are not transformed, the D inner loops walk the iterations
+   within a tile and are transformed by TRANS.  */
+
+lambda_trans_matrix
+lambda_trans_matrix_tiled (lambda_trans_matrix trans)
+{
+  lambda_trans_matrix tiled;
+  int depth = LTM_ROWSIZE (trans);
+  int i, j;
+
+  gcc_assert (LTM_ROWSIZE (trans) == LTM_COLSIZE (trans));
+
+  tiled = lambda_trans_matrix_new (2 * depth, 2 * depth);
+  for (i = 0; i < depth; i++)
+    LTM_MATRIX (tiled)[i][i] = 1;
+  for (i = 0; i < depth; i++)
+    for (j = 0; j < depth; j++)
+      LTM_MATRIX (tiled)[depth + i][depth + j] = LTM_MATRIX (trans)[i][j];
+  LTM_DENOMINATOR (tiled) = LTM_DENOMINATOR (trans);
+  return tiled;
+}
+/* APPLE LOCAL end loop tiling */
+
+
 /* Print out a transformation matrix.  */
 
 void
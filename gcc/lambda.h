@@ -191,6 +191,8 @@ void print_lambda_trans_matrix (FILE *, lambda_trans_matrix);
 void lambda_matrix_vector_mult (lambda_matrix, int, int, lambda_vector, 
 				lambda_vector);
 bool lambda_trans_matrix_id_p (lambda_trans_matrix);
+/* APPLE LOCAL loop tiling */
+lambda_trans_matrix lambda_trans_matrix_tiled (lambda_trans_matrix);
 
 lambda_body_vector lambda_body_vector_new (int);
 lambda_body_vector lambda_body_vector_compute_new (lambda_trans_matrix, 
@@ -203,6 +205,11 @@ lambda_loopnest gcc_loopnest_to_lambda_loopnest (struct loops *,
 void lambda_loopnest_to_gcc_loopnest (struct loop *,
 				      VEC(tree,heap) *, VEC(tree,heap) *,
 				      lambda_loopnest, lambda_trans_matrix);
+/* APPLE LOCAL begin loop tiling */
+bool lambda_loopnest_tile (struct loops *, struct loop *,
+			   VEC(tree,heap) *, VEC(tree,heap) *,
+			   lambda_loopnest, lambda_trans_matrix, int);
+/* APPLE LOCAL end loop tiling */
 
 
 static inline void lambda_vector_negate (lambda_vector, lambda_vector, int);
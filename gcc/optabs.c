@@ -316,6 +316,31 @@ optab_for_tree_code (enum tree_code code, tree type)
     case VEC_RSHIFT_EXPR:
       return vec_shr_optab;
 
+    /* APPLE LOCAL begin vect interleave */
+    case VEC_EXTRACT_EVEN_EXPR:
+      return vec_extract_even_optab;
+
+    case VEC_EXTRACT_ODD_EXPR:
+      return vec_extract_odd_optab;
+
+    case VEC_INTERLEAVE_HIGH_EXPR:
+      return vec_interleave_high_optab;
+
+    case VEC_INTERLEAVE_LOW_EXPR:
+      return vec_interleave_low_optab;
+    /* APPLE LOCAL end vect interleave */
+
+    /* APPLE LOCAL begin vect multiple types */
+    case VEC_UNPACK_HI_EXPR:
+      return TYPE_UNSIGNED (type) ? vec_unpacku_hi_optab : vec_unpacks_hi_optab;
+
+    case VEC_UNPACK_LO_EXPR:
+      return TYPE_UNSIGNED (type) ? vec_unpacku_lo_optab : vec_unpacks_lo_optab;
+
+    case VEC_PACK_MOD_EXPR:
+      return vec_pack_mod_optab;
+    /* APPLE LOCAL end vect multiple types */
+
     default:
       break;
     }
@@ -1277,13 +1302,26 @@ expand_binop (enum machine_mode mode, optab binoptab, rtx op0, rtx op1,
       int icode = (int) binoptab->handlers[(int) mode].insn_code;
       enum machine_mode mode0 = insn_data[icode].operand[1].mode;
       enum machine_mode mode1 = insn_data[icode].operand[2].mode;
+      /* APPLE LOCAL begin vect multiple types */
+      enum machine_mode tmp_mode = mode;
+      /* APPLE LOCAL end vect multiple types */
       rtx pat;
       rtx xop0 = op0, xop1 = op1;
 
+      /* APPLE LOCAL begin vect multiple types */
+      /* Vector packing produces a result with twice as many elements as
+	 each of the operands.  */
+      if (binoptab == vec_pack_mod_optab)
+	{
+	  tmp_mode = insn_data[icode].operand[0].mode;
+	  gcc_assert (GET_MODE_NUNITS (tmp_mode) == 2 * GET_MODE_NUNITS (mode));
+	}
+
       if (target)
 	temp = target;
       else
-	temp = gen_reg_rtx (mode);
+	temp = gen_reg_rtx (tmp_mode);
+      /* APPLE LOCAL end vect multiple types */
 
       /* If it is a commutative operator and the modes would match
 	 if we would swap the operands, we can save the conversions.  */
@@ -1330,8 +1368,10 @@ expand_binop (enum machine_mode mode, optab binoptab, rtx op0, rtx op1,
 	  && mode1 != VOIDmode)
 	xop1 = copy_to_mode_reg (mode1, xop1);
 
-      if (!insn_data[icode].operand[0].predicate (temp, mode))
-	temp = gen_reg_rtx (mode);
+      /* APPLE LOCAL begin vect multiple types */
+      if (!insn_data[icode].operand[0].predicate (temp, tmp_mode))
+	temp = gen_reg_rtx (tmp_mode);
+      /* APPLE LOCAL end vect multiple types */
 
       pat = GEN_FCN (icode) (temp, xop0, xop1);
       if (pat)
@@ -5319,6 +5359,19 @@ init_optabs (void)
   vec_shl_optab = init_optab (UNKNOWN);
   vec_shr_optab = init_optab (UNKNOWN);
   vec_realign_load_optab = init_optab (UNKNOWN);
+  /* APPLE LOCAL begin vect interleave */
+  vec_extract_even_optab = init_optab (UNKNOWN);
+  vec_extract_odd_optab = init_optab (UNKNOWN);
+  vec_interleave_high_optab = init_optab (UNKNOWN);
+  vec_interleave_low_optab = init_optab (UNKNOWN);
+  /* APPLE LOCAL end vect interleave */
+  /* APPLE LOCAL begin vect multiple types */
+  vec_unpacks_hi_optab = init_optab (UNKNOWN);
+  vec_unpacks_lo_optab = init_optab (UNKNOWN);
+  vec_unpacku_hi_optab = init_optab (UNKNOWN);
+  vec_unpacku_lo_optab = init_optab (UNKNOWN);
+  vec_pack_mod_optab = init_optab (UNKNOWN);
+  /* APPLE LOCAL end vect multiple types */
   movmisalign_optab = init_optab (UNKNOWN);
 
   powi_optab = init_optab (UNKNOWN);
@@ -265,6 +265,23 @@ enum optab_index
   OTI_vec_shr,
   /* Extract specified elements from vectors, for vector load.  */
   OTI_vec_realign_load,
+  /* APPLE LOCAL begin vect interleave */
+  /* Extract even/odd fields of two vectors, for strided loads.  */
+  OTI_vec_extract_even,
+  OTI_vec_extract_odd,
+  /* Interleave fields of two vectors, for strided stores.  */
+  OTI_vec_interleave_high,
+  OTI_vec_interleave_low,
+  /* APPLE LOCAL end vect interleave */
+  /* APPLE LOCAL begin vect multiple types */
+  /* Extract and sign/zero extend the high/low half of a vector.  */
+  OTI_vec_unpacks_hi,
+  OTI_vec_unpacks_lo,
+  OTI_vec_unpacku_hi,
+  OTI_vec_unpacku_lo,
+  /* Truncate the elements of two vectors into one.  */
+  OTI_vec_pack_mod,
+  /* APPLE LOCAL end vect multiple types */
 
   /* Perform a raise to the power of integer.  */
   OTI_powi,
@@ -394,6 +411,19 @@ extern GTY(()) optab optab_table[OTI_MAX];
 #define vec_shl_optab (optab_table[OTI_vec_shl])
 #define vec_shr_optab (optab_table[OTI_vec_shr])
 #define vec_realign_load_optab (optab_table[OTI_vec_realign_load])
+/* APPLE LOCAL begin vect interleave */
+#define vec_extract_even_optab (optab_table[OTI_vec_extract_even])
+#define vec_extract_odd_optab (optab_table[OTI_vec_extract_odd])
+#define vec_interleave_high_optab (optab_table[OTI_vec_interleave_high])
+#define vec_interleave_low_optab (optab_table[OTI_vec_interleave_low])
+/* APPLE LOCAL end vect interleave */
+/* APPLE LOCAL begin vect multiple types */
+#define vec_unpacks_hi_optab (optab_table[OTI_vec_unpacks_hi])
+#define vec_unpacks_lo_optab (optab_table[OTI_vec_unpacks_lo])
+#define vec_unpacku_hi_optab (optab_table[OTI_vec_unpacku_hi])
+#define vec_unpacku_lo_optab (optab_table[OTI_vec_unpacku_lo])
+#define vec_pack_mod_optab (optab_table[OTI_vec_pack_mod])
+/* APPLE LOCAL end vect multiple types */
 
 #define powi_optab (optab_table[OTI_powi])
 
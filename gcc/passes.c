@@ -100,6 +100,9 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 				   declarations for e.g. AIX 4.x.  */
 #endif
 
+/* APPLE LOCAL pass report */
+static void finish_pass_report (void);
+
 /* Global variables used to communicate with passes.  */
 int dump_flags;
 bool in_gimple_form;
@@ -243,6 +246,9 @@ finish_optimization_passes (void)
 	  free (name);
 	}
 
+  /* APPLE LOCAL pass report */
+  finish_pass_report ();
+
   timevar_pop (TV_DUMP);
 }
 
@@ -599,12 +605,19 @@ init_optimization_passes (void)
   NEXT_PASS (pass_empty_loop);
   NEXT_PASS (pass_record_bounds);
   NEXT_PASS (pass_linear_transform);
+  /* APPLE LOCAL begin loop distribution */
+  NEXT_PASS (pass_unroll_and_jam);
+  NEXT_PASS (pass_loop_fusion);
+  NEXT_PASS (pass_loop_distribution);
+  /* APPLE LOCAL end loop distribution */
   NEXT_PASS (pass_iv_canon);
   NEXT_PASS (pass_if_conversion);
   NEXT_PASS (pass_vectorize);
   /* NEXT_PASS (pass_may_alias) cannot be done again because the
      vectorizer creates alias relations that are not supported by
      pass_may_alias.  */
+  /* APPLE LOCAL vect slp */
+  NEXT_PASS (pass_slp_vectorize);
   NEXT_PASS (pass_complete_unroll);
   NEXT_PASS (pass_loop_prefetch);
   NEXT_PASS (pass_iv_optimize);
@@ -827,11 +840,133 @@ verify_interpass_invariants (void)
 #endif
 }
 
+/* APPLE LOCAL begin pass report */
+/* The file named by -fpass-report=, opened when the first pass is
+   recorded.  Each executed pass adds one CSV record to it.  */
+static FILE *pass_report_file;
+
+/* The size of the IR of the current function, as recorded in the pass
+   report.  Sizes that do not apply to the current IR are zero.  */
+
+struct pass_report_size
+{
+  int blocks;
+  int stmts;
+  int insns;
+};
+
+/* Measure the IR of the current function into SIZE.  */
+
+static void
+pass_report_measure (struct pass_report_size *size)
+{
+  size->blocks = 0;
+  size->stmts = 0;
+  size->insns = 0;
+
+  if (!current_function_decl || !cfun)
+    return;
+
+  if ((curr_properties & PROP_cfg) && cfun->cfg && basic_block_info)
+    {
+      size->blocks = n_basic_blocks - NUM_FIXED_BLOCKS;
+
+      if (curr_properties & PROP_trees)
+	{
+	  basic_block bb;
+	  block_stmt_iterator bsi;
+
+	  FOR_EACH_BB (bb)
+	    for (bsi = bsi_start (bb); !bsi_end_p (bsi); bsi_next (&bsi))
+	      size->stmts++;
+	}
+    }
+
+  if (curr_properties & PROP_rtl)
+    {
+      rtx insn;
+
+      for (insn = get_insns (); insn; insn = NEXT_INSN (insn))
+	if (INSN_P (insn))
+	  size->insns++;
+    }
+}
+
+/* Write STR to the pass report as a quoted CSV field.  */
+
+static void
+pass_report_quote (const char *str)
+{
+  putc ('"', pass_report_file);
+  for (; *str; str++)
+    {
+      if (*str == '"')
+	putc ('"', pass_report_file);
+      putc (*str, pass_report_file);
+    }
+  putc ('"', pass_report_file);
+}
+
+/* Record in the pass report that PASS ran from START to STOP, changing
+   the size of the IR from BEFORE to AFTER.  */
+
+static void
+pass_report_record (struct tree_opt_pass *pass,
+		    struct timevar_time_def *start,
+		    struct timevar_time_def *stop,
+		    struct pass_report_size *before,
+		    struct pass_report_size *after)
+{
+  if (!pass_report_file)
+    {
+      pass_report_file = fopen (pass_report_file_name, "w");
+      if (!pass_report_file)
+	fatal_error ("can%'t open %s for writing: %m",
+		     pass_report_file_name);
+      fputs ("unit,function,pass,wall,user,sys,ggc_bytes,"
+	     "blocks_before,blocks_after,stmts_before,stmts_after,"
+	     "insns_before,insns_after\n", pass_report_file);
+    }
+
+  pass_report_quote (main_input_filename ? main_input_filename : "");
+  putc (',', pass_report_file);
+  pass_report_quote (current_function_decl
+		     ? IDENTIFIER_POINTER
+			 (DECL_ASSEMBLER_NAME (current_function_decl))
+		     : "");
+  putc (',', pass_report_file);
+  pass_report_quote (pass->name);
+  fprintf (pass_report_file, ",%.6f,%.6f,%.6f,%u,%d,%d,%d,%d,%d,%d\n",
+	   stop->wall - start->wall, stop->user - start->user,
+	   stop->sys - start->sys, stop->ggc_mem - start->ggc_mem,
+	   before->blocks, after->blocks, before->stmts, after->stmts,
+	   before->insns, after->insns);
+}
+
+/* Close the pass report, if one was written.  */
+
+static void
+finish_pass_report (void)
+{
+  if (!pass_report_file)
+    return;
+
+  if (ferror (pass_report_file) != 0 || fclose (pass_report_file) != 0)
+    fatal_error ("error writing to %s: %m", pass_report_file_name);
+  pass_report_file = NULL;
+}
+/* APPLE LOCAL end pass report */
+
 static bool
 execute_one_pass (struct tree_opt_pass *pass)
 {
   bool initializing_dump;
   unsigned int todo_after = 0;
+  /* APPLE LOCAL begin pass report */
+  bool report = pass_report_file_name && pass->name && pass->execute;
+  struct timevar_time_def start, stop;
+  struct pass_report_size before, after;
+  /* APPLE LOCAL end pass report */
 
   /* See if we're supposed to run this pass.  */
   if (pass->gate && !pass->gate ())
@@ -876,10 +1011,20 @@ execute_one_pass (struct tree_opt_pass *pass)
   else
     initializing_dump = false;
 
+  /* APPLE LOCAL begin pass report */
+  if (report)
+    pass_report_measure (&before);
+  /* APPLE LOCAL end pass report */
+
   /* If a timevar is present, start it.  */
   if (pass->tv_id)
     timevar_push (pass->tv_id);
 
+  /* APPLE LOCAL begin pass report */
+  if (report)
+    timevar_get_time (&start);
+  /* APPLE LOCAL end pass report */
+
   /* Do it!  */
   if (pass->execute)
     {
@@ -887,6 +1032,11 @@ execute_one_pass (struct tree_opt_pass *pass)
       last_verified = 0;
     }
 
+  /* APPLE LOCAL begin pass report */
+  if (report)
+    timevar_get_time (&stop);
+  /* APPLE LOCAL end pass report */
+
   /* Stop timevar.  */
   if (pass->tv_id)
     timevar_pop (pass->tv_id);
@@ -908,6 +1058,14 @@ execute_one_pass (struct tree_opt_pass *pass)
   execute_todo (todo_after | pass->todo_flags_finish);
   verify_interpass_invariants ();
 
+  /* APPLE LOCAL begin pass report */
+  if (report)
+    {
+      pass_report_measure (&after);
+      pass_report_record (pass, &start, &stop, &before, &after);
+    }
+  /* APPLE LOCAL end pass report */
+
   /* Flush and close dump file.  */
   if (dump_file_name)
     {
@@ -0,0 +1,133 @@
+/* APPLE LOCAL file resource log */
+/* Log the resources used by the programs the driver runs.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 2, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING.  If not, write to the Free
+Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+02110-1301, USA.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+#include "obstack.h"
+#include "resource-log.h"
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
+#define obstack_chunk_alloc xmalloc
+#define obstack_chunk_free free
+
+bool
+resource_log_p (void)
+{
+  const char *name = getenv (RESOURCE_LOG_ENV);
+
+  return name != NULL && *name != '\0';
+}
+
+/* Add " KEY=" and S, quoted, to OB.  */
+
+static void
+add_quoted (struct obstack *ob, const char *key, const char *s)
+{
+  obstack_1grow (ob, ' ');
+  obstack_grow (ob, key, strlen (key));
+  obstack_grow (ob, "=\"", 2);
+  for (; *s; s++)
+    {
+      if (*s == '"' || *s == '\\')
+	obstack_1grow (ob, '\\');
+      if (*s == '\n')
+	obstack_grow (ob, "\\n", 2);
+      else
+	obstack_1grow (ob, *s);
+    }
+  obstack_1grow (ob, '"');
+}
+
+/* Return the name of the phase the program ARGV is.  */
+
+static const char *
+phase_name (const char *const *argv)
+{
+  const char *base = lbasename (argv[0]);
+  int i;
+
+  if (strncmp (base, "cc1", 3) == 0)
+    for (i = 1; argv[i]; i++)
+      if (strcmp (argv[i], "-E") == 0)
+	return "cpp";
+  return base;
+}
+
+void
+resource_log (const char *const *argv, const char *input, int status,
+	      const struct pex_time *usage)
+{
+  const char *name = getenv (RESOURCE_LOG_ENV);
+  struct obstack ob;
+  char buf[512];
+  char *line;
+  size_t len, done;
+  ssize_t n;
+  int fd;
+
+  if (name == NULL || *name == '\0')
+    return;
+
+  obstack_init (&ob);
+  sprintf (buf, "%s time=%lu pid=%ld ppid=%ld phase=",
+	   RESOURCE_LOG_MAGIC, (unsigned long) time (NULL),
+	   (long) getpid (), (long) getppid ());
+  obstack_grow (&ob, buf, strlen (buf));
+  obstack_grow (&ob, phase_name (argv), strlen (phase_name (argv)));
+  if (WIFSIGNALED (status))
+    sprintf (buf, " signal=%d", WTERMSIG (status));
+  else
+    sprintf (buf, " status=%d", WEXITSTATUS (status));
+  obstack_grow (&ob, buf, strlen (buf));
+  sprintf (buf, " wall=%lu.%03lu user=%lu.%03lu sys=%lu.%03lu"
+	   " maxrss=%lu inblock=%lu outblock=%lu",
+	   usage->wall_seconds, usage->wall_microseconds / 1000,
+	   usage->user_seconds, usage->user_microseconds / 1000,
+	   usage->system_seconds, usage->system_microseconds / 1000,
+	   usage->max_rss, usage->in_blocks, usage->out_blocks);
+  obstack_grow (&ob, buf, strlen (buf));
+  if (input)
+    add_quoted (&ob, "input", input);
+  add_quoted (&ob, "program", argv[0]);
+  obstack_1grow (&ob, '\n');
+  len = obstack_object_size (&ob);
+  line = obstack_finish (&ob);
+
+  /* Write the line at once, so that the lines of programs that finish
+     together do not get mixed up.  */
+  fd = open (name, O_WRONLY | O_APPEND | O_CREAT, 0666);
+  if (fd >= 0)
+    {
+      for (done = 0; done < len; done += n)
+	{
+	  n = write (fd, line + done, len - done);
+	  if (n < 0 && errno == EINTR)
+	    n = 0;
+	  else if (n <= 0)
+	    break;
+	}
+      close (fd);
+    }
+  obstack_free (&ob, NULL);
+}
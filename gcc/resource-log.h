@@ -0,0 +1,56 @@
+/* APPLE LOCAL file resource log */
+/* Log the resources used by the programs the driver runs.
+   Copyright (C) 2026 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 2, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING.  If not, write to the Free
+Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+02110-1301, USA.  */
+
+#ifndef GCC_RESOURCE_LOG_H
+#define GCC_RESOURCE_LOG_H
+
+/* When the environment variable RESOURCE_LOG_ENV names a file, the
+   driver and collect2 append a line to it for each program they run:
+
+     RESOURCE_LOG_MAGIC time=T pid=P ppid=Q phase=NAME status=N
+       wall=S user=S sys=S maxrss=K inblock=B outblock=B
+       [input="FILE"] program="PROG"
+
+   all on one line.  T is when the program finished, in seconds since
+   the epoch.  P is the process that ran it and Q that process's parent,
+   so that the lines of one invocation of the driver can be told apart.
+   NAME is "cpp" for a compiler proper run with -E and the base name of
+   PROG otherwise.  N is its exit status; "signal=N" takes the place of
+   "status=N" if a signal killed it.  The times are in seconds, K is its
+   peak resident set size in kilobytes and the B are the blocks it read
+   and wrote, each zero where the host cannot tell.  FILE is the input
+   file it was run for, if any.  Strings are quoted, with '"' and '\'
+   escaped.  */
+
+#define RESOURCE_LOG_ENV "GCC_RESOURCE_LOG"
+#define RESOURCE_LOG_MAGIC "gcc-resource-log-1"
+
+/* Return true if programs should be logged, in which case the caller
+   should ask pex_init to record their times.  */
+extern bool resource_log_p (void);
+
+/* Log the program ARGV, run for the input file INPUT or with INPUT
+   null, which ended with the wait status STATUS having used the
+   resources in *USAGE.  */
+extern void resource_log (const char *const *argv, const char *input,
+			  int status, const struct pex_time *usage);
+
+#endif /* ! GCC_RESOURCE_LOG_H */
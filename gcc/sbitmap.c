@@ -28,6 +28,153 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 #include "obstack.h"
 #include "basic-block.h"
 
+/* APPLE LOCAL begin sbitmap vector kernels */
+/* The word-wise set operations below are the innermost loops of the
+   iterative dataflow solvers in lcm.c, gcse.c and df.c.  They are all
+   written in terms of sbitmap_kernel, which combines whole host vector
+   registers at a time when the host compiler supports generic vector
+   types and the host has a vector unit to back them, and falls back to
+   one SBITMAP_ELT_TYPE at a time for the remainder.  */
+
+#if GCC_VERSION >= 4000 && defined (__SSE2__)
+#define SBITMAP_VECTOR_BYTES 16
+typedef SBITMAP_ELT_TYPE sbitmap_vec
+  __attribute__ ((vector_size (SBITMAP_VECTOR_BYTES)));
+#define SBITMAP_VECTOR_ELTS (SBITMAP_VECTOR_BYTES / sizeof (SBITMAP_ELT_TYPE))
+#endif
+
+/* Count the leading zeros of a nonzero SBITMAP_ELT_TYPE.  */
+#if GCC_VERSION >= 3004
+# if HOST_BITS_PER_WIDEST_FAST_INT == HOST_BITS_PER_LONG
+#  define SBITMAP_CLZ __builtin_clzl
+# else
+#  define SBITMAP_CLZ __builtin_clzll
+# endif
+#endif
+
+/* The operations implemented by sbitmap_kernel, as a function of the
+   words A, B and C.  */
+
+enum sbitmap_kernel_code
+{
+  SBITMAP_AND,			/* A & B */
+  SBITMAP_IOR,			/* A | B */
+  SBITMAP_XOR,			/* A ^ B */
+  SBITMAP_AND_COMPL,		/* A & ~B */
+  SBITMAP_IOR_AND,		/* A | (B & C) */
+  SBITMAP_AND_IOR,		/* A & (B | C) */
+  SBITMAP_IOR_AND_COMPL		/* A | (B & ~C) */
+};
+
+/* Apply CODE to the words A, B and C.  */
+
+static inline SBITMAP_ELT_TYPE
+sbitmap_kernel_word (enum sbitmap_kernel_code code, SBITMAP_ELT_TYPE a,
+		     SBITMAP_ELT_TYPE b, SBITMAP_ELT_TYPE c)
+{
+  switch (code)
+    {
+    case SBITMAP_AND: return a & b;
+    case SBITMAP_IOR: return a | b;
+    case SBITMAP_XOR: return a ^ b;
+    case SBITMAP_AND_COMPL: return a & ~b;
+    case SBITMAP_IOR_AND: return a | (b & c);
+    case SBITMAP_AND_IOR: return a & (b | c);
+    case SBITMAP_IOR_AND_COMPL: return a | (b & ~c);
+    default: gcc_unreachable ();
+    }
+}
+
+#ifdef SBITMAP_VECTOR_ELTS
+/* Load a vector from P, which need only be aligned for its words.  */
+
+static inline sbitmap_vec
+sbitmap_vec_load (const SBITMAP_ELT_TYPE *p)
+{
+  sbitmap_vec v;
+
+  memcpy (&v, p, sizeof v);
+  return v;
+}
+
+/* Apply CODE to the vectors A, B and C.  */
+
+static inline sbitmap_vec
+sbitmap_kernel_vec (enum sbitmap_kernel_code code, sbitmap_vec a,
+		    sbitmap_vec b, sbitmap_vec c)
+{
+  switch (code)
+    {
+    case SBITMAP_AND: return a & b;
+    case SBITMAP_IOR: return a | b;
+    case SBITMAP_XOR: return a ^ b;
+    case SBITMAP_AND_COMPL: return a & ~b;
+    case SBITMAP_IOR_AND: return a | (b & c);
+    case SBITMAP_AND_IOR: return a & (b | c);
+    case SBITMAP_IOR_AND_COMPL: return a | (b & ~c);
+    default: gcc_unreachable ();
+    }
+}
+#endif
+
+/* Set the N words at DSTP to CODE applied to the words at AP, BP and
+   CP; CP is only read by the three operand codes.  Any of the sources
+   may be DSTP itself.  If CG, return true if any word of DSTP changed,
+   otherwise return false.  CODE and CG are constant at every call, so
+   the switches fold away once this is inlined.  */
+
+static inline bool
+sbitmap_kernel (enum sbitmap_kernel_code code, bool cg, unsigned int n,
+		SBITMAP_ELT_TYPE *dstp, const SBITMAP_ELT_TYPE *ap,
+		const SBITMAP_ELT_TYPE *bp, const SBITMAP_ELT_TYPE *cp)
+{
+  SBITMAP_ELT_TYPE changed = 0;
+  unsigned int i = 0;
+
+#ifdef SBITMAP_VECTOR_ELTS
+  if (n >= SBITMAP_VECTOR_ELTS)
+    {
+      sbitmap_vec zero = { 0 }, vchanged = zero;
+      SBITMAP_ELT_TYPE words[SBITMAP_VECTOR_ELTS];
+      unsigned int j;
+
+      for (; i + SBITMAP_VECTOR_ELTS <= n; i += SBITMAP_VECTOR_ELTS)
+	{
+	  sbitmap_vec tmp
+	    = sbitmap_kernel_vec (code, sbitmap_vec_load (ap + i),
+				  sbitmap_vec_load (bp + i),
+				  code >= SBITMAP_IOR_AND
+				  ? sbitmap_vec_load (cp + i) : zero);
+
+	  if (cg)
+	    vchanged |= sbitmap_vec_load (dstp + i) ^ tmp;
+	  memcpy (dstp + i, &tmp, sizeof tmp);
+	}
+
+      if (cg)
+	{
+	  memcpy (words, &vchanged, sizeof words);
+	  for (j = 0; j < SBITMAP_VECTOR_ELTS; j++)
+	    changed |= words[j];
+	}
+    }
+#endif
+
+  for (; i < n; i++)
+    {
+      SBITMAP_ELT_TYPE tmp
+	= sbitmap_kernel_word (code, ap[i], bp[i],
+			       code >= SBITMAP_IOR_AND ? cp[i] : 0);
+
+      if (cg)
+	changed |= dstp[i] ^ tmp;
+      dstp[i] = tmp;
+    }
+
+  return changed != 0;
+}
+/* APPLE LOCAL end sbitmap vector kernels */
+
 /* Bitmap manipulation routines.  */
 
 /* Allocate a simple bitmap of N_ELMS bits.  */
@@ -239,34 +386,17 @@ sbitmap_vector_ones (sbitmap *bmap, unsigned int n_vecs)
 bool
 sbitmap_union_of_diff_cg (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  sbitmap_ptr cp = c->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      SBITMAP_ELT_TYPE tmp = *ap++ | (*bp++ & ~*cp++);
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  /* APPLE LOCAL sbitmap vector kernels */
+  return sbitmap_kernel (SBITMAP_IOR_AND_COMPL, true, dst->size,
+			 dst->elms, a->elms, b->elms, c->elms);
 }
 
 void
 sbitmap_union_of_diff (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  sbitmap_ptr cp = c->elms;
-
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ | (*bp++ & ~*cp++);
+  /* APPLE LOCAL sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_IOR_AND_COMPL, false, dst->size,
+		  dst->elms, a->elms, b->elms, c->elms);
 }
 
 /* Set bitmap DST to the bitwise negation of the bitmap SRC.  */
@@ -307,8 +437,12 @@ sbitmap_difference (sbitmap dst, sbitmap a, sbitmap b)
      only copy the subtrahend into dest.  */
   if (b->size < min_size)
     min_size = b->size;
-  for (i = 0; i < min_size; i++)
-    *dstp++ = *ap++ & (~*bp++);
+  /* APPLE LOCAL begin sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_AND_COMPL, false, min_size, dstp, ap, bp, NULL);
+  i = min_size;
+  dstp += min_size;
+  ap += min_size;
+  /* APPLE LOCAL end sbitmap vector kernels */
   /* Now fill the rest of dest from A, if B was too short.
      This makes sense only when destination and A differ.  */
   if (dst != a && i != dst_size)
@@ -340,32 +474,17 @@ sbitmap_any_common_bits (sbitmap a, sbitmap b)
 bool
 sbitmap_a_and_b_cg (sbitmap dst, sbitmap a, sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      SBITMAP_ELT_TYPE tmp = *ap++ & *bp++;
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  /* APPLE LOCAL sbitmap vector kernels */
+  return sbitmap_kernel (SBITMAP_AND, true, dst->size,
+			 dst->elms, a->elms, b->elms, NULL);
 }
 
 void
 sbitmap_a_and_b (sbitmap dst, sbitmap a, sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ & *bp++;
+  /* APPLE LOCAL sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_AND, false, dst->size,
+		  dst->elms, a->elms, b->elms, NULL);
 }
 
 /* Set DST to be (A xor B)).
@@ -374,32 +493,17 @@ sbitmap_a_and_b (sbitmap dst, sbitmap a, sbitmap b)
 bool
 sbitmap_a_xor_b_cg (sbitmap dst, sbitmap a, sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      SBITMAP_ELT_TYPE tmp = *ap++ ^ *bp++;
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  /* APPLE LOCAL sbitmap vector kernels */
+  return sbitmap_kernel (SBITMAP_XOR, true, dst->size,
+			 dst->elms, a->elms, b->elms, NULL);
 }
 
 void
 sbitmap_a_xor_b (sbitmap dst, sbitmap a, sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ ^ *bp++;
+  /* APPLE LOCAL sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_XOR, false, dst->size,
+		  dst->elms, a->elms, b->elms, NULL);
 }
 
 /* Set DST to be (A or B)).
@@ -408,32 +512,17 @@ sbitmap_a_xor_b (sbitmap dst, sbitmap a, sbitmap b)
 bool
 sbitmap_a_or_b_cg (sbitmap dst, sbitmap a, sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      SBITMAP_ELT_TYPE tmp = *ap++ | *bp++;
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  /* APPLE LOCAL sbitmap vector kernels */
+  return sbitmap_kernel (SBITMAP_IOR, true, dst->size,
+			 dst->elms, a->elms, b->elms, NULL);
 }
 
 void
 sbitmap_a_or_b (sbitmap dst, sbitmap a, sbitmap b)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ | *bp++;
+  /* APPLE LOCAL sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_IOR, false, dst->size,
+		  dst->elms, a->elms, b->elms, NULL);
 }
 
 /* Return nonzero if A is a subset of B.  */
@@ -457,34 +546,17 @@ sbitmap_a_subset_b_p (sbitmap a, sbitmap b)
 bool
 sbitmap_a_or_b_and_c_cg (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  sbitmap_ptr cp = c->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      SBITMAP_ELT_TYPE tmp = *ap++ | (*bp++ & *cp++);
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  /* APPLE LOCAL sbitmap vector kernels */
+  return sbitmap_kernel (SBITMAP_IOR_AND, true, dst->size,
+			 dst->elms, a->elms, b->elms, c->elms);
 }
 
 void
 sbitmap_a_or_b_and_c (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  sbitmap_ptr cp = c->elms;
-
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ | (*bp++ & *cp++);
+  /* APPLE LOCAL sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_IOR_AND, false, dst->size,
+		  dst->elms, a->elms, b->elms, c->elms);
 }
 
 /* Set DST to be (A and (B or C)).
@@ -493,34 +565,17 @@ sbitmap_a_or_b_and_c (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 bool
 sbitmap_a_and_b_or_c_cg (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  sbitmap_ptr cp = c->elms;
-  SBITMAP_ELT_TYPE changed = 0;
-
-  for (i = 0; i < n; i++)
-    {
-      SBITMAP_ELT_TYPE tmp = *ap++ & (*bp++ | *cp++);
-      changed |= *dstp ^ tmp;
-      *dstp++ = tmp;
-    }
-
-  return changed != 0;
+  /* APPLE LOCAL sbitmap vector kernels */
+  return sbitmap_kernel (SBITMAP_AND_IOR, true, dst->size,
+			 dst->elms, a->elms, b->elms, c->elms);
 }
 
 void
 sbitmap_a_and_b_or_c (sbitmap dst, sbitmap a, sbitmap b, sbitmap c)
 {
-  unsigned int i, n = dst->size;
-  sbitmap_ptr dstp = dst->elms;
-  sbitmap_ptr ap = a->elms;
-  sbitmap_ptr bp = b->elms;
-  sbitmap_ptr cp = c->elms;
-
-  for (i = 0; i < n; i++)
-    *dstp++ = *ap++ & (*bp++ | *cp++);
+  /* APPLE LOCAL sbitmap vector kernels */
+  sbitmap_kernel (SBITMAP_AND_IOR, false, dst->size,
+		  dst->elms, a->elms, b->elms, c->elms);
 }
 
 #ifdef IN_GCC
@@ -550,17 +605,13 @@ sbitmap_intersection_of_succs (sbitmap dst, sbitmap *src, int bb)
   else
     for (++ix; ix < EDGE_COUNT (b->succs); ix++)
       {
-	unsigned int i;
-	sbitmap_ptr p, r;
-
 	e = EDGE_SUCC (b, ix);
 	if (e->dest == EXIT_BLOCK_PTR)
 	  continue;
 
-	p = src[e->dest->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ &= *p++;
+	/* APPLE LOCAL sbitmap vector kernels */
+	sbitmap_kernel (SBITMAP_AND, false, set_size, dst->elms, dst->elms,
+			src[e->dest->index]->elms, NULL);
       }
 }
 
@@ -590,17 +641,13 @@ sbitmap_intersection_of_preds (sbitmap dst, sbitmap *src, int bb)
   else
     for (++ix; ix < EDGE_COUNT (b->preds); ix++)
       {
-	unsigned int i;
-	sbitmap_ptr p, r;
-
 	e = EDGE_PRED (b, ix);
 	if (e->src == ENTRY_BLOCK_PTR)
 	  continue;
 
-	p = src[e->src->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ &= *p++;
+	/* APPLE LOCAL sbitmap vector kernels */
+	sbitmap_kernel (SBITMAP_AND, false, set_size, dst->elms, dst->elms,
+			src[e->src->index]->elms, NULL);
       }
 }
 
@@ -630,17 +677,13 @@ sbitmap_union_of_succs (sbitmap dst, sbitmap *src, int bb)
   else
     for (ix++; ix < EDGE_COUNT (b->succs); ix++)
       {
-	unsigned int i;
-	sbitmap_ptr p, r;
-
 	e = EDGE_SUCC (b, ix);
 	if (e->dest == EXIT_BLOCK_PTR)
 	  continue;
 
-	p = src[e->dest->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ |= *p++;
+	/* APPLE LOCAL sbitmap vector kernels */
+	sbitmap_kernel (SBITMAP_IOR, false, set_size, dst->elms, dst->elms,
+			src[e->dest->index]->elms, NULL);
       }
 }
 
@@ -670,17 +713,13 @@ sbitmap_union_of_preds (sbitmap dst, sbitmap *src, int bb)
   else
     for (ix++; ix < EDGE_COUNT (b->preds); ix++)
       {
-	unsigned int i;
-	sbitmap_ptr p, r;
-
 	e = EDGE_PRED (b, ix);
 	if (e->src == ENTRY_BLOCK_PTR)
 	  continue;
 
-	p = src[e->src->index]->elms;
-	r = dst->elms;
-	for (i = 0; i < set_size; i++)
-	  *r++ |= *p++;
+	/* APPLE LOCAL sbitmap vector kernels */
+	sbitmap_kernel (SBITMAP_IOR, false, set_size, dst->elms, dst->elms,
+			src[e->src->index]->elms, NULL);
       }
 }
 #endif
@@ -710,7 +749,12 @@ sbitmap_last_set_bit (sbitmap bmap)
     {
       SBITMAP_ELT_TYPE word = ptr[i];
 
+      /* APPLE LOCAL begin sbitmap vector kernels */
       if (word != 0)
+#if GCC_VERSION >= 3004
+	return (i * SBITMAP_ELT_BITS + SBITMAP_ELT_BITS - 1
+		- SBITMAP_CLZ (word));
+#else
 	{
 	  unsigned int index = (i + 1) * SBITMAP_ELT_BITS - 1;
 	  SBITMAP_ELT_TYPE mask
@@ -725,6 +769,8 @@ sbitmap_last_set_bit (sbitmap bmap)
 	      index--;
 	    }
 	}
+#endif
+      /* APPLE LOCAL end sbitmap vector kernels */
     }
 
   return -1;
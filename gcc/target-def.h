@@ -341,12 +341,18 @@ Foundation, 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
 #define TARGET_VECTOR_ALIGNMENT_REACHABLE \
   default_builtin_vector_alignment_reachable
 /* APPLE LOCAL end mainline 4.2 5569774 */
+/* APPLE LOCAL begin vect cost model */
+#define TARGET_VECTORIZE_BUILTIN_VECTORIZATION_COST \
+  default_builtin_vectorization_cost
+/* APPLE LOCAL end vect cost model */
 
 #define TARGET_VECTORIZE                                                \
   /* APPLE LOCAL begin mainline 4.2 5569774 */				\
   {TARGET_VECTORIZE_BUILTIN_MASK_FOR_LOAD,				\
-   TARGET_VECTOR_ALIGNMENT_REACHABLE}
-  /* APPLE LOCAL end mainline 4.2 5569774 */
+   TARGET_VECTOR_ALIGNMENT_REACHABLE,					\
+  /* APPLE LOCAL end mainline 4.2 5569774 */				\
+  /* APPLE LOCAL vect cost model */					\
+   TARGET_VECTORIZE_BUILTIN_VECTORIZATION_COST}
 
 #define TARGET_DEFAULT_TARGET_FLAGS 0
 
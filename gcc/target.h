@@ -68,6 +68,27 @@ typedef struct secondary_reload_info
   int t_icode; /* Actually an enum insn_code - see above.  */
 } secondary_reload_info;
 
+/* APPLE LOCAL begin vect cost model */
+/* The kinds of operation whose cost the vectorizer cost model asks the
+   target for.  */
+enum vect_cost_for_stmt
+{
+  scalar_stmt,
+  scalar_load,
+  scalar_store,
+  vector_stmt,
+  vector_load,
+  unaligned_load,
+  vector_store,
+  unaligned_store,
+  vec_to_scalar,
+  scalar_to_vec,
+  vec_perm,
+  cond_branch_not_taken,
+  cond_branch_taken
+};
+/* APPLE LOCAL end vect cost model */
+
 
 struct gcc_target
 {
@@ -381,6 +402,12 @@ struct gcc_target
       interations) for the given type.  */
      bool (* vector_alignment_reachable) (tree, bool);
     /* APPLE LOCAL end mainline 4.2 5569774 */
+
+    /* APPLE LOCAL begin vect cost model */
+    /* Return the cost, in units of a simple scalar statement, of an
+       operation of the given kind for the vectorizer cost model.  */
+    int (* builtin_vectorization_cost) (enum vect_cost_for_stmt);
+    /* APPLE LOCAL end vect cost model */
   } vectorize;
 
   /* The initial value of target_flags.  */
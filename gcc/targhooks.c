@@ -643,4 +643,27 @@ default_builtin_vector_alignment_reachable (tree type, bool is_packed)
   return true;
 }
 /* APPLE LOCAL end mainline 4.2 5569774 */
+
+/* APPLE LOCAL begin vect cost model */
+/* Default vectorizer cost model values: every operation costs as much as
+   a simple scalar statement, except for misaligned vector accesses and
+   taken branches.  */
+
+int
+default_builtin_vectorization_cost (enum vect_cost_for_stmt kind)
+{
+  switch (kind)
+    {
+    case unaligned_load:
+    case unaligned_store:
+      return 2;
+
+    case cond_branch_taken:
+      return 3;
+
+    default:
+      return 1;
+    }
+}
+/* APPLE LOCAL end vect cost model */
 #include "gt-targhooks.h"
@@ -63,6 +63,8 @@ extern const char * default_invalid_within_doloop (rtx);
 extern bool default_narrow_bitfield (void);
 /* APPLE LOCAL mainline 4.2 5569774 */
 extern bool default_builtin_vector_alignment_reachable (tree, bool);
+/* APPLE LOCAL vect cost model */
+extern int default_builtin_vectorization_cost (enum vect_cost_for_stmt);
 
 /* These are here, and not in hooks.[ch], because not all users of
    hooks.h include tm.h, and thus we don't have CUMULATIVE_ARGS.  */
@@ -108,6 +108,22 @@ ppc_intrinsic_time (void)
 # define HAVE_WALL_TIME
 # else
 /* APPLE LOCAL end Mach time */
+/* APPLE LOCAL begin timevar clock */
+/* A monotonic clock_gettime gives nanosecond wall clock time, and
+   getrusage microsecond user and system time; both are much finer
+   than the clock ticks counted by times.  */
+#if defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC) \
+    && defined (HAVE_GETRUSAGE)
+# if defined HAVE_DECL_GETRUSAGE && !HAVE_DECL_GETRUSAGE
+  extern int getrusage (int, struct rusage *);
+# endif
+# define USE_GETRUSAGE
+# define USE_CLOCK_GETTIME
+# define HAVE_USER_TIME
+# define HAVE_SYS_TIME
+# define HAVE_WALL_TIME
+#else
+/* APPLE LOCAL end timevar clock */
 #ifdef HAVE_TIMES
 # if defined HAVE_DECL_TIMES && !HAVE_DECL_TIMES
   extern clock_t times (struct tms *);
@@ -134,6 +150,8 @@ ppc_intrinsic_time (void)
 #endif
 #endif
 #endif
+/* APPLE LOCAL timevar clock */
+#endif /* HAVE_CLOCK_GETTIME */
 /* APPLE LOCAL Mach time */
 #endif /* HAVE_MACH_TIME */
 
@@ -188,6 +206,22 @@ struct timevar_def
   /* Nonzero if this timing variable was ever started or pushed onto
      the timing stack.  */
   unsigned used : 1;
+
+  /* APPLE LOCAL begin timevar inclusive */
+  /* ELAPSED above counts only the time during which this variable was
+     the topmost element of the timing stack (its self time).  This
+     counts all the time during which it was anywhere on the stack,
+     including the time attributed to the variables pushed above it.  */
+  struct timevar_time_def inclusive;
+
+  /* The time at which this variable was pushed onto the timing stack,
+     if it is on the stack.  */
+  struct timevar_time_def inclusive_start;
+
+  /* The number of times this variable is currently on the timing
+     stack.  Only the outermost push is counted in INCLUSIVE.  */
+  unsigned depth;
+  /* APPLE LOCAL end timevar inclusive */
 };
 
 /* An element on the timing stack.  Elapsed time is attributed to the
@@ -230,13 +264,56 @@ static void timevar_accumulate (struct timevar_time_def *,
 static void
 get_time (struct timevar_time_def *now)
 {
+  /* APPLE LOCAL begin pass report */
+  if (!timevar_enable)
+    {
+      now->user = 0;
+      now->sys  = 0;
+      now->wall = 0;
+      now->ggc_mem = timevar_ggc_mem_total;
+      return;
+    }
+
+  timevar_get_time (now);
+}
+
+/* Compute the scale factors used by timevar_get_time, once.  */
+
+static void
+timevar_init_clock (void)
+{
+  static bool initialized;
+
+  if (initialized)
+    return;
+  initialized = true;
+
+#ifdef USE_TIMES
+  ticks_to_msec = TICKS_TO_MSEC;
+#endif
+#ifdef USE_CLOCK
+  clocks_to_msec = CLOCKS_TO_MSEC;
+#endif
+#if defined(USE_MACH_TIME) || defined(USE_PPC_INTRINSICS)
+  mach_timebase_info(&tbase);
+  timeBaseRatio = ((double) tbase.numer / (double) tbase.denom) * 1e-9;
+#endif
+}
+
+/* Fill the current times into NOW, whether or not timing variables
+   are enabled.  This is for clients such as -fpass-report that do
+   their own accounting.  */
+
+void
+timevar_get_time (struct timevar_time_def *now)
+{
+  timevar_init_clock ();
+
   now->user = 0;
   now->sys  = 0;
   now->wall = 0;
   now->ggc_mem = timevar_ggc_mem_total;
-
-  if (!timevar_enable)
-    return;
+  /* APPLE LOCAL end pass report */
 
   {
 #ifdef USE_TIMES
@@ -254,6 +331,15 @@ get_time (struct timevar_time_def *now)
 #ifdef USE_CLOCK
     now->user = clock () * clocks_to_msec;
 #endif
+    /* APPLE LOCAL begin timevar clock */
+#ifdef USE_CLOCK_GETTIME
+    {
+      struct timespec ts;
+      clock_gettime (CLOCK_MONOTONIC, &ts);
+      now->wall = ts.tv_sec + ts.tv_nsec * 1e-9;
+    }
+#endif
+    /* APPLE LOCAL end timevar clock */
     /* APPLE LOCAL begin Mach time */
 #ifdef USE_MACH_TIME
     now->wall = mach_absolute_time() * timeBaseRatio;
@@ -294,18 +380,8 @@ timevar_init (void)
 #include "timevar.def"
 #undef DEFTIMEVAR
 
-#ifdef USE_TIMES
-  ticks_to_msec = TICKS_TO_MSEC;
-#endif
-#ifdef USE_CLOCK
-  clocks_to_msec = CLOCKS_TO_MSEC;
-#endif
-  /* APPLE LOCAL begin Mach time */
-#if defined(USE_MACH_TIME) || defined(USE_PPC_INTRINSICS)
-  mach_timebase_info(&tbase);
-  timeBaseRatio = ((double) tbase.numer / (double) tbase.denom) * 1e-9;
-#endif
-  /* APPLE LOCAL end Mach time */
+  /* APPLE LOCAL pass report */
+  timevar_init_clock ();
 }
 
 /* Push TIMEVAR onto the timing stack.  No further elapsed time is
@@ -340,6 +416,11 @@ timevar_push_1 (timevar_id_t timevar)
      TIMEVAR.  */
   start_time = now;
 
+  /* APPLE LOCAL begin timevar inclusive */
+  if (tv->depth++ == 0)
+    tv->inclusive_start = now;
+  /* APPLE LOCAL end timevar inclusive */
+
   /* See if we have a previously-allocated stack instance.  If so,
      take it off the list.  If not, malloc a new one.  */
   if (unused_stack_instances != NULL)
@@ -376,6 +457,12 @@ timevar_pop_1 (timevar_id_t timevar)
   /* Attribute the elapsed time to the element we're popping.  */
   timevar_accumulate (&popped->timevar->elapsed, &start_time, &now);
 
+  /* APPLE LOCAL begin timevar inclusive */
+  if (--popped->timevar->depth == 0)
+    timevar_accumulate (&popped->timevar->inclusive,
+			&popped->timevar->inclusive_start, &now);
+  /* APPLE LOCAL end timevar inclusive */
+
   /* Reset the start time; from now on, time is attributed to the
      element just exposed on the stack.  */
   start_time = now;
@@ -429,6 +516,8 @@ timevar_stop (timevar_id_t timevar)
 
   get_time (&now);
   timevar_accumulate (&tv->elapsed, &tv->start_time, &now);
+  /* APPLE LOCAL timevar inclusive */
+  timevar_accumulate (&tv->inclusive, &tv->start_time, &now);
 }
 
 /* Summarize timing variables to FP.  The timing variable TV_TOTAL has
@@ -469,6 +558,8 @@ timevar_print (FILE *fp)
     {
       struct timevar_def *tv = &timevars[(timevar_id_t) id];
       const double tiny = 5e-3;
+      /* APPLE LOCAL timevar inclusive */
+      struct timevar_time_def inclusive = tv->inclusive;
 
       /* Don't print the total execution time here; that goes at the
 	 end.  */
@@ -479,13 +570,21 @@ timevar_print (FILE *fp)
       if (!tv->used)
 	continue;
 
+      /* APPLE LOCAL begin timevar inclusive */
+      /* A variable still on the stack has been running since its
+	 outermost push.  */
+      if (tv->depth)
+	timevar_accumulate (&inclusive, &tv->inclusive_start, &now);
+
       /* Don't print timing variables if we're going to get a row of
          zeroes.  */
       if (tv->elapsed.user < tiny
 	  && tv->elapsed.sys < tiny
 	  && tv->elapsed.wall < tiny
+	  && inclusive.wall < tiny
 	  && tv->elapsed.ggc_mem < GGC_MEM_BOUND)
 	continue;
+      /* APPLE LOCAL end timevar inclusive */
 
       /* The timing variable name.  */
       fprintf (fp, " %-22s:", tv->name);
@@ -509,6 +608,11 @@ timevar_print (FILE *fp)
       fprintf (fp, "%7.2f (%2.0f%%) wall",
 	       tv->elapsed.wall,
 	       (total->wall == 0 ? 0 : tv->elapsed.wall / total->wall) * 100);
+
+      /* APPLE LOCAL begin timevar inclusive */
+      /* Print wall clock time including nested timing variables.  */
+      fprintf (fp, "%7.2f incl", inclusive.wall);
+      /* APPLE LOCAL end timevar inclusive */
 #endif /* HAVE_WALL_TIME */
 
       /* Print the amount of ggc memory allocated.  */
@@ -39,6 +39,18 @@ extern int prepends_underscore;
 
 static int tlink_verbose;
 
+/* APPLE LOCAL begin parallel tlink */
+/* The most recompilations to run at once.  */
+static int tlink_jobs;
+
+/* A recompilation in progress.  */
+struct recompile_job
+{
+  struct file_hash_entry *f;
+  struct pex_obj *pex;
+};
+/* APPLE LOCAL end parallel tlink */
+
 static char initial_cwd[MAXPATHLEN + 1];
 
 /* Hash table boilerplate for working with htab_t.  We have hash tables
@@ -60,6 +72,8 @@ typedef struct file_hash_entry
   const char *dir;
   const char *main;
   int tweaking;
+  /* APPLE LOCAL parallel tlink */
+  int recompiling;
 } file;
 
 typedef struct demangled_hash_entry
@@ -106,6 +120,8 @@ static char * pfgets (FILE *);
 static void freadsym (FILE *, file *, int);
 static void read_repo_file (file *);
 static void maybe_tweak (char *, file *);
+/* APPLE LOCAL parallel tlink */
+static int finish_recompile (struct recompile_job *, int *);
 static int recompile_files (void);
 static int read_repo_files (char **);
 static void demangle_new_symbols (void);
@@ -275,6 +291,21 @@ tlink_init (void)
 	tlink_verbose = 3;
     }
 
+  /* APPLE LOCAL begin parallel tlink */
+  p = getenv ("TLINK_JOBS");
+  if (p)
+    tlink_jobs = atoi (p);
+  else
+    {
+      tlink_jobs = 1;
+#ifdef _SC_NPROCESSORS_ONLN
+      tlink_jobs = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+    }
+  if (tlink_jobs < 1)
+    tlink_jobs = 1;
+  /* APPLE LOCAL end parallel tlink */
+
   getcwd (initial_cwd, sizeof (initial_cwd));
 }
 
@@ -438,6 +469,29 @@ maybe_tweak (char *line, file *f)
     }
 }
 
+/* APPLE LOCAL begin parallel tlink */
+/* Wait for the oldest of the *N_JOBS recompilations in JOBS to finish,
+   remove it, and read back the repo file it has updated.  Return 0 if
+   it failed.  Finishing them in the order they were started keeps the
+   outcome the same however long each one takes.  */
+
+static int
+finish_recompile (struct recompile_job *jobs, int *n_jobs)
+{
+  file *f = jobs[0].f;
+  int ret = collect_wait (c_file_name, jobs[0].pex);
+
+  (*n_jobs)--;
+  memmove (jobs, jobs + 1, *n_jobs * sizeof (struct recompile_job));
+  f->recompiling = 0;
+  if (ret != 0)
+    return 0;
+
+  read_repo_file (f);
+  return 1;
+}
+/* APPLE LOCAL end parallel tlink */
+
 /* Update the repo files for each of the object files we have adjusted and
    recompile.  */
 
@@ -445,19 +499,48 @@ static int
 recompile_files (void)
 {
   file *f;
+  /* APPLE LOCAL begin parallel tlink */
+  struct recompile_job *jobs = XNEWVEC (struct recompile_job, tlink_jobs);
+  int n_jobs = 0;
+  int ok = 1;
+  /* APPLE LOCAL end parallel tlink */
 
   putenv (xstrdup ("COMPILER_PATH="));
   putenv (xstrdup ("LIBRARY_PATH="));
 
-  while ((f = file_pop ()) != NULL)
+  /* APPLE LOCAL begin parallel tlink */
+  while (ok)
     {
       char *line;
       const char *p, *q;
       char **argv;
       struct obstack arg_stack;
-      FILE *stream = fopen (f->key, "r");
-      const char *const outname = frob_extension (f->key, ".rnw");
-      FILE *output = fopen (outname, "w");
+      FILE *stream;
+      const char *outname;
+      FILE *output;
+
+      /* Finish a recompilation when there is no room for another or
+	 nothing else to start, as the files it chooses may have to be
+	 recompiled in turn.  */
+      if (n_jobs == tlink_jobs || (file_stack == NULL && n_jobs > 0))
+	{
+	  ok = finish_recompile (jobs, &n_jobs);
+	  continue;
+	}
+      f = file_pop ();
+      if (f == NULL)
+	break;
+
+      /* Don't rewrite the repo file of one still being recompiled.  */
+      while (ok && f->recompiling)
+	ok = finish_recompile (jobs, &n_jobs);
+      if (!ok)
+	break;
+
+      stream = fopen (f->key, "r");
+      outname = frob_extension (f->key, ".rnw");
+      output = fopen (outname, "w");
+      /* APPLE LOCAL end parallel tlink */
 
       while ((line = tfgets (stream)) != NULL)
 	{
@@ -483,11 +566,14 @@ recompile_files (void)
 	{
 	  error ("repository file '%s' does not contain command-line "
 		 "arguments", f->key);
-	  return 0;
+	  /* APPLE LOCAL begin parallel tlink */
+	  ok = 0;
+	  break;
+	  /* APPLE LOCAL end parallel tlink */
 	}
 
       /* Build a null-terminated argv array suitable for
-	 tlink_execute().  Manipulate arguments on the arg_stack while
+	 collect_execute().  Manipulate arguments on the arg_stack while
 	 building argv on the temporary_obstack.  */
 
       obstack_init (&arg_stack);
@@ -533,17 +619,34 @@ recompile_files (void)
       if (tlink_verbose)
 	fprintf (stderr, _("collect: recompiling %s\n"), f->main);
 
-      if (chdir (f->dir) != 0
-	  || tlink_execute (c_file_name, argv, NULL, NULL) != 0
-	  || chdir (initial_cwd) != 0)
-	return 0;
-
-      read_repo_file (f);
+      /* APPLE LOCAL begin parallel tlink */
+      /* The compiler is started in F's directory, and we wait for it
+	 back in ours.  */
+      if (chdir (f->dir) != 0)
+	ok = 0;
+      else
+	{
+	  jobs[n_jobs].f = f;
+	  jobs[n_jobs].pex = collect_execute (c_file_name, argv, NULL, NULL);
+	  n_jobs++;
+	  f->recompiling = 1;
+	  if (chdir (initial_cwd) != 0)
+	    ok = 0;
+	}
+      /* APPLE LOCAL end parallel tlink */
 
       obstack_free (&arg_stack, NULL);
       obstack_free (&temporary_obstack, temporary_firstobj);
     }
-  return 1;
+
+  /* APPLE LOCAL begin parallel tlink */
+  /* After a failure, still wait for the ones that are running.  */
+  while (n_jobs > 0)
+    if (!finish_recompile (jobs, &n_jobs))
+      ok = 0;
+  free (jobs);
+  return ok;
+  /* APPLE LOCAL end parallel tlink */
 }
 
 /* The first phase of processing: determine which object files have
@@ -779,9 +882,18 @@ do_tlink (char **ld_argv, char **object_lst ATTRIBUTE_UNUSED)
 		dump_file (lderrout, stderr);
 	      }
 	    demangle_new_symbols ();
-	    if (! scan_linker_output (ldout)
-		&& ! scan_linker_output (lderrout))
-	      break;
+	    /* APPLE LOCAL begin parallel tlink */
+	    /* Take every missing symbol the linker reported, from both
+	       of its outputs, before recompiling, so that they are all
+	       provided in one round.  */
+	    {
+	      int found_out = scan_linker_output (ldout);
+	      int found_err = scan_linker_output (lderrout);
+
+	      if (! found_out && ! found_err)
+		break;
+	    }
+	    /* APPLE LOCAL end parallel tlink */
 	    if (! recompile_files ())
 	      break;
 	    if (tlink_verbose)
@@ -82,6 +82,8 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 #include "value-prof.h"
 #include "alloc-pool.h"
 #include "tree-mudflap.h"
+/* APPLE LOCAL compile server */
+#include "compile-server.h"
 
 #if defined (DWARF2_UNWIND_INFO) || defined (DWARF2_DEBUGGING_INFO)
 #include "dwarf2out.h"
@@ -1594,6 +1596,27 @@ default_tree_printer (pretty_printer * pp, text_info *text, const char *spec,
   return true;
 }
 
+/* APPLE LOCAL begin retune gc params 6124839 */
+/* Set the GC parameters for the command line in save_argv.  This must
+   be done after general_init's add_params but before argument
+   processing.  */
+
+static void
+retune_ggc_params (void)
+{
+  int i = 0;
+  bool opt = false;
+
+  while (save_argv[++i])
+    {
+      if (strncmp (save_argv[i], "-O", 2) == 0
+	  && strcmp (save_argv[i], "-O0") != 0)
+	opt = true;
+    }
+  init_ggc_heuristics (opt);
+}
+/* APPLE LOCAL end retune gc params 6124839 */
+
 /* Initialization of the front end environment, before command line
    options are parsed.  Signal handlers, internationalization etc.
    ARGV0 is main's argv[0].  */
@@ -1674,20 +1697,6 @@ general_init (const char *argv0)
 
   /* Register the language-independent parameters.  */
   add_params (lang_independent_params, LAST_PARAM);
-
-  /* APPLE LOCAL begin retune gc params 6124839 */
-  { int i = 0;
-    bool opt = false;
-    while (save_argv[++i])
-      {
-	if (strncmp (save_argv[i], "-O", 2) == 0
-	    && strcmp (save_argv[i], "-O0") != 0)
-	  opt = true;
-      }
-    /* This must be done after add_params but before argument processing.  */
-    init_ggc_heuristics(opt);
-  }
-  /* APPLE LOCAL end retune gc params 6124839 */
   init_optimization_passes ();
 }
 
@@ -2205,10 +2214,37 @@ do_compile (void)
 int
 toplev_main (unsigned int argc, const char **argv)
 {
-  save_argv = argv;
+  /* APPLE LOCAL begin compile server */
+  if (argc == 2
+      && strncmp (argv[1], COMPILE_SERVER_OPTION,
+		  strlen (COMPILE_SERVER_OPTION)) == 0)
+    return compile_server_main (argv[0],
+				argv[1] + strlen (COMPILE_SERVER_OPTION));
+
+  toplev_init (argv[0]);
+  return toplev_compile (argc, argv);
+}
+
+/* Do the initialization that does not depend on the command line, as
+   the first half of toplev_main.  A compile server does this once and
+   then calls toplev_compile in a fresh child for each compilation.  */
 
+void
+toplev_init (const char *argv0)
+{
   /* Initialization of GCC's environment, and diagnostics.  */
-  general_init (argv[0]);
+  general_init (argv0);
+}
+
+/* Compile with the command line ARGC, ARGV after toplev_init, as the
+   second half of toplev_main, and return the exit code.  */
+
+int
+toplev_compile (unsigned int argc, const char **argv)
+{
+  save_argv = argv;
+  retune_ggc_params ();
+  /* APPLE LOCAL end compile server */
 
   /* Parse the options and do minimal processing; basically just
      enough to default flags appropriately.  */
@@ -28,6 +28,10 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
    (strncmp (whole, part, strlen (part)) ? NULL : whole + strlen (part))
 
 extern int toplev_main (unsigned int, const char **);
+/* APPLE LOCAL begin compile server */
+extern void toplev_init (const char *);
+extern int toplev_compile (unsigned int, const char **);
+/* APPLE LOCAL end compile server */
 extern int read_integral_parameter (const char *, const char *, const int);
 extern void strip_off_ending (char *, int);
 extern const char *trim_filename (const char *);
@@ -122,9 +122,11 @@ static struct datadep_stats
   int num_miv_unimplemented;
 } dependence_stats;
 
+/* APPLE LOCAL begin vect slp */
 static tree object_analysis (tree, tree, bool, struct data_reference **, 
 			     tree *, tree *, tree *, tree *, tree *,
-			     struct ptr_info_def **, subvar_t *);
+			     struct ptr_info_def **, subvar_t *, bool);
+/* APPLE LOCAL end vect slp */
 static struct data_reference * init_data_ref (tree, tree, tree, tree, bool, 
 					      tree, tree, tree, tree, tree, 
 					      struct ptr_info_def *,
@@ -1507,7 +1509,8 @@ address_analysis (tree expr, tree stmt, bool is_read, struct data_reference *dr,
     case ADDR_EXPR:
       base_address = object_analysis (TREE_OPERAND (expr, 0), stmt, is_read, 
 				      &dr, offset, misalign, aligned_to, step, 
-				      &dummy, &dummy1, &dummy2);
+				      /* APPLE LOCAL vect slp */
+				      &dummy, &dummy1, &dummy2, false);
       return base_address;
 
     case SSA_NAME:
@@ -1586,6 +1589,12 @@ address_analysis (tree expr, tree stmt, bool is_read, struct data_reference *dr,
    PTR_INFO - NULL or points-to aliasing info from a pointer SSA_NAME
    SUBVARS - Sub-variables of the variable
 
+   APPLE LOCAL vect slp
+   STRAIGHT_LINE - TRUE if MEMREF is analyzed for vectorization within its
+                   basic block, in which case references through loop
+                   invariant pointers and to fields of scalar objects are
+                   accepted too.
+
    If the analysis of MEMREF evolution in the loop fails, NULL_TREE is returned, 
    but DR can be created anyway.
    
@@ -1595,7 +1604,9 @@ static tree
 object_analysis (tree memref, tree stmt, bool is_read, 
 		 struct data_reference **dr, tree *offset, tree *misalign, 
 		 tree *aligned_to, tree *step, tree *memtag,
-		 struct ptr_info_def **ptr_info, subvar_t *subvars)
+		 struct ptr_info_def **ptr_info, subvar_t *subvars,
+		 /* APPLE LOCAL vect slp */
+		 bool straight_line)
 {
   tree base = NULL_TREE, base_address = NULL_TREE;
   tree object_offset = ssize_int (0), object_misalign = ssize_int (0);
@@ -1706,6 +1717,12 @@ object_analysis (tree memref, tree stmt, bool is_read,
 		  return NULL_TREE;
 		}
 	    }
+	  /* APPLE LOCAL begin vect slp */
+	  else if (straight_line && comp_ref)
+	    *dr = init_data_ref (stmt, comp_ref, memref, ssize_int (0), is_read,
+				 NULL_TREE, NULL_TREE, NULL_TREE, NULL_TREE,
+				 NULL_TREE, NULL, ARRAY_REF_TYPE);
+	  /* APPLE LOCAL end vect slp */
 	  else 
 	    {
 	      if (dump_file && (dump_flags & TDF_DETAILS))
@@ -1771,7 +1788,8 @@ object_analysis (tree memref, tree stmt, bool is_read,
 	  return NULL_TREE;
 	}
 
-      if (integer_zerop (ptr_step) && !(*dr))
+      /* APPLE LOCAL vect slp */
+      if (integer_zerop (ptr_step) && !(*dr) && !straight_line)
 	{
 	  if (dump_file && (dump_flags & TDF_DETAILS)) 
 	    fprintf (dump_file, "\nptr is loop invariant.\n");	
@@ -1929,7 +1947,8 @@ analyze_offset (tree offset, tree *invariant, tree *constant)
 
 /* Free the memory used by the data reference DR.  */
 
-static void
+/* APPLE LOCAL vect slp */
+void
 free_data_ref (data_reference_p dr)
 {
   DR_FREE_ACCESS_FNS (dr);
@@ -1946,13 +1965,18 @@ free_data_ref (data_reference_p dr)
    MEMREF - the memory reference that is being analyzed
    STMT - the statement that contains MEMREF
    IS_READ - TRUE if STMT reads from MEMREF, FALSE if writes to MEMREF
+   APPLE LOCAL vect slp
+   STRAIGHT_LINE - TRUE if MEMREF is analyzed for vectorization within its
+                   basic block rather than across loop iterations
 
    Output:
    DR (returned value) - data_reference struct for MEMREF
 */
 
-static struct data_reference *
-create_data_ref (tree memref, tree stmt, bool is_read)
+/* APPLE LOCAL begin vect slp */
+struct data_reference *
+create_data_ref (tree memref, tree stmt, bool is_read, bool straight_line)
+/* APPLE LOCAL end vect slp */
 {
   struct data_reference *dr = NULL;
   tree base_address, offset, step, misalign, memtag;
@@ -1968,7 +1992,8 @@ create_data_ref (tree memref, tree stmt, bool is_read)
 
   base_address = object_analysis (memref, stmt, is_read, &dr, &offset, 
 				  &misalign, &aligned_to, &step, &memtag, 
-				  &ptr_info, &subvars);
+				  /* APPLE LOCAL vect slp */
+				  &ptr_info, &subvars, straight_line);
   if (!dr || !base_address)
     {
       if (dump_file && (dump_flags & TDF_DETAILS))
@@ -2184,7 +2209,9 @@ compute_subscript_distance (struct data_dependence_relation *ddr)
    B.  NB_LOOPS is the number of loops surrounding the references: the
    size of the classic distance/direction vectors.  */
 
-static struct data_dependence_relation *
+/* APPLE LOCAL begin loop distribution */
+struct data_dependence_relation *
+/* APPLE LOCAL end loop distribution */
 initialize_data_dependence_relation (struct data_reference *a, 
 				     struct data_reference *b,
  				     VEC (loop_p, heap) *loop_nest)
@@ -4139,7 +4166,8 @@ find_data_references_in_loop (struct loop *loop,
 		    || TREE_CODE (opnd0) == INDIRECT_REF
                     || TREE_CODE (opnd0) == COMPONENT_REF)
 		  {
-		    dr = create_data_ref (opnd0, stmt, false);
+		    /* APPLE LOCAL vect slp */
+		    dr = create_data_ref (opnd0, stmt, false, false);
 		    if (dr) 
 		      {
 			VEC_safe_push (data_reference_p, heap, *datarefs, dr);
@@ -4151,7 +4179,8 @@ find_data_references_in_loop (struct loop *loop,
 		    || TREE_CODE (opnd1) == INDIRECT_REF
 		    || TREE_CODE (opnd1) == COMPONENT_REF)
 		  {
-		    dr = create_data_ref (opnd1, stmt, true);
+		    /* APPLE LOCAL vect slp */
+		    dr = create_data_ref (opnd1, stmt, true, false);
 		    if (dr) 
 		      {
 			VEC_safe_push (data_reference_p, heap, *datarefs, dr);
@@ -4176,7 +4205,9 @@ find_data_references_in_loop (struct loop *loop,
 		      || TREE_CODE (TREE_VALUE (args)) == INDIRECT_REF
 		      || TREE_CODE (TREE_VALUE (args)) == COMPONENT_REF)
 		    {
-		      dr = create_data_ref (TREE_VALUE (args), stmt, true);
+		      /* APPLE LOCAL vect slp */
+		      dr = create_data_ref (TREE_VALUE (args), stmt, true,
+					    false);
 		      if (dr)
 			{
 			  VEC_safe_push (data_reference_p, heap, *datarefs, dr);
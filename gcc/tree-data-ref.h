@@ -291,6 +291,14 @@ extern void dump_data_dependence_direction (FILE *,
 extern void free_dependence_relation (struct data_dependence_relation *);
 extern void free_dependence_relations (VEC (ddr_p, heap) *);
 extern void free_data_refs (VEC (data_reference_p, heap) *);
+/* APPLE LOCAL begin vect slp */
+extern struct data_reference *create_data_ref (tree, tree, bool, bool);
+extern void free_data_ref (data_reference_p);
+/* APPLE LOCAL end vect slp */
+/* APPLE LOCAL begin loop distribution */
+extern struct data_dependence_relation *initialize_data_dependence_relation
+  (struct data_reference *, struct data_reference *, VEC (loop_p, heap) *);
+/* APPLE LOCAL end loop distribution */
 extern struct data_reference *analyze_array (tree, tree, bool);
 extern void estimate_iters_using_array (tree, tree);
 
@@ -313,5 +321,7 @@ index_in_loop_nest (int var, VEC (loop_p, heap) *loop_nest)
 
 /* In lambda-code.c  */
 bool lambda_transform_legal_p (lambda_trans_matrix, int, VEC (ddr_p, heap) *);
+/* APPLE LOCAL loop tiling */
+bool lambda_tiling_legal_p (lambda_trans_matrix, int, VEC (ddr_p, heap) *);
 
 #endif  /* GCC_TREE_DATA_REF_H  */
@@ -802,6 +802,11 @@ void vectorize_loops (struct loops *);
 extern bool vect_can_force_dr_alignment_p (tree, unsigned int);
 extern tree get_vectype_for_scalar_type (tree);
 
+/* APPLE LOCAL begin vect slp */
+/* In tree-vect-slp.c */
+void vect_slp_transform_bbs (struct loops *);
+/* APPLE LOCAL end vect slp */
+
 /* In tree-ssa-phiopt.c */
 bool empty_block_p (basic_block);
 
@@ -811,7 +816,12 @@ void tree_ssa_lim (struct loops *);
 unsigned int tree_ssa_unswitch_loops (struct loops *);
 unsigned int canonicalize_induction_variables (struct loops *);
 unsigned int tree_unroll_loops_completely (struct loops *, bool);
+/* APPLE LOCAL vect outer loop */
+bool tree_unroll_loop_completely (struct loops *, struct loop *);
 unsigned int tree_ssa_prefetch_arrays (struct loops *);
+/* APPLE LOCAL loop tiling */
+unsigned HOST_WIDE_INT loop_memory_footprint (struct loop *,
+					      unsigned HOST_WIDE_INT);
 unsigned int remove_empty_loops (struct loops *);
 void tree_ssa_iv_optimize (struct loops *);
 
@@ -943,6 +953,13 @@ bool sra_type_can_be_decomposed_p (tree);
 /* In tree-loop-linear.c  */
 extern void linear_transform_loops (struct loops *);
 
+/* APPLE LOCAL begin loop distribution */
+/* In tree-loop-distribution.c  */
+extern unsigned int tree_loop_distribution (struct loops *);
+extern unsigned int tree_loop_fusion (struct loops *);
+extern unsigned int tree_unroll_and_jam (struct loops *);
+/* APPLE LOCAL end loop distribution */
+
 /* In tree-ssa-loop-ivopts.c  */
 bool expr_invariant_in_loop_p (struct loop *, tree);
 bool multiplier_allowed_in_address_p (HOST_WIDE_INT);
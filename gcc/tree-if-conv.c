@@ -128,6 +128,15 @@ static tree ifc_temp_var (tree, tree);
 static bool pred_blocks_visited_p (basic_block, bitmap *);
 static basic_block * get_loop_body_in_if_conv_order (const struct loop *loop);
 static bool bb_with_exit_edge_p (struct loop *, basic_block);
+/* APPLE LOCAL begin ifcvt stores */
+static void tree_if_convert_store (tree, tree, block_stmt_iterator *);
+static bool ifc_same_value_p (tree, tree, int);
+static bool ifc_same_memref_p (tree, tree);
+static bool ifc_memref_always_accessed_p (struct loop *, tree, bool);
+static bool ifc_store_in_both_arms_p (struct loop *, basic_block, tree);
+static bool ifc_array_ref_in_bounds_p (struct loop *, tree);
+static bool ifc_memref_safe_p (struct loop *, basic_block, tree, bool);
+/* APPLE LOCAL end ifcvt stores */
 
 /* List of basic blocks in if-conversion-suitable order.  */
 static basic_block *ifc_bbs;
@@ -237,6 +246,15 @@ tree_if_convert_stmt (struct loop *  loop, tree t, tree cond,
 	 this transformation, PHI nodes was selecting default value and now it will
 	 use this new value. This is OK because it does not change validity the
 	 program.  */
+      /* APPLE LOCAL begin ifcvt stores */
+      /* A store is executed unconditionally from now on, so it has to
+	 write back the old value when COND does not hold.  */
+      if (TREE_CODE (TREE_OPERAND (t, 0)) != SSA_NAME
+	  && cond != NULL_TREE
+	  && cond != boolean_true_node
+	  && !bb_with_exit_edge_p (loop, bb_for_stmt (t)))
+	tree_if_convert_store (t, cond, bsi);
+      /* APPLE LOCAL end ifcvt stores */
       break;
 
     case COND_EXPR:
@@ -292,11 +310,62 @@ tree_if_convert_cond_expr (struct loop *loop, tree stmt, tree cond,
   return;
 }
 
+/* APPLE LOCAL begin ifcvt stores */
+/* STMT is a store in a basic block that is executed only when COND
+   holds.  Turn it into a read-modify-write of the same location,
+
+     old = REF;
+     new = COND ? RHS : old;
+     REF = new;
+
+   so that it can be executed unconditionally.  BSI points to STMT.  */
+
+static void
+tree_if_convert_store (tree stmt, tree cond, block_stmt_iterator *bsi)
+{
+  tree lhs = TREE_OPERAND (stmt, 0);
+  tree type = TREE_TYPE (lhs);
+  tree old_stmt, new_stmt, stmts;
+
+  /* Vectorizer prefers to have a comparison as the condition, as in
+     find_phi_replacement_condition.  */
+  cond = force_gimple_operand (unshare_expr (cond), &stmts, false, NULL_TREE);
+  if (stmts)
+    bsi_insert_before (bsi, stmts, BSI_SAME_STMT);
+  if (!is_gimple_reg (cond) && !is_gimple_condexpr (cond))
+    {
+      tree cond_stmt = ifc_temp_var (TREE_TYPE (cond), cond);
+      bsi_insert_before (bsi, cond_stmt, BSI_SAME_STMT);
+      cond = TREE_OPERAND (cond_stmt, 0);
+    }
+
+  old_stmt = ifc_temp_var (type, unshare_expr (lhs));
+  bsi_insert_before (bsi, old_stmt, BSI_SAME_STMT);
+  mark_new_vars_to_rename (old_stmt);
+
+  new_stmt = ifc_temp_var (type, build3 (COND_EXPR, type, cond,
+					 TREE_OPERAND (stmt, 1),
+					 TREE_OPERAND (old_stmt, 0)));
+  bsi_insert_before (bsi, new_stmt, BSI_SAME_STMT);
+
+  TREE_OPERAND (stmt, 1) = TREE_OPERAND (new_stmt, 0);
+  update_stmt (stmt);
+
+  if (dump_file && (dump_flags & TDF_DETAILS))
+    {
+      fprintf (dump_file, "conditional store replacement\n");
+      print_generic_stmt (dump_file, new_stmt, TDF_SLIM);
+      print_generic_stmt (dump_file, stmt, TDF_SLIM);
+    }
+}
+/* APPLE LOCAL end ifcvt stores */
+
 /* Return true, iff PHI is if-convertible. PHI is part of loop LOOP
    and it belongs to basic block BB.
    PHI is not if-convertible
    - if it has more than 2 arguments.
-   - Virtual PHI is immediately used in another PHI node.  */
+   APPLE LOCAL ifcvt stores
+   Virtual PHIs are removed and their symbols renamed.  */
 
 static bool
 if_convertible_phi_p (struct loop *loop, basic_block bb, tree phi)
@@ -314,21 +383,6 @@ if_convertible_phi_p (struct loop *loop, basic_block bb, tree phi)
       return false;
     }
 
-  if (!is_gimple_reg (SSA_NAME_VAR (PHI_RESULT (phi))))
-    {
-      imm_use_iterator imm_iter;
-      use_operand_p use_p;
-      FOR_EACH_IMM_USE_FAST (use_p, imm_iter, PHI_RESULT (phi))
-	{
-	  if (TREE_CODE (USE_STMT (use_p)) == PHI_NODE)
-	    {
-	      if (dump_file && (dump_flags & TDF_DETAILS))
-		fprintf (dump_file, "Difficult to handle this virtual phi.\n");
-	      return false;
-	    }
-	}
-    }
-
   return true;
 }
 
@@ -359,7 +413,9 @@ if_convertible_modify_expr_p (struct loop *loop, basic_block bb, tree m_expr)
 
   /* See if it needs speculative loading or not.  */
   if (bb != loop->header
-      && tree_could_trap_p (TREE_OPERAND (m_expr, 1)))
+      && tree_could_trap_p (TREE_OPERAND (m_expr, 1))
+      /* APPLE LOCAL ifcvt stores */
+      && !ifc_memref_safe_p (loop, bb, TREE_OPERAND (m_expr, 1), false))
     {
       if (dump_file && (dump_flags & TDF_DETAILS))
 	fprintf (dump_file, "tree could trap...\n");
@@ -375,7 +431,9 @@ if_convertible_modify_expr_p (struct loop *loop, basic_block bb, tree m_expr)
 
   if (TREE_CODE (TREE_OPERAND (m_expr, 0)) != SSA_NAME
       && bb != loop->header
-      && !bb_with_exit_edge_p (loop, bb))
+      && !bb_with_exit_edge_p (loop, bb)
+      /* APPLE LOCAL ifcvt stores */
+      && !ifc_memref_safe_p (loop, bb, TREE_OPERAND (m_expr, 0), true))
     {
       if (dump_file && (dump_flags & TDF_DETAILS))
 	{
@@ -389,6 +447,246 @@ if_convertible_modify_expr_p (struct loop *loop, basic_block bb, tree m_expr)
   return true;
 }
 
+/* APPLE LOCAL begin ifcvt stores */
+/* Return true if A and B compute the same value.  SSA names are followed
+   to their definitions through arithmetic that does not read memory, so
+   that two copies of an address computation, one in each arm of a
+   condition, compare equal.  DEPTH bounds the search.  */
+
+static bool
+ifc_same_value_p (tree a, tree b, int depth)
+{
+  enum tree_code code;
+  int i;
+
+  if (operand_equal_p (a, b, 0))
+    return true;
+  if (depth == 0)
+    return false;
+
+  if (TREE_CODE (a) == SSA_NAME)
+    {
+      tree def = SSA_NAME_DEF_STMT (a);
+
+      if (TREE_CODE (def) != MODIFY_EXPR)
+	return false;
+      a = TREE_OPERAND (def, 1);
+    }
+  if (TREE_CODE (b) == SSA_NAME)
+    {
+      tree def = SSA_NAME_DEF_STMT (b);
+
+      if (TREE_CODE (def) != MODIFY_EXPR)
+	return false;
+      b = TREE_OPERAND (def, 1);
+    }
+
+  /* Two loads may read different values.  */
+  if (REFERENCE_CLASS_P (a) || REFERENCE_CLASS_P (b))
+    return false;
+
+  code = TREE_CODE (a);
+  if (code != TREE_CODE (b)
+      || (TREE_CODE_CLASS (code) != tcc_unary
+	  && TREE_CODE_CLASS (code) != tcc_binary)
+      || (TYPE_MAIN_VARIANT (TREE_TYPE (a))
+	  != TYPE_MAIN_VARIANT (TREE_TYPE (b))))
+    return operand_equal_p (a, b, 0);
+
+  for (i = 0; i < TREE_CODE_LENGTH (code); i++)
+    if (!ifc_same_value_p (TREE_OPERAND (a, i), TREE_OPERAND (b, i),
+			   depth - 1))
+      return false;
+
+  return true;
+}
+
+/* Return true if the memory references A and B access the same location
+   with the same type.  */
+
+static bool
+ifc_same_memref_p (tree a, tree b)
+{
+  if (operand_equal_p (a, b, 0))
+    return true;
+
+  if (TREE_CODE (a) != TREE_CODE (b)
+      || (TYPE_MAIN_VARIANT (TREE_TYPE (a))
+	  != TYPE_MAIN_VARIANT (TREE_TYPE (b))))
+    return false;
+
+  switch (TREE_CODE (a))
+    {
+    case INDIRECT_REF:
+      return ifc_same_value_p (TREE_OPERAND (a, 0), TREE_OPERAND (b, 0), 8);
+
+    case ARRAY_REF:
+      return (operand_equal_p (TREE_OPERAND (a, 0), TREE_OPERAND (b, 0), 0)
+	      && !TREE_OPERAND (a, 2) && !TREE_OPERAND (b, 2)
+	      && !TREE_OPERAND (a, 3) && !TREE_OPERAND (b, 3)
+	      && ifc_same_value_p (TREE_OPERAND (a, 1), TREE_OPERAND (b, 1),
+				   8));
+
+    default:
+      return false;
+    }
+}
+
+/* Return true if the memory reference REF is accessed by a statement of
+   LOOP that is executed on every iteration.  If IS_STORE, only a store
+   to REF counts: a load on every iteration shows that REF does not trap,
+   but not that writing it is free of data races.  */
+
+static bool
+ifc_memref_always_accessed_p (struct loop *loop, tree ref, bool is_store)
+{
+  unsigned int i;
+
+  for (i = 0; i < loop->num_nodes; i++)
+    {
+      basic_block bb = ifc_bbs[i];
+      block_stmt_iterator bsi;
+
+      if (!dominated_by_p (CDI_DOMINATORS, loop->latch, bb))
+	continue;
+
+      for (bsi = bsi_start (bb); !bsi_end_p (bsi); bsi_next (&bsi))
+	{
+	  tree stmt = bsi_stmt (bsi);
+
+	  if (TREE_CODE (stmt) == MODIFY_EXPR
+	      && (ifc_same_memref_p (TREE_OPERAND (stmt, 0), ref)
+		  || (!is_store
+		      && ifc_same_memref_p (TREE_OPERAND (stmt, 1), ref))))
+	    return true;
+	}
+    }
+
+  return false;
+}
+
+/* Return true if BB is one arm of a condition executed on every
+   iteration of LOOP, and the other arm also stores to REF.  One of the
+   two stores is then executed on every iteration.  */
+
+static bool
+ifc_store_in_both_arms_p (struct loop *loop, basic_block bb, tree ref)
+{
+  basic_block cond_bb, other_bb;
+  block_stmt_iterator bsi;
+
+  if (!single_pred_p (bb))
+    return false;
+
+  cond_bb = single_pred (bb);
+  if (EDGE_COUNT (cond_bb->succs) != 2
+      || !dominated_by_p (CDI_DOMINATORS, loop->latch, cond_bb))
+    return false;
+
+  other_bb = EDGE_SUCC (cond_bb, 0)->dest;
+  if (other_bb == bb)
+    other_bb = EDGE_SUCC (cond_bb, 1)->dest;
+  if (other_bb == bb
+      || !single_pred_p (other_bb)
+      || !flow_bb_inside_loop_p (loop, other_bb))
+    return false;
+
+  for (bsi = bsi_start (other_bb); !bsi_end_p (bsi); bsi_next (&bsi))
+    {
+      tree stmt = bsi_stmt (bsi);
+
+      if (TREE_CODE (stmt) == MODIFY_EXPR
+	  && ifc_same_memref_p (TREE_OPERAND (stmt, 0), ref))
+	return true;
+    }
+
+  return false;
+}
+
+/* Return true if REF is an element of a declared array whose index stays
+   within the bounds of the array on every iteration of LOOP.  */
+
+static bool
+ifc_array_ref_in_bounds_p (struct loop *loop, tree ref)
+{
+  tree low, up, chrec, niter;
+  HOST_WIDE_INT lo, hi, init, step, n, last;
+
+  if (TREE_CODE (ref) != ARRAY_REF
+      || !DECL_P (TREE_OPERAND (ref, 0)))
+    return false;
+
+  low = array_ref_low_bound (ref);
+  up = array_ref_up_bound (ref);
+  if (!low || !up
+      || !host_integerp (low, 0)
+      || !host_integerp (up, 0))
+    return false;
+
+  chrec = instantiate_parameters
+    (loop, analyze_scalar_evolution (loop, TREE_OPERAND (ref, 1)));
+  if (TREE_CODE (chrec) != POLYNOMIAL_CHREC
+      || CHREC_VARIABLE (chrec) != (unsigned) loop->num
+      || !host_integerp (CHREC_LEFT (chrec), 0)
+      || !host_integerp (CHREC_RIGHT (chrec), 0))
+    return false;
+
+  /* The statements before the exit test are executed as many times as
+     the exit test itself.  */
+  niter = number_of_iterations_in_loop (loop);
+  if (TREE_CODE (niter) != INTEGER_CST
+      || !host_integerp (niter, 1)
+      || integer_zerop (niter))
+    return false;
+
+  lo = tree_low_cst (low, 0);
+  hi = tree_low_cst (up, 0);
+  init = tree_low_cst (CHREC_LEFT (chrec), 0);
+  step = tree_low_cst (CHREC_RIGHT (chrec), 0);
+  n = tree_low_cst (niter, 1);
+
+  if (init < lo || init > hi)
+    return false;
+  if (n - 1 > hi - lo
+      || step > hi - lo
+      || step < lo - hi)
+    return false;
+
+  last = init + step * (n - 1);
+  return last >= lo && last <= hi;
+}
+
+/* Return true if memory reference REF in basic block BB of LOOP may be
+   accessed on every iteration of LOOP.  Accessing it must not trap when
+   BB would not have been executed.  A store that is made unconditional
+   also writes back the old value, which must not race with other
+   threads.  For a load this is known if REF is accessed unconditionally
+   anyway, and for a store if REF is stored to unconditionally or in both
+   arms of a condition.  Otherwise loads are safe if REF is known to be
+   within the bounds of a declared array, and stores if the user also
+   allows the data race with -ftree-loop-if-convert-stores.  */
+
+static bool
+ifc_memref_safe_p (struct loop *loop, basic_block bb, tree ref,
+		   bool is_store)
+{
+  if (!REFERENCE_CLASS_P (ref)
+      || !is_gimple_reg_type (TREE_TYPE (ref)))
+    return false;
+
+  if (ifc_memref_always_accessed_p (loop, ref, is_store))
+    return true;
+
+  if (is_store && ifc_store_in_both_arms_p (loop, bb, ref))
+    return true;
+
+  if (is_store && !flag_tree_loop_if_convert_stores)
+    return false;
+
+  return ifc_array_ref_in_bounds_p (loop, ref);
+}
+/* APPLE LOCAL end ifcvt stores */
+
 /* Return true, iff STMT is if-convertible.
    Statement is if-convertible if,
    - It is if-convertible MODIFY_EXPR
@@ -868,15 +1166,24 @@ process_phi_nodes (struct loop *loop)
       phi = phi_nodes (bb);
       bsi = bsi_after_labels (bb);
 
-      /* BB has two predecessors. Using predecessor's aux field, set
-	 appropriate condition for the PHI node replacement.  */
-      if (phi)
-	true_bb = find_phi_replacement_condition (loop, bb, &cond, &bsi);
-
       while (phi)
 	{
 	  tree next = PHI_CHAIN (phi);
-	  replace_phi_with_cond_modify_expr (phi, cond, true_bb, &bsi);
+	  /* APPLE LOCAL begin ifcvt stores */
+	  /* The stores that the virtual PHIs merged are unconditional
+	     now; let the SSA updater rebuild their chains.  */
+	  if (!is_gimple_reg (SSA_NAME_VAR (PHI_RESULT (phi))))
+	    mark_sym_for_renaming (SSA_NAME_VAR (PHI_RESULT (phi)));
+	  else
+	    {
+	      /* BB has two predecessors. Using predecessor's aux field, set
+		 appropriate condition for the PHI node replacement.  */
+	      if (!true_bb)
+		true_bb = find_phi_replacement_condition (loop, bb, &cond,
+							  &bsi);
+	      replace_phi_with_cond_modify_expr (phi, cond, true_bb, &bsi);
+	    }
+	  /* APPLE LOCAL end ifcvt stores */
 	  release_phi_node (phi);
 	  phi = next;
 	}
@@ -1130,6 +1437,8 @@ main_tree_if_conversion (void)
 {
   unsigned i, loop_num;
   struct loop *loop;
+  /* APPLE LOCAL ifcvt stores */
+  bool changed = false;
 
   if (!current_loops)
     return 0;
@@ -1141,8 +1450,18 @@ main_tree_if_conversion (void)
       if (!loop)
       continue;
 
-      tree_if_conversion (loop, true);
+      /* APPLE LOCAL begin ifcvt stores */
+      if (tree_if_conversion (loop, true))
+	changed = true;
+      /* APPLE LOCAL end ifcvt stores */
     }
+
+  /* APPLE LOCAL begin ifcvt stores */
+  /* Statements and PHI nodes the analyzed evolutions refer to may have
+     been replaced.  */
+  if (changed)
+    scev_reset ();
+  /* APPLE LOCAL end ifcvt stores */
   return 0;
 }
 
@@ -1165,7 +1484,8 @@ struct tree_opt_pass pass_if_conversion =
   0,					/* properties_provided */
   0,					/* properties_destroyed */
   0,					/* todo_flags_start */
-  TODO_dump_func | TODO_verify_loops | TODO_verify_stmts | TODO_verify_flow,	
-                                        /* todo_flags_finish */
+  /* APPLE LOCAL ifcvt stores */
+  TODO_dump_func | TODO_verify_loops | TODO_verify_stmts | TODO_verify_flow
+  | TODO_update_ssa,			/* todo_flags_finish */
   0					/* letter */
 };
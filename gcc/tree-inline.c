@@ -1782,6 +1782,18 @@ estimate_num_insns_1 (tree *tp, int *walk_subtrees, void *data)
 
     case WIDEN_MULT_EXPR:
 
+    /* APPLE LOCAL begin vect interleave */
+    case VEC_EXTRACT_EVEN_EXPR:
+    case VEC_EXTRACT_ODD_EXPR:
+    case VEC_INTERLEAVE_HIGH_EXPR:
+    case VEC_INTERLEAVE_LOW_EXPR:
+    /* APPLE LOCAL end vect interleave */
+    /* APPLE LOCAL begin vect multiple types */
+    case VEC_UNPACK_HI_EXPR:
+    case VEC_UNPACK_LO_EXPR:
+    case VEC_PACK_MOD_EXPR:
+    /* APPLE LOCAL end vect multiple types */
+
     case RESX_EXPR:
       *count += 1;
       break;
@@ -0,0 +1,1815 @@
+/* APPLE LOCAL file loop distribution */
+/* Loop distribution, loop fusion and unroll-and-jam.
+   Copyright (C) 2007 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 2, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING.  If not, write to the Free
+Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+02110-1301, USA.  */
+
+/* This file implements three transformations of innermost loops whose
+   body is a single basic block, driven by the dependences between their
+   data references.
+
+   Loop distribution splits a loop into several loops over the same
+   iteration space, each executing a part of the statements:
+
+	for (i = 1; i < n; i++)		for (i = 1; i < n; i++)
+	  {				  a[i] = b[i] + c[i];
+	    a[i] = b[i] + c[i];	 ==>	for (i = 1; i < n; i++)
+	    d[i] = d[i-1] * a[i];	  d[i] = d[i-1] * a[i];
+	  }
+
+   so that the first loop, free of the recurrence on D, can be vectorized.
+   The statements are the nodes of a graph whose edges are the scalar
+   flow and the memory dependences between them.  Its strongly connected
+   components are placed in partitions in a topological order, grouping
+   the components that belong to recurrences apart from the others.
+   Scalar values are not expanded into arrays: a value computed in one
+   partition and used in another is recomputed there when it neither
+   writes memory nor is used after the loop, and otherwise the two
+   partitions are merged.  The loop is distributed only when this leaves
+   a partition without recurrences next to one with them.
+
+   Loop fusion is the inverse transformation.  Two consecutive loops with
+   the same number of iterations are merged when the code between them
+   can be moved out of the way and no dependence from the first loop to
+   the second goes backwards in the iteration space.  The pass fuses
+   loops that access the same arrays, saving a pass over memory.
+
+   Unroll-and-jam unrolls the outer loop of a nest and fuses the copies
+   of the inner loop, so that the data reused across iterations of the
+   outer loop is loaded once:
+
+	for (i = 0; i < 100; i++)	for (i = 0; i < 100; i += 2)
+	  for (j = 0; j < m; j++)	  for (j = 0; j < m; j++)
+	    y[i] += A[i][j] * x[j];  ==>    {
+					      y[i] += A[i][j] * x[j];
+					      y[i+1] += A[i+1][j] * x[j];
+					    }
+
+   The outer loop is unrolled only when its number of iterations is a
+   known multiple of the unroll factor, since the epilogue loop of a
+   general unrolling cannot be made by versioning a loop nest.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+#include "tm.h"
+#include "ggc.h"
+#include "tree.h"
+#include "target.h"
+#include "basic-block.h"
+#include "diagnostic.h"
+#include "tree-flow.h"
+#include "tree-dump.h"
+#include "timevar.h"
+#include "cfgloop.h"
+#include "expr.h"
+#include "tree-chrec.h"
+#include "tree-data-ref.h"
+#include "tree-scalar-evolution.h"
+#include "tree-pass.h"
+#include "tree-vectorizer.h"
+#include "params.h"
+
+/* The maximal number of statements of a loop that is distributed.  */
+#define MAX_DISTRIBUTED_STMTS 64
+
+/* The maximal number of basic blocks between two loops that are fused.  */
+#define MAX_FUSION_CHAIN 8
+
+/* The kinds of edges of the graph of a distributed loop.  */
+#define LDIST_FLOW 1		/* The source computes a scalar used by the
+				   sink.  */
+#define LDIST_MEM 2		/* The source and the sink access the same
+				   memory.  */
+#define LDIST_CARRIED 4		/* The dependence is carried by the loop.  */
+
+/* A statement or phi node of a distributed loop.  */
+
+struct ldist_node
+{
+  tree stmt;
+
+  /* True for a phi node.  */
+  bool phi_p;
+
+  /* The position of the statement among the phi nodes or among the
+     statements of the loop body, ignoring labels.  The copies of the
+     loop keep the same positions.  */
+  int pos;
+
+  /* True if the statement writes memory, and true if its result is used
+     after the loop.  These statements have to be executed exactly
+     once per iteration.  */
+  bool store_p;
+  bool live_p;
+
+  /* The strongly connected component of the node.  */
+  int scc;
+
+  /* The partition where the node is computed, or -1 if the node may be
+     recomputed in every partition that uses it.  */
+  int part;
+
+  /* Data of the search for the strongly connected components.  */
+  int dfs, low;
+  bool on_stack;
+};
+
+/* The graph of a distributed loop.  */
+
+struct ldist_graph
+{
+  int n_nodes;
+  struct ldist_node nodes[MAX_DISTRIBUTED_STMTS];
+
+  /* The LDIST_* edges between the nodes.  */
+  unsigned char edges[MAX_DISTRIBUTED_STMTS][MAX_DISTRIBUTED_STMTS];
+
+  /* The strongly connected components: whether they contain no statement
+     that must be executed once per iteration, whether they contain a
+     dependence cycle carried by the loop, and whether they compute a
+     value used after the loop.  */
+  int n_sccs;
+  bool scc_pure[MAX_DISTRIBUTED_STMTS];
+  bool scc_rec[MAX_DISTRIBUTED_STMTS];
+  bool scc_live[MAX_DISTRIBUTED_STMTS];
+
+  /* The partitions, with MEMBER[P][N] set if node N is executed by
+     the loop of partition P.  */
+  int n_parts;
+  bool member[MAX_DISTRIBUTED_STMTS][MAX_DISTRIBUTED_STMTS];
+};
+
+/* The result of the dependence test between two data references.  */
+
+enum ldist_dependence
+{
+  /* The references never access the same memory.  */
+  LDIST_DEP_NONE,
+
+  /* The references access the same memory in iterations a fixed
+     distance apart.  */
+  LDIST_DEP_DISTANCE,
+
+  /* Anything else.  */
+  LDIST_DEP_UNKNOWN
+};
+
+/* Returns true if LOOP is an innermost loop whose body and exit test are
+   in its header, followed by an empty latch.  */
+
+static bool
+simple_innermost_loop_p (struct loop *loop)
+{
+  return (loop->single_exit
+	  && loop->single_exit->src == loop->header
+	  && slpeel_can_duplicate_loop_p (loop, loop_preheader_edge (loop)));
+}
+
+/* Returns true if REF is a memory reference that is described by a data
+   reference.  */
+
+static bool
+ldist_ref_p (tree ref)
+{
+  return (TREE_CODE (ref) == ARRAY_REF
+	  || TREE_CODE (ref) == INDIRECT_REF
+	  || TREE_CODE (ref) == COMPONENT_REF);
+}
+
+/* Returns true if STMT is an assignment that accesses memory only as a
+   plain load or store of a single reference, so that all its memory
+   accesses are described by the data references of the loop.  */
+
+static bool
+ldist_simple_stmt_p (tree stmt)
+{
+  tree lhs, rhs;
+
+  if (TREE_CODE (stmt) != MODIFY_EXPR
+      || get_call_expr_in (stmt)
+      || tree_could_throw_p (stmt)
+      || stmt_ann (stmt)->has_volatile_ops)
+    return false;
+
+  if (ZERO_SSA_OPERANDS (stmt, SSA_OP_ALL_VIRTUALS))
+    return true;
+
+  lhs = TREE_OPERAND (stmt, 0);
+  rhs = TREE_OPERAND (stmt, 1);
+  if (TREE_CODE (lhs) == SSA_NAME)
+    return ldist_ref_p (rhs);
+
+  return (ldist_ref_p (lhs)
+	  && (TREE_CODE (rhs) == SSA_NAME || is_gimple_min_invariant (rhs)));
+}
+
+/* Returns the difference A - B of two access functions if it is an
+   integer constant, and NULL_TREE otherwise.  Evolutions in the same
+   loop with the same step cancel out, the references being executed in
+   the same iteration of the loops they share.  */
+
+static tree
+ldist_chrec_difference (tree a, tree b)
+{
+  tree diff;
+
+  if (TREE_CODE (a) == POLYNOMIAL_CHREC
+      || TREE_CODE (b) == POLYNOMIAL_CHREC)
+    {
+      if (TREE_CODE (a) != POLYNOMIAL_CHREC
+	  || TREE_CODE (b) != POLYNOMIAL_CHREC
+	  || CHREC_VARIABLE (a) != CHREC_VARIABLE (b)
+	  || !operand_equal_p (CHREC_RIGHT (a), CHREC_RIGHT (b), 0))
+	return NULL_TREE;
+
+      return ldist_chrec_difference (CHREC_LEFT (a), CHREC_LEFT (b));
+    }
+
+  diff = chrec_fold_minus (TREE_TYPE (a), a,
+			   chrec_convert (TREE_TYPE (a), b, NULL_TREE));
+  return TREE_CODE (diff) == INTEGER_CST ? diff : NULL_TREE;
+}
+
+/* Tests the dependence between the data reference DRA, executed in loop
+   number LOOP_A, and DRB, executed in loop number LOOP_B.  The two loops
+   may be the same loop or consecutive loops with the same number of
+   iterations.  When they access the same memory in iterations IA of
+   LOOP_A and IB of LOOP_B such that IB = IA + DIST, stores DIST to *DIST
+   and returns LDIST_DEP_DISTANCE.  Unlike the distance vectors of the
+   dependence analysis, DIST may be negative.  */
+
+static enum ldist_dependence
+ldist_dr_dependence (struct data_reference *dra, unsigned loop_a,
+		     struct data_reference *drb, unsigned loop_b,
+		     HOST_WIDE_INT *dist)
+{
+  struct data_dependence_relation *ddr;
+  enum ldist_dependence res = LDIST_DEP_UNKNOWN;
+  tree size_a = TYPE_SIZE_UNIT (TREE_TYPE (DR_REF (dra)));
+  tree size_b = TYPE_SIZE_UNIT (TREE_TYPE (DR_REF (drb)));
+  bool pointer_p = DR_TYPE (dra) == POINTER_REF_TYPE;
+  bool known = false;
+  unsigned i;
+
+  ddr = initialize_data_dependence_relation (dra, drb, NULL);
+  if (DDR_ARE_DEPENDENT (ddr) == chrec_known)
+    {
+      free_dependence_relation (ddr);
+      return LDIST_DEP_NONE;
+    }
+  if (DDR_ARE_DEPENDENT (ddr) == chrec_dont_know
+      || DR_TYPE (dra) != DR_TYPE (drb)
+      || DR_NUM_DIMENSIONS (dra) != DR_NUM_DIMENSIONS (drb)
+      || !size_a || !size_b
+      || !host_integerp (size_a, 1)
+      || !tree_int_cst_equal (size_a, size_b))
+    goto end;
+
+  for (i = 0; i < DR_NUM_DIMENSIONS (dra); i++)
+    {
+      tree fa = DR_ACCESS_FN (dra, i);
+      tree fb = DR_ACCESS_FN (drb, i);
+      tree step_a = NULL_TREE, step_b = NULL_TREE, diff;
+      HOST_WIDE_INT d, s;
+
+      if (chrec_contains_undetermined (fa)
+	  || chrec_contains_undetermined (fb))
+	goto end;
+
+      if (TREE_CODE (fa) == POLYNOMIAL_CHREC
+	  && CHREC_VARIABLE (fa) == loop_a)
+	{
+	  step_a = CHREC_RIGHT (fa);
+	  fa = CHREC_LEFT (fa);
+	}
+      if (TREE_CODE (fb) == POLYNOMIAL_CHREC
+	  && CHREC_VARIABLE (fb) == loop_b)
+	{
+	  step_b = CHREC_RIGHT (fb);
+	  fb = CHREC_LEFT (fb);
+	}
+
+      diff = ldist_chrec_difference (fa, fb);
+      if (!diff || !host_integerp (diff, 0))
+	goto end;
+      d = tree_low_cst (diff, 0);
+
+      if (!step_a && !step_b)
+	{
+	  /* The same element in all the iterations.  For a pointer, D is
+	     in bytes and the accesses may overlap partially.  */
+	  if (d == 0)
+	    continue;
+	  res = pointer_p ? LDIST_DEP_UNKNOWN : LDIST_DEP_NONE;
+	  goto end;
+	}
+
+      if (!step_a || !step_b
+	  || !host_integerp (step_a, 0)
+	  || !host_integerp (step_b, 0)
+	  || (s = tree_low_cst (step_a, 0)) != tree_low_cst (step_b, 0)
+	  || s == 0
+	  || (pointer_p
+	      && (s < 0 ? -s : s) < tree_low_cst (size_a, 1)))
+	goto end;
+
+      /* A (IA) = FA + S * IA and B (IB) = FB + S * IB are the same
+	 element when IB = IA + (FA - FB) / S.  */
+      if (d % s != 0)
+	{
+	  res = pointer_p ? LDIST_DEP_UNKNOWN : LDIST_DEP_NONE;
+	  goto end;
+	}
+      if (known && *dist != d / s)
+	{
+	  res = LDIST_DEP_NONE;
+	  goto end;
+	}
+      *dist = d / s;
+      known = true;
+    }
+
+  if (known)
+    res = LDIST_DEP_DISTANCE;
+
+ end:
+  free_dependence_relation (ddr);
+  return res;
+}
+
+/* Returns true if DRA and DRB access the same array or the same memory
+   through the same pointer.  */
+
+static bool
+ldist_same_base_p (struct data_reference *dra, struct data_reference *drb)
+{
+  if (DR_BASE_OBJECT (dra) && DR_BASE_OBJECT (drb))
+    return operand_equal_p (DR_BASE_OBJECT (dra), DR_BASE_OBJECT (drb), 0);
+  if (DR_BASE_ADDRESS (dra) && DR_BASE_ADDRESS (drb))
+    return operand_equal_p (DR_BASE_ADDRESS (dra), DR_BASE_ADDRESS (drb), 0);
+  return false;
+}
+
+/* Returns true if all the statements of LOOP that access memory are
+   described by its data references.  */
+
+static bool
+ldist_simple_loop_stmts_p (struct loop *loop)
+{
+  block_stmt_iterator bsi;
+  tree stmt, exit_cond = last_stmt (loop->header);
+
+  for (bsi = bsi_start (loop->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    {
+      stmt = bsi_stmt (bsi);
+      if (TREE_CODE (stmt) != LABEL_EXPR
+	  && stmt != exit_cond
+	  && !ldist_simple_stmt_p (stmt))
+	return false;
+    }
+
+  return true;
+}
+
+
+/* Loop fusion.  */
+
+/* Stores in CHAIN the basic blocks on the path from the exit of LOOP1
+   to the preheader of LOOP2, and returns their number.  Returns 0 if
+   LOOP2 does not follow LOOP1 on a straight path.  */
+
+static unsigned
+fusion_chain (struct loop *loop1, struct loop *loop2, basic_block *chain)
+{
+  basic_block bb = loop1->single_exit->dest;
+  basic_block preheader = loop_preheader_edge (loop2)->src;
+  unsigned n = 0;
+
+  while (1)
+    {
+      if (n == MAX_FUSION_CHAIN
+	  || bb->loop_father != loop1->outer
+	  || !single_pred_p (bb)
+	  || !single_succ_p (bb))
+	return 0;
+
+      chain[n++] = bb;
+      if (bb == preheader)
+	return n;
+      bb = single_succ (bb);
+    }
+}
+
+/* Returns the index in CHAIN of the basic block containing STMT, or N if
+   STMT is not in CHAIN.  */
+
+static unsigned
+chain_index (basic_block *chain, unsigned n, tree stmt)
+{
+  basic_block bb = bb_for_stmt (stmt);
+  unsigned i;
+
+  for (i = 0; i < n; i++)
+    if (chain[i] == bb)
+      break;
+
+  return i;
+}
+
+/* Records in *HOISTED the statement defining NAME if it is in one of the
+   N basic blocks of CHAIN, together with the statements of CHAIN it
+   depends on.  Returns false if one of them cannot be moved before the
+   first loop.  */
+
+static bool
+fusion_hoist_def (tree name, basic_block *chain, unsigned n,
+		  VEC (tree, heap) **hoisted)
+{
+  tree stmt, use;
+  ssa_op_iter iter;
+  unsigned i;
+
+  if (TREE_CODE (name) != SSA_NAME)
+    return true;
+
+  stmt = SSA_NAME_DEF_STMT (name);
+  if (!bb_for_stmt (stmt) || chain_index (chain, n, stmt) == n)
+    return true;
+
+  for (i = 0; i < VEC_length (tree, *hoisted); i++)
+    if (VEC_index (tree, *hoisted, i) == stmt)
+      return true;
+
+  /* Only computations and loads can be moved.  */
+  if (!ldist_simple_stmt_p (stmt)
+      || TREE_CODE (TREE_OPERAND (stmt, 0)) != SSA_NAME
+      || !ZERO_SSA_OPERANDS (stmt, SSA_OP_VIRTUAL_DEFS))
+    return false;
+
+  VEC_safe_push (tree, heap, *hoisted, stmt);
+  FOR_EACH_SSA_TREE_OPERAND (use, stmt, iter, SSA_OP_USE)
+    if (!fusion_hoist_def (use, chain, n, hoisted))
+      return false;
+
+  return true;
+}
+
+/* Returns true if the value NAME used by LOOP2 is available before LOOP1,
+   or is computed in one of the N basic blocks of CHAIN.  */
+
+static bool
+fusion_available_p (struct loop *loop1, struct loop *loop2,
+		    basic_block *chain, unsigned n, tree name)
+{
+  basic_block bb;
+
+  if (TREE_CODE (name) != SSA_NAME)
+    return true;
+
+  bb = bb_for_stmt (SSA_NAME_DEF_STMT (name));
+  return (!bb
+	  || flow_bb_inside_loop_p (loop2, bb)
+	  || chain_index (chain, n, SSA_NAME_DEF_STMT (name)) < n
+	  || dominated_by_p (CDI_DOMINATORS,
+			     loop_preheader_edge (loop1)->src, bb));
+}
+
+/* Records in SYMS the symbols of the virtual operands of STMT selected
+   by FLAGS.  */
+
+static void
+record_virtual_symbols (tree stmt, bitmap syms, int flags)
+{
+  tree op;
+  ssa_op_iter iter;
+
+  FOR_EACH_SSA_TREE_OPERAND (op, stmt, iter, flags)
+    bitmap_set_bit (syms, DECL_UID (SSA_NAME_VAR (op)));
+}
+
+/* Returns true if the load LOAD and the store STORE, executed in this
+   order in an iteration of their loop, never access the same memory, so
+   that LOAD can be moved before STORE.  */
+
+static bool
+fusion_load_independent_p (tree load, tree store)
+{
+  struct loop *loop = loop_containing_stmt (load);
+  struct data_reference *dra = NULL, *drb = NULL;
+  HOST_WIDE_INT dist;
+  bool ok;
+
+  if (loop->num == 0
+      || !ldist_simple_stmt_p (store)
+      || TREE_CODE (TREE_OPERAND (store, 0)) == SSA_NAME)
+    return false;
+
+  dra = create_data_ref (TREE_OPERAND (load, 1), load, true, false);
+  drb = create_data_ref (TREE_OPERAND (store, 0), store, false, false);
+  ok = (dra && drb
+	&& ldist_dr_dependence (dra, loop->num, drb, loop->num,
+				&dist) == LDIST_DEP_NONE);
+
+  if (dra)
+    free_data_ref (dra);
+  if (drb)
+    free_data_ref (drb);
+  return ok;
+}
+
+/* Returns true if the code in the N basic blocks of CHAIN between LOOP1
+   and LOOP2 allows to fuse the loops.  The statements computing the
+   values used by LOOP2 are stored in *HOISTED, in their order of
+   execution, to be moved before LOOP1; the other statements will be
+   executed after the fused loop, so they must not access the memory
+   accessed by LOOP2.  */
+
+static bool
+fusion_chain_movable_p (struct loop *loop1, struct loop *loop2,
+			basic_block *chain, unsigned n,
+			VEC (tree, heap) **hoisted)
+{
+  VEC (tree, heap) *needed = NULL, *stores = NULL;
+  bitmap loop1_syms = NULL, loop2_syms = NULL, chain_syms = NULL, syms;
+  block_stmt_iterator bsi;
+  edge entry2 = loop_preheader_edge (loop2);
+  tree phi, stmt, use, store;
+  ssa_op_iter iter;
+  unsigned i, j;
+  bool ok = false;
+
+  /* The values used by LOOP2 must be available before LOOP1, or be
+     computed by statements of CHAIN that can be moved there.  The memory
+     state is rebuilt after the fusion.  */
+  for (phi = phi_nodes (loop2->header); phi; phi = PHI_CHAIN (phi))
+    {
+      if (!is_gimple_reg (PHI_RESULT (phi)))
+	continue;
+
+      use = PHI_ARG_DEF_FROM_EDGE (phi, entry2);
+      if (!fusion_available_p (loop1, loop2, chain, n, use)
+	  || !fusion_hoist_def (use, chain, n, &needed))
+	goto end;
+    }
+  for (bsi = bsi_start (loop2->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    FOR_EACH_SSA_TREE_OPERAND (use, bsi_stmt (bsi), iter, SSA_OP_USE)
+      if (!fusion_available_p (loop1, loop2, chain, n, use)
+	  || !fusion_hoist_def (use, chain, n, &needed))
+	goto end;
+  for (i = 0; VEC_iterate (tree, needed, i, stmt); i++)
+    FOR_EACH_SSA_TREE_OPERAND (use, stmt, iter, SSA_OP_USE)
+      if (!fusion_available_p (loop1, loop2, chain, n, use))
+	goto end;
+
+  loop1_syms = BITMAP_ALLOC (NULL);
+  loop2_syms = BITMAP_ALLOC (NULL);
+  chain_syms = BITMAP_ALLOC (NULL);
+  for (bsi = bsi_start (loop1->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    record_virtual_symbols (bsi_stmt (bsi), loop1_syms, SSA_OP_VIRTUAL_DEFS);
+  for (bsi = bsi_start (loop2->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    record_virtual_symbols (bsi_stmt (bsi), loop2_syms, SSA_OP_ALL_VIRTUALS);
+
+  for (i = 0; i < n; i++)
+    for (bsi = bsi_start (chain[i]); !bsi_end_p (bsi); bsi_next (&bsi))
+      {
+	stmt = bsi_stmt (bsi);
+	for (j = 0; j < VEC_length (tree, needed); j++)
+	  if (VEC_index (tree, needed, j) == stmt)
+	    break;
+
+	if (j == VEC_length (tree, needed))
+	  {
+	    if (TREE_CODE (stmt) == ASM_EXPR || get_call_expr_in (stmt))
+	      goto end;
+	    record_virtual_symbols (stmt, chain_syms, SSA_OP_ALL_VIRTUALS);
+	    if (!ZERO_SSA_OPERANDS (stmt, SSA_OP_VIRTUAL_DEFS))
+	      VEC_safe_push (tree, heap, stores, stmt);
+	    continue;
+	  }
+
+	/* A load moved before LOOP1 must not read memory stored by LOOP1
+	   or by the code it is moved across.  */
+	if (!ZERO_SSA_OPERANDS (stmt, SSA_OP_VIRTUAL_USES))
+	  {
+	    syms = BITMAP_ALLOC (NULL);
+	    record_virtual_symbols (stmt, syms, SSA_OP_VIRTUAL_USES);
+	    ok = !bitmap_intersect_p (syms, loop1_syms);
+	    for (j = 0; ok && VEC_iterate (tree, stores, j, store); j++)
+	      {
+		bitmap store_syms = BITMAP_ALLOC (NULL);
+
+		record_virtual_symbols (store, store_syms,
+					SSA_OP_VIRTUAL_DEFS);
+		if (bitmap_intersect_p (syms, store_syms)
+		    && !fusion_load_independent_p (stmt, store))
+		  ok = false;
+		BITMAP_FREE (store_syms);
+	      }
+	    BITMAP_FREE (syms);
+	    if (!ok)
+	      goto end;
+	  }
+	VEC_safe_push (tree, heap, *hoisted, stmt);
+      }
+
+  ok = !bitmap_intersect_p (loop2_syms, chain_syms);
+
+ end:
+  if (loop1_syms)
+    {
+      BITMAP_FREE (loop1_syms);
+      BITMAP_FREE (loop2_syms);
+      BITMAP_FREE (chain_syms);
+    }
+  VEC_free (tree, heap, needed);
+  VEC_free (tree, heap, stores);
+  return ok;
+}
+
+/* Returns true if no dependence between the data references DATAREFS1
+   of LOOP1 and DATAREFS2 of LOOP2 prevents fusing the loops.  Sets
+   *REUSE if the loops access the same data.  */
+
+static bool
+fusion_dependences_ok_p (struct loop *loop1, struct loop *loop2,
+			 VEC (data_reference_p, heap) *datarefs1,
+			 VEC (data_reference_p, heap) *datarefs2,
+			 bool *reuse)
+{
+  struct data_reference *dr1, *dr2;
+  HOST_WIDE_INT dist;
+  unsigned i, j;
+
+  *reuse = false;
+  for (i = 0; VEC_iterate (data_reference_p, datarefs1, i, dr1); i++)
+    for (j = 0; VEC_iterate (data_reference_p, datarefs2, j, dr2); j++)
+      {
+	if (ldist_same_base_p (dr1, dr2))
+	  *reuse = true;
+
+	if (DR_IS_READ (dr1) && DR_IS_READ (dr2))
+	  continue;
+
+	/* The access of LOOP1 in iteration I must not depend on an access
+	   of LOOP2 in an earlier iteration.  */
+	switch (ldist_dr_dependence (dr1, loop1->num, dr2, loop2->num, &dist))
+	  {
+	  case LDIST_DEP_NONE:
+	    break;
+
+	  case LDIST_DEP_DISTANCE:
+	    if (dist < 0)
+	      return false;
+	    break;
+
+	  default:
+	    return false;
+	  }
+      }
+
+  return true;
+}
+
+/* Returns true if LOOP2, which follows LOOP1, can be fused with it.  If
+   NEED_REUSE, the loops must also access the same data.  The statements
+   to move before LOOP1 are stored in *HOISTED.  */
+
+static bool
+can_fuse_loops_p (struct loop *loop1, struct loop *loop2, bool need_reuse,
+		  VEC (tree, heap) **hoisted)
+{
+  basic_block chain[MAX_FUSION_CHAIN];
+  struct tree_niter_desc niter1, niter2;
+  VEC (data_reference_p, heap) *datarefs1 = NULL, *datarefs2 = NULL;
+  unsigned n;
+  bool ok = false, reuse;
+
+  if (loop1->outer != loop2->outer
+      || !simple_innermost_loop_p (loop1)
+      || !simple_innermost_loop_p (loop2))
+    return false;
+
+  n = fusion_chain (loop1, loop2, chain);
+  if (n == 0)
+    return false;
+
+  if (!number_of_iterations_exit (loop1, loop1->single_exit, &niter1, false)
+      || !number_of_iterations_exit (loop2, loop2->single_exit, &niter2,
+				     false)
+      || !integer_nonzerop (niter1.assumptions)
+      || !integer_nonzerop (niter2.assumptions)
+      || !operand_equal_p (niter1.niter, niter2.niter, 0)
+      || !operand_equal_p (niter1.may_be_zero, niter2.may_be_zero, 0))
+    {
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "Loops %d and %d: different iteration counts.\n",
+		 loop1->num, loop2->num);
+      return false;
+    }
+
+  if (tree_num_loop_insns (loop1) + tree_num_loop_insns (loop2)
+      > (unsigned) PARAM_VALUE (PARAM_MAX_UNROLLED_INSNS))
+    return false;
+
+  if (!ldist_simple_loop_stmts_p (loop1)
+      || !ldist_simple_loop_stmts_p (loop2)
+      || find_data_references_in_loop (loop1, &datarefs1) == chrec_dont_know
+      || find_data_references_in_loop (loop2, &datarefs2) == chrec_dont_know)
+    goto end;
+
+  if (!fusion_dependences_ok_p (loop1, loop2, datarefs1, datarefs2, &reuse))
+    {
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "Loops %d and %d: fusion prevented by a "
+		 "dependence.\n", loop1->num, loop2->num);
+      goto end;
+    }
+
+  if (need_reuse && !reuse)
+    goto end;
+
+  ok = fusion_chain_movable_p (loop1, loop2, chain, n, hoisted);
+  if (!ok && dump_file && (dump_flags & TDF_DETAILS))
+    fprintf (dump_file, "Loops %d and %d: the code between them cannot "
+	     "be moved.\n", loop1->num, loop2->num);
+
+ end:
+  free_data_refs (datarefs1);
+  free_data_refs (datarefs2);
+  return ok;
+}
+
+/* Fuses LOOP2 into LOOP1, moving the statements HOISTED before LOOP1.
+   The body of LOOP2 is placed before the exit test of LOOP1, and LOOP2
+   is left to exit in its first iteration, to be removed by the cfg
+   cleanup.  */
+
+static void
+fuse_loops (struct loop *loop1, struct loop *loop2, VEC (tree, heap) *hoisted)
+{
+  basic_block preheader1 = loop_preheader_edge (loop1)->src;
+  edge entry1 = loop_preheader_edge (loop1);
+  edge latch1 = loop_latch_edge (loop1);
+  edge entry2 = loop_preheader_edge (loop2);
+  edge latch2 = loop_latch_edge (loop2);
+  edge exit2 = loop2->single_exit;
+  tree cond2 = last_stmt (loop2->header);
+  block_stmt_iterator bsi, to;
+  tree phi, next, new_phi, stmt, op;
+  ssa_op_iter iter;
+  unsigned i;
+
+  for (i = 0; VEC_iterate (tree, hoisted, i, stmt); i++)
+    {
+      bsi = bsi_for_stmt (stmt);
+      bsi_move_to_bb_end (&bsi, preheader1);
+    }
+
+  /* Move the induction variables and reductions of LOOP2 to LOOP1.  The
+     virtual operands are renamed.  */
+  for (phi = phi_nodes (loop2->header); phi; phi = next)
+    {
+      tree res = PHI_RESULT (phi);
+
+      next = PHI_CHAIN (phi);
+      if (!is_gimple_reg (res))
+	{
+	  mark_sym_for_renaming (SSA_NAME_VAR (res));
+	  continue;
+	}
+
+      new_phi = create_phi_node (SSA_NAME_VAR (res), loop1->header);
+      add_phi_arg (new_phi, PHI_ARG_DEF_FROM_EDGE (phi, entry2), entry1);
+      add_phi_arg (new_phi, PHI_ARG_DEF_FROM_EDGE (phi, latch2), latch1);
+      replace_uses_by (res, PHI_RESULT (new_phi));
+      remove_phi_node (phi, NULL);
+    }
+
+  to = bsi_last (loop1->header);
+  for (bsi = bsi_start (loop2->header); !bsi_end_p (bsi); )
+    {
+      stmt = bsi_stmt (bsi);
+      if (TREE_CODE (stmt) == LABEL_EXPR || stmt == cond2)
+	{
+	  bsi_next (&bsi);
+	  continue;
+	}
+
+      FOR_EACH_SSA_TREE_OPERAND (op, stmt, iter, SSA_OP_ALL_VIRTUALS)
+	mark_sym_for_renaming (SSA_NAME_VAR (op));
+      bsi_move_before (&bsi, &to);
+    }
+
+  COND_EXPR_COND (cond2) = ((exit2->flags & EDGE_TRUE_VALUE)
+			    ? boolean_true_node : boolean_false_node);
+  update_stmt (cond2);
+
+  update_ssa (TODO_update_ssa);
+  cleanup_tree_cfg_loop ();
+  rewrite_into_loop_closed_ssa (NULL, TODO_update_ssa);
+  scev_reset ();
+}
+
+/* Fuses the loops of OUTER with each other, as long as possible.  If
+   NEED_REUSE, only loops accessing the same data are fused.  Returns
+   true if a loop was fused.  */
+
+static bool
+fuse_sibling_loops (struct loop *outer, bool need_reuse)
+{
+  VEC (tree, heap) *hoisted = NULL;
+  struct loop *loop1, *loop2;
+  bool changed = false;
+
+ restart:
+  for (loop1 = outer->inner; loop1; loop1 = loop1->next)
+    for (loop2 = outer->inner; loop2; loop2 = loop2->next)
+      {
+	if (loop1 == loop2)
+	  continue;
+
+	VEC_truncate (tree, hoisted, 0);
+	if (!can_fuse_loops_p (loop1, loop2, need_reuse, &hoisted))
+	  continue;
+
+	if (dump_file)
+	  fprintf (dump_file, "Fused loop %d into loop %d.\n",
+		   loop2->num, loop1->num);
+	fuse_loops (loop1, loop2, hoisted);
+	changed = true;
+	goto restart;
+      }
+
+  VEC_free (tree, heap, hoisted);
+  return changed;
+}
+
+/* Fuses the consecutive loops in LOOPS that access the same data.  */
+
+unsigned int
+tree_loop_fusion (struct loops *loops)
+{
+  unsigned i;
+
+  for (i = 0; i < loops->num; i++)
+    {
+      struct loop *loop = loops->parray[i];
+
+      if (loop && loop->inner && loop->inner->next)
+	fuse_sibling_loops (loop, true);
+    }
+
+  return 0;
+}
+
+
+/* Loop distribution.  */
+
+/* Returns the index of the node of G for STMT, or -1.  */
+
+static int
+ldist_stmt_node (struct ldist_graph *g, tree stmt)
+{
+  int i;
+
+  for (i = 0; i < g->n_nodes; i++)
+    if (g->nodes[i].stmt == stmt)
+      return i;
+
+  return -1;
+}
+
+/* Returns true if NAME is defined outside of LOOP or is one of the
+   RECOMPUTABLE values of LOOP.  */
+
+static bool
+ldist_recomputable_name_p (struct loop *loop, tree name, bitmap recomputable)
+{
+  basic_block bb;
+
+  if (TREE_CODE (name) != SSA_NAME)
+    return true;
+
+  bb = bb_for_stmt (SSA_NAME_DEF_STMT (name));
+  return (!bb
+	  || !flow_bb_inside_loop_p (loop, bb)
+	  || bitmap_bit_p (recomputable, SSA_NAME_VERSION (name)));
+}
+
+/* Returns true if all the scalar operands of STMT in LOOP are
+   RECOMPUTABLE.  */
+
+static bool
+ldist_recomputable_uses_p (struct loop *loop, tree stmt, bitmap recomputable)
+{
+  tree use;
+  ssa_op_iter iter;
+
+  FOR_EACH_SSA_TREE_OPERAND (use, stmt, iter, SSA_OP_USE)
+    if (!ldist_recomputable_name_p (loop, use, recomputable))
+      return false;
+
+  return true;
+}
+
+/* Adds STMT at position POS to G.  Returns false if G is full.  */
+
+static bool
+ldist_add_node (struct ldist_graph *g, struct loop *loop, tree stmt,
+		bool phi_p, int pos)
+{
+  struct ldist_node *node;
+  tree def;
+  use_operand_p use_p;
+  imm_use_iterator iter;
+
+  if (g->n_nodes == MAX_DISTRIBUTED_STMTS)
+    return false;
+
+  node = &g->nodes[g->n_nodes++];
+  node->stmt = stmt;
+  node->phi_p = phi_p;
+  node->pos = pos;
+  node->store_p = (!phi_p
+		   && !ZERO_SSA_OPERANDS (stmt, SSA_OP_VIRTUAL_DEFS));
+  node->live_p = false;
+
+  def = phi_p ? PHI_RESULT (stmt) : TREE_OPERAND (stmt, 0);
+  if (TREE_CODE (def) == SSA_NAME)
+    FOR_EACH_IMM_USE_FAST (use_p, iter, def)
+      if (!flow_bb_inside_loop_p (loop, bb_for_stmt (USE_STMT (use_p))))
+	node->live_p = true;
+
+  return true;
+}
+
+/* Builds in G the statements of LOOP that have to be placed in a
+   partition, and the scalar flow between them.  The other statements
+   compute induction variables and values derived from them, and are
+   kept in every copy of the loop.  Returns false if LOOP cannot be
+   distributed.  */
+
+static bool
+ldist_build_nodes (struct ldist_graph *g, struct loop *loop)
+{
+  bitmap recomputable = BITMAP_ALLOC (NULL);
+  edge latch = loop_latch_edge (loop);
+  tree exit_cond = last_stmt (loop->header);
+  block_stmt_iterator bsi;
+  tree phi, stmt, use, lhs;
+  ssa_op_iter iter;
+  bool ok = false;
+  int pos, i, u;
+
+  pos = 0;
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi), pos++)
+    {
+      affine_iv iv;
+
+      if (!is_gimple_reg (PHI_RESULT (phi)))
+	continue;
+
+      if (simple_iv (loop, phi, PHI_RESULT (phi), &iv, true))
+	bitmap_set_bit (recomputable, SSA_NAME_VERSION (PHI_RESULT (phi)));
+      else if (!ldist_add_node (g, loop, phi, true, pos))
+	goto end;
+    }
+
+  pos = 0;
+  for (bsi = bsi_start (loop->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    {
+      stmt = bsi_stmt (bsi);
+      if (TREE_CODE (stmt) == LABEL_EXPR)
+	continue;
+
+      if (stmt == exit_cond)
+	{
+	  if (!ldist_recomputable_uses_p (loop, stmt, recomputable))
+	    goto end;
+	}
+      else if (!ldist_simple_stmt_p (stmt))
+	goto end;
+      else
+	{
+	  lhs = TREE_OPERAND (stmt, 0);
+	  if (TREE_CODE (lhs) == SSA_NAME
+	      && ZERO_SSA_OPERANDS (stmt, SSA_OP_ALL_VIRTUALS)
+	      && ldist_recomputable_uses_p (loop, stmt, recomputable))
+	    bitmap_set_bit (recomputable, SSA_NAME_VERSION (lhs));
+	  else if (!ldist_add_node (g, loop, stmt, false, pos))
+	    goto end;
+	}
+      pos++;
+    }
+
+  /* The increments of the induction variables must be recomputable.  */
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    if (is_gimple_reg (PHI_RESULT (phi))
+	&& bitmap_bit_p (recomputable, SSA_NAME_VERSION (PHI_RESULT (phi)))
+	&& !ldist_recomputable_name_p (loop,
+				       PHI_ARG_DEF_FROM_EDGE (phi, latch),
+				       recomputable))
+      goto end;
+
+  /* The scalar flow between the nodes.  */
+  for (i = 0; i < g->n_nodes; i++)
+    {
+      stmt = g->nodes[i].stmt;
+      if (g->nodes[i].phi_p)
+	{
+	  use = PHI_ARG_DEF_FROM_EDGE (stmt, latch);
+	  if (TREE_CODE (use) == SSA_NAME
+	      && (u = ldist_stmt_node (g, SSA_NAME_DEF_STMT (use))) >= 0)
+	    g->edges[u][i] |= LDIST_FLOW | LDIST_CARRIED;
+	  continue;
+	}
+
+      FOR_EACH_SSA_TREE_OPERAND (use, stmt, iter, SSA_OP_USE)
+	if ((u = ldist_stmt_node (g, SSA_NAME_DEF_STMT (use))) >= 0)
+	  g->edges[u][i] |= LDIST_FLOW;
+    }
+  ok = true;
+
+ end:
+  BITMAP_FREE (recomputable);
+  return ok;
+}
+
+/* Adds to G the memory dependences between the statements of LOOP.
+   Returns false if they cannot be computed.  */
+
+static bool
+ldist_build_memory_edges (struct ldist_graph *g, struct loop *loop)
+{
+  VEC (data_reference_p, heap) *datarefs = NULL;
+  struct data_reference *dra, *drb;
+  HOST_WIDE_INT dist;
+  unsigned i, j;
+  int a, b;
+  bool ok = false;
+
+  if (find_data_references_in_loop (loop, &datarefs) == chrec_dont_know)
+    goto end;
+
+  for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dra); i++)
+    for (j = i + 1; VEC_iterate (data_reference_p, datarefs, j, drb); j++)
+      {
+	if (DR_IS_READ (dra) && DR_IS_READ (drb))
+	  continue;
+
+	a = ldist_stmt_node (g, DR_STMT (dra));
+	b = ldist_stmt_node (g, DR_STMT (drb));
+	gcc_assert (a >= 0 && b >= 0);
+
+	switch (ldist_dr_dependence (dra, loop->num, drb, loop->num, &dist))
+	  {
+	  case LDIST_DEP_NONE:
+	    break;
+
+	  case LDIST_DEP_DISTANCE:
+	    if (dist > 0)
+	      g->edges[a][b] |= LDIST_MEM | LDIST_CARRIED;
+	    else if (dist < 0)
+	      g->edges[b][a] |= LDIST_MEM | LDIST_CARRIED;
+	    else if (g->nodes[a].pos < g->nodes[b].pos)
+	      g->edges[a][b] |= LDIST_MEM;
+	    else if (g->nodes[b].pos < g->nodes[a].pos)
+	      g->edges[b][a] |= LDIST_MEM;
+	    break;
+
+	  default:
+	    g->edges[a][b] |= LDIST_MEM | LDIST_CARRIED;
+	    g->edges[b][a] |= LDIST_MEM | LDIST_CARRIED;
+	    break;
+	  }
+      }
+  ok = true;
+
+ end:
+  free_data_refs (datarefs);
+  return ok;
+}
+
+/* Tarjan's search for the strongly connected components of G, from node
+   V.  */
+
+static void
+ldist_scc_1 (struct ldist_graph *g, int v, int *stack, int *sp, int *dfs)
+{
+  struct ldist_node *node = &g->nodes[v];
+  int w;
+
+  node->dfs = node->low = (*dfs)++;
+  stack[(*sp)++] = v;
+  node->on_stack = true;
+
+  for (w = 0; w < g->n_nodes; w++)
+    {
+      if (!g->edges[v][w])
+	continue;
+
+      if (g->nodes[w].dfs < 0)
+	{
+	  ldist_scc_1 (g, w, stack, sp, dfs);
+	  node->low = MIN (node->low, g->nodes[w].low);
+	}
+      else if (g->nodes[w].on_stack)
+	node->low = MIN (node->low, g->nodes[w].dfs);
+    }
+
+  if (node->low == node->dfs)
+    {
+      do
+	{
+	  w = stack[--(*sp)];
+	  g->nodes[w].on_stack = false;
+	  g->nodes[w].scc = g->n_sccs;
+	}
+      while (w != v);
+      g->n_sccs++;
+    }
+}
+
+/* Computes the strongly connected components of G and their kinds.  */
+
+static void
+ldist_compute_sccs (struct ldist_graph *g)
+{
+  int stack[MAX_DISTRIBUTED_STMTS];
+  int sp = 0, dfs = 0, u, v, s;
+
+  for (v = 0; v < g->n_nodes; v++)
+    {
+      g->nodes[v].dfs = -1;
+      g->nodes[v].on_stack = false;
+    }
+  for (v = 0; v < g->n_nodes; v++)
+    if (g->nodes[v].dfs < 0)
+      ldist_scc_1 (g, v, stack, &sp, &dfs);
+
+  for (s = 0; s < g->n_sccs; s++)
+    {
+      g->scc_pure[s] = true;
+      g->scc_rec[s] = false;
+      g->scc_live[s] = false;
+    }
+  for (u = 0; u < g->n_nodes; u++)
+    {
+      s = g->nodes[u].scc;
+      if (g->nodes[u].store_p || g->nodes[u].live_p)
+	g->scc_pure[s] = false;
+      if (g->nodes[u].live_p)
+	g->scc_live[s] = true;
+      for (v = 0; v < g->n_nodes; v++)
+	if ((g->edges[u][v] & LDIST_CARRIED) && g->nodes[v].scc == s)
+	  g->scc_rec[s] = true;
+    }
+}
+
+/* Returns the rank of the strongly connected component S of G when
+   placing it after the partition CUR, whose kind is CUR_REC: components
+   that are not placed come first, and the components computing values
+   used after the loop, which must be in the last partition, come last.
+   Otherwise the components that can be added to CUR are preferred.  */
+
+static int
+ldist_scc_rank (struct ldist_graph *g, int s, int cur, bool cur_rec)
+{
+  int rank;
+
+  if (g->scc_pure[s])
+    return 0;
+
+  rank = g->scc_live[s] ? 3 : 1;
+  if (cur < 0 || g->scc_rec[s] != cur_rec)
+    rank++;
+  return rank;
+}
+
+/* Places the strongly connected components of G in partitions, in a
+   topological order of the dependences.  Consecutive components of the
+   same kind, recurrences or not, share a partition.  The components
+   without stores and results used after the loop are not placed: they
+   are recomputed where they are used.  */
+
+static void
+ldist_place_sccs (struct ldist_graph *g)
+{
+  int n_preds[MAX_DISTRIBUTED_STMTS], first[MAX_DISTRIBUTED_STMTS];
+  int scc_part[MAX_DISTRIBUTED_STMTS];
+  bool done[MAX_DISTRIBUTED_STMTS];
+  int k, s, t, u, v, best, cur = -1;
+  bool cur_rec = false;
+
+  for (s = 0; s < g->n_sccs; s++)
+    {
+      n_preds[s] = 0;
+      first[s] = -1;
+      done[s] = false;
+    }
+  for (u = 0; u < g->n_nodes; u++)
+    {
+      s = g->nodes[u].scc;
+      if (first[s] < 0)
+	first[s] = u;
+      for (v = 0; v < g->n_nodes; v++)
+	if (g->edges[u][v] && g->nodes[v].scc != s)
+	  n_preds[g->nodes[v].scc]++;
+    }
+
+  g->n_parts = 0;
+  for (k = 0; k < g->n_sccs; k++)
+    {
+      /* Among the components whose predecessors are placed, take the one
+	 of the lowest rank that comes first in the loop body.  */
+      best = -1;
+      for (s = 0; s < g->n_sccs; s++)
+	if (!done[s] && !n_preds[s]
+	    && (best < 0
+		|| ldist_scc_rank (g, s, cur, cur_rec)
+		   < ldist_scc_rank (g, best, cur, cur_rec)
+		|| (ldist_scc_rank (g, s, cur, cur_rec)
+		    == ldist_scc_rank (g, best, cur, cur_rec)
+		    && first[s] < first[best])))
+	  best = s;
+      gcc_assert (best >= 0);
+
+      done[best] = true;
+      for (u = 0; u < g->n_nodes; u++)
+	if (g->nodes[u].scc == best)
+	  for (v = 0; v < g->n_nodes; v++)
+	    if (g->edges[u][v] && (t = g->nodes[v].scc) != best)
+	      n_preds[t]--;
+
+      if (g->scc_pure[best])
+	scc_part[best] = -1;
+      else
+	{
+	  if (cur < 0 || g->scc_rec[best] != cur_rec)
+	    {
+	      cur = g->n_parts++;
+	      cur_rec = g->scc_rec[best];
+	    }
+	  scc_part[best] = cur;
+	}
+    }
+
+  for (u = 0; u < g->n_nodes; u++)
+    g->nodes[u].part = scc_part[g->nodes[u].scc];
+}
+
+/* Merges the partitions FROM to TO of G into one.  */
+
+static void
+ldist_merge_parts (struct ldist_graph *g, int from, int to)
+{
+  int u;
+
+  for (u = 0; u < g->n_nodes; u++)
+    if (g->nodes[u].part > to)
+      g->nodes[u].part -= to - from;
+    else if (g->nodes[u].part >= from)
+      g->nodes[u].part = from;
+
+  g->n_parts -= to - from;
+}
+
+/* Computes the members of the partitions of G: the nodes placed in the
+   partition, and the unplaced nodes they use.  If this violates a
+   dependence, merges the partitions involved and returns false.  */
+
+static bool
+ldist_compute_members (struct ldist_graph *g)
+{
+  int p, q, u, v;
+  bool changed;
+
+  memset (g->member, 0, sizeof (g->member));
+  for (u = 0; u < g->n_nodes; u++)
+    if (g->nodes[u].part >= 0)
+      g->member[g->nodes[u].part][u] = true;
+
+  do
+    {
+      changed = false;
+      for (p = 0; p < g->n_parts; p++)
+	for (v = 0; v < g->n_nodes; v++)
+	  if (g->member[p][v])
+	    for (u = 0; u < g->n_nodes; u++)
+	      if ((g->edges[u][v] & LDIST_FLOW)
+		  && g->nodes[u].part < 0
+		  && !g->member[p][u])
+		{
+		  g->member[p][u] = true;
+		  changed = true;
+		}
+    }
+  while (changed);
+
+  for (u = 0; u < g->n_nodes; u++)
+    {
+      /* A value that is not recomputed must be used in its partition,
+	 and a value used after the loop must be computed by the last
+	 loop.  */
+      if (g->nodes[u].part >= 0)
+	{
+	  for (v = 0; v < g->n_nodes; v++)
+	    if (g->edges[u][v] & LDIST_FLOW)
+	      for (p = 0; p < g->n_parts; p++)
+		if (g->member[p][v] && p != g->nodes[u].part)
+		  {
+		    ldist_merge_parts (g, MIN (p, g->nodes[u].part),
+				       MAX (p, g->nodes[u].part));
+		    return false;
+		  }
+
+	  if (g->nodes[u].live_p && g->nodes[u].part != g->n_parts - 1)
+	    {
+	      ldist_merge_parts (g, g->nodes[u].part, g->n_parts - 1);
+	      return false;
+	    }
+	}
+
+      /* The loops execute one after the other, so the source of a
+	 memory dependence must be in the same or an earlier loop.  */
+      for (v = 0; v < g->n_nodes; v++)
+	if (u != v && (g->edges[u][v] & LDIST_MEM))
+	  for (p = 0; p < g->n_parts; p++)
+	    if (g->member[p][u])
+	      for (q = 0; q < p; q++)
+		if (g->member[q][v])
+		  {
+		    ldist_merge_parts (g, q, p);
+		    return false;
+		  }
+    }
+
+  return true;
+}
+
+/* Returns true if partition P of G contains a recurrence.  */
+
+static bool
+ldist_part_rec_p (struct ldist_graph *g, int p)
+{
+  int u;
+
+  for (u = 0; u < g->n_nodes; u++)
+    if (g->member[p][u] && g->scc_rec[g->nodes[u].scc])
+      return true;
+
+  return false;
+}
+
+/* Removes from LOOP, a copy of the loop of G, the statements that are
+   not members of partition P.  */
+
+static void
+ldist_prune_loop (struct ldist_graph *g, struct loop *loop, int p)
+{
+  VEC (tree, heap) *phis = NULL, *stmts = NULL;
+  block_stmt_iterator bsi;
+  tree phi, stmt, def;
+  ssa_op_iter iter;
+  int u;
+
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    VEC_safe_push (tree, heap, phis, phi);
+  for (bsi = bsi_start (loop->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    if (TREE_CODE (bsi_stmt (bsi)) != LABEL_EXPR)
+      VEC_safe_push (tree, heap, stmts, bsi_stmt (bsi));
+
+  /* The uses are removed before the definitions.  */
+  for (u = g->n_nodes - 1; u >= 0; u--)
+    {
+      if (g->member[p][u])
+	continue;
+
+      if (g->nodes[u].phi_p)
+	remove_phi_node (VEC_index (tree, phis, g->nodes[u].pos), NULL);
+      else
+	{
+	  stmt = VEC_index (tree, stmts, g->nodes[u].pos);
+	  FOR_EACH_SSA_TREE_OPERAND (def, stmt, iter, SSA_OP_VIRTUAL_DEFS)
+	    mark_sym_for_renaming (SSA_NAME_VAR (def));
+	  bsi = bsi_for_stmt (stmt);
+	  bsi_remove (&bsi, true);
+	  release_defs (stmt);
+	}
+    }
+
+  VEC_free (tree, heap, phis);
+  VEC_free (tree, heap, stmts);
+}
+
+/* Returns true if NAME is an SSA name defined in LOOP.  */
+
+static bool
+ldist_defined_in_loop_p (struct loop *loop, tree name)
+{
+  basic_block bb;
+
+  if (TREE_CODE (name) != SSA_NAME)
+    return false;
+
+  bb = bb_for_stmt (SSA_NAME_DEF_STMT (name));
+  return bb && flow_bb_inside_loop_p (loop, bb);
+}
+
+/* Places a copy of LOOP before it, and returns the copy.  Both loops
+   start from the initial values of the induction variables.  */
+
+static struct loop *
+ldist_copy_loop (struct loops *loops, struct loop *loop)
+{
+  struct loop *copy;
+  edge latch = loop_latch_edge (loop);
+  block_stmt_iterator bsi;
+  basic_block bb;
+  tree phi, phi_copy, def, use;
+  ssa_op_iter iter;
+
+  /* The values defined outside of LOOP are not renamed in the copy.  */
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    {
+      def = PHI_ARG_DEF_FROM_EDGE (phi, loop_preheader_edge (loop));
+      if (TREE_CODE (def) == SSA_NAME)
+	set_current_def (def, NULL_TREE);
+    }
+  for (bsi = bsi_start (loop->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    FOR_EACH_SSA_TREE_OPERAND (use, bsi_stmt (bsi), iter, SSA_OP_ALL_USES)
+      if (!ldist_defined_in_loop_p (loop, use))
+	set_current_def (use, NULL_TREE);
+
+  copy = slpeel_tree_duplicate_loop_to_edge_cfg (loop, loops,
+						 loop_preheader_edge (loop));
+  gcc_assert (copy);
+  copy->estimated_nb_iterations = loop->estimated_nb_iterations;
+
+  /* The copy is entered with the initial values of LOOP, queued on its
+     entry edge when it was redirected.  The arguments queued on the new
+     entry edge of LOOP belong to the phi nodes after the loop, which
+     are not reached from the copy.  */
+  flush_pending_stmts (loop_preheader_edge (copy));
+  PENDING_STMT (loop_preheader_edge (loop)) = NULL_TREE;
+
+  for (phi = phi_nodes (loop->header), phi_copy = phi_nodes (copy->header);
+       phi && phi_copy;
+       phi = PHI_CHAIN (phi), phi_copy = PHI_CHAIN (phi_copy))
+    {
+      def = PHI_ARG_DEF_FROM_EDGE (phi, latch);
+      if (ldist_defined_in_loop_p (loop, def))
+	def = get_current_def (def);
+      add_phi_arg (phi_copy, def, loop_latch_edge (copy));
+    }
+
+  rename_variables_in_loop (copy);
+  delete_update_ssa ();
+
+  /* Leave no current definitions behind for the later users of the
+     renamer, like the vectorizer.  */
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    set_current_def (PHI_RESULT (phi), NULL_TREE);
+  for (bsi = bsi_start (loop->header); !bsi_end_p (bsi); bsi_next (&bsi))
+    FOR_EACH_SSA_TREE_OPERAND (def, bsi_stmt (bsi), iter, SSA_OP_ALL_DEFS)
+      set_current_def (def, NULL_TREE);
+
+  bb = split_edge (loop_preheader_edge (loop));
+  add_bb_to_loop (bb, loop->outer);
+
+  return copy;
+}
+
+/* Distributes the loop of G, LOOP, into the partitions of G.  */
+
+static void
+ldist_transform (struct loops *loops, struct loop *loop,
+		 struct ldist_graph *g)
+{
+  struct loop *copies[MAX_DISTRIBUTED_STMTS];
+  tree phi;
+  int p;
+
+  /* All the copies are made before any statement is removed, so that the
+     names released by the removal are not reused until the memory state
+     is rebuilt.  */
+  initialize_original_copy_tables ();
+  for (p = 0; p < g->n_parts - 1; p++)
+    copies[p] = ldist_copy_loop (loops, loop);
+  free_original_copy_tables ();
+
+  /* The loops now execute one after the other.  */
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    if (!is_gimple_reg (PHI_RESULT (phi)))
+      mark_sym_for_renaming (SSA_NAME_VAR (PHI_RESULT (phi)));
+
+  for (p = 0; p < g->n_parts - 1; p++)
+    ldist_prune_loop (g, copies[p], p);
+  ldist_prune_loop (g, loop, g->n_parts - 1);
+
+  update_ssa (TODO_update_ssa);
+  scev_reset ();
+}
+
+/* Distributes LOOP if this separates its recurrences from statements
+   that could be vectorized.  Returns true if LOOP was distributed.  */
+
+static bool
+distribute_loop (struct loops *loops, struct loop *loop)
+{
+  struct ldist_graph *g = XCNEW (struct ldist_graph);
+  bool rec = false, parallel = false;
+  int p;
+
+  if (!ldist_build_nodes (g, loop)
+      || !ldist_build_memory_edges (g, loop))
+    {
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "Loop %d: cannot analyze the statements.\n",
+		 loop->num);
+      free (g);
+      return false;
+    }
+
+  ldist_compute_sccs (g);
+  ldist_place_sccs (g);
+  while (!ldist_compute_members (g))
+    ;
+
+  for (p = 0; p < g->n_parts; p++)
+    if (ldist_part_rec_p (g, p))
+      rec = true;
+    else
+      parallel = true;
+
+  if (g->n_parts < 2 || !rec || !parallel)
+    {
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "Loop %d: no partition to separate.\n",
+		 loop->num);
+      free (g);
+      return false;
+    }
+
+  if (dump_file)
+    fprintf (dump_file, "Distributed loop %d into %d loops.\n",
+	     loop->num, g->n_parts);
+  ldist_transform (loops, loop, g);
+  free (g);
+  return true;
+}
+
+/* Distributes the innermost loops in LOOPS.  */
+
+unsigned int
+tree_loop_distribution (struct loops *loops)
+{
+  unsigned i, n = loops->num;
+
+  for (i = 1; i < n; i++)
+    {
+      struct loop *loop = loops->parray[i];
+
+      if (loop && simple_innermost_loop_p (loop))
+	distribute_loop (loops, loop);
+    }
+
+  return 0;
+}
+
+
+/* Unroll-and-jam.  */
+
+/* Returns true if the loop nest of LOOP accesses data that does not
+   change with the iterations of LOOP, listed in DATAREFS.  */
+
+static bool
+ujam_reuse_p (struct loop *loop, VEC (data_reference_p, heap) *datarefs)
+{
+  struct data_reference *dr;
+  unsigned i, j;
+
+  for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr); i++)
+    {
+      if (!flow_bb_inside_loop_p (loop->inner, bb_for_stmt (DR_STMT (dr))))
+	continue;
+
+      for (j = 0; j < DR_NUM_DIMENSIONS (dr); j++)
+	{
+	  tree fn = DR_ACCESS_FN (dr, j);
+
+	  if (chrec_contains_undetermined (fn)
+	      || evolution_part_in_loop_num (fn, loop->num))
+	    break;
+	}
+      if (j == DR_NUM_DIMENSIONS (dr))
+	return true;
+    }
+
+  return false;
+}
+
+/* Returns true if jamming FACTOR iterations of LOOP preserves the
+   dependences DDRS of its nest: no dependence may go from an iteration
+   of the inner loop to an earlier one, within FACTOR iterations of
+   LOOP.  */
+
+static bool
+ujam_dependences_ok_p (VEC (ddr_p, heap) *ddrs, unsigned factor)
+{
+  struct data_dependence_relation *ddr;
+  unsigned i, j;
+
+  for (i = 0; VEC_iterate (ddr_p, ddrs, i, ddr); i++)
+    {
+      if (DDR_ARE_DEPENDENT (ddr) == chrec_known)
+	continue;
+
+      if (!DDR_A (ddr) || !DDR_B (ddr))
+	return false;
+
+      if (DR_IS_READ (DDR_A (ddr)) && DR_IS_READ (DDR_B (ddr)))
+	continue;
+
+      if (DDR_ARE_DEPENDENT (ddr) == chrec_dont_know
+	  || DDR_NUM_DIST_VECTS (ddr) == 0)
+	return false;
+
+      for (j = 0; j < DDR_NUM_DIST_VECTS (ddr); j++)
+	{
+	  lambda_vector v = DDR_DIST_VECT (ddr, j);
+
+	  if (v[0] > 0 && v[0] < (int) factor && v[1] < 0)
+	    return false;
+	}
+    }
+
+  return true;
+}
+
+/* Returns true if the blocks of LOOP outside of its inner loop form a
+   straight path, apart from the exit test: the inner loop is then
+   executed in every iteration of LOOP.  */
+
+static bool
+ujam_straight_body_p (struct loop *loop)
+{
+  basic_block *body = get_loop_body (loop);
+  unsigned i;
+  bool ok = true;
+
+  for (i = 0; i < loop->num_nodes; i++)
+    if (body[i]->loop_father == loop
+	&& body[i] != loop->single_exit->src
+	&& !single_succ_p (body[i]))
+      ok = false;
+
+  free (body);
+  return ok;
+}
+
+/* Unrolls LOOP FACTOR times.  The number of iterations of LOOP is a
+   multiple of FACTOR, so only the last copy of the body keeps the exit
+   test.  */
+
+static void
+ujam_unroll_loop (struct loops *loops, struct loop *loop, unsigned factor)
+{
+  edge *to_remove = XNEWVEC (edge, factor);
+  unsigned n_to_remove = 0, i;
+  sbitmap wont_exit = sbitmap_alloc (factor);
+  bool ok;
+
+  sbitmap_ones (wont_exit);
+  RESET_BIT (wont_exit, factor - 1);
+
+  initialize_original_copy_tables ();
+  ok = tree_duplicate_loop_to_header_edge (loop, loop_latch_edge (loop),
+					   loops, factor - 1, wont_exit,
+					   loop->single_exit, to_remove,
+					   &n_to_remove,
+					   DLTHE_FLAG_UPDATE_FREQ);
+  free_original_copy_tables ();
+  gcc_assert (ok);
+
+  for (i = 0; i < n_to_remove; i++)
+    {
+      edge exit = to_remove[i];
+      tree cond = last_stmt (exit->src);
+
+      COND_EXPR_COND (cond) = ((exit->flags & EDGE_TRUE_VALUE)
+			       ? boolean_false_node : boolean_true_node);
+      update_stmt (cond);
+    }
+
+  free (to_remove);
+  sbitmap_free (wont_exit);
+
+  update_ssa (TODO_update_ssa);
+  cleanup_tree_cfg_loop ();
+}
+
+/* Unrolls LOOP and jams the copies of its inner loop, if this is legal
+   and the inner loop reuses data across the iterations of LOOP.
+   Returns true if LOOP was transformed.  */
+
+static bool
+unroll_and_jam_loop (struct loops *loops, struct loop *loop)
+{
+  struct loop *inner = loop->inner;
+  struct tree_niter_desc desc;
+  VEC (data_reference_p, heap) *datarefs = NULL;
+  VEC (ddr_p, heap) *ddrs = NULL;
+  unsigned HOST_WIDE_INT niter;
+  unsigned factor, ninsns;
+  bool ok;
+
+  /* The exit test must end the body of LOOP.  */
+  if (!inner || inner->next || !simple_innermost_loop_p (inner)
+      || !loop->single_exit
+      || !single_pred_p (loop->latch)
+      || single_pred (loop->latch) != loop->single_exit->src
+      || !can_duplicate_loop_p (loop)
+      || !ujam_straight_body_p (loop))
+    return false;
+
+  if (!number_of_iterations_exit (loop, loop->single_exit, &desc, false)
+      || !integer_nonzerop (desc.assumptions)
+      || !integer_zerop (desc.may_be_zero)
+      || !host_integerp (desc.niter, 1))
+    {
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "Loop %d: unknown number of iterations.\n",
+		 loop->num);
+      return false;
+    }
+  niter = tree_low_cst (desc.niter, 1) + 1;
+
+  /* The largest factor that divides the number of iterations and keeps
+     the jammed loop small enough.  */
+  ninsns = tree_num_loop_insns (loop);
+  for (factor = PARAM_VALUE (PARAM_UNROLL_JAM_MAX_UNROLL);
+       factor >= 2;
+       factor--)
+    if (niter % factor == 0
+	&& factor * ninsns <= (unsigned) PARAM_VALUE (PARAM_MAX_UNROLLED_INSNS))
+      break;
+  if (factor < 2)
+    return false;
+
+  compute_data_dependences_for_loop (loop, false, &datarefs, &ddrs);
+  ok = (ujam_dependences_ok_p (ddrs, factor)
+	&& ujam_reuse_p (loop, datarefs));
+  free_dependence_relations (ddrs);
+  free_data_refs (datarefs);
+  if (!ok)
+    {
+      if (dump_file && (dump_flags & TDF_DETAILS))
+	fprintf (dump_file, "Loop %d: no legal and profitable jam.\n",
+		 loop->num);
+      return false;
+    }
+
+  if (dump_file)
+    fprintf (dump_file, "Unrolled loop %d %u times for unroll-and-jam.\n",
+	     loop->num, factor);
+  ujam_unroll_loop (loops, loop, factor);
+  rewrite_into_loop_closed_ssa (NULL, TODO_update_ssa);
+  fuse_sibling_loops (loop, false);
+
+  return true;
+}
+
+/* Unrolls and jams the loop nests in LOOPS.  */
+
+unsigned int
+tree_unroll_and_jam (struct loops *loops)
+{
+  unsigned i, n = loops->num;
+
+  for (i = 1; i < n; i++)
+    {
+      struct loop *loop = loops->parray[i];
+
+      if (loop && loop->inner && !loop->inner->inner)
+	unroll_and_jam_loop (loops, loop);
+    }
+
+  return 0;
+}
@@ -42,6 +42,8 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 #include "tree-scalar-evolution.h"
 #include "tree-pass.h"
 #include "lambda.h"
+/* APPLE LOCAL loop tiling */
+#include "params.h"
 
 /* Linear loop transforms include any composition of interchange,
    scaling, skewing, and reversal.  They are used to change the
@@ -236,15 +238,189 @@ try_interchange_loops (lambda_trans_matrix trans,
   return trans;
 }
 
+/* APPLE LOCAL begin loop tiling */
+/* Return an estimate of the number of iterations of LOOP, or a large
+   default when it is not known at compile time.  */
+
+static unsigned HOST_WIDE_INT
+tile_loop_iterations (struct loop *loop)
+{
+  tree niter = number_of_iterations_in_loop (loop);
+
+  if (niter == NULL_TREE || TREE_CODE (niter) != INTEGER_CST)
+    niter = loop->estimated_nb_iterations;
+  if (niter != NULL_TREE
+      && TREE_CODE (niter) == INTEGER_CST
+      && host_integerp (niter, 1))
+    return tree_low_cst (niter, 1) + 1;
+  return 1000;
+}
+
+/* Return true if LOOP, a loop of the nest starting at FIRST_LOOP, carries
+   reuse of data: either a data reference in DATAREFS depends on a loop
+   nested in LOOP but does not depend on LOOP (temporal reuse) or only
+   walks its last dimension with unit stride in LOOP (spatial reuse), or
+   the first nonzero component of a distance vector in
+   DEPENDENCE_RELATIONS is the one of LOOP.  */
+
+static bool
+loop_carries_reuse_p (struct loop *loop, struct loop *first_loop,
+		      VEC (ddr_p, heap) *dependence_relations,
+		      VEC (data_reference_p, heap) *datarefs)
+{
+  unsigned int i, j, depth;
+  struct data_dependence_relation *ddr;
+  struct data_reference *dr;
+  struct loop *inner;
+
+  for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr); i++)
+    {
+      bool reuse = true, varies_inside = false;
+
+      for (j = 0; j < DR_NUM_DIMENSIONS (dr); j++)
+	{
+	  tree chrec = DR_ACCESS_FN (dr, j);
+	  tree step;
+
+	  if (chrec_contains_undetermined (chrec))
+	    {
+	      reuse = false;
+	      break;
+	    }
+
+	  /* The access function of the last dimension comes first.  */
+	  step = evolution_part_in_loop_num (chrec, loop->num);
+	  if (step != NULL_TREE
+	      && (j != 0
+		  || TREE_CODE (step) != INTEGER_CST
+		  || (!integer_onep (step) && !integer_all_onesp (step))))
+	    {
+	      reuse = false;
+	      break;
+	    }
+
+	  for (inner = loop->inner; inner; inner = inner->inner)
+	    if (evolution_part_in_loop_num (chrec, inner->num) != NULL_TREE)
+	      varies_inside = true;
+	}
+
+      if (reuse && varies_inside)
+	return true;
+    }
+
+  depth = loop->depth - first_loop->depth;
+  for (i = 0; VEC_iterate (ddr_p, dependence_relations, i, ddr); i++)
+    {
+      if (DDR_ARE_DEPENDENT (ddr) == chrec_dont_know
+	  || DDR_ARE_DEPENDENT (ddr) == chrec_known)
+	continue;
+
+      for (j = 0; j < DDR_NUM_DIST_VECTS (ddr); j++)
+	if (lambda_vector_first_nz (DDR_DIST_VECT (ddr, j),
+				    DDR_NB_LOOPS (ddr), 0) == (int) depth)
+	  return true;
+    }
+
+  return false;
+}
+
+/* Return the number of iterations of each loop in a tile when tiling the
+   perfect loop nest FIRST_LOOP of depth DEPTH, or 0 if tiling is not
+   profitable.  Tiling pays off when an outer loop carries reuse of data
+   but one of its iterations accesses more data than fits in the L1
+   cache, so that the data is evicted before it is reused.  The amount of
+   data accessed by the innermost loop is estimated with the reuse
+   analysis of the prefetcher.  The tiles are then made as large as
+   possible while the data accessed between two reuses fits in half of
+   the cache.  */
+
+static int
+determine_tile_size (struct loop *first_loop, unsigned int depth,
+		     VEC (ddr_p, heap) *dependence_relations,
+		     VEC (data_reference_p, heap) *datarefs)
+{
+  unsigned HOST_WIDE_INT cache = PARAM_VALUE (PARAM_L1_CACHE_SIZE) * 1024;
+  unsigned HOST_WIDE_INT footprint, working_set;
+  struct loop **nest, *innermost;
+  int i, reuse_level = -1;
+  unsigned int k;
+  int tile_size = 0, size;
+
+  if (depth < 2)
+    return 0;
+
+  nest = XNEWVEC (struct loop *, depth);
+  for (k = 0, innermost = first_loop; k < depth; k++)
+    {
+      nest[k] = innermost;
+      if (k + 1 < depth)
+	innermost = innermost->inner;
+    }
+
+  /* FOOTPRINT is the amount of data accessed by one iteration of the
+     loop at level I of the nest.  */
+  footprint = loop_memory_footprint (innermost,
+				     tile_loop_iterations (innermost));
+  for (i = depth - 2; i >= 0; i--)
+    {
+      if (footprint > cache
+	  && loop_carries_reuse_p (nest[i], first_loop,
+				   dependence_relations, datarefs))
+	{
+	  reuse_level = i;
+	  break;
+	}
+      if (footprint <= cache)
+	footprint *= MIN (tile_loop_iterations (nest[i]), cache);
+    }
+  free (nest);
+
+  if (reuse_level < 0)
+    {
+      if (dump_file)
+	fprintf (dump_file, "Won't tile loop nest: reuse fits in the cache.\n");
+      return 0;
+    }
+
+  if (PARAM_VALUE (PARAM_LOOP_TILE_SIZE))
+    return PARAM_VALUE (PARAM_LOOP_TILE_SIZE);
+
+  /* The data accessed between two reuses by the loop at REUSE_LEVEL is
+     the data accessed by a tile of the loops nested in it.  */
+  for (size = 8; size <= 1024; size *= 2)
+    {
+      working_set = loop_memory_footprint (innermost, size);
+      for (i = reuse_level + 1; i < (int) depth - 1; i++)
+	working_set *= size;
+      if (working_set > cache / 2)
+	break;
+      tile_size = size;
+    }
+
+  if (dump_file)
+    {
+      if (tile_size)
+	fprintf (dump_file, "Tiling loop nest with tile size %d.\n",
+		 tile_size);
+      else
+	fprintf (dump_file, "Won't tile loop nest: tiles do not fit in the cache.\n");
+    }
+  return tile_size;
+}
+/* APPLE LOCAL end loop tiling */
+
 /* Perform a set of linear transforms on LOOPS.  */
 
 void
 linear_transform_loops (struct loops *loops)
 {
   bool modified = false;
-  unsigned int i;
+  /* APPLE LOCAL loop tiling */
+  unsigned int i, j;
   VEC(tree,heap) *oldivs = NULL;
   VEC(tree,heap) *invariants = NULL;
+  /* APPLE LOCAL loop tiling */
+  bitmap tiled_loops = BITMAP_ALLOC (NULL);
   
   for (i = 1; i < loops->num; i++)
     {
@@ -256,6 +432,8 @@ linear_transform_loops (struct loops *loops)
       lambda_loopnest before, after;
       lambda_trans_matrix trans;
       bool problem = false;
+      /* APPLE LOCAL loop tiling */
+      int tile_size = 0;
       /* If it's not a loop nest, we don't want it.
          We also don't handle sibling loops properly, 
          which are loops of the following form:
@@ -272,6 +450,11 @@ linear_transform_loops (struct loops *loops)
            } */
       if (!loop_nest || !loop_nest->inner || !loop_nest->single_exit)
 	continue;
+      /* APPLE LOCAL begin loop tiling */
+      /* Loops of a tiled nest have bounds that are no longer linear.  */
+      if (bitmap_bit_p (tiled_loops, i))
+	continue;
+      /* APPLE LOCAL end loop tiling */
       VEC_truncate (tree, oldivs, 0);
       VEC_truncate (tree, invariants, 0);
       depth = 1;
@@ -304,7 +487,22 @@ linear_transform_loops (struct loops *loops)
       trans = try_interchange_loops (trans, depth, dependence_relations,
 				     datarefs, loop_nest);
 
-      if (lambda_trans_matrix_id_p (trans))
+      /* APPLE LOCAL begin loop tiling */
+      if (flag_tree_loop_tile && lambda_trans_matrix_id_p (trans))
+	{
+	  tile_size = determine_tile_size (loop_nest, depth,
+					   dependence_relations, datarefs);
+	  if (tile_size
+	      && !lambda_tiling_legal_p (trans, depth, dependence_relations))
+	    {
+	      if (dump_file)
+		fprintf (dump_file, "Won't tile loop nest, tiling is illegal.\n");
+	      tile_size = 0;
+	    }
+	}
+
+      if (lambda_trans_matrix_id_p (trans) && !tile_size)
+      /* APPLE LOCAL end loop tiling */
 	{
 	  if (dump_file)
 	   fprintf (dump_file, "Won't transform loop. Optimal transform is the identity transform\n");
@@ -339,6 +537,20 @@ linear_transform_loops (struct loops *loops)
 	  print_lambda_loopnest (dump_file, after, 'u');
 	}
 
+      /* APPLE LOCAL begin loop tiling */
+      if (tile_size
+	  && lambda_loopnest_tile (loops, loop_nest, oldivs, invariants,
+				   after, trans, tile_size))
+	{
+	  for (temp = loop_nest; temp; temp = temp->inner)
+	    bitmap_set_bit (tiled_loops, temp->num);
+	  for (temp = loop_nest->outer, j = 0;
+	       j < VEC_length (tree, oldivs);
+	       temp = temp->outer, j++)
+	    bitmap_set_bit (tiled_loops, temp->num);
+	}
+      else
+      /* APPLE LOCAL end loop tiling */
       lambda_loopnest_to_gcc_loopnest (loop_nest, oldivs, invariants,
 				       after, trans);
       modified = true;
@@ -353,6 +565,8 @@ linear_transform_loops (struct loops *loops)
 
   VEC_free (tree, heap, oldivs);
   VEC_free (tree, heap, invariants);
+  /* APPLE LOCAL loop tiling */
+  BITMAP_FREE (tiled_loops);
   scev_reset ();
 
   if (modified)
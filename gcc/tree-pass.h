@@ -251,6 +251,8 @@ extern struct tree_opt_pass pass_empty_loop;
 extern struct tree_opt_pass pass_record_bounds;
 extern struct tree_opt_pass pass_if_conversion;
 extern struct tree_opt_pass pass_vectorize;
+/* APPLE LOCAL vect slp */
+extern struct tree_opt_pass pass_slp_vectorize;
 extern struct tree_opt_pass pass_complete_unroll;
 extern struct tree_opt_pass pass_loop_prefetch;
 extern struct tree_opt_pass pass_iv_optimize;
@@ -295,6 +297,11 @@ extern struct tree_opt_pass pass_rest_of_compilation;
 extern struct tree_opt_pass pass_sink_code;
 extern struct tree_opt_pass pass_fre;
 extern struct tree_opt_pass pass_linear_transform;
+/* APPLE LOCAL begin loop distribution */
+extern struct tree_opt_pass pass_unroll_and_jam;
+extern struct tree_opt_pass pass_loop_fusion;
+extern struct tree_opt_pass pass_loop_distribution;
+/* APPLE LOCAL end loop distribution */
 extern struct tree_opt_pass pass_copy_prop;
 extern struct tree_opt_pass pass_store_ccp;
 extern struct tree_opt_pass pass_store_copy_prop;
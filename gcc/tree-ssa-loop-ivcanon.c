@@ -356,6 +356,20 @@ canonicalize_induction_variables (struct loops *loops)
   return 0;
 }
 
+/* APPLE LOCAL begin vect outer loop */
+/* Unroll LOOP completely if its number of iterations is a known constant
+   and the result stays within the complete peeling limits.  The caller
+   is responsible for cleaning up the cfg afterwards.  Returns true if
+   LOOP was unrolled.  */
+
+bool
+tree_unroll_loop_completely (struct loops *loops, struct loop *loop)
+{
+  return canonicalize_loop_induction_variables (loops, loop, false, UL_ALL,
+						false);
+}
+/* APPLE LOCAL end vect outer loop */
+
 /* Unroll LOOPS completely if they iterate just few times.  Unless
    MAY_INCREASE_SIZE is true, perform the unrolling only if the
    size of the code does not increase.  */
@@ -45,6 +45,8 @@ Software Foundation, 59 Temple Place - Suite 330, Boston, MA
 #include "toplev.h"
 #include "params.h"
 #include "langhooks.h"
+/* APPLE LOCAL indirect prefetch */
+#include "tree-inline.h"
 
 /* This pass inserts prefetch instructions to optimize cache usage during
    accesses to arrays in loops.  It processes loops sequentially and:
@@ -201,9 +203,66 @@ struct mem_ref
 				/* Prefetch only first PREFETCH_BEFORE
 				   iterations.  */
   bool issue_prefetch_p;	/* Should we really issue the prefetch?  */
+  /* APPLE LOCAL begin indirect prefetch */
+  bool index_p;			/* Does it load indices of an indirect
+				   reference?  */
+  /* APPLE LOCAL end indirect prefetch */
   struct mem_ref *next;		/* The next reference in the group.  */
 };
 
+/* APPLE LOCAL begin indirect prefetch */
+/* A reference whose address is computed from the value loaded by an affine
+   reference of the loop, like a[b[i]], or a hash table bucket selected
+   by a hash of key[i].  */
+
+struct indirect_ref
+{
+  tree stmt;			/* Statement in that the reference appears.  */
+  tree mem;			/* The reference.  */
+  tree index;			/* SSA name the address of MEM depends on.  */
+  tree load;			/* The affine load INDEX is computed from.  */
+  tree iv;			/* Induction variable in the address of
+				   LOAD.  */
+  HOST_WIDE_INT step;		/* Step of IV.  */
+  tree last;			/* Value of IV in the last iteration.  */
+  bool write_p;			/* Is it a write?  */
+  bool issue_prefetch_p;	/* Should we really issue the prefetch?  */
+  struct indirect_ref *next;	/* The next indirect reference.  */
+};
+
+/* Maximal number of operations between the affine load and the address
+   of an indirect reference.  */
+
+#define MAX_INDEX_CHAIN 8
+
+/* Maximal number of distinct fields of a node of a linked structure we
+   record.  */
+
+#define MAX_LINKED_OFFSETS 8
+
+/* A linked structure traversed by the loop, like in
+
+   for (p = list; p; p = p->next)
+     ...
+
+   The address of the next node is known as soon as the current one is
+   reached, so that we may start fetching it while the loop body works on
+   the current node.  */
+
+struct linked_ref
+{
+  tree stmt;			/* Statement before that the prefetches are
+				   issued.  */
+  tree link;			/* The load of the pointer to the next
+				   node.  */
+  unsigned n_offsets;		/* Number of OFFSETS.  */
+  HOST_WIDE_INT offsets[MAX_LINKED_OFFSETS];
+				/* Sorted offsets of the fields of the node
+				   accessed in the loop.  */
+  struct linked_ref *next;	/* The next linked structure.  */
+};
+/* APPLE LOCAL end indirect prefetch */
+
 /* Dumps information about reference REF to FILE.  */
 
 static void
@@ -489,6 +548,462 @@ gather_memory_references (struct loop *loop)
   return refs;
 }
 
+/* APPLE LOCAL begin indirect prefetch */
+/* A structure used to pass arguments to idx_find_varying and
+   idx_find_iv.  */
+
+struct ind_data
+{
+  struct loop *loop;			/* Loop of the reference.  */
+  tree stmt;				/* Statement of the reference.  */
+  tree name;				/* The varying index.  */
+  affine_iv iv;				/* Its evolution.  */
+};
+
+/* Records in DATA the SSA name among the indices of a reference that is
+   not invariant in the loop.  Fails if there are several such indices, or
+   if the index is not an SSA name.  Callback for for_each_index.  */
+
+static bool
+idx_find_varying (tree base, tree *index, void *data)
+{
+  struct ind_data *ind_data = data;
+
+  if (TREE_CODE (base) == MISALIGNED_INDIRECT_REF
+      || TREE_CODE (base) == ALIGN_INDIRECT_REF)
+    return false;
+
+  if (expr_invariant_in_loop_p (ind_data->loop, *index))
+    return true;
+
+  if (TREE_CODE (*index) != SSA_NAME
+      || (ind_data->name && ind_data->name != *index))
+    return false;
+
+  ind_data->name = *index;
+  return true;
+}
+
+/* Like idx_find_varying, but also requires the varying index to be an
+   induction variable with a nonzero constant step.  */
+
+static bool
+idx_find_iv (tree base, tree *index, void *data)
+{
+  struct ind_data *ind_data = data;
+
+  if (!idx_find_varying (base, index, data))
+    return false;
+
+  if (ind_data->name != *index)
+    return true;
+
+  return (simple_iv (ind_data->loop, ind_data->stmt, *index,
+		     &ind_data->iv, false)
+	  && cst_and_fits_in_hwi (ind_data->iv.step)
+	  && !zero_p (ind_data->iv.step));
+}
+
+/* Returns true if the value of NAME is computed in LOOP from the value read
+   by a single load, using at most *BUDGET cheap operations whose other
+   operands are invariant in LOOP.  The statement of the load is stored
+   to *LOAD.  */
+
+static bool
+computed_from_load_p (struct loop *loop, tree name, tree *load,
+		      unsigned *budget)
+{
+  tree stmt, rhs;
+  int i;
+
+  if (expr_invariant_in_loop_p (loop, name))
+    return true;
+
+  if (TREE_CODE (name) != SSA_NAME
+      || *budget == 0)
+    return false;
+  (*budget)--;
+
+  stmt = SSA_NAME_DEF_STMT (name);
+  if (TREE_CODE (stmt) != MODIFY_EXPR
+      || !flow_bb_inside_loop_p (loop, bb_for_stmt (stmt)))
+    return false;
+
+  rhs = TREE_OPERAND (stmt, 1);
+  if (REFERENCE_CLASS_P (rhs))
+    {
+      if (*load && *load != stmt)
+	return false;
+
+      *load = stmt;
+      return true;
+    }
+
+  if (!INTEGRAL_TYPE_P (TREE_TYPE (rhs))
+      && !POINTER_TYPE_P (TREE_TYPE (rhs)))
+    return false;
+
+  /* Only allow the operations that cannot trap, since we are going to
+     evaluate them for a value the loop did not read yet.  */
+  switch (TREE_CODE (rhs))
+    {
+    case NOP_EXPR:
+    case CONVERT_EXPR:
+    case NEGATE_EXPR:
+    case BIT_NOT_EXPR:
+    case PLUS_EXPR:
+    case MINUS_EXPR:
+    case MULT_EXPR:
+    case BIT_AND_EXPR:
+    case BIT_IOR_EXPR:
+    case BIT_XOR_EXPR:
+    case LSHIFT_EXPR:
+    case RSHIFT_EXPR:
+      break;
+
+    default:
+      return false;
+    }
+
+  for (i = 0; i < TREE_CODE_LENGTH (TREE_CODE (rhs)); i++)
+    if (!computed_from_load_p (loop, TREE_OPERAND (rhs, i), load, budget))
+      return false;
+
+  return true;
+}
+
+/* Record the reference REF to the list IREFS if its address in LOOP is
+   computed from the value read by an affine load.  The reference occurs
+   in statement STMT and it is write if WRITE_P.  The loop exits only
+   through EXIT, after NITER iterations.  */
+
+static void
+gather_indirect_reference (struct loop *loop, edge exit, tree niter,
+			   struct indirect_ref **irefs, tree ref,
+			   bool write_p, tree stmt)
+{
+  tree base, load = NULL_TREE, lref, type, off;
+  HOST_WIDE_INT step, delta;
+  unsigned budget = MAX_INDEX_CHAIN;
+  struct ind_data ind_data;
+  struct indirect_ref *iref;
+
+  /* The affine references are handled by the reuse analysis.  */
+  if (analyze_ref (loop, &ref, &base, &step, &delta, stmt)
+      || TREE_THIS_VOLATILE (ref))
+    return;
+
+  ind_data.loop = loop;
+  ind_data.stmt = stmt;
+  ind_data.name = NULL_TREE;
+  if (!for_each_index (&ref, idx_find_varying, &ind_data)
+      || !ind_data.name
+      || !computed_from_load_p (loop, ind_data.name, &load, &budget)
+      || !load)
+    return;
+
+  /* We are going to read the value the load reads in a later iteration.
+     This is only safe if the load is executed in all the iterations up to
+     the last one, so that we do not access the memory the loop never
+     touches.  */
+  lref = TREE_OPERAND (load, 1);
+  if (TREE_THIS_VOLATILE (lref)
+      || stmt_ann (load)->has_volatile_ops
+      || TREE_CODE (TREE_OPERAND (load, 0)) != SSA_NAME
+      || !dominated_by_p (CDI_DOMINATORS, exit->src, bb_for_stmt (load)))
+    return;
+
+  iref = xcalloc (1, sizeof (struct indirect_ref));
+  iref->index = ind_data.name;
+
+  ind_data.stmt = load;
+  ind_data.name = NULL_TREE;
+  if (!for_each_index (&lref, idx_find_iv, &ind_data)
+      || !ind_data.name)
+    {
+      free (iref);
+      return;
+    }
+
+  type = TREE_TYPE (ind_data.name);
+  off = fold_build2 (MULT_EXPR, sizetype, fold_convert (sizetype, niter),
+		     fold_convert (sizetype, ind_data.iv.step));
+
+  iref->stmt = stmt;
+  iref->mem = ref;
+  iref->load = load;
+  iref->iv = ind_data.name;
+  iref->step = int_cst_value (ind_data.iv.step);
+  iref->last = fold_build2 (PLUS_EXPR, type, ind_data.iv.base,
+			    fold_convert (type, off));
+  iref->write_p = write_p;
+  iref->next = *irefs;
+  *irefs = iref;
+
+  if (dump_file && (dump_flags & TDF_DETAILS))
+    {
+      fprintf (dump_file, "Indirect reference %p: ", (void *) iref);
+      print_generic_expr (dump_file, ref, TDF_SLIM);
+      fprintf (dump_file, "\n  index ");
+      print_generic_expr (dump_file, iref->index, TDF_SLIM);
+      fprintf (dump_file, " computed from ");
+      print_generic_expr (dump_file, TREE_OPERAND (load, 1), TDF_SLIM);
+      fprintf (dump_file, "\n\n");
+    }
+}
+
+/* Record the references in LOOP whose address is computed from the value
+   read by an affine load of LOOP.  */
+
+static struct indirect_ref *
+gather_indirect_references (struct loop *loop)
+{
+  edge exit = single_dom_exit (loop);
+  struct tree_niter_desc desc;
+  basic_block *body, bb;
+  unsigned i;
+  block_stmt_iterator bsi;
+  tree stmt, lhs, rhs;
+  struct indirect_ref *irefs = NULL;
+
+  /* We need to know the last iteration, so that we do not read past the
+     end of the array the indices are loaded from.  */
+  if (!exit
+      || !number_of_iterations_exit (loop, exit, &desc, false)
+      || !integer_nonzerop (desc.assumptions)
+      || !zero_p (desc.may_be_zero))
+    return NULL;
+
+  body = get_loop_body_in_dom_order (loop);
+  for (i = 0; i < loop->num_nodes; i++)
+    {
+      bb = body[i];
+      if (bb->loop_father != loop)
+	continue;
+
+      for (bsi = bsi_start (bb); !bsi_end_p (bsi); bsi_next (&bsi))
+	{
+	  stmt = bsi_stmt (bsi);
+	  if (TREE_CODE (stmt) != MODIFY_EXPR)
+	    continue;
+
+	  lhs = TREE_OPERAND (stmt, 0);
+	  rhs = TREE_OPERAND (stmt, 1);
+
+	  if (REFERENCE_CLASS_P (rhs))
+	    gather_indirect_reference (loop, exit, desc.niter, &irefs,
+				       rhs, false, stmt);
+	  if (REFERENCE_CLASS_P (lhs))
+	    gather_indirect_reference (loop, exit, desc.niter, &irefs,
+				       lhs, true, stmt);
+	}
+    }
+  free (body);
+
+  return irefs;
+}
+
+/* Marks the references in GROUPS that load the indices of IREFS.  */
+
+static void
+mark_index_references (struct mem_ref_group *groups,
+		       struct indirect_ref *irefs)
+{
+  struct mem_ref_group *group;
+  struct mem_ref *ref;
+
+  for (; irefs; irefs = irefs->next)
+    for (group = groups; group; group = group->next)
+      for (ref = group->refs; ref; ref = ref->next)
+	if (ref->stmt == irefs->load)
+	  ref->index_p = true;
+}
+
+/* Returns the offset of REF from the address in the pointer it dereferences,
+   and stores the pointer to PTR.  Returns -1 if REF is not at a constant
+   offset from a pointer.  */
+
+static HOST_WIDE_INT
+pointer_ref_offset (tree ref, tree *ptr)
+{
+  HOST_WIDE_INT bitsize, bitpos;
+  tree base, offset;
+  enum machine_mode mode;
+  int unsignedp, volatilep = 0;
+
+  base = get_inner_reference (ref, &bitsize, &bitpos, &offset, &mode,
+			      &unsignedp, &volatilep, false);
+  if (offset
+      || volatilep
+      || bitpos < 0
+      || TREE_CODE (base) != INDIRECT_REF
+      || TREE_CODE (TREE_OPERAND (base, 0)) != SSA_NAME)
+    return -1;
+
+  *ptr = TREE_OPERAND (base, 0);
+  return bitpos / BITS_PER_UNIT;
+}
+
+/* Records OFFSET to the sorted offsets of LREF.  */
+
+static void
+record_linked_offset (struct linked_ref *lref, HOST_WIDE_INT offset)
+{
+  unsigned i, j;
+
+  for (i = 0; i < lref->n_offsets; i++)
+    {
+      if (lref->offsets[i] == offset)
+	return;
+      if (lref->offsets[i] > offset)
+	break;
+    }
+
+  if (lref->n_offsets == MAX_LINKED_OFFSETS)
+    return;
+
+  for (j = lref->n_offsets; j > i; j--)
+    lref->offsets[j] = lref->offsets[j - 1];
+  lref->offsets[i] = offset;
+  lref->n_offsets++;
+}
+
+/* Checks whether the loop traverses a linked structure through pointer
+   PTR, and if so, records it to the list LREFS.  BODY are the blocks of
+   LOOP in dominance order.  */
+
+static void
+gather_linked_reference (struct loop *loop, basic_block *body, tree ptr,
+			 struct linked_ref **lrefs)
+{
+  tree link, load, rhs, stmt, ref, aptr;
+  basic_block load_bb, bb;
+  edge *exits;
+  unsigned n_exits, i, j;
+  block_stmt_iterator bsi;
+  HOST_WIDE_INT offset;
+  struct linked_ref *lref;
+
+  /* The pointer to the next node must be loaded from the current one.  */
+  link = PHI_ARG_DEF_FROM_EDGE (SSA_NAME_DEF_STMT (ptr),
+				loop_latch_edge (loop));
+  if (TREE_CODE (link) != SSA_NAME)
+    return;
+  load = SSA_NAME_DEF_STMT (link);
+  if (TREE_CODE (load) != MODIFY_EXPR
+      || !flow_bb_inside_loop_p (loop, bb_for_stmt (load)))
+    return;
+  rhs = TREE_OPERAND (load, 1);
+  if (!REFERENCE_CLASS_P (rhs)
+      || stmt_ann (load)->has_volatile_ops
+      || pointer_ref_offset (rhs, &aptr) < 0
+      || aptr != ptr)
+    return;
+
+  /* We load the pointer to the next node earlier than the loop does.
+     To be sure the load does not trap, require that the loop cannot exit
+     without executing it once the current node is accessed.  */
+  load_bb = bb_for_stmt (load);
+  exits = get_loop_exit_edges (loop, &n_exits);
+  for (i = 0; i < n_exits; i++)
+    if (!dominated_by_p (CDI_DOMINATORS, exits[i]->src, load_bb))
+      break;
+  free (exits);
+  if (i != n_exits)
+    return;
+
+  lref = xcalloc (1, sizeof (struct linked_ref));
+  lref->link = rhs;
+
+  for (i = 0; i < loop->num_nodes; i++)
+    {
+      bb = body[i];
+      if (bb->loop_father != loop)
+	continue;
+
+      for (bsi = bsi_start (bb); !bsi_end_p (bsi); bsi_next (&bsi))
+	{
+	  stmt = bsi_stmt (bsi);
+	  if (TREE_CODE (stmt) != MODIFY_EXPR)
+	    continue;
+
+	  for (j = 0; j < 2; j++)
+	    {
+	      ref = TREE_OPERAND (stmt, j);
+	      if (!REFERENCE_CLASS_P (ref))
+		continue;
+
+	      offset = pointer_ref_offset (ref, &aptr);
+	      if (offset < 0 || aptr != ptr)
+		continue;
+
+	      record_linked_offset (lref, offset);
+
+	      /* Issue the prefetches before the first access to the current
+		 node that is always followed by the load.  */
+	      if (!lref->stmt
+		  && dominated_by_p (CDI_DOMINATORS, load_bb, bb))
+		lref->stmt = stmt;
+	    }
+	}
+    }
+
+  lref->next = *lrefs;
+  *lrefs = lref;
+
+  if (dump_file && (dump_flags & TDF_DETAILS))
+    {
+      fprintf (dump_file, "Linked structure %p: next node ",
+	       (void *) lref);
+      print_generic_expr (dump_file, rhs, TDF_SLIM);
+      fprintf (dump_file, ", %u fields accessed\n\n", lref->n_offsets);
+    }
+}
+
+/* Record the linked structures traversed by LOOP.  */
+
+static struct linked_ref *
+gather_linked_references (struct loop *loop)
+{
+  basic_block *body;
+  tree phi, ptr;
+  struct linked_ref *lrefs = NULL;
+
+  body = get_loop_body_in_dom_order (loop);
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    {
+      ptr = PHI_RESULT (phi);
+      if (is_gimple_reg (ptr)
+	  && POINTER_TYPE_P (TREE_TYPE (ptr)))
+	gather_linked_reference (loop, body, ptr, &lrefs);
+    }
+  free (body);
+
+  return lrefs;
+}
+
+/* Release the indirect references IREFS and linked structures LREFS.  */
+
+static void
+release_indirect_refs (struct indirect_ref *irefs, struct linked_ref *lrefs)
+{
+  struct indirect_ref *next_i;
+  struct linked_ref *next_l;
+
+  for (; irefs; irefs = next_i)
+    {
+      next_i = irefs->next;
+      free (irefs);
+    }
+
+  for (; lrefs; lrefs = next_l)
+    {
+      next_l = lrefs->next;
+      free (lrefs);
+    }
+}
+/* APPLE LOCAL end indirect prefetch */
+
 /* Prune the prefetch candidate REF using the self-reuse.  */
 
 static void
@@ -732,6 +1247,47 @@ prune_by_reuse (struct mem_ref_group *groups)
     prune_group_by_reuse (groups);
 }
 
+/* APPLE LOCAL begin loop tiling */
+/* Returns an estimate of the number of bytes that NITER iterations of the
+   innermost LOOP bring into the cache, computed from the reuse analysis
+   used for prefetching: a reference touches a new cache line every
+   PREFETCH_BLOCK / STEP iterations, and none at all once it reuses the
+   lines of another reference of its group.  Used by the loop tiling in
+   tree-loop-linear.c.  */
+
+unsigned HOST_WIDE_INT
+loop_memory_footprint (struct loop *loop, unsigned HOST_WIDE_INT niter)
+{
+  struct mem_ref_group *refs, *group;
+  struct mem_ref *ref;
+  unsigned HOST_WIDE_INT lines = 0, n, step;
+
+  refs = gather_memory_references (loop);
+  prune_by_reuse (refs);
+
+  for (group = refs; group; group = group->next)
+    {
+      step = group->step < 0 ? -group->step : group->step;
+      for (ref = group->refs; ref; ref = ref->next)
+	{
+	  if (step == 0)
+	    {
+	      lines++;
+	      continue;
+	    }
+
+	  n = MIN (niter, ref->prefetch_before);
+	  lines += ((n * MIN (step, (unsigned HOST_WIDE_INT) PREFETCH_BLOCK)
+		    + PREFETCH_BLOCK - 1)
+		   / PREFETCH_BLOCK);
+	}
+    }
+
+  release_mem_refs (refs);
+  return lines * PREFETCH_BLOCK;
+}
+/* APPLE LOCAL end loop tiling */
+
 /* Returns true if we should issue prefetch for REF.  */
 
 static bool
@@ -750,14 +1306,19 @@ should_issue_prefetch_p (struct mem_ref *ref)
    to the number of simultaneous instances of one prefetch running at a
    time).  UNROLL_FACTOR is the factor by that the loop is going to be
    unrolled.  Returns true if there is anything to prefetch.  */
+/* APPLE LOCAL begin indirect prefetch */
+/* The indirect references IREFS are considered as well.  */
 
 static bool
-schedule_prefetches (struct mem_ref_group *groups, unsigned unroll_factor,
+schedule_prefetches (struct mem_ref_group *groups,
+		     struct indirect_ref *irefs, unsigned unroll_factor,
 		     unsigned ahead)
 {
   unsigned max_prefetches, n_prefetches;
+  struct mem_ref_group *group;
   struct mem_ref *ref;
   bool any = false;
+/* APPLE LOCAL end indirect prefetch */
 
   max_prefetches = (SIMULTANEOUS_PREFETCHES * unroll_factor) / ahead;
   if (max_prefetches > (unsigned) SIMULTANEOUS_PREFETCHES)
@@ -769,6 +1330,40 @@ schedule_prefetches (struct mem_ref_group *groups, unsigned unroll_factor,
   if (!max_prefetches)
     return false;
 
+  /* APPLE LOCAL begin indirect prefetch */
+  /* The indirect references are likely to miss on each access, so they
+     get the prefetches first, together with the loads of their indices
+     that the prefetches depend on.  */
+  for (group = groups; group; group = group->next)
+    for (ref = group->refs; ref; ref = ref->next)
+      {
+	if (!ref->index_p || !should_issue_prefetch_p (ref))
+	  continue;
+
+	ref->issue_prefetch_p = true;
+
+	n_prefetches = ((unroll_factor + ref->prefetch_mod - 1)
+			/ ref->prefetch_mod);
+	if (max_prefetches <= n_prefetches)
+	  return true;
+
+	max_prefetches -= n_prefetches;
+	any = true;
+      }
+
+  for (; irefs; irefs = irefs->next)
+    {
+      irefs->issue_prefetch_p = true;
+
+      n_prefetches = unroll_factor;
+      if (max_prefetches <= n_prefetches)
+	return true;
+
+      max_prefetches -= n_prefetches;
+      any = true;
+    }
+  /* APPLE LOCAL end indirect prefetch */
+
   /* For now we just take memory references one by one and issue
      prefetches for as many as possible.  The groups are sorted
      starting with the largest step, since the references with
@@ -777,7 +1372,8 @@ schedule_prefetches (struct mem_ref_group *groups, unsigned unroll_factor,
   for (; groups; groups = groups->next)
     for (ref = groups->refs; ref; ref = ref->next)
       {
-	if (!should_issue_prefetch_p (ref))
+	/* APPLE LOCAL indirect prefetch */
+	if (!should_issue_prefetch_p (ref) || ref->issue_prefetch_p)
 	  continue;
 
 	ref->issue_prefetch_p = true;
@@ -824,6 +1420,14 @@ issue_prefetch_ref (struct mem_ref *ref, unsigned unroll_factor, unsigned ahead)
   block_stmt_iterator bsi;
   unsigned n_prefetches, ap;
 
+  /* APPLE LOCAL begin indirect prefetch */
+  /* The indices of the indirect references must be in the cache by the
+     time they are loaded to prefetch the indirect references, that is
+     AHEAD iterations before the loop reads them.  */
+  if (ref->index_p)
+    ahead *= 2;
+  /* APPLE LOCAL end indirect prefetch */
+
   if (dump_file && (dump_flags & TDF_DETAILS))
     fprintf (dump_file, "Issued prefetch for %p.\n", (void *) ref);
 
@@ -869,6 +1473,232 @@ issue_prefetches (struct mem_ref_group *groups,
 	issue_prefetch_ref (ref, unroll_factor, ahead);
 }
 
+/* APPLE LOCAL begin indirect prefetch */
+/* Forces a copy of EXPR into a gimple operand, emitting the statements
+   before BSI.  The statements may load from memory, so their virtual
+   operands are marked for renaming.  */
+
+static tree
+force_prefetch_operand (block_stmt_iterator *bsi, tree expr)
+{
+  tree stmts, stmt;
+  tree_stmt_iterator tsi;
+
+  expr = force_gimple_operand (unshare_expr (expr), &stmts, true, NULL_TREE);
+  if (!stmts)
+    return expr;
+
+  if (TREE_CODE (stmts) != STATEMENT_LIST)
+    {
+      bsi_insert_before (bsi, stmts, BSI_SAME_STMT);
+      mark_new_vars_to_rename (stmts);
+      return expr;
+    }
+
+  for (tsi = tsi_start (stmts); !tsi_end_p (tsi); tsi_next (&tsi))
+    {
+      stmt = tsi_stmt (tsi);
+      bsi_insert_before (bsi, stmt, BSI_SAME_STMT);
+      mark_new_vars_to_rename (stmt);
+    }
+
+  return expr;
+}
+
+/* Emits a prefetch of ADDR before BSI.  The prefetch is for write if
+   WRITE_P.  */
+
+static void
+emit_prefetch (block_stmt_iterator *bsi, tree addr, bool write_p)
+{
+  tree params, prefetch;
+
+  params = tree_cons (NULL_TREE, addr,
+		      tree_cons (NULL_TREE,
+				 write_p ? integer_one_node : integer_zero_node,
+				 NULL_TREE));
+  prefetch = build_function_call_expr (built_in_decls[BUILT_IN_PREFETCH],
+				       params);
+  bsi_insert_before (bsi, prefetch, BSI_SAME_STMT);
+}
+
+/* Replaces the occurrences of the SSA name DATA in *TP by the expression
+   stored after it.  Callback for walk_tree.  */
+
+static tree
+replace_name_1 (tree *tp, int *walk_subtrees, void *data)
+{
+  tree *names = data;
+
+  if (*tp == names[0])
+    {
+      *tp = names[1];
+      *walk_subtrees = 0;
+    }
+  else if (TYPE_P (*tp))
+    *walk_subtrees = 0;
+
+  return NULL_TREE;
+}
+
+/* Returns a copy of EXPR with NAME replaced by VAL.  */
+
+static tree
+replace_name (tree expr, tree name, tree val)
+{
+  tree names[2];
+
+  names[0] = name;
+  names[1] = val;
+  expr = unshare_expr (expr);
+  walk_tree (&expr, replace_name_1, names, NULL);
+
+  return expr;
+}
+
+/* Returns the expression for the value of NAME in LOOP when VAL is
+   stored to VAR instead of what the loop stores there.  NAME is computed
+   from VAR as verified by computed_from_load_p.  */
+
+static tree
+recompute_from (struct loop *loop, tree name, tree var, tree val)
+{
+  tree rhs, type;
+
+  if (name == var)
+    return val;
+  if (expr_invariant_in_loop_p (loop, name))
+    return name;
+
+  rhs = TREE_OPERAND (SSA_NAME_DEF_STMT (name), 1);
+  type = TREE_TYPE (rhs);
+  if (TREE_CODE_LENGTH (TREE_CODE (rhs)) == 1)
+    return fold_build1 (TREE_CODE (rhs), type,
+			recompute_from (loop, TREE_OPERAND (rhs, 0),
+					var, val));
+
+  return fold_build2 (TREE_CODE (rhs), type,
+		      recompute_from (loop, TREE_OPERAND (rhs, 0), var, val),
+		      recompute_from (loop, TREE_OPERAND (rhs, 1), var, val));
+}
+
+/* Issue prefetches for the indirect reference IREF in LOOP.  The value its
+   address is computed from is loaded AHEAD iterations ahead, but not past
+   the last iteration of the loop.  UNROLL_FACTOR is the factor by which
+   LOOP was unrolled.  */
+
+static void
+issue_indirect_prefetch (struct loop *loop, struct indirect_ref *iref,
+			 unsigned unroll_factor, unsigned ahead)
+{
+  tree type = TREE_TYPE (iref->iv), stype, rest, off, iv, val, index, addr;
+  block_stmt_iterator bsi;
+  unsigned ap;
+
+  if (dump_file && (dump_flags & TDF_DETAILS))
+    fprintf (dump_file, "Issued prefetch for indirect reference %p.\n",
+	     (void *) iref);
+
+  bsi = bsi_for_stmt (iref->stmt);
+  stype = signed_type_for (type);
+  rest = fold_build2 (MINUS_EXPR, stype,
+		      fold_convert (stype, iref->last),
+		      fold_convert (stype, iref->iv));
+  rest = force_prefetch_operand (&bsi, rest);
+
+  for (ap = 0; ap < unroll_factor; ap++)
+    {
+      off = build_int_cst (stype, (ahead + ap) * iref->step);
+      off = fold_build2 (iref->step > 0 ? MIN_EXPR : MAX_EXPR, stype,
+			 rest, off);
+      iv = fold_build2 (PLUS_EXPR, type, iref->iv, fold_convert (type, off));
+      iv = force_prefetch_operand (&bsi, iv);
+
+      /* The load below dereferences IV; give it the aliasing information
+	 of the pointer it was computed from.  */
+      if (POINTER_TYPE_P (type)
+	  && TREE_CODE (iv) == SSA_NAME)
+	{
+	  var_ann_t ann = var_ann (SSA_NAME_VAR (iv));
+
+	  if (SSA_NAME_PTR_INFO (iref->iv)
+	      && !SSA_NAME_PTR_INFO (iv))
+	    duplicate_ssa_name_ptr_info (iv, SSA_NAME_PTR_INFO (iref->iv));
+	  if (!ann->symbol_mem_tag)
+	    ann->symbol_mem_tag
+	      = var_ann (SSA_NAME_VAR (iref->iv))->symbol_mem_tag;
+	}
+
+      val = replace_name (TREE_OPERAND (iref->load, 1), iref->iv, iv);
+      val = force_prefetch_operand (&bsi, val);
+
+      index = recompute_from (loop, iref->index,
+			      TREE_OPERAND (iref->load, 0), val);
+      index = force_prefetch_operand (&bsi, index);
+
+      addr = replace_name (iref->mem, iref->index, index);
+      addr = build_fold_addr_expr_with_type (addr, ptr_type_node);
+      addr = force_prefetch_operand (&bsi, addr);
+
+      emit_prefetch (&bsi, addr, iref->write_p);
+    }
+}
+
+/* Issue prefetches for the next node of the linked structure LREF, one for
+   each cache line the loop accesses.  */
+
+static void
+issue_linked_prefetches (struct linked_ref *lref)
+{
+  block_stmt_iterator bsi;
+  tree node, addr;
+  unsigned i, n_prefetches = 0;
+  HOST_WIDE_INT last = 0;
+
+  if (dump_file && (dump_flags & TDF_DETAILS))
+    fprintf (dump_file, "Issued prefetch for linked structure %p.\n",
+	     (void *) lref);
+
+  bsi = bsi_for_stmt (lref->stmt);
+  node = force_prefetch_operand (&bsi, lref->link);
+  node = fold_convert (ptr_type_node, node);
+
+  for (i = 0; i < lref->n_offsets; i++)
+    {
+      if (n_prefetches > 0
+	  && lref->offsets[i] < last + PREFETCH_BLOCK)
+	continue;
+      if (n_prefetches == (unsigned) SIMULTANEOUS_PREFETCHES)
+	break;
+
+      last = lref->offsets[i];
+      addr = fold_build2 (PLUS_EXPR, ptr_type_node, node,
+			  build_int_cst (ptr_type_node, last));
+      addr = force_prefetch_operand (&bsi, addr);
+      emit_prefetch (&bsi, addr, false);
+      n_prefetches++;
+    }
+}
+
+/* Issue prefetches for the indirect references IREFS and the linked
+   structures LREFS in LOOP as decided before.  AHEAD is the number of
+   iterations to prefetch ahead.  UNROLL_FACTOR is the factor by that LOOP
+   was unrolled.  */
+
+static void
+issue_indirect_prefetches (struct loop *loop, struct indirect_ref *irefs,
+			   struct linked_ref *lrefs,
+			   unsigned unroll_factor, unsigned ahead)
+{
+  for (; irefs; irefs = irefs->next)
+    if (irefs->issue_prefetch_p)
+      issue_indirect_prefetch (loop, irefs, unroll_factor, ahead);
+
+  for (; lrefs; lrefs = lrefs->next)
+    issue_linked_prefetches (lrefs);
+}
+/* APPLE LOCAL end indirect prefetch */
+
 /* Determines whether we can profitably unroll LOOP FACTOR times, and if
    this is the case, fill in DESC by the description of number of
    iterations.  */
@@ -948,6 +1778,41 @@ determine_unroll_factor (struct loop *loop, struct mem_ref_group *refs,
   return factor;
 }
 
+/* APPLE LOCAL begin indirect prefetch */
+/* Returns an estimate of the number of insns executed in one iteration of
+   LOOP: the size of each block is weighted by its frequency relative to the
+   header, so that the blocks executed only conditionally count less, and
+   the inner loops count as many times as they iterate.  */
+
+static unsigned
+loop_iteration_insns (struct loop *loop)
+{
+  basic_block *body;
+  block_stmt_iterator bsi;
+  gcov_type time = 0;
+  unsigned size, i;
+
+  if (loop->header->frequency == 0)
+    return tree_num_loop_insns (loop);
+
+  body = get_loop_body (loop);
+  for (i = 0; i < loop->num_nodes; i++)
+    {
+      size = 0;
+      for (bsi = bsi_start (body[i]); !bsi_end_p (bsi); bsi_next (&bsi))
+	size += estimate_num_insns (bsi_stmt (bsi));
+      time += (gcov_type) size * body[i]->frequency;
+    }
+  free (body);
+
+  time /= loop->header->frequency;
+  if (time > PREFETCH_LATENCY)
+    time = PREFETCH_LATENCY;
+
+  return 1 + (unsigned) time;
+}
+/* APPLE LOCAL end indirect prefetch */
+
 /* Issue prefetch instructions for array references in LOOP.  Returns
    true if the LOOP was unrolled.  LOOPS is the array containing all
    loops.  */
@@ -956,25 +1821,32 @@ static bool
 loop_prefetch_arrays (struct loops *loops, struct loop *loop)
 {
   struct mem_ref_group *refs;
+  /* APPLE LOCAL begin indirect prefetch */
+  struct indirect_ref *irefs;
+  struct linked_ref *lrefs;
   unsigned ahead, ninsns, unroll_factor;
   struct tree_niter_desc desc;
-  bool unrolled = false;
+  bool unrolled = false, any;
 
   /* Step 1: gather the memory references.  */
   refs = gather_memory_references (loop);
+  irefs = gather_indirect_references (loop);
+  lrefs = gather_linked_references (loop);
+  mark_index_references (refs, irefs);
 
   /* Step 2: estimate the reuse effects.  */
   prune_by_reuse (refs);
 
-  if (!anything_to_prefetch_p (refs))
+  if (!anything_to_prefetch_p (refs) && !irefs && !lrefs)
     goto fail;
 
-  /* Step 3: determine the ahead and unroll factor.  */
-
-  /* FIXME: We should use not size of the loop, but the average number of
-     instructions executed per iteration of the loop.  */
+  /* Step 3: determine the ahead and unroll factor.  The prefetch must be
+     issued PREFETCH_LATENCY insns before the access, which is AHEAD
+     iterations of the loop.  */
   ninsns = tree_num_loop_insns (loop);
-  ahead = (PREFETCH_LATENCY + ninsns - 1) / ninsns;
+  ahead = loop_iteration_insns (loop);
+  ahead = (PREFETCH_LATENCY + ahead - 1) / ahead;
+  /* APPLE LOCAL end indirect prefetch */
   unroll_factor = determine_unroll_factor (loop, refs, ahead, ninsns,
 					   &desc);
   if (dump_file && (dump_flags & TDF_DETAILS))
@@ -987,12 +1859,17 @@ loop_prefetch_arrays (struct loops *loops, struct loop *loop)
       && (unsigned HOST_WIDE_INT) int_cst_value (desc.niter) < unroll_factor)
     goto fail;
 
-  /* Step 4: what to prefetch?  */
-  if (!schedule_prefetches (refs, unroll_factor, ahead))
+  /* APPLE LOCAL begin indirect prefetch */
+  /* Step 4: what to prefetch?  The next nodes of linked structures are
+     prefetched regardless of the unrolling.  */
+  any = schedule_prefetches (refs, irefs, unroll_factor, ahead);
+  if (!any && !lrefs)
     goto fail;
 
   /* Step 5: unroll the loop.  TODO -- peeling of first and last few
      iterations so that we do not issue superfluous prefetches.  */
+  if (!any)
+    unroll_factor = 1;
   if (unroll_factor != 1)
     {
       tree_unroll_loop (loops, loop, unroll_factor,
@@ -1002,9 +1879,12 @@ loop_prefetch_arrays (struct loops *loops, struct loop *loop)
 
   /* Step 6: issue the prefetches.  */
   issue_prefetches (refs, unroll_factor, ahead);
+  issue_indirect_prefetches (loop, irefs, lrefs, unroll_factor, ahead);
 
 fail:
   release_mem_refs (refs);
+  release_indirect_refs (irefs, lrefs);
+  /* APPLE LOCAL end indirect prefetch */
   return unrolled;
 }
 
@@ -1065,6 +1945,13 @@ tree_ssa_prefetch_arrays (struct loops *loops)
       todo_flags |= TODO_cleanup_cfg;
     }
 
+  /* APPLE LOCAL begin indirect prefetch */
+  /* The loads issued for the indirect prefetches need their virtual
+     operands renamed.  */
+  if (need_ssa_update_p ())
+    todo_flags |= TODO_update_ssa_only_virtuals;
+  /* APPLE LOCAL end indirect prefetch */
+
   free_original_copy_tables ();
   return todo_flags;
 }
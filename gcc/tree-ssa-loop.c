@@ -216,6 +216,41 @@ struct tree_opt_pass pass_vectorize =
   0					/* letter */
 };
 
+/* APPLE LOCAL begin vect slp */
+/* Straight-line vectorization.  Unlike the other loop passes this one
+   also runs on functions without loops.  */
+
+static unsigned int
+tree_slp_vectorize (void)
+{
+  vect_slp_transform_bbs (current_loops);
+  return 0;
+}
+
+static bool
+gate_tree_slp_vectorize (void)
+{
+  return flag_tree_vectorize && flag_tree_slp_vectorize;
+}
+
+struct tree_opt_pass pass_slp_vectorize =
+{
+  "slp",                                /* name */
+  gate_tree_slp_vectorize,              /* gate */
+  tree_slp_vectorize,                   /* execute */
+  NULL,                                 /* sub */
+  NULL,                                 /* next */
+  0,                                    /* static_pass_number */
+  TV_TREE_SLP_VECTORIZATION,            /* tv_id */
+  PROP_cfg | PROP_ssa,                  /* properties_required */
+  0,                                    /* properties_provided */
+  0,                                    /* properties_destroyed */
+  0,					/* todo_flags_start */
+  TODO_dump_func | TODO_verify_ssa,	/* todo_flags_finish */
+  0					/* letter */
+};
+/* APPLE LOCAL end vect slp */
+
 /* Loop nest optimizations.  */
 
 static unsigned int
@@ -251,6 +286,110 @@ struct tree_opt_pass pass_linear_transform =
   0				        /* letter */	
 };
 
+/* APPLE LOCAL begin loop distribution */
+/* Unroll-and-jam.  */
+
+static unsigned int
+tree_ssa_unroll_and_jam (void)
+{
+  if (!current_loops)
+    return 0;
+
+  return tree_unroll_and_jam (current_loops);
+}
+
+static bool
+gate_tree_ssa_unroll_and_jam (void)
+{
+  return flag_tree_loop_unroll_and_jam != 0;
+}
+
+struct tree_opt_pass pass_unroll_and_jam =
+{
+  "ujam",				/* name */
+  gate_tree_ssa_unroll_and_jam,		/* gate */
+  tree_ssa_unroll_and_jam,		/* execute */
+  NULL,					/* sub */
+  NULL,					/* next */
+  0,					/* static_pass_number */
+  TV_TREE_UNROLL_AND_JAM,		/* tv_id */
+  PROP_cfg | PROP_ssa,			/* properties_required */
+  0,					/* properties_provided */
+  0,					/* properties_destroyed */
+  0,					/* todo_flags_start */
+  TODO_dump_func | TODO_verify_loops,	/* todo_flags_finish */
+  0					/* letter */
+};
+
+/* Loop fusion.  */
+
+static unsigned int
+tree_ssa_loop_fusion (void)
+{
+  if (!current_loops)
+    return 0;
+
+  return tree_loop_fusion (current_loops);
+}
+
+static bool
+gate_tree_ssa_loop_fusion (void)
+{
+  return flag_tree_loop_fusion != 0;
+}
+
+struct tree_opt_pass pass_loop_fusion =
+{
+  "lfusion",				/* name */
+  gate_tree_ssa_loop_fusion,		/* gate */
+  tree_ssa_loop_fusion,			/* execute */
+  NULL,					/* sub */
+  NULL,					/* next */
+  0,					/* static_pass_number */
+  TV_TREE_LOOP_FUSION,			/* tv_id */
+  PROP_cfg | PROP_ssa,			/* properties_required */
+  0,					/* properties_provided */
+  0,					/* properties_destroyed */
+  0,					/* todo_flags_start */
+  TODO_dump_func | TODO_verify_loops,	/* todo_flags_finish */
+  0					/* letter */
+};
+
+/* Loop distribution.  */
+
+static unsigned int
+tree_ssa_loop_distribution (void)
+{
+  if (!current_loops)
+    return 0;
+
+  return tree_loop_distribution (current_loops);
+}
+
+static bool
+gate_tree_ssa_loop_distribution (void)
+{
+  return flag_tree_loop_distribution != 0;
+}
+
+struct tree_opt_pass pass_loop_distribution =
+{
+  "ldist",				/* name */
+  gate_tree_ssa_loop_distribution,	/* gate */
+  tree_ssa_loop_distribution,		/* execute */
+  NULL,					/* sub */
+  NULL,					/* next */
+  0,					/* static_pass_number */
+  TV_TREE_LOOP_DISTRIBUTION,		/* tv_id */
+  PROP_cfg | PROP_ssa,			/* properties_required */
+  0,					/* properties_provided */
+  0,					/* properties_destroyed */
+  0,					/* todo_flags_start */
+  TODO_dump_func | TODO_verify_loops,	/* todo_flags_finish */
+  0					/* letter */
+};
+/* APPLE LOCAL end loop distribution */
+
 /* Canonical induction variable creation pass.  */
 
 static unsigned int
@@ -40,6 +40,10 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 #include "tree-data-ref.h"
 #include "tree-scalar-evolution.h"
 #include "tree-vectorizer.h"
+/* APPLE LOCAL vect cost model */
+#include "toplev.h"
+/* APPLE LOCAL vect outer loop */
+#include "pointer-set.h"
 
 /* Main analysis functions.  */
 static loop_vec_info vect_analyze_loop_form (struct loop *);
@@ -66,6 +70,17 @@ static bool vect_analyze_data_ref_access (struct data_reference *);
 static bool vect_can_advance_ivs_p (loop_vec_info);
 static void vect_update_misalignment_for_peel
   (struct data_reference *, struct data_reference *, int npeel);
+/* APPLE LOCAL begin vect interleave */
+static bool vect_dr_group_member_p (struct data_reference *);
+static bool vect_analyze_group_access (struct data_reference *);
+static bool vect_analyze_group_order (loop_vec_info);
+/* APPLE LOCAL end vect interleave */
+/* APPLE LOCAL begin vect cost model */
+static int vect_invariant_operands_count (tree, loop_vec_info);
+static int vect_estimate_min_profitable_iters (loop_vec_info);
+/* APPLE LOCAL end vect cost model */
+/* APPLE LOCAL vect multiple types */
+static int vect_conversion_stmts_count (stmt_vec_info);
  
 
 /* Function vect_determine_vectorization_factor
@@ -76,10 +91,11 @@ static void vect_update_misalignment_for_peel
    on a target with vector size (VS) 16byte, the VF is set to 4, since 4
    elements can fit in a single vector register.
 
-   We currently support vectorization of loops in which all types operated upon
-   are of the same size. Therefore this function currently sets VF according to
-   the size of the types operated upon, and fails if there are multiple sizes
-   in the loop.
+   APPLE LOCAL begin vect multiple types
+   When the loop operates on types of several sizes, VF is set according to
+   the smallest of them, and the stmts of a wider type are vectorized by
+   several vector stmts each.
+   APPLE LOCAL end vect multiple types
 
    VF is also the factor by which the loop iterations are strip-mined, e.g.:
    original loop:
@@ -189,22 +205,15 @@ vect_determine_vectorization_factor (loop_vec_info loop_vinfo)
           if (vect_print_dump_info (REPORT_DETAILS))
             fprintf (vect_dump, "nunits = %d", nunits);
 
-          if (vectorization_factor)
-            {
-              /* FORNOW: don't allow mixed units. 
-                 This restriction will be relaxed in the future.  */
-              if (nunits != vectorization_factor) 
-                {
-                  if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
-                    fprintf (vect_dump, "not vectorized: mixed data-types");
-                  return false;
-                }
-            }
-          else
+          /* APPLE LOCAL begin vect multiple types */
+          /* The vectorization factor is set by the narrowest type in the
+             loop.  Stmts of wider types are vectorized by several vector
+             stmts each; see vect_get_ncopies.  */
+          gcc_assert (GET_MODE_SIZE (TYPE_MODE (scalar_type)) * nunits
+                      == UNITS_PER_SIMD_WORD);
+          if (nunits > vectorization_factor)
             vectorization_factor = nunits;
-
-          gcc_assert (GET_MODE_SIZE (TYPE_MODE (scalar_type))
-                        * vectorization_factor == UNITS_PER_SIMD_WORD);
+          /* APPLE LOCAL end vect multiple types */
         }
     }
 
@@ -221,6 +230,272 @@ vect_determine_vectorization_factor (loop_vec_info loop_vinfo)
   return true;
 }
 
+/* APPLE LOCAL begin vect cost model */
+/* Function vect_invariant_operands_count.
+
+   Return the number of operands of the rhs of STMT that are constants or
+   loop invariants.  Each of them is broadcast into a vector in the loop
+   preheader.  */
+
+static int
+vect_invariant_operands_count (tree stmt, loop_vec_info loop_vinfo)
+{
+  tree rhs, op, def_stmt, def;
+  enum vect_def_type dt;
+  int i, count = 0;
+
+  if (TREE_CODE (stmt) != MODIFY_EXPR)
+    return 0;
+
+  rhs = TREE_OPERAND (stmt, 1);
+  if (!EXPR_P (rhs))
+    return 0;
+
+  for (i = 0; i < TREE_CODE_LENGTH (TREE_CODE (rhs)); i++)
+    {
+      op = TREE_OPERAND (rhs, i);
+      if (op
+	  && (TREE_CODE (op) == SSA_NAME || CONSTANT_CLASS_P (op))
+	  && vect_is_simple_use (op, loop_vinfo, &def_stmt, &def, &dt)
+	  && (dt == vect_constant_def || dt == vect_invariant_def))
+	count++;
+    }
+
+  return count;
+}
+
+
+/* APPLE LOCAL begin vect multiple types */
+/* Function vect_conversion_stmts_count.
+
+   Return the number of vector stmts that vectorize STMT_INFO, a type
+   promotion or demotion.  Each unpacking step doubles the number of
+   vectors, and each packing step halves it.  */
+
+static int
+vect_conversion_stmts_count (stmt_vec_info stmt_info)
+{
+  tree stmt = STMT_VINFO_STMT (stmt_info);
+  tree op = TREE_OPERAND (TREE_OPERAND (stmt, 1), 0);
+  int size_in = GET_MODE_SIZE (TYPE_MODE (TREE_TYPE (op)));
+  int size_out = GET_MODE_SIZE (TYPE_MODE (TREE_TYPE (stmt)));
+  int ncopies = vect_get_ncopies (stmt_info);
+  int count = 0;
+
+  if (STMT_VINFO_TYPE (stmt_info) == type_promotion_vec_info_type)
+    for (; size_in < size_out; size_out /= 2, ncopies /= 2)
+      count += ncopies;
+  else
+    for (; size_out < size_in; size_out *= 2, ncopies *= 2)
+      count += ncopies;
+
+  return count;
+}
+/* APPLE LOCAL end vect multiple types */
+
+
+/* Function vect_estimate_min_profitable_iters.
+
+   Estimate the cost of one iteration of the scalar loop and of one
+   iteration of the vector loop, and the one-time cost of the code that
+   vectorization adds outside the vector loop: the peeled prolog and epilog
+   iterations, the guards around them, the runtime alignment and alias
+   checks of loop versioning, and the setup and reduction epilog code.
+   All costs are given by the target in units of a scalar statement.
+
+   Return the minimum number of iterations for which the vector loop is
+   cheaper than the scalar loop, or -1 if the vector loop is never
+   profitable.  */
+
+static int
+vect_estimate_min_profitable_iters (loop_vec_info loop_vinfo)
+{
+  struct loop *loop = LOOP_VINFO_LOOP (loop_vinfo);
+  basic_block *bbs = LOOP_VINFO_BBS (loop_vinfo);
+  int nbbs = loop->num_nodes;
+  int vf = LOOP_VINFO_VECT_FACTOR (loop_vinfo);
+  int (*cost) (enum vect_cost_for_stmt)
+    = targetm.vectorize.builtin_vectorization_cost;
+  int scalar_single_iter_cost = 0;
+  int vec_inside_cost = 0;
+  int vec_outside_cost = 0;
+  int peel_iters_prologue, peel_iters_epilogue;
+  int nmisalign, nalias;
+  int min_profitable_iters;
+  int i;
+  block_stmt_iterator si;
+
+  for (i = 0; i < nbbs; i++)
+    for (si = bsi_start (bbs[i]); !bsi_end_p (si); bsi_next (&si))
+      {
+	tree stmt = bsi_stmt (si);
+	stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+	struct data_reference *dr = STMT_VINFO_DATA_REF (stmt_info);
+	tree vectype = STMT_VINFO_VECTYPE (stmt_info);
+	/* APPLE LOCAL vect multiple types */
+	int ncopies;
+
+	if (!STMT_VINFO_RELEVANT_P (stmt_info)
+	    && !STMT_VINFO_LIVE_P (stmt_info))
+	  continue;
+
+	/* APPLE LOCAL vect multiple types */
+	ncopies = vect_get_ncopies (stmt_info);
+
+	switch (STMT_VINFO_TYPE (stmt_info))
+	  {
+	  case load_vec_info_type:
+	    scalar_single_iter_cost += cost (scalar_load);
+	    switch (vect_supportable_dr_alignment (dr))
+	      {
+	      /* APPLE LOCAL begin vect multiple types */
+	      case dr_aligned:
+		vec_inside_cost += ncopies * cost (vector_load);
+		break;
+
+	      case dr_unaligned_supported:
+		vec_inside_cost += ncopies * cost (unaligned_load);
+		break;
+	      /* APPLE LOCAL end vect multiple types */
+
+	      case dr_unaligned_software_pipeline:
+		/* An aligned load and a realignment in the loop; the first
+		   load and the realignment mask before it.  */
+		vec_inside_cost += cost (vector_load) + cost (vector_stmt);
+		vec_outside_cost += cost (vector_load) + cost (vector_stmt);
+		break;
+
+	      default:
+		gcc_unreachable ();
+	      }
+	    break;
+
+	  case store_vec_info_type:
+	    scalar_single_iter_cost += cost (scalar_store);
+	    /* APPLE LOCAL vect multiple types */
+	    vec_inside_cost += ncopies * cost (vector_store);
+	    break;
+
+	  /* APPLE LOCAL begin vect multiple types */
+	  case type_promotion_vec_info_type:
+	  case type_demotion_vec_info_type:
+	    /* Each step of unpacking or packing doubles or halves the
+	       number of vectors.  */
+	    scalar_single_iter_cost += cost (scalar_stmt);
+	    vec_inside_cost += vect_conversion_stmts_count (stmt_info)
+			       * cost (vec_perm);
+	    break;
+	  /* APPLE LOCAL end vect multiple types */
+
+	  case reduc_vec_info_type:
+	    /* The initial vector of the reduction is built before the loop,
+	       and reduced to a scalar after it.  */
+	    scalar_single_iter_cost += cost (scalar_stmt);
+	    vec_inside_cost += cost (vector_stmt);
+	    vec_outside_cost += cost (scalar_to_vec)
+	      + exact_log2 (TYPE_VECTOR_SUBPARTS (vectype))
+		* (cost (vector_stmt) + cost (vec_perm))
+	      + cost (vec_to_scalar);
+	    break;
+
+	  default:
+	    scalar_single_iter_cost += cost (scalar_stmt);
+	    /* APPLE LOCAL vect multiple types */
+	    vec_inside_cost += ncopies * cost (vector_stmt);
+	    vec_outside_cost += vect_invariant_operands_count (stmt, loop_vinfo)
+				* cost (scalar_to_vec);
+	    break;
+	  }
+
+	/* Each member of an interleaving group goes through log2 (size)
+	   stages of extract even/odd or interleave high/low.  */
+	if (dr && STMT_VINFO_STRIDED_ACCESS (stmt_info))
+	  {
+	    stmt_vec_info first_info
+	      = vinfo_for_stmt (DR_GROUP_FIRST_DR (stmt_info));
+	    vec_inside_cost += exact_log2 (DR_GROUP_SIZE (first_info))
+			       * cost (vec_perm);
+	  }
+      }
+
+  /* Iterations of the scalar prolog and epilog loops.  When they are not
+     known at compile time, assume half a vector on average.  */
+  if (LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo) < 0)
+    {
+      peel_iters_prologue = vf / 2;
+      /* Computing the number of prolog iterations, and the guards around
+	 the prolog loop.  */
+      vec_outside_cost += 4 * cost (scalar_stmt)
+			  + cost (cond_branch_taken)
+			  + cost (cond_branch_not_taken);
+    }
+  else if (LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo) > 0)
+    {
+      struct data_reference *dr = LOOP_VINFO_UNALIGNED_DR (loop_vinfo);
+      tree vectype = STMT_VINFO_VECTYPE (vinfo_for_stmt (DR_STMT (dr)));
+      /* APPLE LOCAL begin vect multiple types */
+      int nelements = TYPE_VECTOR_SUBPARTS (vectype);
+      int element_size = TYPE_ALIGN (vectype) / BITS_PER_UNIT / nelements;
+      int elem_misalign = LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo)
+			  / element_size;
+
+      peel_iters_prologue = (nelements - elem_misalign) & (nelements - 1);
+      /* APPLE LOCAL end vect multiple types */
+      vec_outside_cost += cost (cond_branch_taken)
+			  + cost (cond_branch_not_taken);
+    }
+  else
+    peel_iters_prologue = 0;
+
+  if (!LOOP_VINFO_NITERS_KNOWN_P (loop_vinfo)
+      || LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo) < 0)
+    {
+      peel_iters_epilogue = vf / 2;
+      /* Computing the number of vector iterations, and the guards around
+	 the vector and the epilog loops.  */
+      vec_outside_cost += 2 * cost (scalar_stmt)
+			  + cost (cond_branch_taken)
+			  + cost (cond_branch_not_taken);
+    }
+  else
+    {
+      peel_iters_epilogue = (LOOP_VINFO_INT_NITERS (loop_vinfo)
+			     - peel_iters_prologue) % vf;
+      if (peel_iters_prologue || peel_iters_epilogue)
+	vec_outside_cost += cost (cond_branch_taken)
+			    + cost (cond_branch_not_taken);
+    }
+
+  /* Loop versioning: each address checked for alignment is or-ed into a
+     mask, each pair of possibly aliasing data references is compared both
+     ways, and the result selects one of the two loops.  */
+  nmisalign = VEC_length (tree, LOOP_VINFO_MAY_MISALIGN_STMTS (loop_vinfo));
+  nalias = VEC_length (ddr_p, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo));
+  if (nmisalign || nalias)
+    vec_outside_cost += (2 * nmisalign + 5 * nalias) * cost (scalar_stmt)
+			+ cost (cond_branch_taken);
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    fprintf (vect_dump, "cost model: scalar iteration cost = %d, "
+	     "vector iteration cost = %d, vector outside cost = %d, "
+	     "prolog iterations = %d, epilog iterations = %d.",
+	     scalar_single_iter_cost, vec_inside_cost, vec_outside_cost,
+	     peel_iters_prologue, peel_iters_epilogue);
+
+  /* The scalar loop costs SIC * N, and the vectorized code costs
+     VOC + SIC * (PRO + EPI) + VIC * (N - PRO - EPI) / VF.  The latter is
+     smaller when N > VOC * VF / (SIC * VF - VIC) + PRO + EPI.  */
+  if (scalar_single_iter_cost * vf <= vec_inside_cost)
+    return -1;
+
+  min_profitable_iters = vec_outside_cost * vf
+			 / (scalar_single_iter_cost * vf - vec_inside_cost)
+			 + peel_iters_prologue + peel_iters_epilogue + 1;
+
+  return MAX (min_profitable_iters, vf);
+}
+/* APPLE LOCAL end vect cost model */
+
 
 /* Function vect_analyze_operations.
 
@@ -314,6 +589,10 @@ vect_analyze_operations (loop_vec_info loop_vinfo)
 
 	      ok = (vectorizable_operation (stmt, NULL, NULL)
 		    || vectorizable_assignment (stmt, NULL, NULL)
+		    /* APPLE LOCAL begin vect multiple types */
+		    || vectorizable_type_promotion (stmt, NULL, NULL)
+		    || vectorizable_type_demotion (stmt, NULL, NULL)
+		    /* APPLE LOCAL end vect multiple types */
 		    || vectorizable_load (stmt, NULL, NULL)
 		    || vectorizable_store (stmt, NULL, NULL)
 		    || vectorizable_condition (stmt, NULL, NULL));
@@ -354,8 +633,6 @@ vect_analyze_operations (loop_vec_info loop_vinfo)
 	} /* stmts in bb */
     } /* bbs */
 
-  /* TODO: Analyze cost. Decide if worth while to vectorize.  */
-
   /* All operations in the loop are either irrelevant (deal with loop
      control, or dead), or only used outside the loop and can be moved
      out of the loop (e.g. invariants, inductions).  The loop can be 
@@ -386,6 +663,43 @@ vect_analyze_operations (loop_vec_info loop_vinfo)
       return false;
     }
 
+  /* APPLE LOCAL begin vect cost model */
+  /* Analyze cost.  Decide if worth while to vectorize.  */
+  if (flag_vect_cost_model)
+    {
+      int min_profitable_iters
+	= vect_estimate_min_profitable_iters (loop_vinfo);
+
+      if (min_profitable_iters < 0)
+	{
+	  if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
+	    fprintf (vect_dump, "not vectorized: vector version will never "
+		     "be profitable.");
+	  return false;
+	}
+
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "cost model: minimum profitable iterations = %d.",
+		 min_profitable_iters);
+
+      if (LOOP_VINFO_NITERS_KNOWN_P (loop_vinfo))
+	{
+	  if (LOOP_VINFO_INT_NITERS (loop_vinfo)
+	      < (unsigned HOST_WIDE_INT) min_profitable_iters)
+	    {
+	      if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
+		fprintf (vect_dump, "not vectorized: iteration count smaller "
+			 "than the cost model threshold %d.",
+			 min_profitable_iters);
+	      return false;
+	    }
+	}
+      else if (min_profitable_iters > (int) vectorization_factor)
+	/* Guard the vector loop with the threshold at runtime.  */
+	LOOP_VINFO_COST_MODEL_MIN_ITERS (loop_vinfo) = min_profitable_iters;
+    }
+  /* APPLE LOCAL end vect cost model */
+
   if (!LOOP_VINFO_NITERS_KNOWN_P (loop_vinfo)
       || LOOP_VINFO_INT_NITERS (loop_vinfo) % vectorization_factor != 0
       || LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo))
@@ -574,6 +888,83 @@ vect_analyze_scalar_cycles (loop_vec_info loop_vinfo)
 }
 
 
+/* APPLE LOCAL begin vect alias versioning */
+/* Function vect_same_segment_p.
+
+   Return TRUE if the data-refs DRA and DRB access the same segment of
+   memory in the loop.  */
+
+static bool
+vect_same_segment_p (struct data_reference *dra, struct data_reference *drb)
+{
+  return (operand_equal_p (DR_BASE_ADDRESS (dra), DR_BASE_ADDRESS (drb), 0)
+	  && operand_equal_p (DR_OFFSET (dra), DR_OFFSET (drb), 0)
+	  && operand_equal_p (DR_INIT (dra), DR_INIT (drb), 0)
+	  && operand_equal_p (DR_STEP (dra), DR_STEP (drb), 0));
+}
+
+
+/* Function vect_mark_for_runtime_alias_test.
+
+   The dependence between the data-refs of DDR could not be determined.
+   Record DDR in LOOP_VINFO to have the loop versioned with a runtime check
+   that the segments of memory they access do not overlap, and return TRUE,
+   if this is possible.  */
+
+static bool
+vect_mark_for_runtime_alias_test (struct data_dependence_relation *ddr,
+				  loop_vec_info loop_vinfo)
+{
+  struct data_reference *dra = DDR_A (ddr);
+  struct data_reference *drb = DDR_B (ddr);
+  struct data_dependence_relation *ddr2;
+  unsigned int i;
+
+  if (!flag_tree_vect_loop_version || optimize_size)
+    return false;
+
+  /* The length of the segment accessed by each data-ref must be computable
+     from its step and the number of iterations.  */
+  if (!DR_BASE_ADDRESS (dra) || !DR_OFFSET (dra) || !DR_INIT (dra)
+      || !DR_BASE_ADDRESS (drb) || !DR_OFFSET (drb) || !DR_INIT (drb)
+      || !DR_STEP (dra) || TREE_CODE (DR_STEP (dra)) != INTEGER_CST
+      || tree_int_cst_sgn (DR_STEP (dra)) <= 0
+      || !DR_STEP (drb) || TREE_CODE (DR_STEP (drb)) != INTEGER_CST
+      || tree_int_cst_sgn (DR_STEP (drb)) <= 0)
+    return false;
+
+  /* A pair of segments is checked only once.  */
+  for (i = 0;
+       VEC_iterate (ddr_p, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo), i, ddr2);
+       i++)
+    if ((vect_same_segment_p (dra, DDR_A (ddr2))
+	 && vect_same_segment_p (drb, DDR_B (ddr2)))
+	|| (vect_same_segment_p (dra, DDR_B (ddr2))
+	    && vect_same_segment_p (drb, DDR_A (ddr2))))
+      return true;
+
+  if (VEC_length (ddr_p, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo))
+      >= (unsigned) PARAM_VALUE (PARAM_VECT_MAX_VERSION_FOR_ALIAS_CHECKS))
+    {
+      if (vect_print_dump_info (REPORT_DR_DETAILS))
+	fprintf (vect_dump, "too many runtime alias checks");
+      return false;
+    }
+
+  if (vect_print_dump_info (REPORT_DR_DETAILS))
+    {
+      fprintf (vect_dump, "mark for runtime alias check between ");
+      print_generic_expr (vect_dump, DR_REF (dra), TDF_SLIM);
+      fprintf (vect_dump, " and ");
+      print_generic_expr (vect_dump, DR_REF (drb), TDF_SLIM);
+    }
+
+  VEC_safe_push (ddr_p, heap, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo), ddr);
+  return true;
+}
+/* APPLE LOCAL end vect alias versioning */
+
+
 /* Function vect_analyze_data_ref_dependence.
 
    Return TRUE if there (might) exist a dependence between a memory-reference
@@ -598,6 +989,11 @@ vect_analyze_data_ref_dependence (struct data_dependence_relation *ddr,
   
   if (DDR_ARE_DEPENDENT (ddr) == chrec_dont_know)
     {
+      /* APPLE LOCAL begin vect alias versioning */
+      if (vect_mark_for_runtime_alias_test (ddr, loop_vinfo))
+	return false;
+      /* APPLE LOCAL end vect alias versioning */
+
       if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
         {
           fprintf (vect_dump,
@@ -826,6 +1222,24 @@ vect_compute_data_refs_alignment (loop_vec_info loop_vinfo)
 }
 
 
+/* APPLE LOCAL begin vect interleave */
+/* Function vect_dr_group_member_p
+
+   Return TRUE if DR belongs to an interleaving group without being its
+   first member.  The vector accesses of the group are all made from the
+   address of the first member, so the alignment of DR does not matter.  */
+
+static bool
+vect_dr_group_member_p (struct data_reference *dr)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (DR_STMT (dr));
+
+  return (STMT_VINFO_STRIDED_ACCESS (stmt_info)
+	  && DR_GROUP_FIRST_DR (stmt_info) != DR_STMT (dr));
+}
+/* APPLE LOCAL end vect interleave */
+
+
 /* Function vect_update_misalignment_for_peel
 
    DR - the data reference whose misalignment is to be adjusted.
@@ -867,6 +1281,12 @@ vect_update_misalignment_for_peel (struct data_reference *dr,
       && known_alignment_for_access_p (dr_peel))
     {  
       drsize = GET_MODE_SIZE (TYPE_MODE (TREE_TYPE (DR_REF (dr))));
+      /* APPLE LOCAL begin vect interleave */
+      /* An interleaved access advances by the whole group each
+	 iteration.  */
+      if (STMT_VINFO_STRIDED_ACCESS (vinfo_for_stmt (DR_STMT (dr))))
+	drsize *= DR_GROUP_SIZE (vinfo_for_stmt (DR_STMT (dr)));
+      /* APPLE LOCAL end vect interleave */
       DR_MISALIGNMENT (dr) += npeel * drsize;
       DR_MISALIGNMENT (dr) %= UNITS_PER_SIMD_WORD;
       return;
@@ -891,6 +1311,11 @@ vect_verify_datarefs_alignment (loop_vec_info loop_vinfo)
 
   for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr); i++)
     {
+      /* APPLE LOCAL begin vect interleave */
+      if (vect_dr_group_member_p (dr))
+	continue;
+      /* APPLE LOCAL end vect interleave */
+
       supportable_dr_alignment = vect_supportable_dr_alignment (dr);
       if (!supportable_dr_alignment)
         {
@@ -1109,7 +1534,12 @@ vect_enhance_data_refs_alignment (loop_vec_info loop_vinfo)
      TODO: Use a cost model.  */
 
   for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr); i++)
-    if (!DR_IS_READ (dr) && !aligned_access_p (dr))
+    if (!DR_IS_READ (dr) && !aligned_access_p (dr)
+	/* APPLE LOCAL begin vect interleave */
+	/* Peeling moves an interleaved access by whole groups, which
+	   rarely changes its alignment.  */
+	&& !STMT_VINFO_STRIDED_ACCESS (vinfo_for_stmt (DR_STMT (dr))))
+	/* APPLE LOCAL end vect interleave */
       {
 	/* APPLE LOCAL begin mainline 4.2 5569774 */
         do_peeling = vector_alignment_reachable_p (dr);
@@ -1137,9 +1567,14 @@ vect_enhance_data_refs_alignment (loop_vec_info loop_vinfo)
              in the peeled loop (the peeling factor) for use in updating
              DR_MISALIGNMENT values.  The peeling factor is the vectorization
              factor minus the misalignment as an element count.  */
+          /* APPLE LOCAL begin vect multiple types */
+          tree vectype = STMT_VINFO_VECTYPE (vinfo_for_stmt (DR_STMT (dr0)));
+          int nelements = TYPE_VECTOR_SUBPARTS (vectype);
+
           mis = DR_MISALIGNMENT (dr0);
           mis /= GET_MODE_SIZE (TYPE_MODE (TREE_TYPE (DR_REF (dr0))));
-          npeel = LOOP_VINFO_VECT_FACTOR (loop_vinfo) - mis;
+          npeel = nelements - mis;
+          /* APPLE LOCAL end vect multiple types */
         }
 
       /* Ensure that all data refs can be vectorized after the peel.  */
@@ -1147,8 +1582,10 @@ vect_enhance_data_refs_alignment (loop_vec_info loop_vinfo)
         {
           int save_misalignment;
 
-	  if (dr == dr0)
+	  /* APPLE LOCAL begin vect interleave */
+	  if (dr == dr0 || vect_dr_group_member_p (dr))
 	    continue;
+	  /* APPLE LOCAL end vect interleave */
 
 	  save_misalignment = DR_MISALIGNMENT (dr);
 	  vect_update_misalignment_for_peel (dr, dr0, npeel);
@@ -1207,8 +1644,10 @@ vect_enhance_data_refs_alignment (loop_vec_info loop_vinfo)
     {
       for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr); i++)
         {
-          if (aligned_access_p (dr))
+	  /* APPLE LOCAL begin vect interleave */
+          if (aligned_access_p (dr) || vect_dr_group_member_p (dr))
             continue;
+	  /* APPLE LOCAL end vect interleave */
 
           supportable_dr_alignment = vect_supportable_dr_alignment (dr);
 
@@ -1318,10 +1757,272 @@ vect_analyze_data_refs_alignment (loop_vec_info loop_vinfo)
 }
 
 
+/* APPLE LOCAL begin vect interleave */
+/* Function vect_analyze_group_access.
+
+   Analyze the data-ref DR, whose step is not its size, as a member of an
+   interleaving group: the data-refs of the loop of the same kind and type
+   that have the same base, offset and step as DR, and that fall within one
+   step from each other.  For example, in
+
+	for (i = 0; i < N; i++)
+	  {
+	    p[i].re = a[i];
+	    p[i].im = b[i];
+	  }
+
+   the two stores to P form a group of size 2.  FORNOW: the step must be
+   2, 4 or 8 times the size of the data-refs, the group of stores must
+   cover the whole step, and the group of loads can only leave out
+   elements at its end if they belong to the same structure as its first
+   member.  Record the group in the stmt_vec_info of its members and
+   return TRUE if it is supported.  */
+
+static bool
+vect_analyze_group_access (struct data_reference *dr)
+{
+  tree stmt = DR_STMT (dr);
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  loop_vec_info loop_vinfo = STMT_VINFO_LOOP_VINFO (stmt_info);
+  VEC (data_reference_p, heap) *datarefs = LOOP_VINFO_DATAREFS (loop_vinfo);
+  VEC (data_reference_p, heap) *group;
+  tree scalar_type = TREE_TYPE (DR_REF (dr));
+  struct data_reference *dr2, *first_dr;
+  HOST_WIDE_INT size, step, count, init, first_init, last_init;
+  unsigned int i, j;
+  bool ok = true;
+
+  /* DR was already analyzed with an earlier member of its group.  */
+  if (STMT_VINFO_STRIDED_ACCESS (stmt_info))
+    return true;
+
+  if (!host_integerp (DR_STEP (dr), 0)
+      || !host_integerp (DR_INIT (dr), 0)
+      || !host_integerp (TYPE_SIZE_UNIT (scalar_type), 1))
+    return false;
+
+  size = tree_low_cst (TYPE_SIZE_UNIT (scalar_type), 1);
+  step = tree_low_cst (DR_STEP (dr), 0);
+  if (size == 0 || step <= 0 || step % size != 0)
+    return false;
+
+  count = step / size;
+  if (count != 2 && count != 4 && count != 8)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "interleaving of " HOST_WIDE_INT_PRINT_DEC
+		 " elements not supported", count);
+      return false;
+    }
+
+  /* Collect the group, sorted by increasing address.  */
+  group = VEC_alloc (data_reference_p, heap, count);
+  for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr2); i++)
+    {
+      if (DR_IS_READ (dr2) != DR_IS_READ (dr)
+	  || TYPE_MAIN_VARIANT (TREE_TYPE (DR_REF (dr2)))
+	     != TYPE_MAIN_VARIANT (scalar_type)
+	  || !tree_int_cst_equal (DR_STEP (dr2), DR_STEP (dr))
+	  || !host_integerp (DR_INIT (dr2), 0)
+	  || !operand_equal_p (DR_BASE_ADDRESS (dr2), DR_BASE_ADDRESS (dr), 0)
+	  || !operand_equal_p (DR_OFFSET (dr2), DR_OFFSET (dr), 0))
+	continue;
+
+      init = tree_low_cst (DR_INIT (dr2), 0);
+      if (init <= tree_low_cst (DR_INIT (dr), 0) - step
+	  || init >= tree_low_cst (DR_INIT (dr), 0) + step)
+	continue;
+
+      for (j = VEC_length (data_reference_p, group); j > 0; j--)
+	if (tree_low_cst (DR_INIT (VEC_index (data_reference_p, group, j - 1)),
+			  0) <= init)
+	  break;
+      VEC_safe_insert (data_reference_p, heap, group, j, dr2);
+    }
+
+  first_dr = VEC_index (data_reference_p, group, 0);
+  first_init = tree_low_cst (DR_INIT (first_dr), 0);
+  last_init = tree_low_cst (DR_INIT (VEC_last (data_reference_p, group)), 0);
+
+  /* Each element of the step must be accessed at most once, and the
+     group must fit in one step.  */
+  if (last_init - first_init >= step)
+    ok = false;
+  for (i = 0; ok && VEC_iterate (data_reference_p, group, i, dr2); i++)
+    {
+      init = tree_low_cst (DR_INIT (dr2), 0);
+      if ((init - first_init) % size != 0
+	  || STMT_VINFO_STRIDED_ACCESS (vinfo_for_stmt (DR_STMT (dr2)))
+	  || (i > 0
+	      && init == tree_low_cst (DR_INIT (VEC_index (data_reference_p,
+							   group, i - 1)), 0)))
+	ok = false;
+    }
+  if (!ok)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "unsupported interleaving: overlapping accesses");
+      VEC_free (data_reference_p, heap, group);
+      return false;
+    }
+
+  /* Stores cannot leave gaps, which would be overwritten.  Loads read the
+     whole step from the first member, which must not go past the last
+     element of the object accessed in the last iteration.  */
+  if (!DR_IS_READ (dr))
+    ok = VEC_length (data_reference_p, group) == (unsigned) count;
+  else if ((last_init - first_init) / size != count - 1)
+    {
+      tree ref = DR_REF (first_dr);
+      tree record;
+
+      ok = false;
+      if (TREE_CODE (ref) == COMPONENT_REF)
+	{
+	  record = TREE_TYPE (TREE_OPERAND (ref, 0));
+	  ok = (integer_zerop (byte_position (TREE_OPERAND (ref, 1)))
+		&& TYPE_SIZE_UNIT (record)
+		&& host_integerp (TYPE_SIZE_UNIT (record), 1)
+		&& tree_low_cst (TYPE_SIZE_UNIT (record), 1) == step);
+	}
+    }
+  if (!ok)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "unsupported interleaving: gaps in group");
+      VEC_free (data_reference_p, heap, group);
+      return false;
+    }
+
+  for (i = 0; VEC_iterate (data_reference_p, group, i, dr2); i++)
+    {
+      stmt_vec_info info = vinfo_for_stmt (DR_STMT (dr2));
+
+      DR_GROUP_FIRST_DR (info) = DR_STMT (first_dr);
+      DR_GROUP_INDEX (info) = (tree_low_cst (DR_INIT (dr2), 0) - first_init)
+			      / size;
+      if (i + 1 < VEC_length (data_reference_p, group))
+	DR_GROUP_NEXT_DR (info)
+	  = DR_STMT (VEC_index (data_reference_p, group, i + 1));
+    }
+  DR_GROUP_SIZE (vinfo_for_stmt (DR_STMT (first_dr))) = count;
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    {
+      fprintf (vect_dump, "Detected interleaving of size "
+	       HOST_WIDE_INT_PRINT_DEC " with %d members: ", count,
+	       VEC_length (data_reference_p, group));
+      print_generic_expr (vect_dump, DR_REF (first_dr), TDF_SLIM);
+    }
+
+  VEC_free (data_reference_p, heap, group);
+  return true;
+}
+
+
+/* Function vect_group_position.
+
+   Return the index in the data-refs of the loop of the data-ref at which
+   the vector access for DR is emitted.  The loads of an interleaving
+   group are all emitted at the first of its loads to be vectorized, and
+   its stores at the last of its stores.  */
+
+static int
+vect_group_position (VEC (data_reference_p, heap) *datarefs,
+		     struct data_reference *dr)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (DR_STMT (dr));
+  struct data_reference *dr2;
+  tree first_stmt = DR_GROUP_FIRST_DR (stmt_info);
+  int i, pos = -1;
+
+  for (i = 0; VEC_iterate (data_reference_p, datarefs, i, dr2); i++)
+    {
+      stmt_vec_info info = vinfo_for_stmt (DR_STMT (dr2));
+
+      if (dr2 == dr && !first_stmt)
+	return i;
+      if (!first_stmt || DR_GROUP_FIRST_DR (info) != first_stmt)
+	continue;
+      if (DR_IS_READ (dr) && STMT_VINFO_RELEVANT_P (info))
+	return i;
+      pos = i;
+    }
+
+  gcc_assert (pos >= 0);
+  return pos;
+}
+
+
+/* Function vect_analyze_group_order.
+
+   Vectorizing an interleaving group moves its accesses to the position
+   of one of them.  Check that this does not reorder two data-refs that
+   depend on each other within an iteration.  */
+
+static bool
+vect_analyze_group_order (loop_vec_info loop_vinfo)
+{
+  struct loop *loop = LOOP_VINFO_LOOP (loop_vinfo);
+  VEC (data_reference_p, heap) *datarefs = LOOP_VINFO_DATAREFS (loop_vinfo);
+  struct data_dependence_relation *ddr;
+  unsigned int i, j;
+
+  for (i = 0; VEC_iterate (ddr_p, LOOP_VINFO_DDRS (loop_vinfo), i, ddr); i++)
+    {
+      struct data_reference *dra = DDR_A (ddr);
+      struct data_reference *drb = DDR_B (ddr);
+      lambda_vector dist_v;
+      unsigned int loop_depth;
+      bool same_iteration = false;
+      int ia, ib;
+
+      if (DDR_ARE_DEPENDENT (ddr) != NULL_TREE
+	  || dra == drb
+	  || (DR_IS_READ (dra) && DR_IS_READ (drb))
+	  || (!STMT_VINFO_STRIDED_ACCESS (vinfo_for_stmt (DR_STMT (dra)))
+	      && !STMT_VINFO_STRIDED_ACCESS (vinfo_for_stmt (DR_STMT (drb)))))
+	continue;
+
+      loop_depth = index_in_loop_nest (loop->num, DDR_LOOP_NEST (ddr));
+      for (j = 0; VEC_iterate (lambda_vector, DDR_DIST_VECTS (ddr), j, dist_v);
+	   j++)
+	if (dist_v[loop_depth] == 0)
+	  same_iteration = true;
+      if (!same_iteration)
+	continue;
+
+      /* The relative order of DRA and DRB must not change.  */
+      for (ia = 0; VEC_index (data_reference_p, datarefs, ia) != dra; ia++)
+	;
+      for (ib = 0; VEC_index (data_reference_p, datarefs, ib) != drb; ib++)
+	;
+      if ((ia < ib)
+	  != (vect_group_position (datarefs, dra)
+	      < vect_group_position (datarefs, drb)))
+	{
+	  if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
+	    {
+	      fprintf (vect_dump, "not vectorized: interleaving reorders "
+		       "dependent accesses ");
+	      print_generic_expr (vect_dump, DR_REF (dra), TDF_SLIM);
+	      fprintf (vect_dump, " and ");
+	      print_generic_expr (vect_dump, DR_REF (drb), TDF_SLIM);
+	    }
+	  return false;
+	}
+    }
+
+  return true;
+}
+/* APPLE LOCAL end vect interleave */
+
+
 /* Function vect_analyze_data_ref_access.
 
    Analyze the access pattern of the data-reference DR. For now, a data access
-   has to be consecutive to be considered vectorizable.  */
+   has to be consecutive to be considered vectorizable, or to belong to an
+   interleaving group.  */
 
 static bool
 vect_analyze_data_ref_access (struct data_reference *dr)
@@ -1331,6 +2032,10 @@ vect_analyze_data_ref_access (struct data_reference *dr)
 
   if (!step || tree_int_cst_compare (step, TYPE_SIZE_UNIT (scalar_type)))
     {
+      /* APPLE LOCAL begin vect interleave */
+      if (step && vect_analyze_group_access (dr))
+	return true;
+      /* APPLE LOCAL end vect interleave */
       if (vect_print_dump_info (REPORT_DETAILS))
 	fprintf (vect_dump, "not consecutive access");
       return false;
@@ -1343,8 +2048,9 @@ vect_analyze_data_ref_access (struct data_reference *dr)
 
    Analyze the access pattern of all the data references in the loop.
 
-   FORNOW: the only access pattern that is considered vectorizable is a
-	   simple step 1 (consecutive) access.
+   FORNOW: the only access patterns that are considered vectorizable are a
+	   simple step 1 (consecutive) access, and interleaved accesses
+	   whose groups can be moved to a single position in the loop.
 
    FORNOW: handle only arrays and pointer accesses.  */
 
@@ -1366,6 +2072,11 @@ vect_analyze_data_ref_accesses (loop_vec_info loop_vinfo)
 	return false;
       }
 
+  /* APPLE LOCAL begin vect interleave */
+  if (!vect_analyze_group_order (loop_vinfo))
+    return false;
+  /* APPLE LOCAL end vect interleave */
+
   return true;
 }
 
@@ -2160,3 +2871,371 @@ vect_analyze_loop (struct loop *loop)
 
   return loop_vinfo;
 }
+
+/* APPLE LOCAL begin vect outer loop */
+/* Function vect_outer_loop_push_def.
+
+   Add to WORKLIST the statement that defines OP, if OP is an SSA name
+   defined in the loop nest LOOP that is not one of its induction
+   variables.  */
+
+static void
+vect_outer_loop_push_def (struct loop *loop, tree op,
+                          VEC (tree, heap) **worklist)
+{
+  tree def_stmt;
+  basic_block bb;
+  affine_iv iv;
+
+  if (TREE_CODE (op) != SSA_NAME || !is_gimple_reg (op))
+    return;
+
+  def_stmt = SSA_NAME_DEF_STMT (op);
+  bb = bb_for_stmt (def_stmt);
+  if (!bb || !flow_bb_inside_loop_p (loop, bb))
+    return;
+
+  if (simple_iv (bb->loop_father, def_stmt, op, &iv, false))
+    return;
+
+  VEC_safe_push (tree, heap, *worklist, def_stmt);
+}
+
+/* Function vect_outer_loop_stmt_supported_p.
+
+   Return true if STMT, which computes a value stored to memory or
+   carried around the outer loop, has a vector form on this target.  */
+
+static bool
+vect_outer_loop_stmt_supported_p (tree stmt)
+{
+  tree lhs, rhs, vectype;
+  enum tree_code code;
+  optab optab;
+
+  if (TREE_CODE (stmt) != MODIFY_EXPR)
+    return false;
+
+  lhs = TREE_OPERAND (stmt, 0);
+  rhs = TREE_OPERAND (stmt, 1);
+  vectype = get_vectype_for_scalar_type (TREE_TYPE (lhs));
+  if (!vectype)
+    return false;
+
+  /* Loads, stores and copies.  */
+  code = TREE_CODE (rhs);
+  if (TREE_CODE (lhs) != SSA_NAME
+      || code == SSA_NAME
+      || REFERENCE_CLASS_P (rhs)
+      || is_gimple_min_invariant (rhs))
+    return true;
+
+  switch (code)
+    {
+    case NOP_EXPR:
+    case CONVERT_EXPR:
+    case FLOAT_EXPR:
+    case FIX_TRUNC_EXPR:
+      return (get_vectype_for_scalar_type (TREE_TYPE (TREE_OPERAND (rhs, 0)))
+              != NULL_TREE);
+
+    case COND_EXPR:
+      return expand_vec_cond_expr_p (rhs, TYPE_MODE (vectype));
+
+    default:
+      break;
+    }
+
+  if (TREE_CODE_CLASS (code) != tcc_unary
+      && TREE_CODE_CLASS (code) != tcc_binary)
+    return false;
+
+  optab = optab_for_tree_code (code, vectype);
+  return (optab
+          && (optab->handlers[(int) TYPE_MODE (vectype)].insn_code
+              != CODE_FOR_nothing));
+}
+
+/* Function vect_outer_loop_stmts_supported_p.
+
+   Check the statements of the loop nest LOOP before its inner loop is
+   unrolled.  LOOP must contain no calls or volatile accesses, and every
+   statement that contributes to a store or to a value carried around
+   LOOP must have a vector form.  Address computations and the induction
+   variables of the nest are left to the data reference checks.  */
+
+static bool
+vect_outer_loop_stmts_supported_p (struct loop *loop)
+{
+  basic_block *bbs = get_loop_body (loop);
+  VEC (tree, heap) *worklist = VEC_alloc (tree, heap, 64);
+  struct pointer_set_t *visited = pointer_set_create ();
+  block_stmt_iterator bsi;
+  ssa_op_iter iter;
+  tree stmt, phi, use;
+  unsigned int i;
+  int j;
+  bool ok = true;
+
+  for (i = 0; ok && i < loop->num_nodes; i++)
+    for (bsi = bsi_start (bbs[i]); !bsi_end_p (bsi); bsi_next (&bsi))
+      {
+        stmt = bsi_stmt (bsi);
+        if (get_call_expr_in (stmt) || stmt_ann (stmt)->has_volatile_ops)
+          {
+            if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+              fprintf (vect_dump, "outer loop: call or volatile access.");
+            ok = false;
+            break;
+          }
+        if (TREE_CODE (stmt) == MODIFY_EXPR
+            && TREE_CODE (TREE_OPERAND (stmt, 0)) != SSA_NAME)
+          VEC_safe_push (tree, heap, worklist, stmt);
+      }
+  free (bbs);
+
+  for (phi = phi_nodes (loop->header); phi; phi = PHI_CHAIN (phi))
+    vect_outer_loop_push_def (loop, PHI_RESULT (phi), &worklist);
+
+  while (ok && VEC_length (tree, worklist) > 0)
+    {
+      stmt = VEC_pop (tree, worklist);
+      if (pointer_set_insert (visited, stmt))
+        continue;
+
+      if (TREE_CODE (stmt) == PHI_NODE)
+        {
+          for (j = 0; j < PHI_NUM_ARGS (stmt); j++)
+            vect_outer_loop_push_def (loop, PHI_ARG_DEF (stmt, j), &worklist);
+          continue;
+        }
+
+      if (!vect_outer_loop_stmt_supported_p (stmt))
+        {
+          if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+            {
+              fprintf (vect_dump, "outer loop: unsupported statement: ");
+              print_generic_expr (vect_dump, stmt, TDF_SLIM);
+            }
+          ok = false;
+          break;
+        }
+
+      /* The operands of a load, and those of the address of a store,
+         only compute an address.  */
+      if (TREE_CODE (TREE_OPERAND (stmt, 0)) != SSA_NAME)
+        vect_outer_loop_push_def (loop, TREE_OPERAND (stmt, 1), &worklist);
+      else if (!REFERENCE_CLASS_P (TREE_OPERAND (stmt, 1)))
+        FOR_EACH_SSA_TREE_OPERAND (use, stmt, iter, SSA_OP_USE)
+          vect_outer_loop_push_def (loop, use, &worklist);
+    }
+
+  VEC_free (tree, heap, worklist);
+  pointer_set_destroy (visited);
+  return ok;
+}
+
+/* Function vect_outer_loop_access_ok_p.
+
+   Return true if the data reference DR of the loop nest LOOP advances by
+   a step in LOOP that vect_analyze_data_ref_access accepts once the inner
+   loop is unrolled: one element, or a supported interleaving.  A step of
+   zero is also accepted, with *INVARIANT set, if loop invariant motion
+   can take DR out of LOOP.  */
+
+static bool
+vect_outer_loop_access_ok_p (struct loop *loop, struct data_reference *dr,
+                             bool *invariant)
+{
+  tree ref = DR_REF (dr);
+  tree access_fn, evolution;
+  HOST_WIDE_INT size, step = 0, count;
+  unsigned int i;
+
+  if (!host_integerp (TYPE_SIZE_UNIT (TREE_TYPE (ref)), 1))
+    return false;
+  size = tree_low_cst (TYPE_SIZE_UNIT (TREE_TYPE (ref)), 1);
+
+  if (DR_TYPE (dr) == POINTER_REF_TYPE)
+    {
+      struct loop *stmt_loop = loop_containing_stmt (DR_STMT (dr));
+
+      access_fn = analyze_scalar_evolution (stmt_loop, TREE_OPERAND (ref, 0));
+      access_fn = instantiate_parameters (loop, access_fn);
+      if (chrec_contains_undetermined (access_fn))
+        return false;
+      evolution = evolution_part_in_loop_num (access_fn, loop->num);
+      if (evolution)
+        {
+          if (!host_integerp (evolution, 0))
+            return false;
+          step = tree_low_cst (evolution, 0);
+        }
+    }
+  else
+    /* The access functions are the indexes of REF from the innermost
+       dimension outwards; scale each by the size of its elements.  */
+    for (i = 0; i < DR_NUM_DIMENSIONS (dr); i++, ref = TREE_OPERAND (ref, 0))
+      {
+        access_fn = DR_ACCESS_FN (dr, i);
+        if (chrec_contains_undetermined (access_fn)
+            || TREE_CODE (ref) != ARRAY_REF
+            || !host_integerp (TYPE_SIZE_UNIT (TREE_TYPE (ref)), 1))
+          return false;
+        evolution = evolution_part_in_loop_num (access_fn, loop->num);
+        if (!evolution)
+          continue;
+        if (!host_integerp (evolution, 0))
+          return false;
+        step += (tree_low_cst (evolution, 0)
+                 * tree_low_cst (TYPE_SIZE_UNIT (TREE_TYPE (ref)), 1));
+      }
+
+  *invariant = (step == 0);
+  if (step == 0 || step == size)
+    return true;
+  if (size == 0 || step < 0 || step % size != 0)
+    return false;
+  count = step / size;
+  return count == 2 || count == 4 || count == 8;
+}
+
+/* Function vect_analyze_outer_loop.
+
+   Check whether LOOP is a doubly nested loop that can be vectorized
+   once its inner loop is completely unrolled.  The inner loop must run
+   a constant number of times, and LOOP must have no control flow apart
+   from its exit and the inner loop.  Since the unrolling cannot be undone,
+   the statements and data references of the nest are checked here the
+   way vect_analyze_loop will check them after unrolling: the operations
+   must have a vector form, and every access must be consecutive,
+   interleaved or invariant in LOOP.  The elements of the vectors are
+   then consecutive iterations of LOOP, and a reduction in the inner
+   loop becomes a chain of ordinary operations in the body of LOOP.
+
+   Dependence analysis of the whole nest rejects LOOP early if it carries
+   a dependence whose distance is smaller than any vectorization factor.
+   Dependences that cannot be analyzed here are left to vect_analyze_loop,
+   which redoes the complete analysis after unrolling.  */
+
+bool
+vect_analyze_outer_loop (struct loop *loop)
+{
+  struct loop *inner = loop->inner;
+  VEC (data_reference_p, heap) *datarefs;
+  VEC (ddr_p, heap) *ddrs;
+  struct data_reference *dr;
+  struct data_dependence_relation *ddr;
+  basic_block *bbs;
+  ssa_op_iter iter;
+  tree niters, vuse;
+  unsigned int i, j;
+  bool ok = true;
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    fprintf (vect_dump, "=== vect_analyze_outer_loop ===");
+
+  if (!inner || inner->next || inner->inner
+      || !loop->single_exit || !inner->single_exit)
+    {
+      if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+        fprintf (vect_dump, "outer loop: unsupported loop nest.");
+      return false;
+    }
+
+  niters = number_of_iterations_in_loop (inner);
+  if (TREE_CODE (niters) != INTEGER_CST
+      || !just_once_each_iteration_p (inner, inner->single_exit->src))
+    {
+      if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+        fprintf (vect_dump, "outer loop: inner loop bound not constant.");
+      return false;
+    }
+
+  bbs = get_loop_body (loop);
+  for (i = 0; i < loop->num_nodes; i++)
+    if (bbs[i]->loop_father == loop
+        && bbs[i] != loop->single_exit->src
+        && EDGE_COUNT (bbs[i]->succs) > 1)
+      ok = false;
+  free (bbs);
+  if (!ok)
+    {
+      if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+        fprintf (vect_dump, "outer loop: control flow in loop.");
+      return false;
+    }
+
+  if (!vect_outer_loop_stmts_supported_p (loop))
+    return false;
+
+  datarefs = VEC_alloc (data_reference_p, heap, 10);
+  ddrs = VEC_alloc (ddr_p, heap, 10 * 10);
+  compute_data_dependences_for_loop (loop, false, &datarefs, &ddrs);
+
+  /* An access that does not vary with LOOP must be a load that no store
+     in the nest clobbers, so that it is hoisted after unrolling.  */
+  for (i = 0; ok && VEC_iterate (data_reference_p, datarefs, i, dr); i++)
+    {
+      bool invariant = false;
+
+      ok = (DR_STMT (dr)
+            && vect_outer_loop_access_ok_p (loop, dr, &invariant)
+            && (!invariant || DR_IS_READ (dr)));
+      if (ok && invariant)
+        FOR_EACH_SSA_TREE_OPERAND (vuse, DR_STMT (dr), iter,
+                                   SSA_OP_VIRTUAL_USES)
+          {
+            basic_block bb = bb_for_stmt (SSA_NAME_DEF_STMT (vuse));
+
+            if (bb && flow_bb_inside_loop_p (loop, bb))
+              ok = false;
+          }
+
+      if (!ok && vect_print_dump_info (REPORT_OUTER_LOOPS))
+        {
+          if (DR_STMT (dr))
+            {
+              fprintf (vect_dump, "outer loop: unsupported access: ");
+              print_generic_expr (vect_dump, DR_REF (dr), TDF_SLIM);
+            }
+          else
+            fprintf (vect_dump, "outer loop: unknown data reference.");
+        }
+    }
+
+  for (i = 0; ok && VEC_iterate (ddr_p, ddrs, i, ddr); i++)
+    {
+      if (DDR_ARE_DEPENDENT (ddr) != NULL_TREE
+          || (DR_IS_READ (DDR_A (ddr)) && DR_IS_READ (DDR_B (ddr))))
+        continue;
+
+      /* The first entry of a distance vector is the distance in LOOP.  */
+      for (j = 0; j < DDR_NUM_DIST_VECTS (ddr); j++)
+        {
+          int dist = DDR_DIST_VECT (ddr, j)[0];
+
+          if (dist != 0 && abs (dist) < UNITS_PER_SIMD_WORD)
+            {
+              if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+                {
+                  fprintf (vect_dump,
+                           "outer loop: dependence distance %d between ",
+                           dist);
+                  print_generic_expr (vect_dump, DR_REF (DDR_A (ddr)),
+                                      TDF_SLIM);
+                  fprintf (vect_dump, " and ");
+                  print_generic_expr (vect_dump, DR_REF (DDR_B (ddr)),
+                                      TDF_SLIM);
+                }
+              ok = false;
+              break;
+            }
+        }
+    }
+
+  free_dependence_relations (ddrs);
+  free_data_refs (datarefs);
+  return ok;
+}
+/* APPLE LOCAL end vect outer loop */
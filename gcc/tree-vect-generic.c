@@ -409,6 +409,14 @@ expand_vector_operations_1 (block_stmt_iterator *bsi)
     return;
   
   gcc_assert (code != CONVERT_EXPR);
+  /* APPLE LOCAL begin vect multiple types */
+  /* For vector unpacking and packing the optab is selected by the type of
+     the arguments, not the type of the result.  */
+  if (code == VEC_UNPACK_HI_EXPR
+      || code == VEC_UNPACK_LO_EXPR
+      || code == VEC_PACK_MOD_EXPR)
+    type = TREE_TYPE (TREE_OPERAND (rhs, 0));
+  /* APPLE LOCAL end vect multiple types */
   op = optab_for_tree_code (code, type);
 
   /* For widening vector operations, the relevant type is of the arguments,
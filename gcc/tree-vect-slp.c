@@ -0,0 +1,1250 @@
+/* APPLE LOCAL file vect slp */
+/* Straight-line (superword level parallelism) vectorization.
+   Copyright (C) 2007 Free Software Foundation, Inc.
+
+This file is part of GCC.
+
+GCC is free software; you can redistribute it and/or modify it under
+the terms of the GNU General Public License as published by the Free
+Software Foundation; either version 2, or (at your option) any later
+version.
+
+GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or
+FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+for more details.
+
+You should have received a copy of the GNU General Public License
+along with GCC; see the file COPYING.  If not, write to the Free
+Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
+02110-1301, USA.  */
+
+/* This pass packs groups of isomorphic scalar statements of a basic block
+   into vector statements.  Each group starts from stores to adjacent
+   memory locations, as many as there are elements in a vector:
+
+	a[0] = b[0] + c[0];		vb = *(v4si *) &b[0];
+	a[1] = b[1] + c[1];	 ==>	vc = *(v4si *) &c[0];
+	a[2] = b[2] + c[2];		*(v4si *) &a[0] = vb + vc;
+	a[3] = b[3] + c[3];
+
+   The values stored by the group are followed through their definitions
+   in the basic block, building a tree of "lanes": a set of statements of
+   the same kind, one per vector element.  A set of loads from adjacent
+   locations becomes a vector load, a set of identical operations becomes a
+   vector operation, and any other set of values is built into a vector
+   from its scalars.  The vector statements are inserted before the last
+   store of the group, which must be possible without reordering dependent
+   memory accesses, and the scalar stores are removed; the scalar
+   computations they used are left to dead code elimination.
+
+   The data-refs are analyzed by create_data_ref, so the basic blocks of
+   loops that the loop vectorizer left alone are handled as well: their
+   adjacent accesses are vectorized within each iteration, which is
+   vectorization with a vectorization factor of 1.  */
+
+#include "config.h"
+#include "system.h"
+#include "coretypes.h"
+#include "tm.h"
+#include "ggc.h"
+#include "tree.h"
+#include "target.h"
+#include "basic-block.h"
+#include "diagnostic.h"
+#include "tree-flow.h"
+#include "tree-dump.h"
+#include "timevar.h"
+#include "cfgloop.h"
+#include "expr.h"
+#include "optabs.h"
+#include "tree-data-ref.h"
+#include "tree-scalar-evolution.h"
+#include "tree-vectorizer.h"
+
+/* The kinds of nodes of an SLP tree.  */
+enum slp_node_kind {
+  /* Values that are not computed by the tree, built into a vector from
+     their scalars.  */
+  slp_external,
+  /* Loads from adjacent memory locations.  */
+  slp_load,
+  /* Identical unary or binary operations.  */
+  slp_operation
+};
+
+/* A node of an SLP tree: one set of scalar values, one per vector
+   element, and the vector that holds them.  */
+typedef struct _slp_node {
+  enum slp_node_kind kind;
+
+  /* The scalar value of each lane.  For loads and operations, the lhs of
+     the statement that computes it.  */
+  tree *lanes;
+
+  /* The operands of an operation.  */
+  struct _slp_node *ops[2];
+
+  /* The data-ref of each lane of a load.  */
+  struct data_reference **drs;
+
+  /* The vector, once it has been generated.  */
+  tree vec_def;
+
+  /* Next node of the instance, for lookup and freeing.  */
+  struct _slp_node *next;
+} *slp_node;
+
+/* A group of adjacent stores and the tree that computes the stored
+   values.  */
+typedef struct _slp_instance {
+  /* The number of lanes, which is the number of vector elements.  */
+  int group_size;
+  tree vectype;
+
+  /* The stores, in lane order, and their data-refs.  */
+  tree *stores;
+  struct data_reference **store_drs;
+
+  /* The last of the stores in the basic block, before which the vector
+     statements are inserted.  */
+  tree last_store;
+
+  /* The tree of the stored values, and all its nodes.  */
+  slp_node root;
+  slp_node nodes;
+
+  /* The statements of the basic block, indexed by their uid.  */
+  VEC (tree, heap) *bb_stmts;
+} *slp_instance;
+
+static slp_node vect_slp_build_node (slp_instance, tree *);
+
+
+/* Function vect_slp_memory_ref.
+
+   Return the memory reference that STMT stores to, or loads from, or
+   NULL_TREE if it does not access memory through a simple assignment.  */
+
+static tree
+vect_slp_memory_ref (tree stmt, bool *is_read)
+{
+  tree lhs, rhs;
+
+  if (TREE_CODE (stmt) != MODIFY_EXPR)
+    return NULL_TREE;
+
+  lhs = TREE_OPERAND (stmt, 0);
+  rhs = TREE_OPERAND (stmt, 1);
+
+  if (TREE_CODE (lhs) == ARRAY_REF
+      || TREE_CODE (lhs) == INDIRECT_REF
+      || TREE_CODE (lhs) == COMPONENT_REF)
+    {
+      *is_read = false;
+      return lhs;
+    }
+
+  if (TREE_CODE (lhs) == SSA_NAME
+      && (TREE_CODE (rhs) == ARRAY_REF
+	  || TREE_CODE (rhs) == INDIRECT_REF
+	  || TREE_CODE (rhs) == COMPONENT_REF))
+    {
+      *is_read = true;
+      return rhs;
+    }
+
+  return NULL_TREE;
+}
+
+
+/* Function vect_slp_create_dr.
+
+   Analyze the memory reference of STMT, which is a scalar load or store of
+   an element of type SCALAR_TYPE.  Return its data-ref, or NULL if it
+   cannot be part of a vector access.  */
+
+static struct data_reference *
+vect_slp_create_dr (tree stmt, tree scalar_type)
+{
+  struct data_reference *dr;
+  bool is_read;
+  tree ref = vect_slp_memory_ref (stmt, &is_read);
+
+  if (!ref
+      || TREE_THIS_VOLATILE (ref)
+      || stmt_ann (stmt)->has_volatile_ops
+      || tree_could_throw_p (stmt)
+      || TYPE_MAIN_VARIANT (TREE_TYPE (ref))
+	 != TYPE_MAIN_VARIANT (scalar_type))
+    return NULL;
+
+  dr = create_data_ref (ref, stmt, is_read, true);
+  if (!dr)
+    return NULL;
+
+  if (!DR_BASE_ADDRESS (dr) || !DR_OFFSET (dr) || !DR_STEP (dr)
+      || !DR_INIT (dr) || TREE_CODE (DR_INIT (dr)) != INTEGER_CST
+      || !DR_MEMTAG (dr))
+    {
+      free_data_ref (dr);
+      return NULL;
+    }
+
+  return dr;
+}
+
+
+/* Function vect_slp_split_base.
+
+   Return the base address of DR, and add to *INIT its constant offset
+   from it.  A base pointer that is computed by adding a constant to
+   another one, as PRE does for the addresses of adjacent elements, is
+   replaced by that pointer.  */
+
+static tree
+vect_slp_split_base (struct data_reference *dr, HOST_WIDE_INT *init)
+{
+  tree base = DR_BASE_ADDRESS (dr);
+
+  *init += tree_low_cst (DR_INIT (dr), 0);
+  while (TREE_CODE (base) == SSA_NAME)
+    {
+      tree def_stmt = SSA_NAME_DEF_STMT (base);
+      tree rhs, cst;
+
+      if (TREE_CODE (def_stmt) != MODIFY_EXPR)
+	break;
+      rhs = TREE_OPERAND (def_stmt, 1);
+      if (TREE_CODE (rhs) != PLUS_EXPR
+	  || TREE_CODE (TREE_OPERAND (rhs, 0)) != SSA_NAME
+	  || TREE_CODE (TREE_OPERAND (rhs, 1)) != INTEGER_CST)
+	break;
+
+      /* Pointer arithmetic subtracts by adding a wrapped-around constant.  */
+      cst = fold_convert (ssizetype, TREE_OPERAND (rhs, 1));
+      if (!host_integerp (cst, 0))
+	break;
+
+      *init += tree_low_cst (cst, 0);
+      base = TREE_OPERAND (rhs, 0);
+    }
+
+  return base;
+}
+
+
+/* Function vect_slp_dr_distance.
+
+   Return TRUE if DRA and DRB access locations a constant number of bytes
+   apart in every execution of the basic block, and set *DIST to the
+   location accessed by DRB minus the location accessed by DRA.  */
+
+static bool
+vect_slp_dr_distance (struct data_reference *dra, struct data_reference *drb,
+		      HOST_WIDE_INT *dist)
+{
+  HOST_WIDE_INT init_a = 0, init_b = 0;
+
+  if (!operand_equal_p (DR_OFFSET (dra), DR_OFFSET (drb), 0)
+      || !operand_equal_p (DR_STEP (dra), DR_STEP (drb), 0)
+      || !host_integerp (DR_INIT (dra), 0)
+      || !host_integerp (DR_INIT (drb), 0)
+      || !operand_equal_p (vect_slp_split_base (dra, &init_a),
+			   vect_slp_split_base (drb, &init_b), 0))
+    return false;
+
+  *dist = init_b - init_a;
+  return true;
+}
+
+
+/* Function vect_slp_adjacent_p.
+
+   Return TRUE if DRB accesses the memory location LANE elements of SIZE
+   bytes after the location accessed by DRA, in every execution of the
+   basic block.  */
+
+static bool
+vect_slp_adjacent_p (struct data_reference *dra, struct data_reference *drb,
+		     int lane, HOST_WIDE_INT size)
+{
+  HOST_WIDE_INT dist;
+
+  return vect_slp_dr_distance (dra, drb, &dist) && dist == lane * size;
+}
+
+
+/* Function vect_slp_free_nodes.
+
+   Free the nodes of the tree of INSTANCE.  */
+
+static void
+vect_slp_free_nodes (slp_instance instance)
+{
+  slp_node node, next;
+  int i;
+
+  for (node = instance->nodes; node; node = next)
+    {
+      next = node->next;
+      if (node->drs)
+	{
+	  for (i = 0; i < instance->group_size; i++)
+	    free_data_ref (node->drs[i]);
+	  free (node->drs);
+	}
+      free (node->lanes);
+      free (node);
+    }
+  instance->nodes = NULL;
+  instance->root = NULL;
+}
+
+
+/* Function vect_slp_new_node.
+
+   Create a node of kind KIND for the values LANES of INSTANCE.  */
+
+static slp_node
+vect_slp_new_node (slp_instance instance, enum slp_node_kind kind,
+		   tree *lanes)
+{
+  slp_node node = XCNEW (struct _slp_node);
+
+  node->kind = kind;
+  node->lanes = XNEWVEC (tree, instance->group_size);
+  memcpy (node->lanes, lanes, instance->group_size * sizeof (tree));
+  node->next = instance->nodes;
+  instance->nodes = node;
+  return node;
+}
+
+
+/* Function vect_slp_build_load.
+
+   The values LANES are all loaded by statements of the basic block.  If
+   they are loaded from adjacent memory locations in lane order, return a
+   load node for them, otherwise return NULL.  */
+
+static slp_node
+vect_slp_build_load (slp_instance instance, tree *lanes)
+{
+  int n = instance->group_size;
+  tree scalar_type = TREE_TYPE (instance->vectype);
+  HOST_WIDE_INT size = tree_low_cst (TYPE_SIZE_UNIT (scalar_type), 1);
+  struct data_reference **drs = XCNEWVEC (struct data_reference *, n);
+  slp_node node;
+  int i;
+
+  for (i = 0; i < n; i++)
+    {
+      drs[i] = vect_slp_create_dr (SSA_NAME_DEF_STMT (lanes[i]),
+				   scalar_type);
+      if (!drs[i]
+	  || !DR_IS_READ (drs[i])
+	  || (i > 0 && !vect_slp_adjacent_p (drs[0], drs[i], i, size)))
+	break;
+    }
+
+  if (i < n)
+    {
+      for (i = 0; i < n; i++)
+	if (drs[i])
+	  free_data_ref (drs[i]);
+      free (drs);
+      return NULL;
+    }
+
+  node = vect_slp_new_node (instance, slp_load, lanes);
+  node->drs = drs;
+  return node;
+}
+
+
+/* Function vect_slp_supported_operation_p.
+
+   Return TRUE if the rhs RHS of a statement computing a value of type
+   SCALAR_TYPE is an operation that can be done on vectors of type VECTYPE
+   with all its operands of that type.  */
+
+static bool
+vect_slp_supported_operation_p (tree rhs, tree scalar_type, tree vectype)
+{
+  enum tree_code code = TREE_CODE (rhs);
+  optab optab;
+  int i;
+
+  if (TREE_CODE_CLASS (code) != tcc_unary
+      && TREE_CODE_CLASS (code) != tcc_binary)
+    return false;
+
+  /* Conversions and shifts by a scalar amount mix types.  */
+  if (code == NOP_EXPR || code == CONVERT_EXPR || code == FLOAT_EXPR
+      || code == FIX_TRUNC_EXPR || code == VIEW_CONVERT_EXPR
+      || code == LSHIFT_EXPR || code == RSHIFT_EXPR
+      || code == LROTATE_EXPR || code == RROTATE_EXPR)
+    return false;
+
+  for (i = 0; i < TREE_CODE_LENGTH (code); i++)
+    if (TYPE_MAIN_VARIANT (TREE_TYPE (TREE_OPERAND (rhs, i)))
+	!= TYPE_MAIN_VARIANT (scalar_type))
+      return false;
+
+  optab = optab_for_tree_code (code, vectype);
+  return (optab
+	  && optab->handlers[(int) TYPE_MODE (vectype)].insn_code
+	     != CODE_FOR_nothing);
+}
+
+
+/* Function vect_slp_build_node.
+
+   Build the node of the tree of INSTANCE that computes the values LANES,
+   one per vector element, and the nodes of their operands.  */
+
+static slp_node
+vect_slp_build_node (slp_instance instance, tree *lanes)
+{
+  int n = instance->group_size;
+  tree scalar_type = TREE_TYPE (instance->vectype);
+  basic_block bb = bb_for_stmt (instance->last_store);
+  tree first_rhs = NULL_TREE;
+  slp_node node;
+  int i, j;
+
+  /* The same values may be used twice, as in x * x.  */
+  for (node = instance->nodes; node; node = node->next)
+    if (!memcmp (node->lanes, lanes, n * sizeof (tree)))
+      return node;
+
+  for (i = 0; i < n; i++)
+    {
+      tree def_stmt, rhs;
+
+      if (TREE_CODE (lanes[i]) != SSA_NAME)
+	break;
+      def_stmt = SSA_NAME_DEF_STMT (lanes[i]);
+      if (TREE_CODE (def_stmt) != MODIFY_EXPR
+	  || bb_for_stmt (def_stmt) != bb
+	  || TYPE_MAIN_VARIANT (TREE_TYPE (lanes[i]))
+	     != TYPE_MAIN_VARIANT (scalar_type))
+	break;
+
+      /* Each lane must compute a different value with the same kind of
+	 rhs.  */
+      for (j = 0; j < i; j++)
+	if (lanes[j] == lanes[i])
+	  break;
+      if (j < i)
+	break;
+
+      rhs = TREE_OPERAND (def_stmt, 1);
+      if (i == 0)
+	first_rhs = rhs;
+      else if (TREE_CODE (rhs) != TREE_CODE (first_rhs))
+	break;
+    }
+
+  if (i == n)
+    {
+      bool is_read;
+
+      if (vect_slp_memory_ref (SSA_NAME_DEF_STMT (lanes[0]), &is_read))
+	{
+	  node = vect_slp_build_load (instance, lanes);
+	  if (node)
+	    return node;
+	}
+      else if (vect_slp_supported_operation_p (first_rhs, scalar_type,
+					       instance->vectype))
+	{
+	  int nops = TREE_CODE_LENGTH (TREE_CODE (first_rhs));
+	  tree *op_lanes = XNEWVEC (tree, n);
+
+	  node = vect_slp_new_node (instance, slp_operation, lanes);
+	  for (j = 0; j < nops; j++)
+	    {
+	      for (i = 0; i < n; i++)
+		op_lanes[i]
+		  = TREE_OPERAND (TREE_OPERAND (SSA_NAME_DEF_STMT (lanes[i]),
+						1), j);
+	      node->ops[j] = vect_slp_build_node (instance, op_lanes);
+	    }
+	  free (op_lanes);
+	  return node;
+	}
+    }
+
+  return vect_slp_new_node (instance, slp_external, lanes);
+}
+
+
+/* Function vect_slp_vops_conflict_p.
+
+   Return TRUE if the statements A and B may access the same memory,
+   according to their virtual operands.  */
+
+static bool
+vect_slp_vops_conflict_p (tree a, tree b)
+{
+  ssa_op_iter iter_a, iter_b;
+  tree op_a, op_b;
+
+  FOR_EACH_SSA_TREE_OPERAND (op_a, a, iter_a,
+			     SSA_OP_VIRTUAL_USES | SSA_OP_VIRTUAL_DEFS)
+    FOR_EACH_SSA_TREE_OPERAND (op_b, b, iter_b,
+			       SSA_OP_VIRTUAL_USES | SSA_OP_VIRTUAL_DEFS)
+      if (SSA_NAME_VAR (op_a) == SSA_NAME_VAR (op_b))
+	return true;
+
+  return false;
+}
+
+
+/* Function vect_slp_independent_p.
+
+   Return TRUE if the statement STMT of the basic block cannot access the
+   memory accessed through the data-ref DR, whose elements are of type
+   SCALAR_TYPE.  */
+
+static bool
+vect_slp_independent_p (tree stmt, struct data_reference *dr,
+			tree scalar_type)
+{
+  struct data_reference *dr2;
+  HOST_WIDE_INT size, size2, dist;
+  bool is_read, independent;
+  tree ref;
+
+  if (!vect_slp_vops_conflict_p (stmt, DR_STMT (dr)))
+    return true;
+
+  /* Both access the same object; see whether the ranges of bytes they
+     access are known to be disjoint.  */
+  ref = vect_slp_memory_ref (stmt, &is_read);
+  if (!ref
+      || !TYPE_SIZE_UNIT (TREE_TYPE (ref))
+      || TREE_CODE (TYPE_SIZE_UNIT (TREE_TYPE (ref))) != INTEGER_CST)
+    return false;
+
+  dr2 = vect_slp_create_dr (stmt, TREE_TYPE (ref));
+  if (!dr2)
+    return false;
+
+  size = tree_low_cst (TYPE_SIZE_UNIT (scalar_type), 1);
+  size2 = tree_low_cst (TYPE_SIZE_UNIT (TREE_TYPE (ref)), 1);
+  independent = (vect_slp_dr_distance (dr, dr2, &dist)
+		 && (dist >= size || -dist >= size2));
+
+  free_data_ref (dr2);
+  return independent;
+}
+
+
+/* Function vect_slp_store_lane_p.
+
+   Return TRUE if STMT is one of the stores of INSTANCE.  */
+
+static bool
+vect_slp_store_lane_p (slp_instance instance, tree stmt)
+{
+  int i;
+
+  for (i = 0; i < instance->group_size; i++)
+    if (instance->stores[i] == stmt)
+      return true;
+
+  return false;
+}
+
+
+/* Function vect_slp_analyze_dependences.
+
+   The vector statements of INSTANCE are executed at its last store: the
+   vector loads are moved down from the first scalar load of each lane,
+   and the stores are moved down to the last one.  Return TRUE if this
+   does not reorder accesses to the same memory.  */
+
+static bool
+vect_slp_analyze_dependences (slp_instance instance)
+{
+  tree scalar_type = TREE_TYPE (instance->vectype);
+  unsigned int last = stmt_ann (instance->last_store)->uid;
+  unsigned int uid;
+  slp_node node;
+  int i;
+
+  /* A store moved down must not pass an access to the same location,
+     except for the other stores of the group.  The loads of the tree are
+     checked below.  */
+  for (i = 0; i < instance->group_size; i++)
+    for (uid = stmt_ann (instance->stores[i])->uid + 1; uid < last; uid++)
+      {
+	tree stmt = VEC_index (tree, instance->bb_stmts, uid);
+
+	if (!vect_slp_store_lane_p (instance, stmt)
+	    && !vect_slp_independent_p (stmt, instance->store_drs[i],
+					scalar_type))
+	  return false;
+      }
+
+  /* A load moved down must not pass a store to the same location.  The
+     stores of the group, all moved below it, must not precede it.  */
+  for (node = instance->nodes; node; node = node->next)
+    {
+      if (node->kind != slp_load)
+	continue;
+
+      for (i = 0; i < instance->group_size; i++)
+	{
+	  tree load = DR_STMT (node->drs[i]);
+	  unsigned int load_uid = stmt_ann (load)->uid;
+	  int j;
+
+	  for (uid = load_uid + 1; uid < last; uid++)
+	    {
+	      tree stmt = VEC_index (tree, instance->bb_stmts, uid);
+
+	      if (!vect_slp_store_lane_p (instance, stmt)
+		  && !ZERO_SSA_OPERANDS (stmt, SSA_OP_VIRTUAL_DEFS)
+		  && !vect_slp_independent_p (stmt, node->drs[i],
+					      scalar_type))
+		return false;
+	    }
+
+	  for (j = 0; j < instance->group_size; j++)
+	    if (stmt_ann (instance->stores[j])->uid < load_uid
+		&& !vect_slp_independent_p (instance->stores[j],
+					    node->drs[i], scalar_type))
+	      return false;
+	}
+    }
+
+  return true;
+}
+
+
+/* Function vect_slp_dr_aligned_p.
+
+   Return TRUE if the vector access of type VECTYPE at the location of DR
+   is known to be aligned, forcing the alignment of the accessed variable
+   if possible when FORCE.  */
+
+static bool
+vect_slp_dr_aligned_p (struct data_reference *dr, tree vectype, bool force)
+{
+  tree base_addr = DR_BASE_ADDRESS (dr);
+  tree base = build_fold_indirect_ref (base_addr);
+  tree alignment = ssize_int (TYPE_ALIGN_UNIT (vectype));
+  tree misalign = DR_OFFSET_MISALIGNMENT (dr);
+  tree aligned_to = DR_ALIGNED_TO (dr);
+
+  if (!misalign
+      || (aligned_to && tree_int_cst_compare (aligned_to, alignment) < 0)
+      || TREE_CODE (DR_STEP (dr)) != INTEGER_CST
+      || !integer_zerop (size_binop (TRUNC_MOD_EXPR,
+				     fold_convert (ssizetype, DR_STEP (dr)),
+				     alignment))
+      || !integer_zerop (size_binop (TRUNC_MOD_EXPR, misalign, alignment)))
+    return false;
+
+  if (DECL_P (base)
+      && tree_int_cst_compare (ssize_int (DECL_ALIGN_UNIT (base)),
+			       alignment) >= 0)
+    return true;
+
+  if (TREE_CODE (base_addr) == SSA_NAME
+      && tree_int_cst_compare (ssize_int (TYPE_ALIGN_UNIT (TREE_TYPE (
+						 TREE_TYPE (base_addr)))),
+			       alignment) >= 0)
+    return true;
+
+  /* Do not change the alignment of global variables if
+     flag_section_anchors is enabled.  */
+  if (!DECL_P (base)
+      || !vect_can_force_dr_alignment_p (base, TYPE_ALIGN (vectype))
+      || (TREE_STATIC (base) && flag_section_anchors))
+    return false;
+
+  if (force)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "force alignment");
+      DECL_ALIGN (base) = TYPE_ALIGN (vectype);
+      DECL_USER_ALIGN (base) = 1;
+    }
+  return true;
+}
+
+
+/* Function vect_slp_access_supported_p.
+
+   Return TRUE if the target can do the vector access of type VECTYPE at
+   the location of DR, whatever its alignment.  */
+
+static bool
+vect_slp_access_supported_p (struct data_reference *dr, tree vectype)
+{
+  return (vect_slp_dr_aligned_p (dr, vectype, false)
+	  || movmisalign_optab->handlers[(int) TYPE_MODE (vectype)].insn_code
+	     != CODE_FOR_nothing);
+}
+
+
+/* Function vect_slp_profitable_p.
+
+   Compare the cost of the scalar statements replaced by INSTANCE with the
+   cost of its vector statements, and return TRUE if the latter is smaller.
+   Also check that every memory access is supported.  */
+
+static bool
+vect_slp_profitable_p (slp_instance instance)
+{
+  int (*cost) (enum vect_cost_for_stmt)
+    = targetm.vectorize.builtin_vectorization_cost;
+  int n = instance->group_size;
+  int scalar_cost, vec_cost;
+  bool vectorizes = false;
+  slp_node node;
+  int i;
+
+  if (!vect_slp_access_supported_p (instance->store_drs[0],
+				    instance->vectype))
+    return false;
+
+  scalar_cost = n * cost (scalar_store);
+  vec_cost = vect_slp_dr_aligned_p (instance->store_drs[0],
+				    instance->vectype, false)
+	     ? cost (vector_store) : cost (unaligned_store);
+
+  for (node = instance->nodes; node; node = node->next)
+    switch (node->kind)
+      {
+      case slp_load:
+	if (!vect_slp_access_supported_p (node->drs[0], instance->vectype))
+	  return false;
+	scalar_cost += n * cost (scalar_load);
+	vec_cost += vect_slp_dr_aligned_p (node->drs[0], instance->vectype,
+					   false)
+		    ? cost (vector_load) : cost (unaligned_load);
+	vectorizes = true;
+	break;
+
+      case slp_operation:
+	scalar_cost += n * cost (scalar_stmt);
+	vec_cost += cost (vector_stmt);
+	vectorizes = true;
+	break;
+
+      case slp_external:
+	for (i = 0; i < n; i++)
+	  if (!CONSTANT_CLASS_P (node->lanes[i]))
+	    break;
+	if (i == n)
+	  {
+	    /* A vector constant.  */
+	    vec_cost += cost (vector_load);
+	    vectorizes = true;
+	  }
+	else
+	  {
+	    for (i = 1; i < n; i++)
+	      if (node->lanes[i] != node->lanes[0])
+		break;
+	    vec_cost += (i == n ? 1 : n) * cost (scalar_to_vec);
+	  }
+	break;
+
+      default:
+	gcc_unreachable ();
+      }
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    fprintf (vect_dump, "SLP cost model: scalar cost = %d, vector cost = %d.",
+	     scalar_cost, vec_cost);
+
+  /* Just building a vector from scalars to store it is not worth while.  */
+  if (!vectorizes)
+    return false;
+
+  return !flag_vect_cost_model || vec_cost < scalar_cost;
+}
+
+
+/* Function vect_slp_new_ssa.
+
+   Insert before BSI a statement that assigns RHS to a new SSA name of
+   type TYPE, whose variable is named after PREFIX, and return the name.  */
+
+static tree
+vect_slp_new_ssa (tree type, const char *prefix, tree rhs,
+		  block_stmt_iterator *bsi)
+{
+  tree var = create_tmp_var (type, prefix);
+  tree stmt, name;
+
+  add_referenced_var (var);
+  stmt = build2 (MODIFY_EXPR, type, var, rhs);
+  name = make_ssa_name (var, stmt);
+  TREE_OPERAND (stmt, 0) = name;
+  bsi_insert_before (bsi, stmt, BSI_SAME_STMT);
+  mark_new_vars_to_rename (stmt);
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    {
+      fprintf (vect_dump, "add new stmt: ");
+      print_generic_expr (vect_dump, stmt, TDF_SLIM);
+    }
+  return name;
+}
+
+
+/* Function vect_slp_vector_ref.
+
+   Return a reference to the vector of type VECTYPE that starts at the
+   location accessed by DR, creating the vector pointer before BSI.  */
+
+static tree
+vect_slp_vector_ref (struct data_reference *dr, tree vectype,
+		     block_stmt_iterator *bsi)
+{
+  tree vect_ptr_type = build_pointer_type (vectype);
+  tree vect_ptr, addr, ptr, tag, stmt;
+
+  addr = force_gimple_operand_bsi (bsi,
+				   build_fold_addr_expr (unshare_expr (
+							   DR_REF (dr))),
+				   true, NULL_TREE);
+
+  /* The vector pointer aliases what the scalar data-ref does.  */
+  vect_ptr = create_tmp_var (vect_ptr_type, "vect_p");
+  add_referenced_var (vect_ptr);
+  tag = DR_MEMTAG (dr);
+  if (!MTAG_P (tag))
+    new_type_alias (vect_ptr, tag, DR_REF (dr));
+  else
+    var_ann (vect_ptr)->symbol_mem_tag = tag;
+  var_ann (vect_ptr)->subvars = DR_SUBVARS (dr);
+
+  stmt = build2 (MODIFY_EXPR, vect_ptr_type, vect_ptr,
+		 fold_convert (vect_ptr_type, addr));
+  ptr = make_ssa_name (vect_ptr, stmt);
+  TREE_OPERAND (stmt, 0) = ptr;
+  bsi_insert_before (bsi, stmt, BSI_SAME_STMT);
+  if (DR_PTR_INFO (dr))
+    duplicate_ssa_name_ptr_info (ptr, DR_PTR_INFO (dr));
+
+  if (vect_slp_dr_aligned_p (dr, vectype, true))
+    return build_fold_indirect_ref (ptr);
+
+  return build2 (MISALIGNED_INDIRECT_REF, vectype, ptr, size_zero_node);
+}
+
+
+/* Function vect_slp_transform_node.
+
+   Generate the vector statements of NODE of INSTANCE and its operands
+   before BSI, and return the vector it computes.  */
+
+static tree
+vect_slp_transform_node (slp_instance instance, slp_node node,
+			 block_stmt_iterator *bsi)
+{
+  tree vectype = instance->vectype;
+  tree scalar_type = TREE_TYPE (vectype);
+  tree list = NULL_TREE;
+  int n = instance->group_size;
+  int i;
+
+  if (node->vec_def)
+    return node->vec_def;
+
+  switch (node->kind)
+    {
+    case slp_load:
+      node->vec_def
+	= vect_slp_new_ssa (vectype, "vect_",
+			    vect_slp_vector_ref (node->drs[0], vectype, bsi),
+			    bsi);
+      break;
+
+    case slp_operation:
+      {
+	tree rhs = TREE_OPERAND (SSA_NAME_DEF_STMT (node->lanes[0]), 1);
+	enum tree_code code = TREE_CODE (rhs);
+	tree op0 = vect_slp_transform_node (instance, node->ops[0], bsi);
+
+	if (TREE_CODE_CLASS (code) == tcc_binary)
+	  rhs = build2 (code, vectype, op0,
+			vect_slp_transform_node (instance, node->ops[1], bsi));
+	else
+	  rhs = build1 (code, vectype, op0);
+	node->vec_def = vect_slp_new_ssa (vectype, "vect_", rhs, bsi);
+	break;
+      }
+
+    case slp_external:
+      {
+	bool constant_p = true;
+
+	for (i = n - 1; i >= 0; i--)
+	  {
+	    tree op = node->lanes[i];
+
+	    if (CONSTANT_CLASS_P (op))
+	      op = fold_convert (scalar_type, op);
+	    else
+	      constant_p = false;
+	    list = tree_cons (NULL_TREE, op, list);
+	  }
+
+	node->vec_def
+	  = vect_slp_new_ssa (vectype, "vect_cst_",
+			      constant_p
+			      ? build_vector (vectype, list)
+			      : build_constructor_from_list (vectype, list),
+			      bsi);
+	break;
+      }
+
+    default:
+      gcc_unreachable ();
+    }
+
+  return node->vec_def;
+}
+
+
+/* Function vect_slp_transform_instance.
+
+   Replace the stores of INSTANCE by a vector store of the vector computed
+   by its tree.  */
+
+static void
+vect_slp_transform_instance (slp_instance instance)
+{
+  block_stmt_iterator bsi = bsi_for_stmt (instance->last_store);
+  tree vec, ref, stmt, op;
+  ssa_op_iter iter;
+  int i;
+
+  vec = vect_slp_transform_node (instance, instance->root, &bsi);
+  ref = vect_slp_vector_ref (instance->store_drs[0], instance->vectype, &bsi);
+
+  stmt = build2 (MODIFY_EXPR, instance->vectype, ref, vec);
+  bsi_insert_before (&bsi, stmt, BSI_SAME_STMT);
+  mark_new_vars_to_rename (stmt);
+  if (vect_print_dump_info (REPORT_DETAILS))
+    {
+      fprintf (vect_dump, "add new stmt: ");
+      print_generic_expr (vect_dump, stmt, TDF_SLIM);
+    }
+#ifdef USE_MAPPED_LOCATION
+  SET_EXPR_LOCATION (stmt, EXPR_LOCATION (instance->last_store));
+#else
+  SET_EXPR_LOCUS (stmt, EXPR_LOCUS (instance->last_store));
+#endif
+
+  /* The memory the scalar stores defined is now defined by the vector
+     store; their virtual definitions are renamed.  */
+  for (i = 0; i < instance->group_size; i++)
+    {
+      tree store = instance->stores[i];
+
+      FOR_EACH_SSA_TREE_OPERAND (op, store, iter, SSA_OP_ALL_VIRTUALS)
+	mark_sym_for_renaming (SSA_NAME_VAR (op));
+      bsi = bsi_for_stmt (store);
+      bsi_remove (&bsi, true);
+    }
+}
+
+
+/* Function vect_slp_number_stmts.
+
+   Number the statements of BB in order, and record them in STMTS.  */
+
+static void
+vect_slp_number_stmts (basic_block bb, VEC (tree, heap) **stmts)
+{
+  block_stmt_iterator si;
+
+  VEC_truncate (tree, *stmts, 0);
+  for (si = bsi_start (bb); !bsi_end_p (si); bsi_next (&si))
+    {
+      stmt_ann (bsi_stmt (si))->uid = VEC_length (tree, *stmts);
+      VEC_safe_push (tree, heap, *stmts, bsi_stmt (si));
+    }
+}
+
+
+/* Function vect_slp_collect_stores.
+
+   Record in STORE_DRS the data-refs of the stores of the statements
+   BB_STMTS that may be lanes of a group: stores of a scalar that can be a
+   vector element.  */
+
+static void
+vect_slp_collect_stores (VEC (tree, heap) *bb_stmts,
+			 VEC (data_reference_p, heap) **store_drs)
+{
+  unsigned int uid;
+  tree stmt;
+
+  for (uid = 0; VEC_iterate (tree, bb_stmts, uid, stmt); uid++)
+    {
+      struct data_reference *dr;
+      tree scalar_type;
+      bool is_read;
+
+      if (!vect_slp_memory_ref (stmt, &is_read) || is_read)
+	continue;
+
+      scalar_type = TREE_TYPE (TREE_OPERAND (stmt, 0));
+      if (!INTEGRAL_TYPE_P (scalar_type) && !SCALAR_FLOAT_TYPE_P (scalar_type))
+	continue;
+
+      dr = vect_slp_create_dr (stmt, scalar_type);
+      if (dr)
+	VEC_safe_push (data_reference_p, heap, *store_drs, dr);
+    }
+}
+
+
+/* Function vect_slp_free_stores.
+
+   Free the data-refs STORE_DRS, and empty it.  */
+
+static void
+vect_slp_free_stores (VEC (data_reference_p, heap) *store_drs)
+{
+  struct data_reference *dr;
+  unsigned int i;
+
+  for (i = 0; VEC_iterate (data_reference_p, store_drs, i, dr); i++)
+    free_data_ref (dr);
+  VEC_truncate (data_reference_p, store_drs, 0);
+}
+
+
+/* Function vect_slp_free_instance.  */
+
+static void
+vect_slp_free_instance (slp_instance instance)
+{
+  vect_slp_free_nodes (instance);
+  free (instance->store_drs);
+  free (instance->stores);
+  free (instance);
+}
+
+
+/* Function vect_slp_analyze_group.
+
+   Try to build an instance of type VECTYPE whose stores are the store of
+   DR0, for the first lane, and the stores of STORE_DRS to the following
+   memory locations.  Return it if it can and should be vectorized,
+   otherwise return NULL.  */
+
+static slp_instance
+vect_slp_analyze_group (struct data_reference *dr0, tree vectype,
+			VEC (data_reference_p, heap) *store_drs,
+			VEC (tree, heap) *bb_stmts)
+{
+  tree scalar_type = TREE_TYPE (vectype);
+  HOST_WIDE_INT size = tree_low_cst (TYPE_SIZE_UNIT (scalar_type), 1);
+  int n = TYPE_VECTOR_SUBPARTS (vectype);
+  struct data_reference *dr;
+  slp_instance instance;
+  tree *values;
+  unsigned int j;
+  int i;
+
+  instance = XCNEW (struct _slp_instance);
+  instance->group_size = n;
+  instance->vectype = vectype;
+  instance->bb_stmts = bb_stmts;
+  instance->stores = XCNEWVEC (tree, n);
+  instance->store_drs = XCNEWVEC (struct data_reference *, n);
+  instance->stores[0] = DR_STMT (dr0);
+  instance->store_drs[0] = dr0;
+  instance->last_store = DR_STMT (dr0);
+
+  /* Find the stores of the other lanes.  */
+  for (j = 0; VEC_iterate (data_reference_p, store_drs, j, dr); j++)
+    {
+      if (dr == dr0
+	  || TYPE_MAIN_VARIANT (TREE_TYPE (DR_REF (dr)))
+	     != TYPE_MAIN_VARIANT (scalar_type))
+	continue;
+
+      for (i = 1; i < n; i++)
+	if (!instance->stores[i] && vect_slp_adjacent_p (dr0, dr, i, size))
+	  break;
+      if (i == n)
+	continue;
+
+      instance->stores[i] = DR_STMT (dr);
+      instance->store_drs[i] = dr;
+      if (stmt_ann (DR_STMT (dr))->uid
+	  > stmt_ann (instance->last_store)->uid)
+	instance->last_store = DR_STMT (dr);
+    }
+
+  for (i = 0; i < n; i++)
+    if (!instance->stores[i])
+      break;
+
+  if (i == n)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	{
+	  fprintf (vect_dump, "SLP group of stores starting with: ");
+	  print_generic_expr (vect_dump, DR_STMT (dr0), TDF_SLIM);
+	}
+
+      values = XNEWVEC (tree, n);
+      for (i = 0; i < n; i++)
+	values[i] = TREE_OPERAND (instance->stores[i], 1);
+      instance->root = vect_slp_build_node (instance, values);
+      free (values);
+
+      if (!vect_slp_profitable_p (instance))
+	{
+	  if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
+	    fprintf (vect_dump, "not vectorized: SLP group is not "
+		     "profitable or not supported.");
+	}
+      else if (!vect_slp_analyze_dependences (instance))
+	{
+	  if (vect_print_dump_info (REPORT_UNVECTORIZED_LOOPS))
+	    fprintf (vect_dump, "not vectorized: SLP group would reorder "
+		     "dependent accesses.");
+	}
+      else
+	return instance;
+    }
+
+  vect_slp_free_instance (instance);
+  return NULL;
+}
+
+
+/* Function vect_slp_transform_bb.
+
+   Vectorize the groups of stores of BB.  Return the number of groups
+   vectorized.  */
+
+static unsigned int
+vect_slp_transform_bb (basic_block bb)
+{
+  VEC (tree, heap) *bb_stmts = VEC_alloc (tree, heap, 32);
+  VEC (data_reference_p, heap) *store_drs = NULL;
+  tree scalar_type = NULL_TREE, vectype = NULL_TREE;
+  unsigned int num_vectorized = 0;
+  struct data_reference *dr;
+  unsigned int i;
+
+  vect_slp_number_stmts (bb, &bb_stmts);
+  vect_slp_collect_stores (bb_stmts, &store_drs);
+
+  i = 0;
+  while (VEC_iterate (data_reference_p, store_drs, i, dr))
+    {
+      tree stmt = DR_STMT (dr);
+      slp_instance instance;
+
+      /* Building a vector type is not free; most stores of a basic block
+	 have the same type.  */
+      if (TYPE_MAIN_VARIANT (TREE_TYPE (DR_REF (dr))) != scalar_type)
+	{
+	  scalar_type = TYPE_MAIN_VARIANT (TREE_TYPE (DR_REF (dr)));
+	  vectype = get_vectype_for_scalar_type (scalar_type);
+	  if (vectype && !VECTOR_MODE_P (TYPE_MODE (vectype)))
+	    vectype = NULL_TREE;
+	}
+      if (!vectype)
+	{
+	  i++;
+	  continue;
+	}
+
+      vect_loop_location = EXPR_HAS_LOCATION (stmt)
+			   ? EXPR_LOC (stmt) : UNKNOWN_LOC;
+      instance = vect_slp_analyze_group (dr, vectype, store_drs, bb_stmts);
+      if (!instance)
+	{
+	  i++;
+	  continue;
+	}
+
+      vect_slp_transform_instance (instance);
+      vect_slp_free_instance (instance);
+      update_ssa (TODO_update_ssa);
+
+      if (vect_print_dump_info (REPORT_VECTORIZED_LOOPS))
+	fprintf (vect_dump, "basic block vectorized using SLP.");
+      num_vectorized++;
+
+      /* The statements changed; start over.  The vector store is not a
+	 candidate, so groups that were vectorized are not found again.  */
+      vect_slp_free_stores (store_drs);
+      vect_slp_number_stmts (bb, &bb_stmts);
+      vect_slp_collect_stores (bb_stmts, &store_drs);
+      i = 0;
+    }
+
+  vect_slp_free_stores (store_drs);
+  VEC_free (data_reference_p, heap, store_drs);
+  VEC_free (tree, heap, bb_stmts);
+  return num_vectorized;
+}
+
+
+/* Function vect_slp_transform_bbs.
+
+   Entry point to straight-line vectorization: vectorize the groups of
+   adjacent stores of all the basic blocks of the function.  LOOPS are the
+   loops of the function, or NULL if it has none.  */
+
+void
+vect_slp_transform_bbs (struct loops *loops)
+{
+  unsigned int num_vectorized = 0;
+  basic_block bb;
+
+  vect_set_dump_settings ();
+
+  /* The analysis of data-refs needs the loop tree, even when it is just
+     the root of the function body.  */
+  if (!loops)
+    {
+      loops = XCNEW (struct loops);
+      flow_loops_find (loops);
+      scev_initialize (loops);
+    }
+
+  FOR_EACH_BB (bb)
+    num_vectorized += vect_slp_transform_bb (bb);
+
+  vect_loop_location = UNKNOWN_LOC;
+
+  /* Do not leave the evolutions computed for the analysis to the loop
+     optimizations that follow.  */
+  if (loops != current_loops)
+    {
+      scev_finalize ();
+      loop_optimizer_finalize (loops);
+    }
+  else
+    scev_reset ();
+
+  if (num_vectorized)
+    {
+      /* APPLE LOCAL 4095567 */
+      DECL_STRUCT_FUNCTION (current_function_decl)->uses_vector = 1;
+      if (vect_print_dump_info (REPORT_VECTORIZED_LOOPS))
+	fprintf (vect_dump, "vectorized %u store groups in function (SLP).\n",
+		 num_vectorized);
+    }
+}
@@ -61,6 +61,15 @@ static bool vect_is_simple_cond (tree, loop_vec_info);
 static void update_vuses_to_preheader (tree, struct loop*);
 static void vect_create_epilog_for_reduction (tree, tree, enum tree_code, tree);
 static tree get_initial_def_for_reduction (tree, tree, tree *);
+/* APPLE LOCAL begin vect multiple types */
+static tree vect_get_vec_def_for_copy (tree, tree, int, loop_vec_info);
+static void vect_record_stmt_copy (tree, tree);
+static tree vect_double_or_half_vectype (tree, bool, bool);
+static tree vect_gen_conversion (enum tree_code, tree, tree, tree, tree,
+				 block_stmt_iterator *);
+static bool vect_conversion_supported_p (tree, tree);
+static tree vect_analyze_conversion (tree, bool);
+/* APPLE LOCAL end vect multiple types */
 
 /* Utility function dealing with loop peeling (not peeling itself).  */
 static void vect_generate_tmps_on_preheader 
@@ -345,11 +354,29 @@ vect_create_data_ref_ptr (tree stmt,
       tree indx_before_incr, indx_after_incr;
       tree incr;
 
+      /* APPLE LOCAL begin vect interleave */
+      tree step = TYPE_SIZE_UNIT (vectype);
+
+      /* The members of an interleaving group are accessed through the
+	 pointer of its first data-ref, which advances over the whole
+	 group.  */
+      if (STMT_VINFO_STRIDED_ACCESS (stmt_info))
+	step = size_binop (MULT_EXPR, step,
+			   size_int (DR_GROUP_SIZE (vinfo_for_stmt (
+					DR_GROUP_FIRST_DR (stmt_info)))));
+      /* APPLE LOCAL begin vect multiple types */
+      /* A data-ref accessed by several vectors in each iteration of the
+	 vectorized loop advances over all of them.  */
+      else
+	step = size_binop (MULT_EXPR, step,
+			   size_int (vect_get_ncopies (stmt_info)));
+      /* APPLE LOCAL end vect multiple types */
+
       standard_iv_increment_position (loop, &incr_bsi, &insert_after);
-      create_iv (vect_ptr_init,
-		 fold_convert (vect_ptr_type, TYPE_SIZE_UNIT (vectype)),
+      create_iv (vect_ptr_init, fold_convert (vect_ptr_type, step),
 		 NULL_TREE, loop, &incr_bsi, insert_after,
 		 &indx_before_incr, &indx_after_incr);
+      /* APPLE LOCAL end vect interleave */
       incr = bsi_stmt (incr_bsi);
       set_stmt_info (stmt_ann (incr),
 		     new_stmt_vec_info (incr, loop_vinfo));
@@ -568,6 +595,63 @@ vect_get_vec_def_for_operand (tree op, tree stmt, tree *scalar_def)
 }
 
 
+/* APPLE LOCAL begin vect multiple types */
+/* Function vect_get_vec_def_for_copy.
+
+   OP is an operand of a stmt that is vectorized by several vector stmts,
+   and VEC_OPRND is the vector def of OP used in the first of them, as
+   returned by vect_get_vec_def_for_operand.  Return the vector def of OP
+   to use in the vector stmt number COPY.  If OP is defined in the loop,
+   this is the def of the vector stmt number COPY of its defining stmt;
+   otherwise VEC_OPRND itself can be used again.  */
+
+static tree
+vect_get_vec_def_for_copy (tree op, tree vec_oprnd, int copy,
+			   loop_vec_info loop_vinfo)
+{
+  tree def_stmt, def;
+  enum vect_def_type dt;
+  stmt_vec_info def_stmt_info;
+  bool is_simple_use;
+
+  if (copy == 0)
+    return vec_oprnd;
+
+  is_simple_use = vect_is_simple_use (op, loop_vinfo, &def_stmt, &def, &dt);
+  gcc_assert (is_simple_use);
+  if (dt != vect_loop_def)
+    return vec_oprnd;
+
+  /* The copies of a stmt replaced by a pattern are recorded in the
+     pattern stmt.  */
+  def_stmt_info = vinfo_for_stmt (def_stmt);
+  if (STMT_VINFO_IN_PATTERN_P (def_stmt_info))
+    def_stmt_info = vinfo_for_stmt (STMT_VINFO_RELATED_STMT (def_stmt_info));
+
+  gcc_assert ((unsigned) copy
+	      < VEC_length (tree, STMT_VINFO_VEC_STMTS (def_stmt_info)));
+  return TREE_OPERAND (VEC_index (tree, STMT_VINFO_VEC_STMTS (def_stmt_info),
+				  copy), 0);
+}
+
+
+/* Function vect_record_stmt_copy.
+
+   Record VEC_STMT as the next of the vector stmts that vectorize STMT, for
+   the uses of STMT in stmts that are vectorized by several vector stmts
+   as well.  */
+
+static void
+vect_record_stmt_copy (tree stmt, tree vec_stmt)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+
+  if (vect_get_ncopies (stmt_info) > 1)
+    VEC_safe_push (tree, heap, STMT_VINFO_VEC_STMTS (stmt_info), vec_stmt);
+}
+/* APPLE LOCAL end vect multiple types */
+
+
 /* Function vect_finish_stmt_generation.
 
    Insert a new stmt.  */
@@ -1169,6 +1253,16 @@ vectorizable_reduction (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   if (STMT_VINFO_DEF_TYPE (stmt_info) != vect_reduction_def)
     return false;
 
+  /* APPLE LOCAL begin vect multiple types */
+  /* FORNOW: the reduction is computed in a single vector.  */
+  if (vect_get_ncopies (stmt_info) > 1)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "multiple types in reduction.");
+      return false;
+    }
+  /* APPLE LOCAL end vect multiple types */
+
   /* 2. Has this been recognized as a reduction pattern? 
 
      Check if STMT represents a pattern that has been recognized
@@ -1368,8 +1462,12 @@ vectorizable_reduction (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
 /* Function vectorizable_assignment.
 
    Check if STMT performs an assignment (copy) that can be vectorized. 
-   If VEC_STMT is also passed, vectorize the STMT: create a vectorized 
-   stmt to replace it, put it in VEC_STMT, and insert it at BSI.
+   APPLE LOCAL begin vect multiple types
+   A conversion between integer types of the same size is a copy as well.
+   If VEC_STMT is also passed, vectorize the STMT: create the vectorized 
+   stmts to replace it, put the first of them in VEC_STMT, and insert them
+   at BSI.
+   APPLE LOCAL end vect multiple types
    Return FALSE if not a vectorizable STMT, TRUE otherwise.  */
 
 bool
@@ -1385,6 +1483,12 @@ vectorizable_assignment (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   tree new_temp;
   tree def, def_stmt;
   enum vect_def_type dt;
+  /* APPLE LOCAL begin vect multiple types */
+  int ncopies = vect_get_ncopies (stmt_info);
+  bool is_conversion = false;
+  tree vec_oprnd0 = NULL_TREE, new_stmt, rhs;
+  int j;
+  /* APPLE LOCAL end vect multiple types */
 
   /* Is vectorizable assignment?  */
   if (!STMT_VINFO_RELEVANT_P (stmt_info))
@@ -1400,6 +1504,25 @@ vectorizable_assignment (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
     return false;
 
   op = TREE_OPERAND (stmt, 1);
+  /* APPLE LOCAL begin vect multiple types */
+  if (TREE_CODE (op) == NOP_EXPR || TREE_CODE (op) == CONVERT_EXPR)
+    {
+      tree type_in = TREE_TYPE (TREE_OPERAND (op, 0));
+      tree type_out = TREE_TYPE (scalar_dest);
+
+      /* Only a conversion that leaves the bits of the value unchanged can
+	 be vectorized as a copy.  */
+      if (!INTEGRAL_TYPE_P (type_in)
+	  || !INTEGRAL_TYPE_P (type_out)
+	  || TYPE_MODE (type_in) != TYPE_MODE (type_out)
+	  || TYPE_PRECISION (type_in) != GET_MODE_BITSIZE (TYPE_MODE (type_in))
+	  || TYPE_PRECISION (type_out)
+	     != GET_MODE_BITSIZE (TYPE_MODE (type_out)))
+	return false;
+      op = TREE_OPERAND (op, 0);
+      is_conversion = true;
+    }
+  /* APPLE LOCAL end vect multiple types */
   if (!vect_is_simple_use (op, loop_vinfo, &def_stmt, &def, &dt))
     {
       if (vect_print_dump_info (REPORT_DETAILS))
@@ -1407,6 +1530,13 @@ vectorizable_assignment (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
       return false;
     }
 
+  /* APPLE LOCAL begin vect multiple types */
+  /* FORNOW: the vector defs of a constant or invariant operand would be
+     built in the type of the result.  */
+  if (is_conversion && dt != vect_loop_def)
+    return false;
+  /* APPLE LOCAL end vect multiple types */
+
   if (!vec_stmt) /* transformation not required.  */
     {
       STMT_VINFO_TYPE (stmt_info) = assignment_vec_info_type;
@@ -1420,15 +1550,28 @@ vectorizable_assignment (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   /* Handle def.  */
   vec_dest = vect_create_destination_var (scalar_dest, vectype);
 
-  /* Handle use.  */
-  op = TREE_OPERAND (stmt, 1);
-  vec_oprnd = vect_get_vec_def_for_operand (op, stmt, NULL);
-
-  /* Arguments are ready. create the new vector stmt.  */
-  *vec_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, vec_oprnd);
-  new_temp = make_ssa_name (vec_dest, *vec_stmt);
-  TREE_OPERAND (*vec_stmt, 0) = new_temp;
-  vect_finish_stmt_generation (stmt, *vec_stmt, bsi);
+  /* APPLE LOCAL begin vect multiple types */
+  *vec_stmt = NULL_TREE;
+  for (j = 0; j < ncopies; j++)
+    {
+      /* Handle use.  */
+      if (j == 0)
+	vec_oprnd0 = vect_get_vec_def_for_operand (op, stmt, NULL);
+      vec_oprnd = vect_get_vec_def_for_copy (op, vec_oprnd0, j, loop_vinfo);
+
+      /* Arguments are ready. create the new vector stmt.  */
+      rhs = vec_oprnd;
+      if (is_conversion)
+	rhs = build1 (VIEW_CONVERT_EXPR, vectype, vec_oprnd);
+      new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, rhs);
+      new_temp = make_ssa_name (vec_dest, new_stmt);
+      TREE_OPERAND (new_stmt, 0) = new_temp;
+      vect_finish_stmt_generation (stmt, new_stmt, bsi);
+      vect_record_stmt_copy (stmt, new_stmt);
+      if (j == 0)
+	*vec_stmt = new_stmt;
+    }
+  /* APPLE LOCAL end vect multiple types */
   
   return true;
 }
@@ -1465,7 +1608,10 @@ vect_min_worthwhile_factor (enum tree_code code)
 
    Check if STMT performs a binary or unary operation that can be vectorized. 
    If VEC_STMT is also passed, vectorize the STMT: create a vectorized 
-   stmt to replace it, put it in VEC_STMT, and insert it at BSI.
+   APPLE LOCAL begin vect multiple types
+   stmt for each of its copies, put the first in VEC_STMT, and insert them
+   at BSI.
+   APPLE LOCAL end vect multiple types
    Return FALSE if not a vectorizable STMT, TRUE otherwise.  */
 
 bool
@@ -1490,6 +1636,13 @@ vectorizable_operation (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   enum machine_mode optab_op2_mode;
   tree def, def_stmt;
   enum vect_def_type dt;
+  /* APPLE LOCAL begin vect multiple types */
+  int ncopies = vect_get_ncopies (stmt_info);
+  tree vec_oprnd0_first = NULL_TREE, vec_oprnd1_first = NULL_TREE;
+  bool scalar_shift_arg = false;
+  tree new_stmt;
+  int j;
+  /* APPLE LOCAL end vect multiple types */
 
   /* Is STMT a vectorizable binary/unary operation?   */
   if (!STMT_VINFO_RELEVANT_P (stmt_info))
@@ -1533,6 +1686,19 @@ vectorizable_operation (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
 	    fprintf (vect_dump, "use not simple.");
 	  return false;
 	}	
+      /* APPLE LOCAL begin vect multiple types */
+      /* The vector defs of an operand defined in the loop have the vector
+	 type of its def stmt, so it must hold as many elements as the
+	 vector type of STMT.  */
+      if (dt == vect_loop_def
+	  && GET_MODE_SIZE (TYPE_MODE (TREE_TYPE (op)))
+	     != GET_MODE_SIZE (TYPE_MODE (TREE_TYPE (TREE_OPERAND (stmt, 0)))))
+	{
+	  if (vect_print_dump_info (REPORT_DETAILS))
+	    fprintf (vect_dump, "operand of different size.");
+	  return false;
+	}
+      /* APPLE LOCAL end vect multiple types */
     } 
 
   /* Supportable by target?  */
@@ -1600,48 +1766,656 @@ vectorizable_operation (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   scalar_dest = TREE_OPERAND (stmt, 0);
   vec_dest = vect_create_destination_var (scalar_dest, vectype);
 
-  /* Handle uses.  */
+  /* APPLE LOCAL begin vect multiple types */
+  *vec_stmt = NULL_TREE;
+  for (j = 0; j < ncopies; j++)
+    {
+      /* Handle uses.  */
+      op0 = TREE_OPERAND (operation, 0);
+      if (j == 0)
+	vec_oprnd0_first = vect_get_vec_def_for_operand (op0, stmt, NULL);
+      vec_oprnd0 = vect_get_vec_def_for_copy (op0, vec_oprnd0_first, j,
+					      loop_vinfo);
+
+      if (op_type == binary_op)
+	{
+	  op1 = TREE_OPERAND (operation, 1);
+
+	  if (j == 0 && (code == LSHIFT_EXPR || code == RSHIFT_EXPR))
+	    {
+	      /* Vector shl and shr insn patterns can be defined with
+		 scalar operand 2 (shift operand).  In this case, use
+		 constant or loop invariant op1 directly, without
+		 extending it to vector mode first.  */
+
+	      optab_op2_mode = insn_data[icode].operand[2].mode;
+	      if (!VECTOR_MODE_P (optab_op2_mode))
+		{
+		  if (vect_print_dump_info (REPORT_DETAILS))
+		    fprintf (vect_dump, "operand 1 using scalar mode.");
+		  scalar_shift_arg = true;
+		}
+	    }
+
+	  if (scalar_shift_arg)
+	    vec_oprnd1 = op1;
+	  else
+	    {
+	      if (j == 0)
+		vec_oprnd1_first = vect_get_vec_def_for_operand (op1, stmt,
+								 NULL);
+	      vec_oprnd1 = vect_get_vec_def_for_copy (op1, vec_oprnd1_first,
+						      j, loop_vinfo);
+	    }
+	}
+
+      /* Arguments are ready. create the new vector stmt.  */
+
+      if (op_type == binary_op)
+	new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest,
+			   build2 (code, vectype, vec_oprnd0, vec_oprnd1));
+      else
+	new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest,
+			   build1 (code, vectype, vec_oprnd0));
+      new_temp = make_ssa_name (vec_dest, new_stmt);
+      TREE_OPERAND (new_stmt, 0) = new_temp;
+      vect_finish_stmt_generation (stmt, new_stmt, bsi);
+      vect_record_stmt_copy (stmt, new_stmt);
+      if (j == 0)
+	*vec_stmt = new_stmt;
+    }
+  /* APPLE LOCAL end vect multiple types */
+
+  return true;
+}
+
+
+/* APPLE LOCAL begin vect multiple types */
+/* Function vect_double_or_half_vectype.
+
+   Return the vector type whose elements are integers twice as wide (if
+   WIDEN) or half as wide as those of VECTYPE, with the signedness given by
+   UNSIGNEDP, or NULL_TREE if there is no such type.  */
+
+static tree
+vect_double_or_half_vectype (tree vectype, bool widen, bool unsignedp)
+{
+  int bits = GET_MODE_BITSIZE (TYPE_MODE (TREE_TYPE (vectype)));
+  tree scalar_type;
+
+  bits = widen ? bits * 2 : bits / 2;
+  scalar_type = lang_hooks.types.type_for_size (bits, unsignedp);
+  if (!scalar_type)
+    return NULL_TREE;
+
+  return get_vectype_for_scalar_type (scalar_type);
+}
+
+
+/* Function vect_conversion_supported_p.
+
+   Check whether the target can convert vectors of type VECTYPE_IN into
+   vectors of type VECTYPE_OUT, whose elements are integers of a different
+   size, by unpacking or packing them in one or more steps.  Each step
+   doubles or halves the size of the elements; the intermediate elements
+   have the signedness of the narrower of the two types.  */
+
+static bool
+vect_conversion_supported_p (tree vectype_in, tree vectype_out)
+{
+  int nunits_out = TYPE_VECTOR_SUBPARTS (vectype_out);
+  bool promotion = TYPE_VECTOR_SUBPARTS (vectype_in) > (unsigned) nunits_out;
+  bool unsignedp = TYPE_UNSIGNED (TREE_TYPE (promotion ? vectype_in
+					     : vectype_out));
+  tree type = vectype_in;
+  tree next_type;
+  enum machine_mode mode;
+
+  while (TYPE_VECTOR_SUBPARTS (type) != (unsigned) nunits_out)
+    {
+      mode = TYPE_MODE (type);
+      if (promotion
+	  ? TYPE_VECTOR_SUBPARTS (type) == 2 * (unsigned) nunits_out
+	  : 2 * TYPE_VECTOR_SUBPARTS (type) == (unsigned) nunits_out)
+	next_type = vectype_out;
+      else
+	next_type = vect_double_or_half_vectype (type, promotion, unsignedp);
+      if (!next_type || !VECTOR_MODE_P (mode))
+	return false;
+
+      if (promotion)
+	{
+	  optab hi = optab_for_tree_code (VEC_UNPACK_HI_EXPR, type);
+	  optab lo = optab_for_tree_code (VEC_UNPACK_LO_EXPR, type);
+	  int icode_hi = (int) hi->handlers[(int) mode].insn_code;
+	  int icode_lo = (int) lo->handlers[(int) mode].insn_code;
+
+	  if (icode_hi == CODE_FOR_nothing
+	      || icode_lo == CODE_FOR_nothing
+	      || insn_data[icode_hi].operand[0].mode != TYPE_MODE (next_type)
+	      || insn_data[icode_lo].operand[0].mode != TYPE_MODE (next_type))
+	    return false;
+	}
+      else
+	{
+	  int icode = (int) vec_pack_mod_optab->handlers[(int) mode].insn_code;
+
+	  if (icode == CODE_FOR_nothing
+	      || insn_data[icode].operand[0].mode != TYPE_MODE (next_type))
+	    return false;
+	}
+
+      type = next_type;
+    }
+
+  return true;
+}
+
+
+/* Function vect_gen_conversion.
+
+   Create a vector stmt for STMT that computes CODE, a vector unpack or
+   pack, of OP0 and OP1 (NULL_TREE for an unpack) into a new vector of
+   type VECTYPE.  Insert it at BSI and return it.  */
+
+static tree
+vect_gen_conversion (enum tree_code code, tree vectype, tree op0, tree op1,
+		     tree stmt, block_stmt_iterator *bsi)
+{
+  tree vec_dest = vect_create_destination_var (TREE_OPERAND (stmt, 0),
+					       vectype);
+  tree rhs, new_stmt, new_temp;
+
+  if (op1)
+    rhs = build2 (code, vectype, op0, op1);
+  else
+    rhs = build1 (code, vectype, op0);
+  new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, rhs);
+  new_temp = make_ssa_name (vec_dest, new_stmt);
+  TREE_OPERAND (new_stmt, 0) = new_temp;
+  vect_finish_stmt_generation (stmt, new_stmt, bsi);
+
+  return new_stmt;
+}
+
+
+/* Function vect_analyze_conversion.
+
+   Check if STMT is a conversion between integer types whose sizes differ
+   by a factor of two or more, and whose operand is defined in the loop.
+   If so, return the vector type of its operand.  PROMOTION selects
+   conversions to a wider type, or else to a narrower one.  */
+
+static tree
+vect_analyze_conversion (tree stmt, bool promotion)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  loop_vec_info loop_vinfo = STMT_VINFO_LOOP_VINFO (stmt_info);
+  tree vectype_out = STMT_VINFO_VECTYPE (stmt_info);
+  tree scalar_dest, operation, op0, type_in, type_out, vectype_in;
+  tree def, def_stmt;
+  enum vect_def_type dt;
+  int nunits_in, nunits_out;
+
+  if (!STMT_VINFO_RELEVANT_P (stmt_info))
+    return NULL_TREE;
+
+  gcc_assert (STMT_VINFO_DEF_TYPE (stmt_info) == vect_loop_def);
+
+  if (STMT_VINFO_LIVE_P (stmt_info))
+    {
+      /* FORNOW: not yet supported.  */
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "value used after loop.");
+      return NULL_TREE;
+    }
+
+  if (TREE_CODE (stmt) != MODIFY_EXPR)
+    return NULL_TREE;
+
+  scalar_dest = TREE_OPERAND (stmt, 0);
+  if (TREE_CODE (scalar_dest) != SSA_NAME)
+    return NULL_TREE;
+
+  operation = TREE_OPERAND (stmt, 1);
+  if (TREE_CODE (operation) != NOP_EXPR
+      && TREE_CODE (operation) != CONVERT_EXPR)
+    return NULL_TREE;
+
   op0 = TREE_OPERAND (operation, 0);
+  type_in = TREE_TYPE (op0);
+  type_out = TREE_TYPE (scalar_dest);
+  if (!INTEGRAL_TYPE_P (type_in)
+      || !INTEGRAL_TYPE_P (type_out)
+      || TYPE_PRECISION (type_in) != GET_MODE_BITSIZE (TYPE_MODE (type_in))
+      || TYPE_PRECISION (type_out) != GET_MODE_BITSIZE (TYPE_MODE (type_out)))
+    return NULL_TREE;
+
+  vectype_in = get_vectype_for_scalar_type (type_in);
+  if (!vectype_in)
+    return NULL_TREE;
+  nunits_in = TYPE_VECTOR_SUBPARTS (vectype_in);
+  nunits_out = TYPE_VECTOR_SUBPARTS (vectype_out);
+  if (promotion ? nunits_in <= nunits_out : nunits_in >= nunits_out)
+    return NULL_TREE;
+
+  /* The vector defs of a constant or invariant operand would have to be
+     built in the type of the operand; FORNOW only loop defs are handled.  */
+  if (!vect_is_simple_use (op0, loop_vinfo, &def_stmt, &def, &dt)
+      || dt != vect_loop_def)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "use not simple.");
+      return NULL_TREE;
+    }
+
+  if (!vect_conversion_supported_p (vectype_in, vectype_out))
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "conversion not supported by target.");
+      return NULL_TREE;
+    }
+
+  return vectype_in;
+}
+
+
+/* Function vectorizable_type_promotion.
+
+   Check if STMT converts an integer into a wider integer type, in a way
+   that can be vectorized by unpacking the vectors of its operand.  Since
+   the vectorization factor is set by the narrowest type in the loop, the
+   operand has NCOPIES_IN vectors and the result 2**K times as many, K being
+   the number of unpacking steps.
+   If VEC_STMT is also passed, vectorize the STMT: create the vectorized 
+   stmts to replace it, put the first of them in VEC_STMT, and insert them
+   at BSI.
+   Return FALSE if not a vectorizable STMT, TRUE otherwise.  */
+
+bool
+vectorizable_type_promotion (tree stmt, block_stmt_iterator *bsi,
+			     tree *vec_stmt)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  loop_vec_info loop_vinfo = STMT_VINFO_LOOP_VINFO (stmt_info);
+  tree vectype_out = STMT_VINFO_VECTYPE (stmt_info);
+  int nunits_out = TYPE_VECTOR_SUBPARTS (vectype_out);
+  tree vectype_in, op0, vec_oprnd0, type, next_type, new_stmt;
+  enum tree_code code_first, code_second;
+  bool unsignedp;
+  tree *defs, *next_defs, *tmp;
+  int ncopies_in, nvecs, i, j, n;
+
+  vectype_in = vect_analyze_conversion (stmt, true);
+  if (!vectype_in)
+    return false;
+
+  if (!vec_stmt) /* transformation not required.  */
+    {
+      STMT_VINFO_TYPE (stmt_info) = type_promotion_vec_info_type;
+      return true;
+    }
+
+  /** Transform.  **/
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    fprintf (vect_dump, "transform type promotion.");
+
+  /* The low half of a vector register holds the elements that come first
+     in memory on a little-endian target.  */
+  if (BYTES_BIG_ENDIAN)
+    {
+      code_first = VEC_UNPACK_HI_EXPR;
+      code_second = VEC_UNPACK_LO_EXPR;
+    }
+  else
+    {
+      code_first = VEC_UNPACK_LO_EXPR;
+      code_second = VEC_UNPACK_HI_EXPR;
+    }
+
+  unsignedp = TYPE_UNSIGNED (TREE_TYPE (vectype_in));
+  ncopies_in = LOOP_VINFO_VECT_FACTOR (loop_vinfo)
+	       / TYPE_VECTOR_SUBPARTS (vectype_in);
+  nvecs = TYPE_VECTOR_SUBPARTS (vectype_in) / nunits_out;
+  defs = XNEWVEC (tree, nvecs);
+  next_defs = XNEWVEC (tree, nvecs);
+
+  op0 = TREE_OPERAND (TREE_OPERAND (stmt, 1), 0);
   vec_oprnd0 = vect_get_vec_def_for_operand (op0, stmt, NULL);
+  *vec_stmt = NULL_TREE;
 
-  if (op_type == binary_op)
+  for (j = 0; j < ncopies_in; j++)
     {
-      op1 = TREE_OPERAND (operation, 1);
+      /* Unpack each vector of the operand into 2, 4, ... vectors, until
+	 they have the type of the result.  */
+      defs[0] = vect_get_vec_def_for_copy (op0, vec_oprnd0, j, loop_vinfo);
+      type = vectype_in;
+      for (n = 1; n < nvecs; n *= 2)
+	{
+	  next_type = (2 * n == nvecs ? vectype_out
+		       : vect_double_or_half_vectype (type, true, unsignedp));
+	  for (i = 0; i < n; i++)
+	    {
+	      new_stmt = vect_gen_conversion (code_first, next_type, defs[i],
+					      NULL_TREE, stmt, bsi);
+	      next_defs[2 * i] = TREE_OPERAND (new_stmt, 0);
+	      new_stmt = vect_gen_conversion (code_second, next_type, defs[i],
+					      NULL_TREE, stmt, bsi);
+	      next_defs[2 * i + 1] = TREE_OPERAND (new_stmt, 0);
+	    }
+	  tmp = defs;
+	  defs = next_defs;
+	  next_defs = tmp;
+	  type = next_type;
+	}
 
-      if (code == LSHIFT_EXPR || code == RSHIFT_EXPR)
+      for (i = 0; i < nvecs; i++)
 	{
-	  /* Vector shl and shr insn patterns can be defined with
-	     scalar operand 2 (shift operand).  In this case, use
-	     constant or loop invariant op1 directly, without
-	     extending it to vector mode first.  */
+	  new_stmt = SSA_NAME_DEF_STMT (defs[i]);
+	  vect_record_stmt_copy (stmt, new_stmt);
+	  if (!*vec_stmt)
+	    *vec_stmt = new_stmt;
+	}
+    }
+
+  free (defs);
+  free (next_defs);
+  return true;
+}
+
+
+/* Function vectorizable_type_demotion.
+
+   Check if STMT converts an integer into a narrower integer type, in a way
+   that can be vectorized by packing the vectors of its operand, 2**K of
+   them for each vector of the result, K being the number of packing steps.
+   If VEC_STMT is also passed, vectorize the STMT: create the vectorized 
+   stmts to replace it, put the first of them in VEC_STMT, and insert them
+   at BSI.
+   Return FALSE if not a vectorizable STMT, TRUE otherwise.  */
 
-	  optab_op2_mode = insn_data[icode].operand[2].mode;
-	  if (!VECTOR_MODE_P (optab_op2_mode))
+bool
+vectorizable_type_demotion (tree stmt, block_stmt_iterator *bsi,
+			    tree *vec_stmt)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  loop_vec_info loop_vinfo = STMT_VINFO_LOOP_VINFO (stmt_info);
+  tree vectype_out = STMT_VINFO_VECTYPE (stmt_info);
+  int ncopies = vect_get_ncopies (stmt_info);
+  tree vectype_in, op0, vec_oprnd0, type, next_type, new_stmt = NULL_TREE;
+  bool unsignedp;
+  tree *defs;
+  int nvecs, i, j, n;
+
+  vectype_in = vect_analyze_conversion (stmt, false);
+  if (!vectype_in)
+    return false;
+
+  if (!vec_stmt) /* transformation not required.  */
+    {
+      STMT_VINFO_TYPE (stmt_info) = type_demotion_vec_info_type;
+      return true;
+    }
+
+  /** Transform.  **/
+
+  if (vect_print_dump_info (REPORT_DETAILS))
+    fprintf (vect_dump, "transform type demotion.");
+
+  unsignedp = TYPE_UNSIGNED (TREE_TYPE (vectype_out));
+  nvecs = TYPE_VECTOR_SUBPARTS (vectype_out)
+	  / TYPE_VECTOR_SUBPARTS (vectype_in);
+  defs = XNEWVEC (tree, nvecs);
+
+  op0 = TREE_OPERAND (TREE_OPERAND (stmt, 1), 0);
+  vec_oprnd0 = vect_get_vec_def_for_operand (op0, stmt, NULL);
+  *vec_stmt = NULL_TREE;
+
+  for (j = 0; j < ncopies; j++)
+    {
+      /* Pack the NVECS vectors of the operand that make up one vector of
+	 the result pairwise, until a single vector is left.  */
+      for (i = 0; i < nvecs; i++)
+	defs[i] = vect_get_vec_def_for_copy (op0, vec_oprnd0, j * nvecs + i,
+					     loop_vinfo);
+      type = vectype_in;
+      for (n = nvecs; n > 1; n /= 2)
+	{
+	  next_type = (n == 2 ? vectype_out
+		       : vect_double_or_half_vectype (type, false, unsignedp));
+	  for (i = 0; i < n / 2; i++)
 	    {
-	      if (vect_print_dump_info (REPORT_DETAILS))
-		fprintf (vect_dump, "operand 1 using scalar mode.");
-	      vec_oprnd1 = op1;
+	      new_stmt = vect_gen_conversion (VEC_PACK_MOD_EXPR, next_type,
+					      defs[2 * i], defs[2 * i + 1],
+					      stmt, bsi);
+	      defs[i] = TREE_OPERAND (new_stmt, 0);
 	    }
+	  type = next_type;
 	}
 
-      if (!vec_oprnd1)
-	vec_oprnd1 = vect_get_vec_def_for_operand (op1, stmt, NULL); 
+      vect_record_stmt_copy (stmt, new_stmt);
+      if (!*vec_stmt)
+	*vec_stmt = new_stmt;
     }
 
-  /* Arguments are ready. create the new vector stmt.  */
+  free (defs);
+  return true;
+}
+/* APPLE LOCAL end vect multiple types */
 
-  if (op_type == binary_op)
-    *vec_stmt = build2 (MODIFY_EXPR, vectype, vec_dest,
-		build2 (code, vectype, vec_oprnd0, vec_oprnd1));
-  else
-    *vec_stmt = build2 (MODIFY_EXPR, vectype, vec_dest,
-		build1 (code, vectype, vec_oprnd0));
-  new_temp = make_ssa_name (vec_dest, *vec_stmt);
-  TREE_OPERAND (*vec_stmt, 0) = new_temp;
-  vect_finish_stmt_generation (stmt, *vec_stmt, bsi);
 
+/* APPLE LOCAL begin vect interleave */
+/* Function vect_bump_data_ref_ptr.
+
+   Return an SSA_NAME set to DATAREF_PTR + J vectors, the pointer to the
+   J-th vector of the interleaving group of STMT accessed through
+   DATAREF_PTR.
+   APPLE LOCAL begin vect multiple types
+   Likewise for the J-th vector of a data-ref that is accessed by several
+   vectors in each iteration of the vectorized loop.
+   APPLE LOCAL end vect multiple types
+   The new stmt is inserted at BSI.  */
+
+static tree
+vect_bump_data_ref_ptr (tree dataref_ptr, int j, tree stmt,
+			block_stmt_iterator *bsi)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  /* APPLE LOCAL begin vect multiple types */
+  struct data_reference *dr
+    = (STMT_VINFO_STRIDED_ACCESS (stmt_info)
+       ? STMT_VINFO_DATA_REF (vinfo_for_stmt (DR_GROUP_FIRST_DR (stmt_info)))
+       : STMT_VINFO_DATA_REF (stmt_info));
+  /* APPLE LOCAL end vect multiple types */
+  tree vectype = STMT_VINFO_VECTYPE (stmt_info);
+  tree ptr_type = TREE_TYPE (dataref_ptr);
+  tree offset, new_stmt, new_ptr;
+
+  if (j == 0)
+    return dataref_ptr;
+
+  offset = size_binop (MULT_EXPR, TYPE_SIZE_UNIT (vectype), size_int (j));
+  new_stmt = build2 (MODIFY_EXPR, void_type_node,
+		     SSA_NAME_VAR (dataref_ptr),
+		     build2 (PLUS_EXPR, ptr_type, dataref_ptr,
+			     fold_convert (ptr_type, offset)));
+  new_ptr = make_ssa_name (SSA_NAME_VAR (dataref_ptr), new_stmt);
+  TREE_OPERAND (new_stmt, 0) = new_ptr;
+  vect_finish_stmt_generation (stmt, new_stmt, bsi);
+
+  /* Copy the points-to information if it exists.  */
+  if (DR_PTR_INFO (dr))
+    duplicate_ssa_name_ptr_info (new_ptr, DR_PTR_INFO (dr));
+  merge_alias_info (new_ptr, dataref_ptr);
+
+  return new_ptr;
+}
+
+
+/* Function vect_permute_chain.
+
+   CHAIN holds the LENGTH vectors accessed by an interleaving group of
+   size LENGTH, a power of 2.  Permute them in log2 (LENGTH) stages of
+   CODE1/CODE2 operations on pairs of vectors, inserted at BSI for STMT,
+   and store the result in CHAIN.
+
+   For loads (CODE1/CODE2 = VEC_EXTRACT_EVEN_EXPR/VEC_EXTRACT_ODD_EXPR),
+   CHAIN holds the vectors read from memory, and RESULT[I] is the vector of
+   the group member with index I:
+
+	RESULT[J] = CODE1 (CHAIN[2*J], CHAIN[2*J+1])
+	RESULT[J+LENGTH/2] = CODE2 (CHAIN[2*J], CHAIN[2*J+1])
+
+   For stores (CODE1/CODE2 = VEC_INTERLEAVE_LOW_EXPR/VEC_INTERLEAVE_HIGH_EXPR),
+   this is done the other way around:
+
+	RESULT[2*J] = CODE1 (CHAIN[J], CHAIN[J+LENGTH/2])
+	RESULT[2*J+1] = CODE2 (CHAIN[J], CHAIN[J+LENGTH/2])
+
+   For example, for a group of 4 stores of vectors a, b, c and d of 4
+   elements, the first stage computes
+
+	{a0 c0 a1 c1}, {a2 c2 a3 c3}, {b0 d0 b1 d1}, {b2 d2 b3 d3}
+
+   and the second
+
+	{a0 b0 c0 d0}, {a1 b1 c1 d1}, {a2 b2 c2 d2}, {a3 b3 c3 d3}.  */
+
+static void
+vect_permute_chain (tree *chain, unsigned int length, enum tree_code code1,
+		    enum tree_code code2, tree stmt, block_stmt_iterator *bsi)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  tree vectype = STMT_VINFO_VECTYPE (stmt_info);
+  tree *result = XNEWVEC (tree, length);
+  bool is_load = (code1 == VEC_EXTRACT_EVEN_EXPR);
+  unsigned int i, j, n;
+
+  for (n = length; n > 1; n /= 2)
+    {
+      for (j = 0; j < length / 2; j++)
+	{
+	  tree first = is_load ? chain[2 * j] : chain[j];
+	  tree second = is_load ? chain[2 * j + 1] : chain[j + length / 2];
+
+	  for (i = 0; i < 2; i++)
+	    {
+	      tree vec_dest = vect_get_new_vect_var (vectype, vect_simple_var,
+						     is_load ? "perm_load"
+						     : "perm_store");
+	      tree new_stmt, new_temp;
+
+	      add_referenced_var (vec_dest);
+	      new_stmt = build2 (MODIFY_EXPR, void_type_node, vec_dest,
+				 build2 (i == 0 ? code1 : code2, vectype,
+					 first, second));
+	      new_temp = make_ssa_name (vec_dest, new_stmt);
+	      TREE_OPERAND (new_stmt, 0) = new_temp;
+	      vect_finish_stmt_generation (stmt, new_stmt, bsi);
+
+	      if (is_load)
+		result[j + i * length / 2] = new_temp;
+	      else
+		result[2 * j + i] = new_temp;
+	    }
+	}
+      memcpy (chain, result, length * sizeof (tree));
+    }
+
+  free (result);
+}
+/* Function vect_transform_strided_store.
+
+   Vectorize STMT, a store of an interleaving group.  The stores of the
+   group are vectorized together when the last of them is reached: the
+   vectors of the stored values are interleaved by vect_permute_chain,
+   and written one after the other from the address of the first data-ref
+   of the group.  Set *VEC_STMT to the last vector store, or to NULL_TREE
+   if STMT is not the last store of its group.  */
+
+static bool
+vect_transform_strided_store (tree stmt, block_stmt_iterator *bsi,
+			      tree *vec_stmt)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  tree vectype = STMT_VINFO_VECTYPE (stmt_info);
+  tree first_stmt = DR_GROUP_FIRST_DR (stmt_info);
+  stmt_vec_info first_info = vinfo_for_stmt (first_stmt);
+  unsigned int group_size = DR_GROUP_SIZE (first_info);
+  tree *chain, *members;
+  tree next_stmt, dataref_ptr, dummy, new_stmt = NULL_TREE;
+  tree def;
+  ssa_op_iter iter;
+  block_stmt_iterator si;
+  unsigned int i;
+
+  gcc_assert (vect_supportable_dr_alignment (STMT_VINFO_DATA_REF (first_info))
+	      == dr_aligned);  /* FORNOW */
+
+  /* Wait for the last store of the group, after which all the stored
+     values are available.  */
+  DR_GROUP_STORE_COUNT (first_info)++;
+  if (DR_GROUP_STORE_COUNT (first_info) < group_size)
+    {
+      *vec_stmt = NULL_TREE;
+      return true;
+    }
+
+  /* Collect the vector defs of the stored values in address order.  */
+  chain = XNEWVEC (tree, group_size);
+  for (i = 0, next_stmt = first_stmt; i < group_size; i++)
+    {
+      chain[i] = vect_get_vec_def_for_operand (TREE_OPERAND (next_stmt, 1),
+					       next_stmt, NULL);
+      next_stmt = DR_GROUP_NEXT_DR (vinfo_for_stmt (next_stmt));
+    }
+
+  /* And the scalar stores in statement order.  */
+  members = XNEWVEC (tree, group_size);
+  for (i = 0, si = bsi_start (bb_for_stmt (stmt)); i < group_size;
+       bsi_next (&si))
+    {
+      stmt_vec_info info = vinfo_for_stmt (bsi_stmt (si));
+
+      if (info && DR_GROUP_FIRST_DR (info) == first_stmt
+	  && STMT_VINFO_DATA_REF (info)
+	  && !DR_IS_READ (STMT_VINFO_DATA_REF (info)))
+	members[i++] = bsi_stmt (si);
+    }
+  gcc_assert (members[group_size - 1] == stmt);
+
+  vect_permute_chain (chain, group_size, VEC_INTERLEAVE_LOW_EXPR,
+		      VEC_INTERLEAVE_HIGH_EXPR, stmt, bsi);
+
+  dataref_ptr = vect_create_data_ref_ptr (first_stmt, bsi, NULL_TREE,
+					  &dummy, false);
+
+  for (i = 0; i < group_size; i++)
+    {
+      tree ptr = vect_bump_data_ref_ptr (dataref_ptr, i, stmt, bsi);
+
+      new_stmt = build2 (MODIFY_EXPR, vectype,
+			 build_fold_indirect_ref (ptr), chain[i]);
+      vect_finish_stmt_generation (stmt, new_stmt, bsi);
+
+      /* The I-th vector store takes over the V_MAY_DEFS of the I-th
+	 scalar store in statement order, which keeps the chain of virtual
+	 definitions; the scalar stores are deleted.  */
+      copy_virtual_operands (new_stmt, members[i]);
+      FOR_EACH_SSA_TREE_OPERAND (def, members[i], iter, SSA_OP_VMAYDEF)
+	{
+	  SSA_NAME_DEF_STMT (def) = new_stmt;
+	  mark_sym_for_renaming (SSA_NAME_VAR (def));
+	}
+    }
+
+  free (chain);
+  free (members);
+  *vec_stmt = new_stmt;
   return true;
 }
+/* APPLE LOCAL end vect interleave */
 
 
 /* Function vectorizable_store.
@@ -1669,6 +2443,14 @@ vectorizable_store (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   ssa_op_iter iter;
   tree def, def_stmt;
   enum vect_def_type dt;
+  /* APPLE LOCAL vect interleave */
+  bool strided_store = STMT_VINFO_STRIDED_ACCESS (stmt_info);
+  /* APPLE LOCAL begin vect multiple types */
+  int ncopies = vect_get_ncopies (stmt_info);
+  tree vec_oprnd0 = NULL_TREE, dataref_ptr = NULL_TREE, new_stmt;
+  def_operand_p def_p;
+  int j;
+  /* APPLE LOCAL end vect multiple types */
 
   /* Is vectorizable store? */
 
@@ -1677,7 +2459,9 @@ vectorizable_store (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
 
   scalar_dest = TREE_OPERAND (stmt, 0);
   if (TREE_CODE (scalar_dest) != ARRAY_REF
-      && TREE_CODE (scalar_dest) != INDIRECT_REF)
+      && TREE_CODE (scalar_dest) != INDIRECT_REF
+      /* APPLE LOCAL vect interleave */
+      && (TREE_CODE (scalar_dest) != COMPONENT_REF || !strided_store))
     return false;
 
   op = TREE_OPERAND (stmt, 1);
@@ -1697,6 +2481,21 @@ vectorizable_store (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   if (!STMT_VINFO_DATA_REF (stmt_info))
     return false;
 
+  /* APPLE LOCAL begin vect interleave */
+  if (strided_store && !vect_strided_store_supported (vectype))
+    return false;
+  /* APPLE LOCAL end vect interleave */
+
+  /* APPLE LOCAL begin vect multiple types */
+  /* FORNOW: the stores of an interleaving group are vectorized by one
+     vector each.  */
+  if (strided_store && ncopies > 1)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "multiple types in interleaved store.");
+      return false;
+    }
+  /* APPLE LOCAL end vect multiple types */
 
   if (!vec_stmt) /* transformation not required.  */
     {
@@ -1709,41 +2508,151 @@ vectorizable_store (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   if (vect_print_dump_info (REPORT_DETAILS))
     fprintf (vect_dump, "transform store");
 
+  /* APPLE LOCAL begin vect interleave */
+  if (strided_store)
+    return vect_transform_strided_store (stmt, bsi, vec_stmt);
+  /* APPLE LOCAL end vect interleave */
+
   alignment_support_cheme = vect_supportable_dr_alignment (dr);
   gcc_assert (alignment_support_cheme);
   gcc_assert (alignment_support_cheme == dr_aligned);  /* FORNOW */
 
-  /* Handle use - get the vectorized def from the defining stmt.  */
-  vec_oprnd1 = vect_get_vec_def_for_operand (op, stmt, NULL);
+  /* APPLE LOCAL begin vect multiple types */
+  *vec_stmt = NULL_TREE;
+  for (j = 0; j < ncopies; j++)
+    {
+      /* Handle use - get the vectorized def from the defining stmt.  */
+      if (j == 0)
+	vec_oprnd0 = vect_get_vec_def_for_operand (op, stmt, NULL);
+      vec_oprnd1 = vect_get_vec_def_for_copy (op, vec_oprnd0, j, loop_vinfo);
 
-  /* Handle def.  */
-  /* FORNOW: make sure the data reference is aligned.  */
-  vect_align_data_ref (stmt);
-  data_ref = vect_create_data_ref_ptr (stmt, bsi, NULL_TREE, &dummy, false);
-  data_ref = build_fold_indirect_ref (data_ref);
+      /* Handle def.  */
+      if (j == 0)
+	{
+	  /* FORNOW: make sure the data reference is aligned.  */
+	  vect_align_data_ref (stmt);
+	  dataref_ptr = vect_create_data_ref_ptr (stmt, bsi, NULL_TREE,
+						  &dummy, false);
+	}
+      data_ref = vect_bump_data_ref_ptr (dataref_ptr, j, stmt, bsi);
+      data_ref = build_fold_indirect_ref (data_ref);
 
-  /* Arguments are ready. create the new vector stmt.  */
-  *vec_stmt = build2 (MODIFY_EXPR, vectype, data_ref, vec_oprnd1);
-  vect_finish_stmt_generation (stmt, *vec_stmt, bsi);
+      /* Arguments are ready. create the new vector stmt.  */
+      new_stmt = build2 (MODIFY_EXPR, vectype, data_ref, vec_oprnd1);
+      vect_finish_stmt_generation (stmt, new_stmt, bsi);
 
-  /* Copy the V_MAY_DEFS representing the aliasing of the original array
-     element's definition to the vector's definition then update the
-     defining statement.  The original is being deleted so the same
-     SSA_NAMEs can be used.  */
-  copy_virtual_operands (*vec_stmt, stmt);
+      /* Copy the V_MAY_DEFS representing the aliasing of the original array
+	 element's definition to the vector's definition then update the
+	 defining statement.  The original is being deleted so the same
+	 SSA_NAMEs can be used by the first copy; the other copies get
+	 new SSA_NAMEs, which are put in place by renaming.  */
+      copy_virtual_operands (new_stmt, stmt);
 
-  FOR_EACH_SSA_TREE_OPERAND (def, stmt, iter, SSA_OP_VMAYDEF)
+      if (j == 0)
+	{
+	  FOR_EACH_SSA_TREE_OPERAND (def, stmt, iter, SSA_OP_VMAYDEF)
+	    {
+	      SSA_NAME_DEF_STMT (def) = new_stmt;
+
+	      /* If this virtual def has a use outside the loop and a loop
+		 peel is performed then the def may be renamed by the peel.
+		 Mark it for renaming so the later use will also be
+		 renamed.  */
+	      mark_sym_for_renaming (SSA_NAME_VAR (def));
+	    }
+	  *vec_stmt = new_stmt;
+	}
+      else
+	FOR_EACH_SSA_DEF_OPERAND (def_p, new_stmt, iter, SSA_OP_VMAYDEF)
+	  {
+	    def = DEF_FROM_PTR (def_p);
+	    SET_DEF (def_p, make_ssa_name (SSA_NAME_VAR (def), new_stmt));
+	    mark_sym_for_renaming (SSA_NAME_VAR (def));
+	  }
+    }
+  /* APPLE LOCAL end vect multiple types */
+
+  return true;
+}
+
+
+/* APPLE LOCAL begin vect interleave */
+/* Function vect_transform_strided_load.
+
+   Vectorize STMT, a load of an interleaving group.  All the loads of the
+   group are vectorized at the first of them: the vectors covering one
+   iteration of the group are read from the address of the first data-ref
+   of the group, and separated by vect_permute_chain into a vector for
+   each member.  Set *VEC_STMT to the stmt that computes the vector of
+   STMT.  */
+
+static bool
+vect_transform_strided_load (tree stmt, block_stmt_iterator *bsi,
+			     tree *vec_stmt)
+{
+  stmt_vec_info stmt_info = vinfo_for_stmt (stmt);
+  tree vectype = STMT_VINFO_VECTYPE (stmt_info);
+  tree first_stmt = DR_GROUP_FIRST_DR (stmt_info);
+  struct data_reference *first_dr
+    = STMT_VINFO_DATA_REF (vinfo_for_stmt (first_stmt));
+  unsigned int group_size = DR_GROUP_SIZE (vinfo_for_stmt (first_stmt));
+  tree scalar_dest = TREE_OPERAND (stmt, 0);
+  tree *chain;
+  tree next_stmt, dataref_ptr, dummy;
+  unsigned int i;
+
+  /* An earlier load of the group did the work.  */
+  if (STMT_VINFO_VEC_STMT (stmt_info))
     {
-      SSA_NAME_DEF_STMT (def) = *vec_stmt;
+      *vec_stmt = STMT_VINFO_VEC_STMT (stmt_info);
+      return true;
+    }
 
-      /* If this virtual def has a use outside the loop and a loop peel is 
-	 performed then the def may be renamed by the peel.  Mark it for 
-	 renaming so the later use will also be renamed.  */
-      mark_sym_for_renaming (SSA_NAME_VAR (def));
+  chain = XNEWVEC (tree, group_size);
+  dataref_ptr = vect_create_data_ref_ptr (first_stmt, bsi, NULL_TREE,
+					  &dummy, false);
+  for (i = 0; i < group_size; i++)
+    {
+      tree ptr = vect_bump_data_ref_ptr (dataref_ptr, i, stmt, bsi);
+      tree vec_dest = vect_create_destination_var (scalar_dest, vectype);
+      tree data_ref, new_stmt, new_temp;
+
+      if (aligned_access_p (first_dr))
+	data_ref = build_fold_indirect_ref (ptr);
+      else
+	{
+	  int mis = DR_MISALIGNMENT (first_dr);
+	  tree tmis = (mis == -1 ? size_zero_node : size_int (mis));
+	  tmis = size_binop (MULT_EXPR, tmis, size_int (BITS_PER_UNIT));
+	  data_ref = build2 (MISALIGNED_INDIRECT_REF, vectype, ptr, tmis);
+	}
+      new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, data_ref);
+      new_temp = make_ssa_name (vec_dest, new_stmt);
+      TREE_OPERAND (new_stmt, 0) = new_temp;
+      vect_finish_stmt_generation (stmt, new_stmt, bsi);
+      copy_virtual_operands (new_stmt, stmt);
+      chain[i] = new_temp;
+    }
+
+  vect_permute_chain (chain, group_size, VEC_EXTRACT_EVEN_EXPR,
+		      VEC_EXTRACT_ODD_EXPR, stmt, bsi);
+
+  /* Record the vector of each member of the group.  Members missing from
+     the group leave their vector unused.  */
+  for (next_stmt = first_stmt; next_stmt;
+       next_stmt = DR_GROUP_NEXT_DR (vinfo_for_stmt (next_stmt)))
+    {
+      stmt_vec_info info = vinfo_for_stmt (next_stmt);
+
+      STMT_VINFO_VEC_STMT (info)
+	= SSA_NAME_DEF_STMT (chain[DR_GROUP_INDEX (info)]);
     }
 
+  free (chain);
+  *vec_stmt = STMT_VINFO_VEC_STMT (stmt_info);
   return true;
 }
+/* APPLE LOCAL end vect interleave */
 
 
 /* vectorizable_load.
@@ -1774,6 +2683,13 @@ vectorizable_load (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   struct loop *loop = LOOP_VINFO_LOOP (loop_vinfo);
   edge pe = loop_preheader_edge (loop);
   enum dr_alignment_support alignment_support_cheme;
+  /* APPLE LOCAL vect interleave */
+  bool strided_load = STMT_VINFO_STRIDED_ACCESS (stmt_info);
+  /* APPLE LOCAL begin vect multiple types */
+  int ncopies = vect_get_ncopies (stmt_info);
+  tree dataref_ptr0 = NULL_TREE;
+  int j;
+  /* APPLE LOCAL end vect multiple types */
 
   /* Is vectorizable load? */
   if (!STMT_VINFO_RELEVANT_P (stmt_info))
@@ -1797,7 +2713,9 @@ vectorizable_load (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
     return false;
 
   op = TREE_OPERAND (stmt, 1);
-  if (TREE_CODE (op) != ARRAY_REF && TREE_CODE (op) != INDIRECT_REF)
+  if (TREE_CODE (op) != ARRAY_REF && TREE_CODE (op) != INDIRECT_REF
+      /* APPLE LOCAL vect interleave */
+      && (TREE_CODE (op) != COMPONENT_REF || !strided_load))
     return false;
 
   if (!STMT_VINFO_DATA_REF (stmt_info))
@@ -1814,6 +2732,40 @@ vectorizable_load (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
       return false;
     }
 
+  /* APPLE LOCAL begin vect interleave */
+  if (strided_load)
+    {
+      struct data_reference *first_dr
+	= STMT_VINFO_DATA_REF (vinfo_for_stmt (DR_GROUP_FIRST_DR (stmt_info)));
+
+      if (!vect_strided_load_supported (vectype))
+	return false;
+
+      /* FORNOW: the loads of the group are not software pipelined.  */
+      if (vect_supportable_dr_alignment (first_dr)
+	  == dr_unaligned_software_pipeline)
+	{
+	  if (vect_print_dump_info (REPORT_DETAILS))
+	    fprintf (vect_dump, "unaligned interleaved load not supported.");
+	  return false;
+	}
+    }
+  /* APPLE LOCAL end vect interleave */
+
+  /* APPLE LOCAL begin vect multiple types */
+  /* FORNOW: interleaved and realigned loads are vectorized by one vector
+     each.  */
+  if (ncopies > 1
+      && (strided_load
+	  || vect_supportable_dr_alignment (dr)
+	     == dr_unaligned_software_pipeline))
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "multiple types in interleaved or realigned load.");
+      return false;
+    }
+  /* APPLE LOCAL end vect multiple types */
+
   if (!vec_stmt) /* transformation not required.  */
     {
       STMT_VINFO_TYPE (stmt_info) = load_vec_info_type;
@@ -1825,6 +2777,11 @@ vectorizable_load (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   if (vect_print_dump_info (REPORT_DETAILS))
     fprintf (vect_dump, "transform load.");
 
+  /* APPLE LOCAL begin vect interleave */
+  if (strided_load)
+    return vect_transform_strided_load (stmt, bsi, vec_stmt);
+  /* APPLE LOCAL end vect interleave */
+
   alignment_support_cheme = vect_supportable_dr_alignment (dr);
   gcc_assert (alignment_support_cheme);
 
@@ -1841,21 +2798,33 @@ vectorizable_load (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
       */
 
       vec_dest = vect_create_destination_var (scalar_dest, vectype);
-      data_ref = vect_create_data_ref_ptr (stmt, bsi, NULL_TREE, &dummy, false);
-      if (aligned_access_p (dr))
-        data_ref = build_fold_indirect_ref (data_ref);
-      else
+      /* APPLE LOCAL begin vect multiple types */
+      dataref_ptr0 = vect_create_data_ref_ptr (stmt, bsi, NULL_TREE, &dummy,
+					       false);
+      for (j = 0; j < ncopies; j++)
 	{
-	  int mis = DR_MISALIGNMENT (dr);
-	  tree tmis = (mis == -1 ? size_zero_node : size_int (mis));
-	  tmis = size_binop (MULT_EXPR, tmis, size_int(BITS_PER_UNIT));
-	  data_ref = build2 (MISALIGNED_INDIRECT_REF, vectype, data_ref, tmis);
+	  data_ref = vect_bump_data_ref_ptr (dataref_ptr0, j, stmt, bsi);
+	  if (aligned_access_p (dr))
+	    data_ref = build_fold_indirect_ref (data_ref);
+	  else
+	    {
+	      int mis = DR_MISALIGNMENT (dr);
+	      tree tmis = (mis == -1 ? size_zero_node : size_int (mis));
+	      tmis = size_binop (MULT_EXPR, tmis, size_int(BITS_PER_UNIT));
+	      data_ref = build2 (MISALIGNED_INDIRECT_REF, vectype, data_ref,
+				 tmis);
+	    }
+	  new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, data_ref);
+	  new_temp = make_ssa_name (vec_dest, new_stmt);
+	  TREE_OPERAND (new_stmt, 0) = new_temp;
+	  vect_finish_stmt_generation (stmt, new_stmt, bsi);
+	  copy_virtual_operands (new_stmt, stmt);
+	  vect_record_stmt_copy (stmt, new_stmt);
+	  if (j == 0)
+	    *vec_stmt = new_stmt;
 	}
-      new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, data_ref);
-      new_temp = make_ssa_name (vec_dest, new_stmt);
-      TREE_OPERAND (new_stmt, 0) = new_temp;
-      vect_finish_stmt_generation (stmt, new_stmt, bsi);
-      copy_virtual_operands (new_stmt, stmt);
+      return true;
+      /* APPLE LOCAL end vect multiple types */
     }
   else if (alignment_support_cheme == dr_unaligned_software_pipeline)
     {
@@ -2066,6 +3035,29 @@ vect_is_simple_cond (tree cond, loop_vec_info loop_vinfo)
   return true;
 }
 
+/* APPLE LOCAL begin vect cond mixed types */
+/* Function vect_view_convert.
+
+   Reinterpret the bits of vector OP as a vector of type VECTYPE.  The new
+   stmt is inserted at BSI, on behalf of STMT.  Return its result.  */
+
+static tree
+vect_view_convert (tree vectype, tree op, tree stmt, block_stmt_iterator *bsi)
+{
+  tree vec_dest, new_stmt, new_temp;
+
+  vec_dest = vect_get_new_vect_var (vectype, vect_simple_var, "vect_vc_");
+  add_referenced_var (vec_dest);
+  new_stmt = build2 (MODIFY_EXPR, vectype, vec_dest,
+		     build1 (VIEW_CONVERT_EXPR, vectype, op));
+  new_temp = make_ssa_name (vec_dest, new_stmt);
+  TREE_OPERAND (new_stmt, 0) = new_temp;
+  vect_finish_stmt_generation (stmt, new_stmt, bsi);
+
+  return new_temp;
+}
+/* APPLE LOCAL end vect cond mixed types */
+
 /* vectorizable_condition.
 
    Check if STMT is conditional modify expression that can be vectorized. 
@@ -2091,6 +3083,8 @@ vectorizable_condition (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   enum machine_mode vec_mode;
   tree def;
   enum vect_def_type dt;
+  /* APPLE LOCAL vect cond mixed types */
+  tree cond_vectype;
 
   if (!STMT_VINFO_RELEVANT_P (stmt_info))
     return false;
@@ -2120,10 +3114,39 @@ vectorizable_condition (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   if (!vect_is_simple_cond (cond_expr, loop_vinfo))
     return false;
 
-  /* We do not handle two different vector types for the condition
-     and the values.  */
+  /* APPLE LOCAL begin vect multiple types */
+  /* FORNOW: not yet supported.  */
+  if (vect_get_ncopies (stmt_info) > 1)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "multiple types in condition.");
+      return false;
+    }
+  /* APPLE LOCAL end vect multiple types */
+
+  /* APPLE LOCAL begin vect cond mixed types */
+  /* The condition may compare values of a different type than the
+     values selected, e.g. select floats by comparing ints.  The
+     selection is then done in the vector type of the comparison, on
+     the bits of the values.  Both vector types must have the same
+     number and size of elements.  */
+  cond_vectype = vectype;
   if (TREE_TYPE (TREE_OPERAND (cond_expr, 0)) != TREE_TYPE (vectype))
-    return false;
+    {
+      cond_vectype = get_vectype_for_scalar_type
+			(TREE_TYPE (TREE_OPERAND (cond_expr, 0)));
+      if (!cond_vectype
+	  || TYPE_VECTOR_SUBPARTS (cond_vectype)
+	     != TYPE_VECTOR_SUBPARTS (vectype)
+	  || GET_MODE_SIZE (TYPE_MODE (cond_vectype))
+	     != GET_MODE_SIZE (TYPE_MODE (vectype)))
+	{
+	  if (vect_print_dump_info (REPORT_DETAILS))
+	    fprintf (vect_dump, "condition and values of different sizes.");
+	  return false;
+	}
+    }
+  /* APPLE LOCAL end vect cond mixed types */
 
   if (TREE_CODE (then_clause) == SSA_NAME)
     {
@@ -2148,13 +3171,17 @@ vectorizable_condition (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
     return false;
 
 
-  vec_mode = TYPE_MODE (vectype);
+  /* APPLE LOCAL begin vect cond mixed types */
+  vec_mode = TYPE_MODE (cond_vectype);
 
   if (!vec_stmt) 
     {
       STMT_VINFO_TYPE (stmt_info) = condition_vec_info_type;
-      return expand_vec_cond_expr_p (op, vec_mode);
+      /* The signedness of the comparison decides which pattern is
+	 used.  */
+      return expand_vec_cond_expr_p (TREE_OPERAND (cond_expr, 0), vec_mode);
     }
+  /* APPLE LOCAL end vect cond mixed types */
 
   /* Transform */
 
@@ -2163,19 +3190,47 @@ vectorizable_condition (tree stmt, block_stmt_iterator *bsi, tree *vec_stmt)
   vec_dest = vect_create_destination_var (scalar_dest, vectype);
 
   /* Handle cond expr.  */
+  /* APPLE LOCAL begin vect cond mixed types */
+  /* Constant and invariant operands of the comparison are built in the
+     vector type of STMT; make that the type of the comparison.  */
+  STMT_VINFO_VECTYPE (stmt_info) = cond_vectype;
   vec_cond_lhs = 
     vect_get_vec_def_for_operand (TREE_OPERAND (cond_expr, 0), stmt, NULL);
   vec_cond_rhs = 
     vect_get_vec_def_for_operand (TREE_OPERAND (cond_expr, 1), stmt, NULL);
+  STMT_VINFO_VECTYPE (stmt_info) = vectype;
+  /* APPLE LOCAL end vect cond mixed types */
   vec_then_clause = vect_get_vec_def_for_operand (then_clause, stmt, NULL);
   vec_else_clause = vect_get_vec_def_for_operand (else_clause, stmt, NULL);
 
+  /* APPLE LOCAL begin vect cond mixed types */
+  if (cond_vectype != vectype)
+    {
+      vec_then_clause = vect_view_convert (cond_vectype, vec_then_clause,
+					   stmt, bsi);
+      vec_else_clause = vect_view_convert (cond_vectype, vec_else_clause,
+					   stmt, bsi);
+    }
+
   /* Arguments are ready. create the new vector stmt.  */
-  vec_compare = build2 (TREE_CODE (cond_expr), vectype, 
+  vec_compare = build2 (TREE_CODE (cond_expr), cond_vectype, 
 			vec_cond_lhs, vec_cond_rhs);
-  vec_cond_expr = build3 (VEC_COND_EXPR, vectype, 
+  vec_cond_expr = build3 (VEC_COND_EXPR, cond_vectype, 
 			  vec_compare, vec_then_clause, vec_else_clause);
 
+  if (cond_vectype != vectype)
+    {
+      tree cond_dest = vect_create_destination_var (scalar_dest,
+						    cond_vectype);
+      tree cond_stmt = build2 (MODIFY_EXPR, cond_vectype, cond_dest,
+			       vec_cond_expr);
+      new_temp = make_ssa_name (cond_dest, cond_stmt);
+      TREE_OPERAND (cond_stmt, 0) = new_temp;
+      vect_finish_stmt_generation (stmt, cond_stmt, bsi);
+      vec_cond_expr = build1 (VIEW_CONVERT_EXPR, vectype, new_temp);
+    }
+  /* APPLE LOCAL end vect cond mixed types */
+
   *vec_stmt = build2 (MODIFY_EXPR, vectype, vec_dest, vec_cond_expr);
   new_temp = make_ssa_name (vec_dest, *vec_stmt);
   TREE_OPERAND (*vec_stmt, 0) = new_temp;
@@ -2219,6 +3274,15 @@ vect_transform_stmt (tree stmt, block_stmt_iterator *bsi)
       case store_vec_info_type:
 	done = vectorizable_store (stmt, bsi, &vec_stmt);
 	gcc_assert (done);
+	/* APPLE LOCAL begin vect interleave */
+	/* The stores of an interleaving group are vectorized, and then
+	   removed, when the last of them is reached.  */
+	if (!vec_stmt)
+	  {
+	    gcc_assert (STMT_VINFO_STRIDED_ACCESS (stmt_info));
+	    return false;
+	  }
+	/* APPLE LOCAL end vect interleave */
 	is_store = true;
 	break;
 
@@ -2227,6 +3291,18 @@ vect_transform_stmt (tree stmt, block_stmt_iterator *bsi)
 	gcc_assert (done);
 	break;
 
+      /* APPLE LOCAL begin vect multiple types */
+      case type_promotion_vec_info_type:
+	done = vectorizable_type_promotion (stmt, bsi, &vec_stmt);
+	gcc_assert (done);
+	break;
+
+      case type_demotion_vec_info_type:
+	done = vectorizable_type_demotion (stmt, bsi, &vec_stmt);
+	gcc_assert (done);
+	break;
+      /* APPLE LOCAL end vect multiple types */
+
       default:
 	if (vect_print_dump_info (REPORT_DETAILS))
 	  fprintf (vect_dump, "stmt not supported.");
@@ -2606,8 +3682,15 @@ vect_do_peeling_for_loop_bound (loop_vec_info loop_vinfo, tree *ratio,
 				   &ratio_mult_vf_name, ratio);
 
   loop_num  = loop->num; 
+  /* APPLE LOCAL begin vect cost model */
+  /* If the cost model decided that the vector loop only pays off for
+     enough iterations, make the guard of the vector loop also send loops
+     that iterate fewer times directly to the scalar epilog loop.  */
   new_loop = slpeel_tree_peel_loop_to_edge (loop, loops, loop->single_exit,
-					    ratio_mult_vf_name, ni_name, false);
+					    ratio_mult_vf_name, ni_name, false,
+					    LOOP_VINFO_COST_MODEL_MIN_ITERS
+					      (loop_vinfo));
+  /* APPLE LOCAL end vect cost model */
   gcc_assert (new_loop);
   gcc_assert (loop_num == loop->num);
 #ifdef ENABLE_CHECKING
@@ -2655,13 +3738,18 @@ vect_do_peeling_for_loop_bound (loop_vec_info loop_vinfo, tree *ratio,
    prolog_niters = min ( LOOP_NITERS , (VF - addr_mis/elem_size)&(VF-1) )
    
    (elem_size = element type size; an element is the scalar element 
-	whose type is the inner type of the vectype)  */
+	whose type is the inner type of the vectype)
+
+   APPLE LOCAL begin vect multiple types
+   VF here is the number of elements in the vector type of DR, which is
+   less than the vectorization factor if the loop also operates on
+   narrower types.
+   APPLE LOCAL end vect multiple types  */
 
 static tree 
 vect_gen_niters_for_prolog_loop (loop_vec_info loop_vinfo, tree loop_niters)
 {
   struct data_reference *dr = LOOP_VINFO_UNALIGNED_DR (loop_vinfo);
-  int vf = LOOP_VINFO_VECT_FACTOR (loop_vinfo);
   struct loop *loop = LOOP_VINFO_LOOP (loop_vinfo);
   tree var, stmt;
   tree iters, iters_name;
@@ -2672,18 +3760,26 @@ vect_gen_niters_for_prolog_loop (loop_vec_info loop_vinfo, tree loop_niters)
   tree vectype = STMT_VINFO_VECTYPE (stmt_info);
   int vectype_align = TYPE_ALIGN (vectype) / BITS_PER_UNIT;
   tree niters_type = TREE_TYPE (loop_niters);
+  /* APPLE LOCAL begin vect multiple types */
+  /* The number of elements in a vector of DR, which may be less than the
+     vectorization factor.  */
+  int nelements = TYPE_VECTOR_SUBPARTS (vectype);
+  /* APPLE LOCAL end vect multiple types */
 
   pe = loop_preheader_edge (loop); 
 
   if (LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo) > 0)
     {
       int byte_misalign = LOOP_PEELING_FOR_ALIGNMENT (loop_vinfo);
-      int element_size = vectype_align/vf;
+      /* APPLE LOCAL begin vect multiple types */
+      int element_size = vectype_align/nelements;
       int elem_misalign = byte_misalign / element_size;
 
       if (vect_print_dump_info (REPORT_DETAILS))
         fprintf (vect_dump, "known alignment = %d.", byte_misalign);
-      iters = build_int_cst (niters_type, (vf - elem_misalign)&(vf-1));
+      iters = build_int_cst (niters_type,
+			     (nelements - elem_misalign)&(nelements-1));
+      /* APPLE LOCAL end vect multiple types */
     }
   else
     {
@@ -2694,10 +3790,12 @@ vect_gen_niters_for_prolog_loop (loop_vec_info loop_vinfo, tree loop_niters)
       tree size = TYPE_SIZE (ptr_type);
       tree type = lang_hooks.types.type_for_size (tree_low_cst (size, 1), 1);
       tree vectype_size_minus_1 = build_int_cst (type, vectype_align - 1);
+      /* APPLE LOCAL begin vect multiple types */
       tree elem_size_log =
-        build_int_cst (type, exact_log2 (vectype_align/vf));
-      tree vf_minus_1 = build_int_cst (type, vf - 1);
-      tree vf_tree = build_int_cst (type, vf);
+        build_int_cst (type, exact_log2 (vectype_align/nelements));
+      tree nelements_minus_1 = build_int_cst (type, nelements - 1);
+      tree nelements_tree = build_int_cst (type, nelements);
+      /* APPLE LOCAL end vect multiple types */
       tree byte_misalign;
       tree elem_misalign;
 
@@ -2712,9 +3810,11 @@ vect_gen_niters_for_prolog_loop (loop_vec_info loop_vinfo, tree loop_niters)
       elem_misalign =
         build2 (RSHIFT_EXPR, type, byte_misalign, elem_size_log);
 
-      /* Create:  (niters_type) (VF - elem_misalign)&(VF - 1)  */
-      iters = build2 (MINUS_EXPR, type, vf_tree, elem_misalign);
-      iters = build2 (BIT_AND_EXPR, type, iters, vf_minus_1);
+      /* APPLE LOCAL begin vect multiple types */
+      /* Create:  (niters_type) (nelements - elem_misalign)&(nelements - 1)  */
+      iters = build2 (MINUS_EXPR, type, nelements_tree, elem_misalign);
+      iters = build2 (BIT_AND_EXPR, type, iters, nelements_minus_1);
+      /* APPLE LOCAL end vect multiple types */
       iters = fold_convert (niters_type, iters);
     }
 
@@ -2814,7 +3914,8 @@ vect_do_peeling_for_alignment (loop_vec_info loop_vinfo, struct loops *loops)
   /* Peel the prolog loop and iterate it niters_of_prolog_loop.  */
   new_loop = 
 	slpeel_tree_peel_loop_to_edge (loop, loops, loop_preheader_edge (loop), 
-				       niters_of_prolog_loop, ni_name, true); 
+				       /* APPLE LOCAL vect cost model */
+				       niters_of_prolog_loop, ni_name, true, 0);
   gcc_assert (new_loop);
 #ifdef ENABLE_CHECKING
   slpeel_verify_cfg_after_peeling (new_loop, loop);
@@ -2957,6 +4058,117 @@ vect_create_cond_for_align_checks (loop_vec_info loop_vinfo,
 }
 
 
+/* APPLE LOCAL begin vect alias versioning */
+/* Function vect_create_cond_for_alias_checks.
+
+   Create a conditional expression that is true if none of the pairs of
+   data references in LOOP_VINFO_MAY_ALIAS_DDRS overlap.  For each pair
+   (DRA, DRB), the segment of memory accessed by DRA in all the iterations
+   of the loop is [addr_a, addr_a + step_a * niters), and the test is
+
+     (addr_a + step_a * niters <= addr_b) || (addr_b + step_b * niters <= addr_a)
+
+   Statements needed to compute the addresses are added to
+   COND_EXPR_STMT_LIST.  The data-ref of an interleaving group is
+   represented by its first data-ref, from which the group is accessed.  */
+
+static tree
+vect_create_cond_for_alias_checks (loop_vec_info loop_vinfo,
+				   tree *cond_expr_stmt_list)
+{
+  VEC (ddr_p, heap) *may_alias_ddrs = LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo);
+  tree niters = fold_convert (sizetype,
+			      unshare_expr (LOOP_VINFO_NITERS (loop_vinfo)));
+  struct data_dependence_relation *ddr;
+  tree uintptr_type, cond_expr = NULL_TREE;
+  unsigned int i;
+
+  uintptr_type
+    = lang_hooks.types.type_for_size (tree_low_cst (TYPE_SIZE (ptr_type_node),
+						    1), 1);
+
+  for (i = 0; VEC_iterate (ddr_p, may_alias_ddrs, i, ddr); i++)
+    {
+      tree seg_min[2], seg_max[2];
+      tree part_cond_expr;
+      int k;
+
+      for (k = 0; k < 2; k++)
+	{
+	  struct data_reference *dr = k == 0 ? DDR_A (ddr) : DDR_B (ddr);
+	  tree stmt = DR_STMT (dr);
+	  tree addr_base, seg_len;
+
+	  if (STMT_VINFO_STRIDED_ACCESS (vinfo_for_stmt (stmt)))
+	    {
+	      stmt = DR_GROUP_FIRST_DR (vinfo_for_stmt (stmt));
+	      dr = STMT_VINFO_DATA_REF (vinfo_for_stmt (stmt));
+	    }
+
+	  addr_base = vect_create_addr_base_for_vector_ref (stmt,
+							    cond_expr_stmt_list,
+							    NULL_TREE);
+	  seg_len = size_binop (MULT_EXPR, fold_convert (sizetype, DR_STEP (dr)),
+				unshare_expr (niters));
+	  seg_min[k] = fold_convert (uintptr_type, addr_base);
+	  seg_max[k] = fold_build2 (PLUS_EXPR, uintptr_type,
+				    unshare_expr (seg_min[k]),
+				    fold_convert (uintptr_type, seg_len));
+	}
+
+      part_cond_expr
+	= fold_build2 (TRUTH_OR_EXPR, boolean_type_node,
+		       fold_build2 (LE_EXPR, boolean_type_node,
+				    seg_max[0], seg_min[1]),
+		       fold_build2 (LE_EXPR, boolean_type_node,
+				    seg_max[1], seg_min[0]));
+      if (cond_expr)
+	cond_expr = fold_build2 (TRUTH_AND_EXPR, boolean_type_node,
+				 cond_expr, part_cond_expr);
+      else
+	cond_expr = part_cond_expr;
+    }
+
+  if (vect_print_dump_info (REPORT_VECTORIZED_LOOPS))
+    fprintf (vect_dump, "created %u versioning for alias checks.",
+	     VEC_length (ddr_p, may_alias_ddrs));
+
+  return cond_expr;
+}
+/* APPLE LOCAL end vect alias versioning */
+
+
+/* APPLE LOCAL begin vect interleave */
+/* Function vect_remove_stores.
+
+   Remove the scalar stores of the interleaving group of STMT, which have
+   all been vectorized, and free their stmt_vec_info.  STMT itself is left
+   to the caller.  */
+
+static void
+vect_remove_stores (tree stmt)
+{
+  tree next_stmt = DR_GROUP_FIRST_DR (vinfo_for_stmt (stmt));
+
+  while (next_stmt)
+    {
+      stmt_vec_info info = vinfo_for_stmt (next_stmt);
+      tree tmp = DR_GROUP_NEXT_DR (info);
+
+      if (next_stmt != stmt)
+	{
+	  block_stmt_iterator bsi = bsi_for_stmt (next_stmt);
+
+	  free (info);
+	  set_stmt_info (stmt_ann (next_stmt), NULL);
+	  bsi_remove (&bsi, true);
+	}
+      next_stmt = tmp;
+    }
+}
+/* APPLE LOCAL end vect interleave */
+
+
 /* Function vect_transform_loop.
 
    The analysis phase has determined that the loop is vectorizable.
@@ -2986,7 +4198,12 @@ vect_transform_loop (loop_vec_info loop_vinfo,
      loops is executed.  The test checks for the alignment of all of the
      data references that may or may not be aligned. */
 
-  if (VEC_length (tree, LOOP_VINFO_MAY_MISALIGN_STMTS (loop_vinfo)))
+  /* APPLE LOCAL begin vect alias versioning */
+  /* The test also checks that the data references whose dependence is
+     unknown do not overlap.  */
+  if (VEC_length (tree, LOOP_VINFO_MAY_MISALIGN_STMTS (loop_vinfo))
+      || VEC_length (ddr_p, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo)))
+    /* APPLE LOCAL end vect alias versioning */
     {
       struct loop *nloop;
       tree cond_expr;
@@ -2998,8 +4215,32 @@ vect_transform_loop (loop_vec_info loop_vinfo,
       edge new_exit_e, e;
       tree orig_phi, new_phi, arg;
 
-      cond_expr = vect_create_cond_for_align_checks (loop_vinfo,
-                                                     &cond_expr_stmt_list);
+      /* APPLE LOCAL begin vect alias versioning */
+      cond_expr = NULL_TREE;
+      if (VEC_length (tree, LOOP_VINFO_MAY_MISALIGN_STMTS (loop_vinfo)))
+	cond_expr = vect_create_cond_for_align_checks (loop_vinfo,
+						       &cond_expr_stmt_list);
+
+      if (VEC_length (ddr_p, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo)))
+	{
+	  tree alias_cond_expr, stmts;
+
+	  alias_cond_expr
+	    = vect_create_cond_for_alias_checks (loop_vinfo,
+						 &cond_expr_stmt_list);
+	  if (cond_expr)
+	    cond_expr = fold_build2 (TRUTH_AND_EXPR, boolean_type_node,
+				     cond_expr, alias_cond_expr);
+	  else
+	    cond_expr = alias_cond_expr;
+
+	  cond_expr = force_gimple_operand (unshare_expr (cond_expr), &stmts,
+					    true, NULL_TREE);
+	  if (stmts)
+	    append_to_statement_list_force (stmts, &cond_expr_stmt_list);
+	}
+      /* APPLE LOCAL end vect alias versioning */
+
       initialize_original_copy_tables ();
       nloop = loop_version (loops, loop, cond_expr, &condition_bb, true);
       free_original_copy_tables();
@@ -3098,11 +4339,13 @@ vect_transform_loop (loop_vec_info loop_vinfo,
 	      bsi_next (&si);
 	      continue;
 	    }
-	  /* FORNOW: Verify that all stmts operate on the same number of
-	             units and no inner unrolling is necessary.  */
-	  gcc_assert 
-		(TYPE_VECTOR_SUBPARTS (STMT_VINFO_VECTYPE (stmt_info))
-		 == (unsigned HOST_WIDE_INT) vectorization_factor);
+	  /* APPLE LOCAL begin vect multiple types */
+	  /* A stmt of a type wider than the narrowest one in the loop is
+	     vectorized by several vector stmts.  */
+	  gcc_assert (vectorization_factor
+		      % TYPE_VECTOR_SUBPARTS (STMT_VINFO_VECTYPE (stmt_info))
+		      == 0);
+	  /* APPLE LOCAL end vect multiple types */
 
 	  /* -------- vectorize statement ------------ */
 	  if (vect_print_dump_info (REPORT_DETAILS))
@@ -3113,6 +4356,10 @@ vect_transform_loop (loop_vec_info loop_vinfo,
 	    {
 	      /* Free the attached stmt_vec_info and remove the stmt.  */
 	      stmt_ann_t ann = stmt_ann (stmt);
+	      /* APPLE LOCAL begin vect interleave */
+	      if (STMT_VINFO_STRIDED_ACCESS (stmt_info))
+		vect_remove_stores (stmt);
+	      /* APPLE LOCAL end vect interleave */
 	      free (stmt_info);
 	      set_stmt_info (ann, NULL);
 	      bsi_remove (&si, true);
@@ -151,8 +151,6 @@ Software Foundation, 51 Franklin Street, Fifth Floor, Boston, MA
 /*************************************************************************
   Simple Loop Peeling Utilities
  *************************************************************************/
-static struct loop *slpeel_tree_duplicate_loop_to_edge_cfg 
-  (struct loop *, struct loops *, edge);
 static void slpeel_update_phis_for_duplicate_loop 
   (struct loop *, struct loop *, bool after);
 static void slpeel_update_phi_nodes_for_guard1 
@@ -163,12 +161,10 @@ static edge slpeel_add_loop_guard (basic_block, tree, basic_block, basic_block);
 
 static void rename_use_op (use_operand_p);
 static void rename_variables_in_bb (basic_block);
-static void rename_variables_in_loop (struct loop *);
 
 /*************************************************************************
   General Vectorization Utilities
  *************************************************************************/
-static void vect_set_dump_settings (void);
 
 /* vect_dump will be set to stderr or dump_file if exist.  */
 FILE *vect_dump;
@@ -181,7 +177,8 @@ enum verbosity_levels vect_verbosity_level = MAX_VERBOSITY_LEVEL;
 unsigned int vect_loops_num;
 
 /* Loop location.  */
-static LOC vect_loop_location;
+/* APPLE LOCAL vect slp */
+LOC vect_loop_location;
 
 /* Bitmap of virtual variables to be renamed.  */
 bitmap vect_vnames_to_rename;
@@ -249,7 +246,9 @@ rename_variables_in_bb (basic_block bb)
 
 /* Renames variables in new generated LOOP.  */
 
-static void
+/* APPLE LOCAL begin loop distribution */
+void
+/* APPLE LOCAL end loop distribution */
 rename_variables_in_loop (struct loop *loop)
 {
   unsigned i;
@@ -825,7 +824,9 @@ slpeel_make_loop_iterate_ntimes (struct loop *loop, tree niters)
 /* Given LOOP this function generates a new copy of it and puts it 
    on E which is either the entry or exit of LOOP.  */
 
-static struct loop *
+/* APPLE LOCAL begin loop distribution */
+struct loop *
+/* APPLE LOCAL end loop distribution */
 slpeel_tree_duplicate_loop_to_edge_cfg (struct loop *loop, struct loops *loops, 
 					edge e)
 {
@@ -1049,6 +1050,12 @@ slpeel_verify_cfg_after_peeling (struct loop *first_loop,
         for updating the loop bound of the first-loop to FIRST_NITERS.  If it
         is false, the caller of this function may want to take care of this
         (this can be useful if we don't want new stmts added to first-loop).
+   APPLE LOCAL begin vect cost model
+   - TH: if nonzero, the first loop is also skipped when NITERS is smaller
+        than TH (the cost model threshold).  Only used when peeling the last
+        iterations; TH must be at least the vectorization factor, so that the
+        first loop is still skipped whenever FIRST_NITERS is zero.
+   APPLE LOCAL end vect cost model
 
    Output:
    The function returns a pointer to the new loop-copy, or NULL if it failed
@@ -1059,6 +1066,8 @@ slpeel_verify_cfg_after_peeling (struct loop *first_loop,
    The first guard is:
      if (FIRST_NITERS == 0) then skip the first loop,
      and go directly to the second loop.
+     APPLE LOCAL vect cost model
+     If TH is nonzero, the first guard is (NITERS < TH) instead.
    The second guard is:
      if (FIRST_NITERS == NITERS) then skip the second loop.
 
@@ -1069,7 +1078,9 @@ slpeel_verify_cfg_after_peeling (struct loop *first_loop,
 struct loop*
 slpeel_tree_peel_loop_to_edge (struct loop *loop, struct loops *loops, 
 			       edge e, tree first_niters, 
-			       tree niters, bool update_first_loop_count)
+			       /* APPLE LOCAL vect cost model */
+			       tree niters, bool update_first_loop_count,
+			       unsigned int th)
 {
   struct loop *new_loop = NULL, *first_loop, *second_loop;
   edge skip_e;
@@ -1162,9 +1173,19 @@ slpeel_tree_peel_loop_to_edge (struct loop *loop, struct loops *loops,
   bb_before_second_loop = split_edge (first_loop->single_exit);
   add_bb_to_loop (bb_before_second_loop, first_loop->outer);
 
-  pre_condition =
-    fold_build2 (LE_EXPR, boolean_type_node, first_niters, 
-                 build_int_cst (TREE_TYPE (first_niters), 0));
+  /* APPLE LOCAL begin vect cost model */
+  if (th)
+    {
+      gcc_assert (e == exit_e);
+      pre_condition =
+	fold_build2 (LT_EXPR, boolean_type_node, niters,
+		     build_int_cst (TREE_TYPE (niters), th));
+    }
+  else
+    pre_condition =
+      fold_build2 (LE_EXPR, boolean_type_node, first_niters, 
+		   build_int_cst (TREE_TYPE (first_niters), 0));
+  /* APPLE LOCAL end vect cost model */
   skip_e = slpeel_add_loop_guard (bb_before_first_loop, pre_condition,
                                   bb_before_second_loop, bb_before_first_loop);
   slpeel_update_phi_nodes_for_guard1 (skip_e, first_loop,
@@ -1293,7 +1314,8 @@ vect_set_verbosity_level (const char *val)
    If the user defined the verbosity level, but there is no dump file,
    print to stderr, otherwise print to the dump file.  */
 
-static void
+/* APPLE LOCAL vect slp */
+void
 vect_set_dump_settings (void)
 {
   vect_dump = dump_file;
@@ -1365,6 +1387,8 @@ new_stmt_vec_info (tree stmt, loop_vec_info loop_vinfo)
   STMT_VINFO_LIVE_P (res) = 0;
   STMT_VINFO_VECTYPE (res) = NULL;
   STMT_VINFO_VEC_STMT (res) = NULL;
+  /* APPLE LOCAL vect multiple types */
+  STMT_VINFO_VEC_STMTS (res) = NULL;
   STMT_VINFO_IN_PATTERN_P (res) = false;
   STMT_VINFO_RELATED_STMT (res) = NULL;
   STMT_VINFO_DATA_REF (res) = NULL;
@@ -1373,6 +1397,13 @@ new_stmt_vec_info (tree stmt, loop_vec_info loop_vinfo)
   else
     STMT_VINFO_DEF_TYPE (res) = vect_loop_def;
   STMT_VINFO_SAME_ALIGN_REFS (res) = VEC_alloc (dr_p, heap, 5);
+  /* APPLE LOCAL begin vect interleave */
+  DR_GROUP_FIRST_DR (res) = NULL_TREE;
+  DR_GROUP_NEXT_DR (res) = NULL_TREE;
+  DR_GROUP_SIZE (res) = 0;
+  DR_GROUP_INDEX (res) = 0;
+  DR_GROUP_STORE_COUNT (res) = 0;
+  /* APPLE LOCAL end vect interleave */
 
   return res;
 }
@@ -1429,6 +1460,13 @@ new_loop_vec_info (struct loop *loop)
   LOOP_VINFO_UNALIGNED_DR (res) = NULL;
   LOOP_VINFO_MAY_MISALIGN_STMTS (res)
     = VEC_alloc (tree, heap, PARAM_VALUE (PARAM_VECT_MAX_VERSION_CHECKS));
+  /* APPLE LOCAL begin vect alias versioning */
+  LOOP_VINFO_MAY_ALIAS_DDRS (res)
+    = VEC_alloc (ddr_p, heap,
+		 PARAM_VALUE (PARAM_VECT_MAX_VERSION_FOR_ALIAS_CHECKS));
+  /* APPLE LOCAL end vect alias versioning */
+  /* APPLE LOCAL vect cost model */
+  LOOP_VINFO_COST_MODEL_MIN_ITERS (res) = 0;
 
   return res;
 }
@@ -1493,6 +1531,8 @@ destroy_loop_vec_info (loop_vec_info loop_vinfo)
 			
 	      /* Free stmt_vec_info.  */
 	      VEC_free (dr_p, heap, STMT_VINFO_SAME_ALIGN_REFS (stmt_info));
+	      /* APPLE LOCAL vect multiple types */
+	      VEC_free (tree, heap, STMT_VINFO_VEC_STMTS (stmt_info));
 	      free (stmt_info);
 	      set_stmt_info (ann, NULL);
 
@@ -1508,6 +1548,8 @@ destroy_loop_vec_info (loop_vec_info loop_vinfo)
   free_data_refs (LOOP_VINFO_DATAREFS (loop_vinfo));
   free_dependence_relations (LOOP_VINFO_DDRS (loop_vinfo));
   VEC_free (tree, heap, LOOP_VINFO_MAY_MISALIGN_STMTS (loop_vinfo));
+  /* APPLE LOCAL vect alias versioning */
+  VEC_free (ddr_p, heap, LOOP_VINFO_MAY_ALIAS_DDRS (loop_vinfo));
 
   free (loop_vinfo);
 }
@@ -1623,6 +1665,58 @@ vect_supportable_dr_alignment (struct data_reference *dr)
 }
 
 
+/* APPLE LOCAL begin vect interleave */
+/* Function vect_strided_load_supported.
+
+   Return TRUE if the target can separate the members of an interleaving
+   group loaded in vectors of type VECTYPE, i.e. extract the even and the
+   odd elements of a pair of such vectors.  */
+
+bool
+vect_strided_load_supported (tree vectype)
+{
+  enum machine_mode mode = TYPE_MODE (vectype);
+
+  if (!VECTOR_MODE_P (mode)
+      || vec_extract_even_optab->handlers[mode].insn_code == CODE_FOR_nothing
+      || vec_extract_odd_optab->handlers[mode].insn_code == CODE_FOR_nothing)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "extract even/odd not supported by target");
+      return false;
+    }
+
+  return true;
+}
+
+
+/* Function vect_strided_store_supported.
+
+   Return TRUE if the target can merge the members of an interleaving
+   group stored in vectors of type VECTYPE, i.e. interleave the high and
+   the low halves of a pair of such vectors.  */
+
+bool
+vect_strided_store_supported (tree vectype)
+{
+  enum machine_mode mode = TYPE_MODE (vectype);
+
+  if (!VECTOR_MODE_P (mode)
+      || vec_interleave_high_optab->handlers[mode].insn_code
+	 == CODE_FOR_nothing
+      || vec_interleave_low_optab->handlers[mode].insn_code
+	 == CODE_FOR_nothing)
+    {
+      if (vect_print_dump_info (REPORT_DETAILS))
+	fprintf (vect_dump, "interleave high/low not supported by target");
+      return false;
+    }
+
+  return true;
+}
+/* APPLE LOCAL end vect interleave */
+
+
 /* Function vect_is_simple_use.
 
    Input:
@@ -2027,6 +2121,112 @@ vect_is_simple_iv_evolution (unsigned loop_nb, tree access_fn, tree * init,
 }
 
 
+/* APPLE LOCAL begin vect outer loop */
+/* Function vect_propagate_unrolled_constants.
+
+   Substitute the constants that complete unrolling assigns to the
+   induction variables of an inner loop into the body of LOOP, so that
+   the data references of the copies get constant offsets.  */
+
+static void
+vect_propagate_unrolled_constants (struct loop *loop)
+{
+  basic_block *bbs = get_loop_body_in_dom_order (loop);
+  block_stmt_iterator bsi;
+  unsigned int i;
+
+  for (i = 0; i < loop->num_nodes; i++)
+    for (bsi = bsi_start (bbs[i]); !bsi_end_p (bsi); bsi_next (&bsi))
+      {
+        tree stmt = bsi_stmt (bsi);
+        tree lhs, rhs;
+
+        if (TREE_CODE (stmt) != MODIFY_EXPR)
+          continue;
+        lhs = TREE_OPERAND (stmt, 0);
+        rhs = TREE_OPERAND (stmt, 1);
+        if (TREE_CODE (lhs) == SSA_NAME
+            && is_gimple_reg (lhs)
+            && !SSA_NAME_OCCURS_IN_ABNORMAL_PHI (lhs)
+            && TREE_CODE (rhs) == INTEGER_CST)
+          replace_uses_by (lhs, rhs);
+      }
+  free (bbs);
+}
+
+/* Function vect_unroll_inner_loops.
+
+   Completely unroll the inner loop of every loop nest in LOOPS that
+   vect_analyze_outer_loop accepts, unless the inner loop is vectorizable
+   by itself and runs for at least two vector iterations.  The outer loops
+   of these nests then become innermost loops that vectorize_loops can
+   vectorize.  */
+
+static void
+vect_unroll_inner_loops (struct loops *loops)
+{
+  unsigned int i, n = loops->num;
+  bitmap unrolled = BITMAP_ALLOC (NULL);
+  bitmap_iterator bi;
+
+  for (i = 1; i < n; i++)
+    {
+      struct loop *loop = loops->parray[i];
+      loop_vec_info loop_vinfo;
+      bool inner_ok;
+
+      if (!loop || !loop->inner)
+        continue;
+
+      vect_loop_location = find_loop_location (loop);
+      if (!vect_analyze_outer_loop (loop))
+        continue;
+
+      loop_vinfo = vect_analyze_loop (loop->inner);
+      inner_ok = (loop_vinfo
+                  && LOOP_VINFO_VECTORIZABLE_P (loop_vinfo)
+                  && (!LOOP_VINFO_NITERS_KNOWN_P (loop_vinfo)
+                      || (LOOP_VINFO_INT_NITERS (loop_vinfo)
+                          >= (unsigned HOST_WIDE_INT)
+                             (2 * LOOP_VINFO_VECT_FACTOR (loop_vinfo)))));
+      destroy_loop_vec_info (loop_vinfo);
+      if (inner_ok)
+        {
+          if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+            fprintf (vect_dump, "outer loop: vectorizing inner loop instead.");
+          continue;
+        }
+
+      if (!tree_unroll_loop_completely (loops, loop->inner))
+        {
+          if (vect_print_dump_info (REPORT_OUTER_LOOPS))
+            fprintf (vect_dump, "outer loop: inner loop too large to unroll.");
+          continue;
+        }
+
+      if (vect_print_dump_info (REPORT_DETAILS))
+        fprintf (vect_dump, "outer loop: unrolled inner loop.");
+      bitmap_set_bit (unrolled, loop->num);
+    }
+  vect_loop_location = UNKNOWN_LOC;
+
+  /* Remove the exits of the unrolled loops and merge the copies of their
+     bodies, so that the outer loops consist of a header and a latch.
+     Loads that only varied with the inner loop, such as the coefficients
+     of a filter, are now invariant; hoist them out of the outer loops.  */
+  if (!bitmap_empty_p (unrolled))
+    {
+      update_ssa (TODO_update_ssa);
+      cleanup_tree_cfg_loop ();
+      EXECUTE_IF_SET_IN_BITMAP (unrolled, 0, i, bi)
+        vect_propagate_unrolled_constants (loops->parray[i]);
+      update_ssa (TODO_update_ssa);
+      tree_ssa_lim (loops);
+    }
+  BITMAP_FREE (unrolled);
+}
+/* APPLE LOCAL end vect outer loop */
+
 /* Function vectorize_loops.
    
    Entry Point to loop vectorization phase.  */
@@ -2044,6 +2244,10 @@ vectorize_loops (struct loops *loops)
      need to be renamed.  */
   vect_vnames_to_rename = BITMAP_ALLOC (NULL);
 
+  /* APPLE LOCAL begin vect outer loop */
+  vect_unroll_inner_loops (loops);
+  /* APPLE LOCAL end vect outer loop */
+
   /*  ----------- Analyze loops. -----------  */
 
   /* If some loop was duplicated, it gets bigger number 
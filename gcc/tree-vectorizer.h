@@ -131,6 +131,21 @@ typedef struct _loop_vec_info {
      runtime (loop versioning) misalignment check.  */
   VEC(tree,heap) *may_misalign_stmts;
 
+  /* APPLE LOCAL begin vect alias versioning */
+  /* Pairs of data references whose dependence could not be determined at
+     compile time, and that are checked not to overlap at runtime (loop
+     versioning).  */
+  VEC (ddr_p, heap) *may_alias_ddrs;
+  /* APPLE LOCAL end vect alias versioning */
+
+  /* APPLE LOCAL begin vect cost model */
+  /* The minimum number of iterations for which the vectorized loop is
+     estimated to be profitable, or 0 if the cost model is not used.  Loops
+     whose iteration count is unknown at compile time execute the scalar
+     loop when they iterate fewer times.  */
+  int min_profitable_iters;
+  /* APPLE LOCAL end vect cost model */
+
   /* The loop location in the source.  */
   LOC loop_line_number;
 } *loop_vec_info;
@@ -149,6 +164,10 @@ typedef struct _loop_vec_info {
 #define LOOP_PEELING_FOR_ALIGNMENT(L) (L)->peeling_for_alignment
 #define LOOP_VINFO_UNALIGNED_DR(L)    (L)->unaligned_dr
 #define LOOP_VINFO_MAY_MISALIGN_STMTS(L) (L)->may_misalign_stmts
+/* APPLE LOCAL vect alias versioning */
+#define LOOP_VINFO_MAY_ALIAS_DDRS(L)  (L)->may_alias_ddrs
+/* APPLE LOCAL vect cost model */
+#define LOOP_VINFO_COST_MODEL_MIN_ITERS(L) (L)->min_profitable_iters
 #define LOOP_VINFO_LOC(L)             (L)->loop_line_number
 
 #define LOOP_VINFO_NITERS_KNOWN_P(L)                     \
@@ -165,7 +184,11 @@ enum stmt_vec_info_type {
   op_vec_info_type,
   assignment_vec_info_type,
   condition_vec_info_type,
-  reduc_vec_info_type
+  /* APPLE LOCAL begin vect multiple types */
+  reduc_vec_info_type,
+  type_promotion_vec_info_type,
+  type_demotion_vec_info_type
+  /* APPLE LOCAL end vect multiple types */
 };
 
 typedef struct data_reference *dr_p;
@@ -197,6 +220,13 @@ typedef struct _stmt_vec_info {
   /* The vectorized version of the stmt.  */
   tree vectorized_stmt;
 
+  /* APPLE LOCAL begin vect multiple types */
+  /* When the stmt is vectorized by several vector stmts, because its
+     vector type holds fewer elements than the vectorization factor, all
+     of them in order.  The first one is also VECTORIZED_STMT.  */
+  VEC(tree,heap) *vectorized_stmts;
+  /* APPLE LOCAL end vect multiple types */
+
 
   /** The following is relevant only for stmts that contain a non-scalar
      data-ref (array/pointer/struct access). A GIMPLE stmt is expected to have 
@@ -226,6 +256,24 @@ typedef struct _stmt_vec_info {
   /* Classify the def of this stmt.  */
   enum vect_def_type def_type;
 
+  /* APPLE LOCAL begin vect interleave */
+  /* Interleaving info.  A data-ref whose step is a small multiple of its
+     size belongs to an interleaving group, formed by the data-refs of the
+     loop that have the same base, offset and step and together cover one
+     step of the access.  The group is loaded or stored with consecutive
+     vector accesses from the address of its first member.  */
+  /* The stmt of the member of the group with the lowest address.  */
+  tree first_dr;
+  /* The stmt of the next member, in increasing order of address.  */
+  tree next_dr;
+  /* In the first member, the number of elements in one step.  */
+  unsigned int size;
+  /* The offset of this member from the first one, in elements.  */
+  unsigned int index;
+  /* In the first member of a group of stores, the number of members
+     transformed so far.  */
+  unsigned int store_count;
+  /* APPLE LOCAL end vect interleave */
 } *stmt_vec_info;
 
 /* Access Functions.  */
@@ -236,11 +284,21 @@ typedef struct _stmt_vec_info {
 #define STMT_VINFO_LIVE_P(S)              (S)->live
 #define STMT_VINFO_VECTYPE(S)             (S)->vectype
 #define STMT_VINFO_VEC_STMT(S)            (S)->vectorized_stmt
+/* APPLE LOCAL vect multiple types */
+#define STMT_VINFO_VEC_STMTS(S)           (S)->vectorized_stmts
 #define STMT_VINFO_DATA_REF(S)            (S)->data_ref_info
 #define STMT_VINFO_IN_PATTERN_P(S)        (S)->in_pattern_p
 #define STMT_VINFO_RELATED_STMT(S)        (S)->related_stmt
 #define STMT_VINFO_SAME_ALIGN_REFS(S)     (S)->same_align_refs
 #define STMT_VINFO_DEF_TYPE(S)            (S)->def_type
+/* APPLE LOCAL begin vect interleave */
+#define STMT_VINFO_STRIDED_ACCESS(S)      ((S)->first_dr != NULL_TREE)
+#define DR_GROUP_FIRST_DR(S)              (S)->first_dr
+#define DR_GROUP_NEXT_DR(S)               (S)->next_dr
+#define DR_GROUP_SIZE(S)                  (S)->size
+#define DR_GROUP_INDEX(S)                 (S)->index
+#define DR_GROUP_STORE_COUNT(S)           (S)->store_count
+/* APPLE LOCAL end vect interleave */
 
 static inline void set_stmt_info (stmt_ann_t ann, stmt_vec_info stmt_info);
 static inline stmt_vec_info vinfo_for_stmt (tree stmt);
@@ -259,6 +317,19 @@ vinfo_for_stmt (tree stmt)
   return ann ? (stmt_vec_info) ann->common.aux : NULL;
 }
 
+/* APPLE LOCAL begin vect multiple types */
+/* Return the number of vector stmts needed to vectorize the stmt of
+   STMT_INFO.  The vectorization factor is set by the narrowest type in
+   the loop, so a vector of a wider type covers only part of it.  */
+
+static inline int
+vect_get_ncopies (stmt_vec_info stmt_info)
+{
+  return LOOP_VINFO_VECT_FACTOR (STMT_VINFO_LOOP_VINFO (stmt_info))
+	 / TYPE_VECTOR_SUBPARTS (STMT_VINFO_VECTYPE (stmt_info));
+}
+/* APPLE LOCAL end vect multiple types */
+
 /*-----------------------------------------------------------------*/
 /* Info on data references alignment.                              */
 /*-----------------------------------------------------------------*/
@@ -306,10 +377,17 @@ extern bitmap vect_vnames_to_rename;
    last few iterations when the loop bound is unknown or does not evenly
    divide by the vectorization factor, and to peel the first few iterations
    to force the alignment of data references in the loop.  */
+/* APPLE LOCAL begin vect cost model */
 extern struct loop *slpeel_tree_peel_loop_to_edge 
-  (struct loop *, struct loops *, edge, tree, tree, bool);
+  (struct loop *, struct loops *, edge, tree, tree, bool, unsigned int);
+/* APPLE LOCAL end vect cost model */
 extern void slpeel_make_loop_iterate_ntimes (struct loop *, tree);
 extern bool slpeel_can_duplicate_loop_p (struct loop *, edge);
+/* APPLE LOCAL begin loop distribution */
+extern struct loop *slpeel_tree_duplicate_loop_to_edge_cfg
+  (struct loop *, struct loops *, edge);
+extern void rename_variables_in_loop (struct loop *);
+/* APPLE LOCAL end loop distribution */
 #ifdef ENABLE_CHECKING
 extern void slpeel_verify_cfg_after_peeling (struct loop *, struct loop *);
 #endif
@@ -328,6 +406,10 @@ extern bool vect_can_force_dr_alignment_p (tree, unsigned int);
 extern enum dr_alignment_support vect_supportable_dr_alignment
   (struct data_reference *);
 extern bool reduction_code_for_scalar_code (enum tree_code, enum tree_code *);
+/* APPLE LOCAL begin vect interleave */
+extern bool vect_strided_load_supported (tree);
+extern bool vect_strided_store_supported (tree);
+/* APPLE LOCAL end vect interleave */
 /* Creation and deletion of loop and stmt info structs.  */
 extern loop_vec_info new_loop_vec_info (struct loop *loop);
 extern void destroy_loop_vec_info (loop_vec_info);
@@ -339,6 +421,8 @@ extern void vectorize_loops (struct loops *);
 /** In tree-vect-analyze.c  **/
 /* Driver for analysis stage.  */
 extern loop_vec_info vect_analyze_loop (struct loop *);
+/* APPLE LOCAL vect outer loop */
+extern bool vect_analyze_outer_loop (struct loop *);
 
 
 /** In tree-vect-patterns.c  **/
@@ -358,6 +442,10 @@ extern bool vectorizable_assignment (tree, block_stmt_iterator *, tree *);
 extern bool vectorizable_condition (tree, block_stmt_iterator *, tree *);
 extern bool vectorizable_live_operation (tree, block_stmt_iterator *, tree *);
 extern bool vectorizable_reduction (tree, block_stmt_iterator *, tree *);
+/* APPLE LOCAL begin vect multiple types */
+extern bool vectorizable_type_promotion (tree, block_stmt_iterator *, tree *);
+extern bool vectorizable_type_demotion (tree, block_stmt_iterator *, tree *);
+/* APPLE LOCAL end vect multiple types */
 /* Driver for transformation stage.  */
 extern void vect_transform_loop (loop_vec_info, struct loops *);
 
@@ -366,6 +454,10 @@ extern void vect_transform_loop (loop_vec_info, struct loops *);
  *************************************************************************/
 extern bool vect_print_dump_info (enum verbosity_levels);
 extern void vect_set_verbosity_level (const char *);
+/* APPLE LOCAL vect slp */
+extern void vect_set_dump_settings (void);
 extern LOC find_loop_location (struct loop *);
+/* APPLE LOCAL vect slp */
+extern LOC vect_loop_location;
 
 #endif  /* GCC_TREE_VECTORIZER_H  */
@@ -786,8 +786,10 @@ int_cst_hash_hash (const void *x)
 {
   tree t = (tree) x;
 
+  /* APPLE LOCAL begin relocatable PCH */
   return (TREE_INT_CST_HIGH (t) ^ TREE_INT_CST_LOW (t)
-	  ^ htab_hash_pointer (TREE_TYPE (t)));
+	  ^ TYPE_UID (TREE_TYPE (t)));
+  /* APPLE LOCAL end relocatable PCH */
 }
 
 /* Return nonzero if the value represented by *X (an INTEGER_CST tree node)
@@ -4003,7 +4005,8 @@ tree_int_map_eq (const void *va, const void *vb)
 static unsigned int
 tree_int_map_hash (const void *item)
 {
-  return htab_hash_pointer (((const struct tree_int_map *)item)->from);
+  /* APPLE LOCAL relocatable PCH */
+  return DECL_UID (((const struct tree_int_map *)item)->from);
 }
 
 /* Return true if this tree int map structure is marked for garbage collection
@@ -4025,8 +4028,9 @@ decl_init_priority_lookup (tree from)
   struct tree_int_map *h, in;
   in.from = from;
 
+  /* APPLE LOCAL relocatable PCH */
   h = htab_find_with_hash (init_priority_for_decl, 
-			   &in, htab_hash_pointer (from));
+			   &in, DECL_UID (from));
   if (h)
     return h->to;
   return 0;
@@ -4043,8 +4047,9 @@ decl_init_priority_insert (tree from, unsigned short to)
   h = ggc_alloc (sizeof (struct tree_int_map));
   h->from = from;
   h->to = to;
+  /* APPLE LOCAL relocatable PCH */
   loc = htab_find_slot_with_hash (init_priority_for_decl, h, 
-				  htab_hash_pointer (from), INSERT);
+				  DECL_UID (from), INSERT);
   *(struct tree_int_map **) loc = h;
 }  
 
@@ -4057,8 +4062,9 @@ decl_restrict_base_lookup (tree from)
   struct tree_map in;
 
   in.from = from;
+  /* APPLE LOCAL relocatable PCH */
   h = htab_find_with_hash (restrict_base_for_decl, &in,
-			   htab_hash_pointer (from));
+			   DECL_UID (from));
   return h ? h->to : NULL_TREE;
 }
 
@@ -4071,7 +4077,8 @@ decl_restrict_base_insert (tree from, tree to)
   void **loc;
 
   h = ggc_alloc (sizeof (struct tree_map));
-  h->hash = htab_hash_pointer (from);
+  /* APPLE LOCAL relocatable PCH */
+  h->hash = DECL_UID (from);
   h->from = from;
   h->to = to;
   loc = htab_find_slot_with_hash (restrict_base_for_decl, h, h->hash, INSERT);
@@ -4122,7 +4129,8 @@ decl_debug_expr_lookup (tree from)
   struct tree_map *h, in;
   in.from = from;
 
-  h = htab_find_with_hash (debug_expr_for_decl, &in, htab_hash_pointer (from));
+  /* APPLE LOCAL relocatable PCH */
+  h = htab_find_with_hash (debug_expr_for_decl, &in, DECL_UID (from));
   if (h)
     return h->to;
   return NULL_TREE;
@@ -4137,7 +4145,8 @@ decl_debug_expr_insert (tree from, tree to)
   void **loc;
 
   h = ggc_alloc (sizeof (struct tree_map));
-  h->hash = htab_hash_pointer (from);
+  /* APPLE LOCAL relocatable PCH */
+  h->hash = DECL_UID (from);
   h->from = from;
   h->to = to;
   loc = htab_find_slot_with_hash (debug_expr_for_decl, h, h->hash, INSERT);
@@ -4152,7 +4161,8 @@ decl_value_expr_lookup (tree from)
   struct tree_map *h, in;
   in.from = from;
 
-  h = htab_find_with_hash (value_expr_for_decl, &in, htab_hash_pointer (from));
+  /* APPLE LOCAL relocatable PCH */
+  h = htab_find_with_hash (value_expr_for_decl, &in, DECL_UID (from));
   if (h)
     return h->to;
   return NULL_TREE;
@@ -4167,7 +4177,8 @@ decl_value_expr_insert (tree from, tree to)
   void **loc;
 
   h = ggc_alloc (sizeof (struct tree_map));
-  h->hash = htab_hash_pointer (from);
+  /* APPLE LOCAL relocatable PCH */
+  h->hash = DECL_UID (from);
   h->from = from;
   h->to = to;
   loc = htab_find_slot_with_hash (value_expr_for_decl, h, h->hash, INSERT);
@@ -4956,8 +4967,10 @@ iterative_hash_expr (tree t, hashval_t val)
 	 hash codes.  */
       if (DECL_BUILT_IN (t))
 	{
-	  val = iterative_hash_pointer (built_in_decls[DECL_FUNCTION_CODE (t)], 
-				      val);
+	  /* APPLE LOCAL begin relocatable PCH */
+	  val = iterative_hash_host_wide_int
+	    (DECL_UID (built_in_decls[DECL_FUNCTION_CODE (t)]), val);
+	  /* APPLE LOCAL end relocatable PCH */
 	  return val;
 	}
       /* else FALL THROUGH */
@@ -508,6 +508,16 @@ struct pex_time
   unsigned long user_microseconds;
   unsigned long system_seconds;
   unsigned long system_microseconds;
+  /* APPLE LOCAL begin pex resource usage */
+  /* Elapsed time from starting the program to waiting for it.  */
+  unsigned long wall_seconds;
+  unsigned long wall_microseconds;
+  /* Peak resident set size in kilobytes, and the number of blocks
+     read and written.  Zero where the host cannot tell.  */
+  unsigned long max_rss;
+  unsigned long in_blocks;
+  unsigned long out_blocks;
+  /* APPLE LOCAL end pex resource usage */
 };
 
 extern int pex_get_times (struct pex_obj *, int count,
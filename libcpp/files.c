@@ -273,6 +273,16 @@ pch_open_file (cpp_reader *pfile, _cpp_file *file, bool *invalid_pch)
     pchname = indirect_file (pchname, 0);
   /* APPLE LOCAL end distcc pch indirection --mrs */
 
+  /* APPLE LOCAL begin compile server prefix PCH */
+  if (CPP_OPTION (pfile, next_pch) && ! file->main_file)
+    {
+      free (pchname);
+      pchname = xstrdup (CPP_OPTION (pfile, next_pch));
+      len = strlen (pchname) + 1;
+      CPP_OPTION (pfile, next_pch) = NULL;
+    }
+  /* APPLE LOCAL end compile server prefix PCH */
+
   if (stat (pchname, &st) == 0)
     {
       DIR *pchdir;
@@ -456,6 +456,13 @@ struct cpp_options
   /* True if dependencies should be restored from a precompiled header.  */
   bool restore_pch_deps;
 
+  /* APPLE LOCAL begin compile server prefix PCH */
+  /* If nonnull, the precompiled header to try for the next file
+     looked up other than the main file, in place of its own NAME.gch.
+     Used once.  */
+  const char *next_pch;
+  /* APPLE LOCAL end compile server prefix PCH */
+
   /* APPLE LOCAL begin Symbol Separation */
   unsigned char making_pch;
   unsigned char making_ss;
@@ -36,6 +36,11 @@ extern int errno;
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+/* APPLE LOCAL begin pex resource usage */
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+/* APPLE LOCAL end pex resource usage */
 
 extern int mkstemps (char *, int);
 
@@ -46,6 +51,8 @@ extern int mkstemps (char *, int);
 static void pex_add_remove (struct pex_obj *, const char *, int);
 static int pex_get_status_and_time (struct pex_obj *, int, const char **,
 				    int *);
+/* APPLE LOCAL pex resource usage */
+static void pex_now (unsigned long *, unsigned long *);
 
 /* Initialize a pex_obj structure.  */
 
@@ -317,6 +324,17 @@ pex_run_in_environment (struct pex_obj *obj, int flags, const char *executable,
   obj->children = XRESIZEVEC (long, obj->children, obj->count);
   obj->children[obj->count - 1] = pid;
 
+  /* APPLE LOCAL begin pex resource usage */
+  /* Note when the program started, for its wall time.  */
+  if ((obj->flags & PEX_RECORD_TIMES) != 0)
+    {
+      obj->time = XRESIZEVEC (struct pex_time, obj->time, obj->count);
+      memset (&obj->time[obj->count - 1], 0, sizeof (struct pex_time));
+      pex_now (&obj->time[obj->count - 1].wall_seconds,
+	       &obj->time[obj->count - 1].wall_microseconds);
+    }
+  /* APPLE LOCAL end pex resource usage */
+
   return NULL;
 
  error_exit:
@@ -465,6 +483,28 @@ pex_read_output (struct pex_obj *obj, int binary)
   return obj->read_output;
 }
 
+/* APPLE LOCAL begin pex resource usage */
+/* Store the current time in *SECONDS and *MICROSECONDS, or zero if the
+   host cannot tell.  */
+
+static void
+pex_now (unsigned long *seconds, unsigned long *microseconds)
+{
+#ifdef HAVE_GETTIMEOFDAY
+  struct timeval tv;
+
+  if (gettimeofday (&tv, NULL) == 0)
+    {
+      *seconds = tv.tv_sec;
+      *microseconds = tv.tv_usec;
+      return;
+    }
+#endif
+  *seconds = 0;
+  *microseconds = 0;
+}
+/* APPLE LOCAL end pex resource usage */
+
 /* Get the exit status and, if requested, the resource time for all
    the child processes.  Return 0 on failure, 1 on success.  */
 
@@ -485,10 +525,34 @@ pex_get_status_and_time (struct pex_obj *obj, int done, const char **errmsg,
   ret = 1;
   for (i = obj->number_waited; i < obj->count; ++i)
     {
+      /* APPLE LOCAL begin pex resource usage */
+      unsigned long start_seconds = 0, start_microseconds = 0;
+      unsigned long seconds, microseconds;
+
+      if (obj->time != NULL)
+	{
+	  start_seconds = obj->time[i].wall_seconds;
+	  start_microseconds = obj->time[i].wall_microseconds;
+	  memset (&obj->time[i], 0, sizeof (struct pex_time));
+	}
+      /* APPLE LOCAL end pex resource usage */
       if (obj->funcs->wait (obj, obj->children[i], &obj->status[i],
 			    obj->time == NULL ? NULL : &obj->time[i],
 			    done, errmsg, err) < 0)
 	ret = 0;
+      /* APPLE LOCAL begin pex resource usage */
+      if (obj->time != NULL && start_seconds != 0)
+	{
+	  pex_now (&seconds, &microseconds);
+	  if (microseconds < start_microseconds)
+	    {
+	      --seconds;
+	      microseconds += 1000000;
+	    }
+	  obj->time[i].wall_seconds = seconds - start_seconds;
+	  obj->time[i].wall_microseconds = microseconds - start_microseconds;
+	}
+      /* APPLE LOCAL end pex resource usage */
     }
   obj->number_waited = i;
 
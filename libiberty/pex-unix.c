@@ -108,6 +108,16 @@ pex_wait (struct pex_obj *obj ATTRIBUTE_UNUSED, pid_t pid, int *status,
       time->user_microseconds= r.ru_utime.tv_usec;
       time->system_seconds = r.ru_stime.tv_sec;
       time->system_microseconds= r.ru_stime.tv_usec;
+      /* APPLE LOCAL begin pex resource usage */
+#ifdef __APPLE__
+      /* Darwin gives the peak resident set size in bytes.  */
+      time->max_rss = r.ru_maxrss / 1024;
+#else
+      time->max_rss = r.ru_maxrss;
+#endif
+      time->in_blocks = r.ru_inblock;
+      time->out_blocks = r.ru_oublock;
+      /* APPLE LOCAL end pex resource usage */
     }
 
   return ret;